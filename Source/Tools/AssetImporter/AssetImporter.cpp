@@ -164,7 +164,11 @@ bool noOverwriteTexture_ = false;
 bool noOverwriteNewerTexture_ = false;
 bool checkUniqueModel_ = true;
 bool moveToBindPose_ = false;
+bool optimizeGeometries_ = true;
 unsigned maxBones_ = 64;
+unsigned numGeneratedLods_ = 0;
+float lodReductionFactor_ = 0.5f;
+float animationSampleRate_ = 0.0f;
 ea::vector<ea::string> nonSkinningBoneIncludes_;
 ea::vector<ea::string> nonSkinningBoneExcludes_;
 
@@ -286,6 +290,7 @@ void Run(const ea::vector<ea::string>& arguments)
             "-ns         Do not create subdirectories for resources\n"
             "-nz         Do not create a zone and a directional light (scene mode only)\n"
             "-nf         Do not fix infacing normals\n"
+            "-no         Do not optimize vertex cache, overdraw and vertex fetch order\n"
             "-ne         Do not save empty nodes (scene mode only)\n"
             "-mb <x>     Maximum number of bones per submesh. Default 64\n"
             "-p <path>   Set path for scene resources. Default is output file path\n"
@@ -308,6 +313,9 @@ void Run(const ea::vector<ea::string>& arguments)
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
+            "-gl <num>   Generate LOD levels by mesh simplification, including the original\n"
+            "-glr <x>    Ratio of triangles kept by each generated LOD level. Default 0.5\n"
+            "-ca <rate>  Compress animations, resampling them at the given rate per second\n"
         );
     }
 
@@ -405,6 +413,10 @@ void Run(const ea::vector<ea::string>& arguments)
                         suppressFbxPivotNodes_ = false;
                     break;
 
+                case 'o':
+                    optimizeGeometries_ = false;
+                    break;
+
                 }
             }
             else if (argument == "mb" && !value.empty())
@@ -414,6 +426,21 @@ void Run(const ea::vector<ea::string>& arguments)
                     maxBones_ = 1;
                 ++i;
             }
+            else if (argument == "gl" && !value.empty())
+            {
+                numGeneratedLods_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "glr" && !value.empty())
+            {
+                lodReductionFactor_ = Clamp(ToFloat(value), 0.01f, 0.99f);
+                ++i;
+            }
+            else if (argument == "ca" && !value.empty())
+            {
+                animationSampleRate_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
             else if (argument == "p" && !value.empty())
             {
                 resourcePath_ = AddTrailingSlash(value);
@@ -1227,6 +1254,31 @@ void BuildAndSaveModel(OutModel& model)
             outModel->SetGeometryBoneMappings(allBoneMappings);
     }
 
+    // Generate LOD levels if requested
+    if (numGeneratedLods_ > 1)
+    {
+        PrintLine("Generating " + ea::to_string(numGeneratedLods_) + " LOD levels");
+        outModel->GenerateLods(numGeneratedLods_, lodReductionFactor_);
+        for (unsigned i = 0; i < outModel->GetNumGeometries(); ++i)
+        {
+            for (unsigned j = 1; j < outModel->GetNumGeometryLodLevels(i); ++j)
+            {
+                Geometry* geometry = outModel->GetGeometry(i, j);
+                PrintLine("Geometry " + ea::to_string(i) + " LOD " + ea::to_string(j) + ": " +
+                    ea::to_string(geometry->GetIndexCount() / 3) + " triangles, distance " +
+                    ea::to_string(geometry->GetLodDistance()) + ", error " + ea::to_string(geometry->GetLodError()));
+            }
+        }
+    }
+
+    // Optimize index and vertex order, including generated LOD levels
+    if (optimizeGeometries_)
+    {
+        float acmrBefore, acmrAfter;
+        outModel->OptimizeGeometries(true, true, &acmrBefore, &acmrAfter);
+        PrintLine("Optimized geometries, ACMR " + ea::to_string(acmrBefore) + " -> " + ea::to_string(acmrAfter));
+    }
+
     File outFile(context_);
     if (!outFile.Open(model.outName_, FILE_WRITE))
         ErrorExit("Could not open output file " + model.outName_);
@@ -1496,6 +1548,16 @@ void BuildAndSaveAnimations(OutModel* model)
             }
         }
 
+        if (animationSampleRate_ > 0.0f)
+        {
+            unsigned uncompressedSize = 0;
+            for (const auto& track : outAnim->GetTracks())
+                uncompressedSize += track.second.keyFrames_.size() * sizeof(AnimationKeyFrame);
+            if (outAnim->Compress(animationSampleRate_))
+                PrintLine("Compressed animation " + animName + " keyframes from " + ea::to_string(uncompressedSize) + " to " +
+                    ea::to_string(outAnim->GetMemoryUse()) + " bytes");
+        }
+
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
             ErrorExit("Could not open output file " + animOutName);
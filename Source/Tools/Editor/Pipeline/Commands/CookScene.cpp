@@ -50,6 +50,7 @@ void CookScene::RegisterCommandLine(CLI::App& cli)
 {
     cli.add_option("--input", input_, "XML scene file.")->required();
     cli.add_option("--output", output_, "Resulting binary scene file.");
+    cli.add_flag("--packed", packed_, "Write packed binary scene file.");
     cli.set_callback([this]() {
         GetSubsystem<Editor>()->GetEngineParameters()[EP_HEADLESS] = true;
     });
@@ -85,7 +86,7 @@ void CookScene::Execute()
             File output(context_);
             if (output.Open(output_, FILE_WRITE))
             {
-                if (!scene.Save(output))
+                if (!(packed_ ? scene.SavePacked(output) : scene.Save(output)))
                     editor->ErrorExit(Format("Could not convert '{}' to binary version.", input_));
                 else
                     fs->SetLastModifiedTime(output_, fs->GetLastModifiedTime(input_));
@@ -46,6 +46,8 @@ protected:
     ea::string input_;
     ///
     ea::string output_;
+    /// Write packed binary scene file.
+    bool packed_ = false;
 };
 
 }
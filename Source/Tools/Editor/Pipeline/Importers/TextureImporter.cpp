@@ -22,6 +22,7 @@
 
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/Image.h>
 #include "Pipeline/Asset.h"
 #include "Pipeline/Importers/TextureImporter.h"
 
@@ -88,6 +89,12 @@ const char* TextureImporter::pixelFormatNames[] = {
     nullptr
 };
 
+const char* TextureImporter::containerNames[] = {
+    "DDS",
+    "UTEX",
+    nullptr
+};
+
 TextureImporter::TextureImporter(Context* context)
     : AssetImporter(context)
 {
@@ -120,6 +127,7 @@ void TextureImporter::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Force Primary Encoding", bool, forcePrimaryEncoding_, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Use Transparent Indices For Black", bool, useTransparentIndicesForBlack_, false, AM_DEFAULT);
     URHO3D_ENUM_ATTRIBUTE("Pixel Format", pixelFormat_, pixelFormatNames, PixelFormat::None, AM_DEFAULT);
+    URHO3D_ENUM_ATTRIBUTE("Container", container_, containerNames, Container::DDS, AM_DEFAULT);
 }
 
 void TextureImporter::RenderInspector(const char* filter)
@@ -140,6 +148,7 @@ bool TextureImporter::Execute(Urho3D::Asset* input, const ea::string& outputPath
     ea::string outputDirectory = outputPath + GetPath(input->GetName());
     ea::string outputFile = outputDirectory + GetFileName(input->GetName()) + ".dds";
     int pixelFormatValue = GetAttribute("Pixel Format").GetInt();
+    bool utexContainer = GetAttribute("Container").GetInt() == (int)Container::UTEX;
 
     if (pixelFormatValue == (int)PixelFormat::None)
         return false;
@@ -220,6 +229,21 @@ bool TextureImporter::Execute(Urho3D::Asset* input, const ea::string& outputPath
         return false;
     }
 
+    if (utexContainer)
+    {
+        // Repack crunch output so that all mip levels are loaded with a single read and uploaded without decoding
+        ea::string utexFile = ReplaceExtension(outputFile, ".utex");
+        SharedPtr<Image> image(context_->CreateObject<Image>());
+        bool converted = image->LoadFile(outputFile) && image->SaveUTEX(utexFile);
+        context_->GetFileSystem()->Delete(outputFile);
+        if (!converted)
+        {
+            logger_.Error("Converting 'res://{}' to texture container '{}' failed.", input->GetName(), utexFile);
+            return false;
+        }
+        outputFile = utexFile;
+    }
+
     AddByproduct(outputFile);
     return true;
 }
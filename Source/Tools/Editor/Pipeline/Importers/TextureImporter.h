@@ -69,6 +69,14 @@ public:
         Uber
     };
 
+    enum class Container
+    {
+        /// DirectDraw surface as written by crunch.
+        DDS,
+        /// Engine texture container, loaded without decoding.
+        UTEX,
+    };
+
     enum class PixelFormat
     {
         None,
@@ -100,6 +108,7 @@ public:
     static const char* compressorNames[];
     static const char* dxtQualityNames[];
     static const char* pixelFormatNames[];
+    static const char* containerNames[];
 
     explicit TextureImporter(Context* context);
     /// Register object with the engine.
@@ -165,6 +174,8 @@ protected:
     bool useTransparentIndicesForBlack_ = false;
     ///
     PixelFormat pixelFormat_ = PixelFormat::None;
+    /// Output file container. UTEX is opt-in; crunch output is kept as DDS by default.
+    Container container_ = Container::DDS;
     ///
     Logger logger_ = Log::GetLogger(ClassName::GetTypeNameStatic());
 };
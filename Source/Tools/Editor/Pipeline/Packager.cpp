@@ -26,8 +26,7 @@
 #include <Urho3D/Core/Thread.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/IO/FileSystem.h>
-#include <LZ4/lz4.h>
-#include <LZ4/lz4hc.h>
+#include <Urho3D/IO/PackageBuilder.h>
 
 #include "Project.h"
 #include "Pipeline/Asset.h"
@@ -39,9 +38,8 @@ namespace Urho3D
 
 Packager::Packager(Context* context)
     : Object(context)
-    , output_(context)
+    , builder_(new PackageBuilder(context))
 {
-    compressBuffer_.resize(LZ4_compressBound(blockSize_));
 }
 
 Packager::~Packager()
@@ -58,11 +56,8 @@ bool Packager::OpenPackage(const ea::string& path, Flavor* flavor, bool compress
     flavor_ = WeakPtr(flavor);
     compress_ = compress;
 
-    if (output_.Open(path, FILE_WRITE))
-    {
-        WriteHeaders();
+    if (builder_->Open(path))
         return true;
-    }
     logger_.Error("Opening '{}' failed, package was not created.", GetFileNameAndExtension(path));
     return false;
 }
@@ -91,7 +86,7 @@ void Packager::Start()
     if (filesTotal_ == 0)
     {
         logger_.Warning("Resources directory is empty, package was not created.");
-        output_.Close();
+        builder_->Close();
         context_->GetFileSystem()->Delete(outputPath_);
         return;
     }
@@ -142,71 +137,39 @@ void Packager::WritePackage()
     AddFile(cachePath, "CacheInfo.json");   filesDone_++;
     AddFile(cachePath, "Settings.json");    filesDone_++;
 
-    entriesOffset_ = output_.GetSize();
-
-    for (const FileEntry& entry : entries_)
-    {
-        output_.WriteString(entry.name_);
-        output_.WriteUInt(entry.offset_);
-        output_.WriteUInt(entry.size_);
-        output_.WriteUInt(entry.checksum_);
-    }
-    // Write package size to the end of file to allow finding it linked to an executable file
-    unsigned currentSize = output_.GetSize();
-    output_.WriteUInt(currentSize + sizeof(unsigned));
-
-    WriteHeaders();
+    if (!builder_->Close())
+        logger_.Error("Writing index of '{}' failed.", GetFileNameAndExtension(outputPath_));
 
     logger_.Info("Packaging completed.");
 }
 
-void Packager::WriteHeaders()
-{
-    output_.Seek(0);
-    output_.WriteFileID(compress_ ? "RLZ4" : "RPAK");
-    output_.WriteUInt(entries_.size());
-    output_.WriteUInt(checksum_);
-    output_.WriteUInt(0);                                   // Version. Reserved for future use.
-    output_.WriteInt64(entriesOffset_);
-}
-
 bool Packager::AddFile(const ea::string& root, const ea::string& path)
 {
     assert(root.ends_with("/"));
 
-    FileEntry entry{};
+    ea::string entryName;
     ea::string fileFullPath;
 
     if (IsAbsolutePath(path))
     {
         assert(root.starts_with(root));
         fileFullPath = path;
-        entry.name_ = path.substr(root.length());
+        entryName = path.substr(root.length());
     }
     else
     {
         fileFullPath = root + path;
-        entry.name_ = path;
-    }
-    entry.checksum_ = 0;
-    entry.offset_ = 0;
-    entry.size_ = File(context_, fileFullPath).GetSize();
-    if (!entry.size_)
-    {
-        logger_.Warning("Skipped empty/missing file '{}'.", fileFullPath);
-        return false;
+        entryName = path;
     }
 
-    unsigned lastOffset = entry.offset_ = output_.GetSize();
-
     File srcFile(context_, fileFullPath);
-    if (!srcFile.IsOpen())
+    if (!srcFile.IsOpen() || !srcFile.GetSize())
     {
-        logger_.Error("Could not open file {}. Skipped!", fileFullPath);
+        logger_.Warning("Skipped empty/missing file '{}'.", fileFullPath);
         return false;
     }
 
-    unsigned dataSize = entry.size_;
+    unsigned dataSize = srcFile.GetSize();
     buffer_.resize(dataSize);
 
     if (srcFile.Read(&buffer_[0], dataSize) != dataSize)
@@ -216,44 +179,21 @@ bool Packager::AddFile(const ea::string& root, const ea::string& path)
     }
     srcFile.Close();
 
-    for (unsigned j = 0; j < dataSize; ++j)
+    // Formats that are already compressed are stored as is
+    const PackageCodec codec = PackageBuilder::SelectCodec(entryName, compress_ ? PACKAGE_CODEC_LZ4HC : PACKAGE_CODEC_STORE);
+    if (!builder_->Append(entryName, buffer_.data(), dataSize, codec))
     {
-        checksum_ = SDBMHash(checksum_, buffer_[j]);
-        entry.checksum_ = SDBMHash(entry.checksum_, buffer_[j]);
+        logger_.Error("Could not write file {} to the package. Skipped!", fileFullPath);
+        return false;
     }
 
-    entries_.push_back(entry);
-    if (!compress_)
-    {
-        logger_.Info("Added {} size {}", entry.name_, dataSize);
-        output_.Write(&buffer_[0], entry.size_);
-    }
+    const PackageEntry& entry = builder_->GetIndex().back().entry_;
+    if (entry.codec_ == PACKAGE_CODEC_STORE)
+        logger_.Info("Added {} size {}", entryName, dataSize);
     else
     {
-        unsigned pos = 0;
-
-        // TODO: This could be parallelized.
-        while (pos < dataSize)
-        {
-            int unpackedSize = blockSize_;
-            if (pos + unpackedSize > dataSize)
-                unpackedSize = static_cast<int>(dataSize) - pos;
-
-            auto packedSize = (unsigned) LZ4_compress_HC((const char*) &buffer_[pos], (char*) compressBuffer_.data(), unpackedSize,
-                LZ4_compressBound(unpackedSize), 0);
-            if (!packedSize)
-                logger_.Error("LZ4 compression failed for file {} at offset {}.", entry.name_, pos);
-
-            output_.WriteUShort((unsigned short) unpackedSize);
-            output_.WriteUShort((unsigned short) packedSize);
-            output_.Write(compressBuffer_.data(), packedSize);
-
-            pos += unpackedSize;
-        }
-
-        unsigned totalPackedBytes = output_.GetSize() - lastOffset;
-        logger_.Info("{} in: {} out: {} ratio: {}", entry.name_, dataSize, totalPackedBytes,
-            totalPackedBytes ? 1.f * dataSize / totalPackedBytes : 0.f);
+        logger_.Info("{} in: {} out: {} ratio: {}", entryName, dataSize, entry.packedSize_,
+            entry.packedSize_ ? 1.f * dataSize / entry.packedSize_ : 0.f);
     }
     return true;
 }
@@ -31,26 +31,11 @@ namespace Urho3D
 {
 
 class Asset;
+class PackageBuilder;
 
-struct FileEntry
-{
-    /// This is essentially a resource name.
-    ea::string name_;
-    /// Offset to the file data from the file start.
-    unsigned offset_{};
-    /// Size of file data.
-    unsigned size_{};
-    /// Checksum of file data.
-    unsigned checksum_{};
-};
-
-///
-/// rbfx uses modified Urho3D pak file format. File header is modified and extended. Version field was added to facilitate easy modification
-/// of file structure in the future. Package entry list was moved to the end of the file (much like in a zip file) in order to allow
-/// creation of package files without knowing full list of files before-hand.
-///
-
-/// %Packager is responsible for creating a package for specified flavor. Package will use new file format and have RPAK/RLZ4 file id.
+/// %Packager is responsible for creating a package for specified flavor. Packages are written in the indexed format: file data is
+/// aligned for memory mapping, every file picks its own codec so that already compressed formats are stored as is, and a sorted
+/// hashed index at the end of the file allows lookups without parsing the whole file list.
 class Packager : public Object
 {
     URHO3D_OBJECT(Packager, Object);
@@ -75,8 +60,6 @@ public:
 protected:
     /// Add a file to the package. This is a blocking operation.
     bool AddFile(const ea::string& root, const ea::string& path);
-    /// Writes file headter to the start of the file.
-    void WriteHeaders();
     /// A worker running in another thread that will handle writing the package.
     void WritePackage();
 
@@ -84,31 +67,20 @@ protected:
     Logger logger_{};
     /// Full path to output package file.
     ea::string outputPath_{};
-    /// Package file.
-    File output_;
-    /// List of files that will be present in the package.
-    ea::vector<FileEntry> entries_{};
+    /// Package writer.
+    SharedPtr<PackageBuilder> builder_;
     /// Flavor that is being compressed.
     WeakPtr<Flavor> flavor_;
     /// A list of assets that are to be written into the package.
     ea::vector<SharedPtr<Asset>> queuedAssets_{};
     /// Flag indicating whether file content is compressed or not.
     bool compress_ = false;
-    /// Checksum of all file data (uncompressed).
-    unsigned checksum_ = 0;
-    /// Offset to the list of file entries in this package.
-    int64_t entriesOffset_ = 0;
-    /// LZ4 block size for data compression.
-    const int blockSize_ = 32768;
-    /// Buffer that holds data that was read from file. It will be written to package or used in compression.
+    /// Buffer that holds data that was read from file before it is written to the package.
     ea::vector<uint8_t> buffer_{};
-    /// Buffer that holds compressed file data.
-    ea::vector<uint8_t> compressBuffer_{};
     /// Total number of assets to be processed. This number may be less than files written to the package as each asset may carry multiple byproducts.
     unsigned filesTotal_ = 0;
     /// A number of already completed written assets.
     std::atomic<uint32_t> filesDone_{0};
 };
 
-
 }
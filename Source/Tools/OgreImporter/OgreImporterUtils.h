@@ -104,9 +104,6 @@ struct ModelVertex
     float blendWeights_[4]{};
     unsigned char blendIndices_[4]{};
     bool hasBlendWeights_{};
-    unsigned useCount_{};
-    int cachePosition_{};
-    float score_{};
 };
 
 struct ModelVertexBuffer
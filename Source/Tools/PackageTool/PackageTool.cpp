@@ -24,8 +24,10 @@
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/PackageBuilder.h>
 #include <Urho3D/IO/PackageFile.h>
 
 #ifdef WIN32
@@ -57,8 +59,12 @@ ea::string basePath_;
 ea::vector<FileEntry> entries_;
 unsigned checksum_ = 0;
 bool compress_ = false;
+bool fastCompress_ = false;
+bool useDictionary_ = false;
+bool legacyFormat_ = false;
 bool quiet_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
+unsigned alignment_ = DEFAULT_PACKAGE_ALIGNMENT;
 
 ea::string ignoreExtensions_[] = {
     ".bak",
@@ -69,6 +75,7 @@ int main(int argc, char** argv);
 void Run(const ea::vector<ea::string>& arguments);
 void ProcessFile(const ea::string& fileName, const ea::string& rootDir);
 void WritePackageFile(const ea::string& fileName, const ea::string& rootDir);
+void WriteIndexedPackageFile(const ea::string& fileName, const ea::string& rootDir);
 void WriteHeader(File& dest);
 
 int main(int argc, char** argv)
@@ -97,6 +104,10 @@ void Run(const ea::vector<ea::string>& arguments)
             "\n"
             "Options:\n"
             "-c      Enable package file LZ4 compression\n"
+            "-f      Use fast LZ4 instead of LZ4 high compression, implies -c\n"
+            "-d      Train a compression dictionary from the files and compress with it, implies -c\n"
+            "-a <n>  Align file data to n bytes (power of two, default 16)\n"
+            "-o      Write the original package format without index, codecs or alignment\n"
             "-q      Enable quiet mode\n"
             "\n"
             "Basepath is an optional prefix that will be added to the file entries.\n\n"
@@ -125,6 +136,22 @@ void Run(const ea::vector<ea::string>& arguments)
                     case 'c':
                         compress_ = true;
                         break;
+                    case 'f':
+                        compress_ = true;
+                        fastCompress_ = true;
+                        break;
+                    case 'd':
+                        compress_ = true;
+                        useDictionary_ = true;
+                        break;
+                    case 'a':
+                        if (i + 1 >= arguments.size() || !ToUInt(arguments[i + 1]) || !IsPowerOfTwo(ToUInt(arguments[i + 1])))
+                            ErrorExit("Alignment must be a power of two");
+                        alignment_ = ToUInt(arguments[++i]);
+                        break;
+                    case 'o':
+                        legacyFormat_ = true;
+                        break;
                     case 'q':
                         quiet_ = true;
                         break;
@@ -192,7 +219,10 @@ void Run(const ea::vector<ea::string>& arguments)
         for (unsigned i = 0; i < fileNames.size(); ++i)
             ProcessFile(fileNames[i], dirName);
 
-        WritePackageFile(packageName, dirName);
+        if (legacyFormat_)
+            WritePackageFile(packageName, dirName);
+        else
+            WriteIndexedPackageFile(packageName, dirName);
     }
     else
     {
@@ -206,6 +236,9 @@ void Run(const ea::vector<ea::string>& arguments)
             PrintLine("Package size: " + ea::to_string(packageFile->GetTotalSize()));
             PrintLine("Checksum: " + ea::to_string(packageFile->GetChecksum()));
             PrintLine("Compressed: " + ea::string(packageFile->IsCompressed() ? "yes" : "no"));
+            PrintLine("Version: " + ea::to_string(packageFile->GetVersion()));
+            PrintLine("Alignment: " + ea::to_string(packageFile->GetAlignment()));
+            PrintLine("Dictionary size: " + ea::to_string(packageFile->GetDictionary() ? packageFile->GetDictionary()->size() : 0));
             break;
         case 'L':
             if (!packageFile->IsCompressed())
@@ -221,9 +254,13 @@ void Run(const ea::vector<ea::string>& arguments)
                     ea::string fileEntry(current->first);
                     if (outputCompressionRatio)
                     {
-                        unsigned compressedSize =
-                            (i == entries.end() ? packageFile->GetTotalSize() - sizeof(unsigned) : i->second.offset_) -
-                            current->second.offset_;
+                        // Indexed packages store the compressed size, otherwise assume entries are stored back to back
+                        unsigned compressedSize = current->second.packedSize_;
+                        if (!packageFile->GetVersion())
+                        {
+                            compressedSize = (i == entries.end() ? packageFile->GetTotalSize() - sizeof(unsigned) : i->second.offset_) -
+                                current->second.offset_;
+                        }
                         fileEntry.append_sprintf("\tin: %u\tout: %u\tratio: %f", current->second.size_, compressedSize,
                             compressedSize ? 1.f * current->second.size_ / compressedSize : 0.f);
                     }
@@ -366,6 +403,82 @@ void WritePackageFile(const ea::string& fileName, const ea::string& rootDir)
     }
 }
 
+void WriteIndexedPackageFile(const ea::string& fileName, const ea::string& rootDir)
+{
+    if (!quiet_)
+        PrintLine("Writing package");
+
+    SharedPtr<PackageBuilder> builder(new PackageBuilder(context_));
+    if (!builder->Open(fileName))
+        ErrorExit("Could not open output file " + fileName);
+    builder->SetAlignment(alignment_);
+
+    const PackageCodec preferredCodec = !compress_ ? PACKAGE_CODEC_STORE : fastCompress_ ? PACKAGE_CODEC_LZ4 :
+        useDictionary_ ? PACKAGE_CODEC_LZ4HC_DICT : PACKAGE_CODEC_LZ4HC;
+
+    if (useDictionary_)
+    {
+        // Train the dictionary from the beginning of each compressible file
+        static const unsigned DICTIONARY_SAMPLE_SIZE = 16384;
+        ea::vector<ea::vector<unsigned char> > samples;
+        for (const FileEntry& entry : entries_)
+        {
+            if (PackageBuilder::SelectCodec(entry.name_, preferredCodec) == PACKAGE_CODEC_STORE)
+                continue;
+
+            File srcFile(context_, rootDir + "/" + entry.name_);
+            ea::vector<unsigned char> sample(Min(entry.size_, DICTIONARY_SAMPLE_SIZE));
+            if (srcFile.Read(sample.data(), sample.size()) == sample.size())
+                samples.push_back(ea::move(sample));
+        }
+
+        ea::vector<unsigned char> dictionary = PackageBuilder::TrainDictionary(samples);
+        builder->SetDictionary(dictionary);
+        if (!quiet_)
+            PrintLine("Dictionary size " + ea::to_string(dictionary.size()));
+    }
+
+    for (const FileEntry& entry : entries_)
+    {
+        ea::string fileFullPath = rootDir + "/" + entry.name_;
+        File srcFile(context_, fileFullPath);
+        if (!srcFile.IsOpen())
+            ErrorExit("Could not open file " + fileFullPath);
+
+        ea::vector<unsigned char> buffer(entry.size_);
+        if (srcFile.Read(buffer.data(), entry.size_) != entry.size_)
+            ErrorExit("Could not read file " + fileFullPath);
+
+        if (!builder->Append(basePath_ + entry.name_, buffer.data(), buffer.size(),
+            PackageBuilder::SelectCodec(entry.name_, preferredCodec)))
+            ErrorExit("Could not write file " + entry.name_);
+
+        if (!quiet_)
+        {
+            const PackageEntry& written = builder->GetIndex().back().entry_;
+            ea::string fileEntry(entry.name_);
+            fileEntry.append_sprintf("\tin: %u\tout: %u\tratio: %f", written.size_, written.packedSize_,
+                written.packedSize_ ? 1.f * written.size_ / written.packedSize_ : 0.f);
+            PrintLine(fileEntry);
+        }
+    }
+
+    const unsigned numFiles = builder->GetNumFiles();
+    const unsigned totalDataSize = builder->GetTotalDataSize();
+    const unsigned checksum = builder->GetChecksum();
+    if (!builder->Close())
+        ErrorExit("Could not finish package " + fileName);
+
+    if (!quiet_)
+    {
+        PrintLine("Number of files: " + ea::to_string(numFiles));
+        PrintLine("File data size: " + ea::to_string(totalDataSize));
+        PrintLine("Package size: " + ea::to_string(File(context_, fileName).GetSize()));
+        PrintLine("Checksum: " + ea::to_string(checksum));
+        PrintLine("Compressed: " + ea::string(compress_ ? "yes" : "no"));
+    }
+}
+
 void WriteHeader(File& dest)
 {
     if (!compress_)
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2017-2019 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Command line utility always uses console.
+#define URHO3D_WIN32_CONSOLE
+
+#include <Urho3D/Core/CommandLine.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Application.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SmoothedTransform.h>
+#include <Urho3D/Scene/SplinePath.h>
+
+
+using namespace Urho3D;
+
+/// Measures sequential and parallel loading of a generated scene in binary, XML and JSON formats.
+class BenchmarkApplication : public Application
+{
+    URHO3D_OBJECT(BenchmarkApplication, Application);
+public:
+    explicit BenchmarkApplication(Context* context) : Application(context)
+    {
+    }
+
+    void Setup() override
+    {
+        engineParameters_[EP_ENGINE_CLI_PARAMETERS] = false;
+        engineParameters_[EP_SOUND] = false;
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_LEVEL] = LOG_WARNING;
+
+        auto& app = GetCommandLineParser();
+        app.add_option("-n,--nodes", numNodes_, "Number of nodes in the generated scene.")->set_default_str("500000");
+        app.add_option("-f,--formats", formats_, "Comma-separated list of formats to load (binary, xml, json).")->set_default_str("binary,xml,json");
+    }
+
+    void Start() override
+    {
+        PrintLine(Format("Generating scene with {} nodes, {} worker threads", numNodes_, GetSubsystem<WorkQueue>()->GetNumThreads()));
+        SharedPtr<Scene> scene = GenerateScene();
+
+        for (const ea::string& format : formats_.split(','))
+        {
+            VectorBuffer data;
+            if (format == "binary")
+                scene->Save(data);
+            else if (format == "xml")
+                scene->SaveXML(data);
+            else if (format == "json")
+                scene->SaveJSON(data);
+            else
+            {
+                PrintLine(Format("Unknown format '{}'.", format), true);
+                continue;
+            }
+
+            VectorBuffer results[2];
+            long long times[2];
+            for (unsigned parallel = 0; parallel < 2; ++parallel)
+            {
+                SharedPtr<Scene> loaded(new Scene(context_));
+                loaded->SetParallelLoading(parallel != 0);
+
+                MemoryBuffer source(data.GetData(), data.GetSize());
+                HiresTimer timer;
+                bool success;
+                if (format == "binary")
+                    success = loaded->Load(source);
+                else if (format == "xml")
+                    success = loaded->LoadXML(source);
+                else
+                    success = loaded->LoadJSON(source);
+                times[parallel] = timer.GetUSec(false);
+
+                if (!success)
+                    PrintLine(Format("Loading {} scene failed.", format), true);
+                loaded->Save(results[parallel]);
+            }
+
+            const bool identical = results[0].GetBuffer() == results[1].GetBuffer();
+            PrintLine(Format("{}: {} bytes, sequential {:.1f} ms, parallel {:.1f} ms, results {}", format, data.GetSize(),
+                times[0] / 1000.0, times[1] / 1000.0, identical ? "identical" : "DIFFERENT"));
+        }
+
+        engine_->Exit();
+    }
+
+    /// Generate a scene with nodes at varying depths, a single large subtree and some components referring to other nodes.
+    SharedPtr<Scene> GenerateScene()
+    {
+        SharedPtr<Scene> scene(new Scene(context_));
+        ea::vector<Node*> nodes;
+        nodes.push_back(scene->CreateChild("Large"));
+
+        SetRandomSeed(1);
+        for (unsigned i = 1; i < numNodes_; ++i)
+        {
+            Node* parent = i % 64 == 0 ? scene.Get() : nodes[RandomIndex(nodes.size())];
+            Node* node = parent->CreateChild(Format("Node{}", i), i % 3 ? REPLICATED : LOCAL);
+            node->SetPosition(Vector3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f)));
+            node->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+            if (i % 5 == 0)
+                node->AddTag(Format("Tag{}", i % 4));
+            if (i % 7 == 0)
+                node->SetVar("Value", (int)i);
+            if (i % 4 == 0)
+                node->CreateComponent<SmoothedTransform>();
+            if (i % 11 == 0)
+            {
+                auto* spline = node->CreateComponent<SplinePath>();
+                spline->AddControlPoint(nodes[RandomIndex(nodes.size())]);
+                spline->AddControlPoint(nodes[RandomIndex(nodes.size())]);
+                spline->SetSpeed(Random(1.0f, 5.0f));
+            }
+            nodes.push_back(node);
+        }
+
+        return scene;
+    }
+
+    /// Return a random index large enough for the whole scene.
+    static unsigned RandomIndex(unsigned size) { return (((unsigned)Rand() << 15u) | (unsigned)Rand()) % size; }
+
+    unsigned numNodes_{500000};
+    ea::string formats_{"binary,xml,json"};
+};
+
+URHO3D_DEFINE_APPLICATION_MAIN(BenchmarkApplication);
@@ -24,6 +24,7 @@
 #define URHO3D_WIN32_CONSOLE
 
 #include <Urho3D/Core/CommandLine.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Engine/Application.h>
 #include <Urho3D/Engine/EngineDefs.h>
 #include <Urho3D/IO/FileSystem.h>
@@ -35,6 +36,8 @@
 #include <Urho3D/Resource/JSONFile.h>
 #include <Urho3D/Resource/XMLArchive.h>
 #include <Urho3D/Resource/JSONArchive.h>
+#include <Urho3D/Resource/JSONStreamArchive.h>
+#include <Urho3D/Resource/XMLStreamArchive.h>
 #include <Urho3D/Scene/Serializable.h>
 #include <Urho3D/Scene/Scene.h>
 #include <Urho3D/UI/UIElement.h>
@@ -59,10 +62,11 @@ public:
 
         auto& app = GetCommandLineParser();
         app.add_option("-t,--type", type_, "Name of type that handles serialization of specified files.")->required();
-        app.add_option("-i,--input-type", inputType_, "Serialization format of input file.")->set_default_str("old");
+        app.add_option("-i,--input-type", inputType_, "Serialization format of input file: old, new or stream. Stream reads xml/json archives without building a document tree.")->set_default_str("old");
         app.add_option("-o,--output-type", outputType_, "Serialization format of output file.")-> set_default_str("new");
         app.add_option("input", input_, "Input file (xml/json/binary).")->required();
         app.add_option("output", output_, "Output file (xml/json/binary).")->required();
+        app.add_option("-b,--benchmark", benchmarkIterations_, "Number of iterations of xml/json archive reading throughput benchmark.");
     }
 
     void Start() override
@@ -79,7 +83,27 @@ public:
         bool loaded = false, read = false, saved = false;
         do
         {
-            if (GetExtension(input_) == ".xml")
+            if (GetExtension(input_) == ".xml" && inputType_ == "stream")
+            {
+                File file(context_);
+
+                if (!(read = file.Open(input_)))
+                    break;
+
+                XMLStreamInputArchive archive(context_, file);
+                loaded = converter->Serialize(archive);
+            }
+            else if (GetExtension(input_) == ".json" && inputType_ == "stream")
+            {
+                File file(context_);
+
+                if (!(read = file.Open(input_)))
+                    break;
+
+                JSONStreamInputArchive archive(context_, file);
+                loaded = converter->Serialize(archive);
+            }
+            else if (GetExtension(input_) == ".xml")
             {
                 XMLFile file(context_);
 
@@ -118,7 +142,7 @@ public:
 
                 if (inputType_ == "old")
                     loaded = converter->Load(file);
-                else if (inputType_ == "new")
+                else if (inputType_ == "new" || inputType_ == "stream")
                 {
                     BinaryInputArchive archive(context_, file);
                     loaded = converter->Serialize(archive);
@@ -161,7 +185,8 @@ public:
                 {
                     XMLFile file(context_);
                     XMLOutputArchive archive(&file);
-                    saved = converter->Serialize(archive);
+                    if ((saved = converter->Serialize(archive)))
+                        saved = file.SaveFile(output_);
                 }
             }
             else if (GetExtension(output_) == ".json")
@@ -202,14 +227,85 @@ public:
         else
             PrintLine("Conversion succeeded.");
 
+        if (saved && benchmarkIterations_ > 0)
+            RunBenchmark();
+
         engine_->Exit();
     }
 
+    /// Compare the throughput of reading the input file with tree-based and streaming archives.
+    void RunBenchmark()
+    {
+        const ea::string extension = GetExtension(input_);
+        if (extension != ".xml" && extension != ".json")
+        {
+            PrintLine("Benchmark is supported for xml/json input only.", true);
+            return;
+        }
+
+        File file(context_, input_);
+        const ea::string text = file.ReadText();
+        const double megabytes = text.size() * benchmarkIterations_ / (1024.0 * 1024.0);
+
+        HiresTimer timer;
+        HiresTimer parseTimer;
+        long long parseUSec = 0;
+        bool treeLoaded = true;
+        for (unsigned i = 0; i < benchmarkIterations_; ++i)
+        {
+            SharedPtr<Serializable> object = StaticCast<Serializable>(context_->CreateObject(type_));
+            if (extension == ".xml")
+            {
+                XMLFile xmlFile(context_);
+                parseTimer.Reset();
+                treeLoaded &= xmlFile.FromString(text);
+                parseUSec += parseTimer.GetUSec(false);
+                XMLInputArchive archive(&xmlFile);
+                treeLoaded &= object->Serialize(archive);
+            }
+            else
+            {
+                JSONFile jsonFile(context_);
+                parseTimer.Reset();
+                treeLoaded &= jsonFile.FromString(text);
+                parseUSec += parseTimer.GetUSec(false);
+                JSONInputArchive archive(&jsonFile);
+                treeLoaded &= object->Serialize(archive);
+            }
+        }
+        const double treeSeconds = timer.GetUSec(true) / 1000000.0;
+
+        bool streamLoaded = true;
+        for (unsigned i = 0; i < benchmarkIterations_; ++i)
+        {
+            SharedPtr<Serializable> object = StaticCast<Serializable>(context_->CreateObject(type_));
+            if (extension == ".xml")
+            {
+                XMLStreamInputArchive archive(context_, text);
+                streamLoaded &= object->Serialize(archive);
+            }
+            else
+            {
+                JSONStreamInputArchive archive(context_, text);
+                streamLoaded &= object->Serialize(archive);
+            }
+        }
+        const double streamSeconds = timer.GetUSec(true) / 1000000.0;
+
+        if (!treeLoaded || !streamLoaded)
+            PrintLine("Benchmark loading failed.", true);
+
+        PrintLine(Format("Tree archive: {:.3f} s including {:.3f} s of document parsing, {:.2f} MB/s",
+            treeSeconds, parseUSec / 1000000.0, megabytes / treeSeconds));
+        PrintLine(Format("Stream archive: {:.3f} s, {:.2f} MB/s", streamSeconds, megabytes / streamSeconds));
+    }
+
     ea::string type_;
     ea::string inputType_{"old"};
     ea::string outputType_{"new"};
     ea::string input_;
     ea::string output_;
+    unsigned benchmarkIterations_{};
 };
 
 URHO3D_DEFINE_APPLICATION_MAIN(ConverterApplication);
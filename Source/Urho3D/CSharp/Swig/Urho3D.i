@@ -275,6 +275,8 @@ namespace SDL
 
 %ignore Urho3D::Detail::CriticalSection;
 %ignore Urho3D::MutexLock;
+%ignore Urho3D::SharedMutex;
+%ignore Urho3D::SharedMutexLock;
 %include "Urho3D/Core/Variant.h"
 %include "Object.i"
 %director Urho3D::AttributeAccessor;
@@ -330,6 +332,9 @@ namespace SDL
 %ignore Urho3D::GetWideNativePath;
 %ignore Urho3D::logLevelNames;
 %ignore Urho3D::LOG_LEVEL_COLORS;
+// Asynchronous reads complete through native callbacks from I/O threads.
+%ignore Urho3D::File::ReadAsync;
+%ignore Urho3D::PackageFile::ReadAsync;
 
 %extend Urho3D::Log {
 public:
@@ -394,7 +399,6 @@ public:
 
 // These expose iterators of underlying collection. Iterate object through GetObject() instead.
 %ignore Urho3D::BackgroundLoadItem;
-%ignore Urho3D::BackgroundLoader::ThreadFunction;
 %rename(GetValueType) Urho3D::PListValue::GetType;
 
 %include "Urho3D/Resource/Resource.h"
@@ -408,6 +412,7 @@ public:
 %include "Urho3D/Resource/PListFile.h"
 %include "Urho3D/Resource/XMLElement.h"
 %include "Urho3D/Resource/XMLFile.h"
+%ignore Urho3D::ResourceCache::RequestResource;
 %include "Urho3D/Resource/ResourceCache.h"
 
 // --------------------------------------- Scene ---------------------------------------
@@ -419,6 +424,8 @@ public:
 %ignore Urho3D::Animatable::animatedNetworkAttributes_; // Needs HashSet wrapped
 %ignore Urho3D::AsyncProgress::resources_;
 %ignore Urho3D::ValueAnimation::GetKeyFrames;
+%ignore Urho3D::ValueAnimation::GetPackedKeyFrames;
+%ignore Urho3D::VAnimPackedKeyFrames;
 %ignore Urho3D::Serializable::networkState_;
 %ignore Urho3D::Serializable::instanceDefaultValues_;
 %ignore Urho3D::ReplicationState::connection_;
@@ -430,6 +437,13 @@ public:
 %ignore Urho3D::Node::SetEntity;
 %ignore Urho3D::Scene::GetRegistry;
 %ignore Urho3D::Scene::GetComponentIndex;
+%ignore Urho3D::Scene::GetComponentView;
+%ignore Urho3D::Scene::GetNodesWithVar;
+%ignore Urho3D::Scene::GetNodesWithTag(StringHash) const;
+%ignore Urho3D::SceneComponentView;
+%ignore Urho3D::Scene::GetDataComponentTypes;
+%ignore Urho3D::Scene::GetDataComponentType;
+%ignore Urho3D::Scene::GetAttributeAnimationSystem;
 
 %include "Urho3D/Scene/AnimationDefs.h"
 %include "Urho3D/Scene/ValueAnimationInfo.h"
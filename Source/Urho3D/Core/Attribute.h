@@ -68,8 +68,83 @@ public:
     virtual void Get(const Serializable* ptr, Variant& dest) const = 0;
     /// Set the attribute.
     virtual void Set(Serializable* ptr, const Variant& src) = 0;
+#ifndef SWIG
+    /// Return variant type of the raw data accepted by GetRaw() and SetRaw(), or VAR_NONE if the attribute can only be accessed through Variant.
+    virtual VariantType GetRawType() const { return VAR_NONE; }
+    /// Get the attribute as raw data of the raw type.
+    virtual void GetRaw(const Serializable* ptr, void* dest) const { }
+    /// Set the attribute from raw data of the raw type.
+    virtual void SetRaw(Serializable* ptr, const void* src) { }
+#endif
 };
 
+/// Return size of an attribute value of the given type when accessed as raw data, bypassing Variant. Return 0 if the type can only be accessed through Variant.
+inline unsigned GetRawAttributeSize(VariantType type)
+{
+    switch (type)
+    {
+    case VAR_INT: return sizeof(int);
+    case VAR_BOOL: return sizeof(bool);
+    case VAR_FLOAT: return sizeof(float);
+    case VAR_VECTOR2: return sizeof(Vector2);
+    case VAR_VECTOR3: return sizeof(Vector3);
+    case VAR_VECTOR4: return sizeof(Vector4);
+    case VAR_QUATERNION: return sizeof(Quaternion);
+    case VAR_COLOR: return sizeof(Color);
+    case VAR_INTRECT: return sizeof(IntRect);
+    case VAR_INTVECTOR2: return sizeof(IntVector2);
+    case VAR_MATRIX3: return sizeof(Matrix3);
+    case VAR_MATRIX3X4: return sizeof(Matrix3x4);
+    case VAR_MATRIX4: return sizeof(Matrix4);
+    case VAR_DOUBLE: return sizeof(double);
+    case VAR_RECT: return sizeof(Rect);
+    case VAR_INTVECTOR3: return sizeof(IntVector3);
+    case VAR_INT64: return sizeof(long long);
+    default: return 0;
+    }
+}
+
+/// Return variant type for raw attribute access to values of a C++ type, or VAR_NONE if the type can only be accessed through Variant.
+template <typename T> VariantType GetRawAttributeType() { return VAR_NONE; }
+/// Return variant type for raw attribute access to int values.
+template <> inline VariantType GetRawAttributeType<int>() { return VAR_INT; }
+/// Return variant type for raw attribute access to unsigned values.
+template <> inline VariantType GetRawAttributeType<unsigned>() { return VAR_INT; }
+/// Return variant type for raw attribute access to long long values.
+template <> inline VariantType GetRawAttributeType<long long>() { return VAR_INT64; }
+/// Return variant type for raw attribute access to unsigned long long values.
+template <> inline VariantType GetRawAttributeType<unsigned long long>() { return VAR_INT64; }
+/// Return variant type for raw attribute access to bool values.
+template <> inline VariantType GetRawAttributeType<bool>() { return VAR_BOOL; }
+/// Return variant type for raw attribute access to float values.
+template <> inline VariantType GetRawAttributeType<float>() { return VAR_FLOAT; }
+/// Return variant type for raw attribute access to double values.
+template <> inline VariantType GetRawAttributeType<double>() { return VAR_DOUBLE; }
+/// Return variant type for raw attribute access to Vector2 values.
+template <> inline VariantType GetRawAttributeType<Vector2>() { return VAR_VECTOR2; }
+/// Return variant type for raw attribute access to Vector3 values.
+template <> inline VariantType GetRawAttributeType<Vector3>() { return VAR_VECTOR3; }
+/// Return variant type for raw attribute access to Vector4 values.
+template <> inline VariantType GetRawAttributeType<Vector4>() { return VAR_VECTOR4; }
+/// Return variant type for raw attribute access to Quaternion values.
+template <> inline VariantType GetRawAttributeType<Quaternion>() { return VAR_QUATERNION; }
+/// Return variant type for raw attribute access to Color values.
+template <> inline VariantType GetRawAttributeType<Color>() { return VAR_COLOR; }
+/// Return variant type for raw attribute access to Rect values.
+template <> inline VariantType GetRawAttributeType<Rect>() { return VAR_RECT; }
+/// Return variant type for raw attribute access to IntRect values.
+template <> inline VariantType GetRawAttributeType<IntRect>() { return VAR_INTRECT; }
+/// Return variant type for raw attribute access to IntVector2 values.
+template <> inline VariantType GetRawAttributeType<IntVector2>() { return VAR_INTVECTOR2; }
+/// Return variant type for raw attribute access to IntVector3 values.
+template <> inline VariantType GetRawAttributeType<IntVector3>() { return VAR_INTVECTOR3; }
+/// Return variant type for raw attribute access to Matrix3 values.
+template <> inline VariantType GetRawAttributeType<Matrix3>() { return VAR_MATRIX3; }
+/// Return variant type for raw attribute access to Matrix3x4 values.
+template <> inline VariantType GetRawAttributeType<Matrix3x4>() { return VAR_MATRIX3X4; }
+/// Return variant type for raw attribute access to Matrix4 values.
+template <> inline VariantType GetRawAttributeType<Matrix4>() { return VAR_MATRIX4; }
+
 /// Description of an automatically serializable variable.
 struct AttributeInfo
 {
@@ -27,6 +27,7 @@
 #else
 #   include <mutex>
 #endif
+#include <shared_mutex>
 
 #include <Urho3D/Urho3D.h>
 #include "../Core/NonCopyable.h"
@@ -77,6 +78,26 @@ private:
     MutexType lock_;
 };
 
+/// Operating system mutual exclusion primitive that allows concurrent shared access for readers. Not recursive.
+class URHO3D_API SharedMutex
+{
+public:
+    /// Acquire exclusive access. Block if any access is held.
+    void Acquire() { lock_.lock(); }
+    /// Try to acquire exclusive access without locking. Return true if successful.
+    bool TryAcquire() { return lock_.try_lock(); }
+    /// Release exclusive access.
+    void Release() { lock_.unlock(); }
+    /// Acquire shared access. Block if exclusive access is held.
+    void AcquireShared() { lock_.lock_shared(); }
+    /// Release shared access.
+    void ReleaseShared() { lock_.unlock_shared(); }
+
+private:
+    /// Underlying mutex object.
+    std::shared_mutex lock_;
+};
+
 #if URHO3D_PROFILING
 class URHO3D_API ProfiledMutex
 {
@@ -114,4 +135,19 @@ private:
     Mutex& mutex_;
 };
 
+/// Lock that automatically acquires and releases shared access to a mutex.
+template<typename Mutex>
+class SharedMutexLock : private NonCopyable
+{
+public:
+    /// Construct and acquire shared access.
+    explicit SharedMutexLock(Mutex& mutex) : mutex_(mutex) { mutex_.AcquireShared(); }
+    /// Destruct. Release shared access.
+    ~SharedMutexLock() { mutex_.ReleaseShared(); }
+
+private:
+    /// Mutex reference.
+    Mutex& mutex_;
+};
+
 }
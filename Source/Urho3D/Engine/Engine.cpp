@@ -38,7 +38,9 @@
 #include "../Engine/EngineDefs.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Input/Input.h"
+#include "../IO/AsyncIO.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/PackageFile.h"
@@ -126,6 +128,7 @@ Engine::Engine(Context* context) :
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
     context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new AsyncIO(context_));
 #ifdef URHO3D_LOGGING
     context_->RegisterSubsystem(new Log(context_));
 #endif
@@ -182,6 +185,7 @@ bool Engine::Initialize(const VariantMap& parameters)
     // Register the rest of the subsystems
     context_->RegisterSubsystem(new Input(context_));
     context_->RegisterSubsystem(new Audio(context_));
+    context_->RegisterSubsystem(new TextureStreamer(context_));
     if (!headless_)
     {
         context_->RegisterSubsystem(new Graphics(context_));
@@ -290,6 +294,11 @@ bool Engine::Initialize(const VariantMap& parameters)
         }
     }
 
+    // Texture streaming budget is given in megabytes. In headless mode the streamed levels are tracked without GPU uploads
+    auto* textureStreamer = GetSubsystem<TextureStreamer>();
+    textureStreamer->SetEnabled(GetParameter(parameters, EP_TEXTURE_STREAMING, false).GetBool());
+    textureStreamer->SetMemoryBudget((unsigned long long)GetParameter(parameters, EP_TEXTURE_STREAMING_BUDGET, 512).GetInt() << 20u);
+
     // Init FPU state of main thread
     InitFPU();
 
@@ -345,6 +354,9 @@ bool Engine::InitializeResourceCache(const VariantMap& parameters, bool removeOl
             cache->RemovePackageFile(packageFiles[i].Get());
     }
 
+    // Memory map packages before they are added so that resource files read straight from the mapping
+    cache->SetMapPackages(GetParameter(parameters, EP_MAP_RESOURCE_PACKAGES, false).GetBool());
+
     // Add resource paths
     ea::vector<ea::string> resourcePrefixPaths = GetParameter(parameters, EP_RESOURCE_PREFIX_PATHS,
         EMPTY_STRING).GetString().split(';', true);
@@ -933,6 +945,7 @@ void Engine::DefineParameters(CLI::App& commandLine, VariantMap& engineParameter
     addOptionString("--pp,--prefix-paths", EP_RESOURCE_PREFIX_PATHS, "Resource prefix paths")->envname("URHO3D_PREFIX_PATH")->set_custom_option("path1;path2;...");
     addOptionString("--pr,--resource-paths", EP_RESOURCE_PATHS, "Resource paths")->set_custom_option("path1;path2;...");
     addOptionString("--pf,--resource-packages", EP_RESOURCE_PACKAGES, "Resource packages")->set_custom_option("path1;path2;...");
+    addFlag("--mmap", EP_MAP_RESOURCE_PACKAGES, true, "Memory map resource packages");
     addOptionString("--ap,--autoload-paths", EP_AUTOLOAD_PATHS, "Resource autoload paths")->set_custom_option("path1;path2;...");
     addOptionString("--ds,--dump-shaders", EP_DUMP_SHADERS, "Dump shaders")->set_custom_option("filename");
     addFlagInternal("--mq,--material-quality", "Material quality", [&](CLI::results_t res) {
@@ -44,6 +44,7 @@ static const ea::string EP_LOG_LEVEL = "LogLevel";
 static const ea::string EP_LOG_NAME = "LogName";
 static const ea::string EP_LOG_QUIET = "LogQuiet";
 static const ea::string EP_LOW_QUALITY_SHADOWS = "LowQualityShadows";
+static const ea::string EP_MAP_RESOURCE_PACKAGES = "MapResourcePackages";
 static const ea::string EP_MATERIAL_QUALITY = "MaterialQuality";
 static const ea::string EP_MONITOR = "Monitor";
 static const ea::string EP_MULTI_SAMPLE = "MultiSample";
@@ -66,6 +67,8 @@ static const ea::string EP_SOUND_STEREO = "SoundStereo";
 static const ea::string EP_TEXTURE_ANISOTROPY = "TextureAnisotropy";
 static const ea::string EP_TEXTURE_FILTER_MODE = "TextureFilterMode";
 static const ea::string EP_TEXTURE_QUALITY = "TextureQuality";
+static const ea::string EP_TEXTURE_STREAMING = "TextureStreaming";
+static const ea::string EP_TEXTURE_STREAMING_BUDGET = "TextureStreamingBudget";
 static const ea::string EP_TIME_OUT = "TimeOut";
 static const ea::string EP_TOUCH_EMULATION = "TouchEmulation";
 static const ea::string EP_TRIPLE_BUFFER = "TripleBuffer";
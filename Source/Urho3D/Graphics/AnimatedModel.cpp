@@ -38,6 +38,7 @@
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Octree.h"
+#include "../Graphics/Skinning.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
@@ -62,6 +63,14 @@ static const StringVector animationStatesStructureElementNames =
     "   Layer"
 };
 
+static const StringVector animationLodLevelsStructureElementNames =
+{
+    "LOD Level Count",
+    "   Screen Size",
+    "   Update Interval",
+    "   Max Bone Depth"
+};
+
 static bool CompareAnimationOrder(const SharedPtr<AnimationState>& lhs, const SharedPtr<AnimationState>& rhs)
 {
     return lhs->GetLayer() < rhs->GetLayer();
@@ -125,6 +134,9 @@ void AnimatedModel::RegisterObject(Context* context)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, animationStatesStructureElementNames);
     URHO3D_ACCESSOR_ATTRIBUTE("Morphs", GetMorphsAttr, SetMorphsAttr, ea::vector<unsigned char>, Variant::emptyBuffer,
         AM_DEFAULT | AM_NOEDIT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Animation LOD Levels", GetAnimationLodLevelsAttr, SetAnimationLodLevelsAttr, VariantVector,
+        Variant::emptyVariantVector, AM_DEFAULT)
+        .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, animationLodLevelsStructureElementNames);
 }
 
 bool AnimatedModel::Load(Deserializer& source)
@@ -240,6 +252,7 @@ void AnimatedModel::Update(const FrameInfo& frame)
             if (animationDirty_)
             {
                 animationLodTimer_ = -1.0f;
+                animationLodFramesLeft_ = 0;
                 forceAnimationUpdate_ = true;
             }
             return;
@@ -250,6 +263,8 @@ void AnimatedModel::Update(const FrameInfo& frame)
             return;
         float scale = GetWorldBoundingBox().Size().DotProduct(DOT_SCALE);
         animationLodDistance_ = frame.camera_->GetLodDistance(distance, scale, lodBias_);
+        // Use the coarsest screen size based animation LOD level when not visible
+        animationScreenSize_ = 0.0f;
     }
 
     if (animationDirty_ || animationOrderDirty_)
@@ -280,14 +295,27 @@ void AnimatedModel::UpdateBatches(const FrameInfo& frame)
     float scale = transformedBoundingBox.Size().DotProduct(DOT_SCALE);
     float newLodDistance = frame.camera_->GetLodDistance(distance_, scale, lodBias_);
 
-    // If model is rendered from several views, use the minimum LOD distance for animation LOD
+    // Calculate screen size as a fraction of the view height for the screen size based animation LOD
+    float newScreenSize = 0.0f;
+    if (!animationLodLevels_.empty())
+    {
+        const float viewExtent = frame.camera_->GetHalfViewSize() * (frame.camera_->IsOrthographic() ? 1.0f : distance_);
+        const float bias = lodBias_ * frame.camera_->GetLodBias();
+        newScreenSize = viewExtent > M_EPSILON ? transformedBoundingBox.Size().Length() * 0.5f * bias / viewExtent : M_INFINITY;
+    }
+
+    // If model is rendered from several views, use the minimum LOD distance and maximum screen size for animation LOD
     if (frame.frameNumber_ != animationLodFrameNumber_)
     {
         animationLodDistance_ = newLodDistance;
+        animationScreenSize_ = newScreenSize;
         animationLodFrameNumber_ = frame.frameNumber_;
     }
     else
+    {
         animationLodDistance_ = Min(animationLodDistance_, newLodDistance);
+        animationScreenSize_ = Max(animationScreenSize_, newScreenSize);
+    }
 
     if (newLodDistance != lodDistance_)
     {
@@ -544,6 +572,25 @@ void AnimatedModel::SetAnimationLodBias(float bias)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetAnimationLodLevels(const ea::vector<AnimationLodLevel>& levels)
+{
+    animationLodLevels_ = levels;
+    ea::quick_sort(animationLodLevels_.begin(), animationLodLevels_.end(),
+        [](const AnimationLodLevel& lhs, const AnimationLodLevel& rhs) { return lhs.screenSize_ > rhs.screenSize_; });
+    if (animationLodLevels_.size() >= MAX_ANIMATION_LOD_LEVELS)
+        animationLodLevels_.resize(MAX_ANIMATION_LOD_LEVELS - 1);
+    for (AnimationLodLevel& level : animationLodLevels_)
+        level.updateInterval_ = Max(level.updateInterval_, 1U);
+
+    animationLodLevel_ = 0;
+    animationLodFramesLeft_ = 0;
+    animationLodMaskLevel_ = M_MAX_UNSIGNED;
+    animationLodBoneMask_.clear();
+
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
 void AnimatedModel::SetUpdateInvisible(bool enable)
 {
     updateInvisible_ = enable;
@@ -701,6 +748,10 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
         return;
     }
 
+    // The animation LOD bone mask and interpolation refer to bones by index
+    animationLodMaskLevel_ = M_MAX_UNSIGNED;
+    animationLodFramesLeft_ = 0;
+
     if (isMaster_)
     {
         // Check if bone structure has stayed compatible (reloading the model.) In that case retain the old bones and animations
@@ -855,6 +906,31 @@ void AnimatedModel::SetAnimationStatesAttr(const VariantVector& value)
     }
 }
 
+void AnimatedModel::SetAnimationLodLevelsAttr(const VariantVector& value)
+{
+    ea::vector<AnimationLodLevel> levels;
+    unsigned index = 0;
+    unsigned numLevels = index < value.size() ? value[index++].GetUInt() : 0;
+    // Prevent overly large value being assigned from the editor
+    numLevels = Min(numLevels, MAX_ANIMATION_LOD_LEVELS - 1);
+
+    levels.reserve(numLevels);
+    while (numLevels--)
+    {
+        // If not enough data, add a default level
+        AnimationLodLevel level;
+        if (index + 2 < value.size())
+        {
+            level.screenSize_ = value[index++].GetFloat();
+            level.updateInterval_ = value[index++].GetUInt();
+            level.maxBoneDepth_ = value[index++].GetUInt();
+        }
+        levels.push_back(level);
+    }
+
+    SetAnimationLodLevels(levels);
+}
+
 void AnimatedModel::SetMorphsAttr(const ea::vector<unsigned char>& value)
 {
     for (unsigned index = 0; index < value.size(); ++index)
@@ -896,6 +972,20 @@ VariantVector AnimatedModel::GetAnimationStatesAttr() const
     return ret;
 }
 
+VariantVector AnimatedModel::GetAnimationLodLevelsAttr() const
+{
+    VariantVector ret;
+    ret.reserve(animationLodLevels_.size() * 3 + 1);
+    ret.push_back((int)animationLodLevels_.size());
+    for (const AnimationLodLevel& level : animationLodLevels_)
+    {
+        ret.push_back(level.screenSize_);
+        ret.push_back((int)level.updateInterval_);
+        ret.push_back((int)level.maxBoneDepth_);
+    }
+    return ret;
+}
+
 const ea::vector<unsigned char>& AnimatedModel::GetMorphsAttr() const
 {
     attrBuffer_.Clear();
@@ -933,6 +1023,40 @@ void AnimatedModel::UpdateBoneBoundingBox()
     worldBoundingBoxDirty_ = true;
 }
 
+bool AnimatedModel::GetSkinnedVertices(unsigned geometryIndex, unsigned lodLevel, ea::vector<Vector3>& positions,
+    ea::vector<Vector3>* normals)
+{
+    if (!model_ || !node_ || skinMatrices_.empty() || geometryIndex >= model_->GetNumGeometries())
+        return false;
+
+    Geometry* geometry = model_->GetGeometry(geometryIndex, lodLevel);
+    VertexBuffer* buffer = geometry ? geometry->GetVertexBuffer(0) : nullptr;
+    if (!buffer || !buffer->GetShadowData())
+        return false;
+
+    if (!buffer->HasElement(TYPE_VECTOR3, SEM_POSITION) || !buffer->HasElement(TYPE_VECTOR4, SEM_BLENDWEIGHTS) ||
+        !buffer->HasElement(TYPE_UBYTE4, SEM_BLENDINDICES) || (normals && !buffer->HasElement(TYPE_VECTOR3, SEM_NORMAL)))
+        return false;
+
+    if (skinningDirty_)
+        UpdateSkinning();
+
+    // Blend indices refer to the per-geometry matrices when bone mappings are in use
+    const ea::vector<Matrix3x4>& skinMatrices = geometryIndex < geometrySkinMatrices_.size() &&
+        !geometrySkinMatrices_[geometryIndex].empty() ? geometrySkinMatrices_[geometryIndex] : skinMatrices_;
+
+    unsigned vertexCount = buffer->GetVertexCount();
+    positions.resize(vertexCount);
+    if (normals)
+        normals->resize(vertexCount);
+
+    SkinVertices(positions.data(), normals ? normals->data() : nullptr, buffer->GetShadowData(), buffer->GetVertexSize(),
+        vertexCount, buffer->GetElementOffset(SEM_POSITION), buffer->GetElementOffset(SEM_NORMAL),
+        buffer->GetElementOffset(SEM_BLENDWEIGHTS), buffer->GetElementOffset(SEM_BLENDINDICES), skinMatrices.data(),
+        skinMatrices.size());
+    return true;
+}
+
 void AnimatedModel::OnNodeSet(Node* node)
 {
     Drawable::OnNodeSet(node);
@@ -1256,6 +1380,36 @@ void AnimatedModel::SetGeometryBoneMappings()
 
 void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
 {
+    // Screen size based animation LOD replaces the distance based update timer
+    if (!animationLodLevels_.empty())
+    {
+        if (animationLodFramesLeft_)
+        {
+            InterpolateAnimationLod();
+            return;
+        }
+
+        animationLodLevel_ = 0;
+        while (animationLodLevel_ < animationLodLevels_.size() &&
+            animationScreenSize_ < animationLodLevels_[animationLodLevel_].screenSize_)
+            ++animationLodLevel_;
+        if (animationLodLevel_ != animationLodMaskLevel_)
+            UpdateAnimationLodBoneMask();
+
+        if (octant_)
+            octant_->GetRoot()->AddAnimationLodUpdate(animationLodLevel_);
+
+        // Interpolate only from a pose that has already been animated
+        const unsigned interval = animationLodLevel_ ? animationLodLevels_[animationLodLevel_ - 1].updateInterval_ : 1;
+        if (interval > 1 && isMaster_ && animationLodTimer_ >= 0.0f)
+            ApplyAnimationLod(interval);
+        else
+            ApplyAnimation();
+
+        animationLodTimer_ = 0.0f;
+        return;
+    }
+
     // If using animation LOD, accumulate time and see if it is time to update
     if (animationLodBias_ > 0.0f && animationLodDistance_ > 0.0f)
     {
@@ -1303,6 +1457,99 @@ void AnimatedModel::ApplyAnimation()
     animationDirty_ = false;
 }
 
+void AnimatedModel::ApplyAnimationLod(unsigned interval)
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    animationLodPositions_.resize(bones.size());
+    animationLodRotations_.resize(bones.size());
+    animationLodScales_.resize(bones.size());
+
+    // Remember the current pose, then apply the animations to get the pose to interpolate toward
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (!boneNode)
+            continue;
+        animationLodPositions_[i] = boneNode->GetPosition();
+        animationLodRotations_[i] = boneNode->GetRotation();
+        animationLodScales_[i] = boneNode->GetScale();
+    }
+
+    ApplyAnimation();
+
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (!boneNode)
+            continue;
+        const Vector3 position = boneNode->GetPosition();
+        const Quaternion rotation = boneNode->GetRotation();
+        const Vector3 scale = boneNode->GetScale();
+        boneNode->SetTransformSilent(animationLodPositions_[i], animationLodRotations_[i], animationLodScales_[i]);
+        animationLodPositions_[i] = position;
+        animationLodRotations_[i] = rotation;
+        animationLodScales_[i] = scale;
+    }
+
+    animationLodFramesLeft_ = interval;
+    InterpolateAnimationLod();
+}
+
+void AnimatedModel::InterpolateAnimationLod()
+{
+    // Step so that the pose arrives at the target when no frames are left
+    const float t = 1.0f / animationLodFramesLeft_;
+    --animationLodFramesLeft_;
+
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.size() && i < animationLodPositions_.size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        Node* boneNode = bone.node_;
+        if (!boneNode || !bone.animated_)
+            continue;
+        boneNode->SetTransformSilent(boneNode->GetPosition().Lerp(animationLodPositions_[i], t),
+            boneNode->GetRotation().Slerp(animationLodRotations_[i], t), boneNode->GetScale().Lerp(animationLodScales_[i], t));
+    }
+
+    node_->MarkDirty();
+    UpdateBoneBoundingBox();
+}
+
+void AnimatedModel::UpdateAnimationLodBoneMask()
+{
+    animationLodMaskLevel_ = animationLodLevel_;
+    animationLodBoneMask_.clear();
+
+    const unsigned maxDepth = animationLodLevel_ ? animationLodLevels_[animationLodLevel_ - 1].maxBoneDepth_ : 0;
+    if (!maxDepth)
+        return;
+
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    animationLodBoneMask_.resize(bones.size());
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        // Walk up toward the root bone, stopping as soon as the bone is known to be too deep
+        unsigned depth = 0;
+        unsigned index = i;
+        while (depth <= maxDepth && bones[index].parentIndex_ != index && bones[index].parentIndex_ < bones.size())
+        {
+            index = bones[index].parentIndex_;
+            ++depth;
+        }
+        animationLodBoneMask_[i] = depth > maxDepth;
+    }
+}
+
+bool AnimatedModel::IsBoneAnimationLodMasked(const Bone* bone) const
+{
+    if (animationLodBoneMask_.empty())
+        return false;
+
+    const auto index = (unsigned)(bone - skeleton_.GetBones().data());
+    return index < animationLodBoneMask_.size() && animationLodBoneMask_[index];
+}
+
 void AnimatedModel::UpdateSkinning()
 {
     // Note: the model's world transform will be baked in the skin matrices
@@ -1390,47 +1637,11 @@ void AnimatedModel::ApplyMorph(VertexBuffer* buffer, void* destVertexData, unsig
     float weight)
 {
     const VertexMaskFlags elementMask = morph.elementMask_ & buffer->GetElementMask();
-    unsigned vertexCount = morph.vertexCount_;
     unsigned normalOffset = buffer->GetElementOffset(SEM_NORMAL);
     unsigned tangentOffset = buffer->GetElementOffset(SEM_TANGENT);
-    unsigned vertexSize = buffer->GetVertexSize();
 
-    unsigned char* srcData = morph.morphData_.get();
-    auto* destData = (unsigned char*)destVertexData;
-
-    while (vertexCount--)
-    {
-        unsigned vertexIndex = *((unsigned*)srcData) - morphRangeStart;
-        srcData += sizeof(unsigned);
-
-        if (elementMask & MASK_POSITION)
-        {
-            auto* dest = (float*)(destData + vertexIndex * vertexSize);
-            auto* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-        if (elementMask & MASK_NORMAL)
-        {
-            auto* dest = (float*)(destData + vertexIndex * vertexSize + normalOffset);
-            auto* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-        if (elementMask & MASK_TANGENT)
-        {
-            auto* dest = (float*)(destData + vertexIndex * vertexSize + tangentOffset);
-            auto* src = (float*)srcData;
-            dest[0] += src[0] * weight;
-            dest[1] += src[1] * weight;
-            dest[2] += src[2] * weight;
-            srcData += 3 * sizeof(float);
-        }
-    }
+    ApplyMorphDeltas((unsigned char*)destVertexData, buffer->GetVertexSize(), morphRangeStart, morph.morphData_.get(),
+        morph.vertexCount_, elementMask, normalOffset, tangentOffset, weight);
 }
 
 void AnimatedModel::HandleModelReloadFinished(StringHash eventType, VariantMap& eventData)
@@ -32,6 +32,17 @@ namespace Urho3D
 class Animation;
 class AnimationState;
 
+/// Screen size based animation LOD level of an animated model.
+struct AnimationLodLevel
+{
+    /// Screen size as a fraction of the view height, below which the level is used.
+    float screenSize_{};
+    /// Number of frames between bone updates. The pose is interpolated toward the latest update in between, which lags the animation by the interval.
+    unsigned updateInterval_{1};
+    /// Maximum depth of animated bones in the skeleton hierarchy, or zero for no limit. Deeper bones stay in their initial pose.
+    unsigned maxBoneDepth_{};
+};
+
 /// Animated model component.
 class URHO3D_API AnimatedModel : public StaticModel
 {
@@ -55,6 +66,10 @@ public:
     bool LoadJSON(const JSONValue& source) override;
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     void ApplyAttributes() override;
+    /// Suppress bone node creation while attributes are loaded by the scene loaders.
+    void BeginAttributeLoad() override { loading_ = true; }
+    /// Restore bone node creation after attribute loading.
+    void EndAttributeLoad() override { loading_ = false; }
     /// Process octree raycast. May be called from a worker thread.
     void ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results) override;
     /// Update before octree reinsertion. Is called from a worker thread.
@@ -86,6 +101,8 @@ public:
     void RemoveAllAnimationStates();
     /// Set animation LOD bias.
     void SetAnimationLodBias(float bias);
+    /// Set screen size based animation LOD levels, which replace the distance based animation LOD. Levels are sorted by decreasing screen size and at most MAX_ANIMATION_LOD_LEVELS - 1 are used, as level zero is the full animation.
+    void SetAnimationLodLevels(const ea::vector<AnimationLodLevel>& levels);
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     void SetUpdateInvisible(bool enable);
     /// Set vertex morph weight by index.
@@ -120,6 +137,12 @@ public:
     /// Return animation LOD bias.
     float GetAnimationLodBias() const { return animationLodBias_; }
 
+    /// Return screen size based animation LOD levels.
+    const ea::vector<AnimationLodLevel>& GetAnimationLodLevels() const { return animationLodLevels_; }
+
+    /// Return current animation LOD level. Zero is the full animation.
+    unsigned GetAnimationLodLevel() const { return animationLodLevel_; }
+
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
@@ -150,6 +173,8 @@ public:
     void SetAnimationStatesAttr(const VariantVector& value);
     /// Set morphs attribute.
     void SetMorphsAttr(const ea::vector<unsigned char>& value);
+    /// Set animation LOD levels attribute.
+    void SetAnimationLodLevelsAttr(const VariantVector& value);
     /// Return model attribute.
     ResourceRef GetModelAttr() const;
     /// Return bones' animation enabled attribute.
@@ -158,6 +183,8 @@ public:
     VariantVector GetAnimationStatesAttr() const;
     /// Return morphs attribute.
     const ea::vector<unsigned char>& GetMorphsAttr() const;
+    /// Return animation LOD levels attribute.
+    VariantVector GetAnimationLodLevelsAttr() const;
 
     /// Return per-geometry bone mappings.
     const ea::vector<ea::vector<unsigned> >& GetGeometryBoneMappings() const { return geometryBoneMappings_; }
@@ -167,6 +194,9 @@ public:
 
     /// Recalculate the bone bounding box. Normally called internally, but can also be manually called if up-to-date information before rendering is necessary.
     void UpdateBoneBoundingBox();
+    /// Calculate world-space skinned vertex positions and optionally normals of a geometry's first vertex buffer on the CPU, using the current skin matrices. Vertex morphs are not applied. Requires shadowed float positions, blend weights and blend indices. Return true if successful.
+    bool GetSkinnedVertices(unsigned geometryIndex, unsigned lodLevel, ea::vector<Vector3>& positions,
+        ea::vector<Vector3>* normals = nullptr);
 
 protected:
     /// Handle node being assigned.
@@ -199,6 +229,14 @@ private:
     void CopyMorphVertices(void* destVertexData, void* srcVertexData, unsigned vertexCount, VertexBuffer* destBuffer, VertexBuffer* srcBuffer);
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Apply animations at an animation LOD level that updates every interval frames, and start interpolating toward the new pose.
+    void ApplyAnimationLod(unsigned interval);
+    /// Step the bones toward the pose of the last animation LOD update.
+    void InterpolateAnimationLod();
+    /// Recalculate the bone mask of the current animation LOD level.
+    void UpdateAnimationLodBoneMask();
+    /// Return whether a bone is excluded by the current animation LOD level.
+    bool IsBoneAnimationLodMasked(const Bone* bone) const;
     /// Recalculate skinning.
     void UpdateSkinning();
     /// Reapply all vertex morphs.
@@ -239,6 +277,24 @@ private:
     float animationLodTimer_;
     /// Animation LOD distance, the minimum of all LOD view distances last frame.
     float animationLodDistance_;
+    /// Screen size based animation LOD levels.
+    ea::vector<AnimationLodLevel> animationLodLevels_;
+    /// Animation screen size, the maximum of all view screen sizes last frame. Infinite until measured by a view, so that headless instances use the finest animation LOD level.
+    float animationScreenSize_{ M_INFINITY };
+    /// Current animation LOD level.
+    unsigned animationLodLevel_{};
+    /// Frames left until the interpolated pose reaches the last animation LOD update.
+    unsigned animationLodFramesLeft_{};
+    /// Animation LOD level the bone mask was calculated for.
+    unsigned animationLodMaskLevel_{M_MAX_UNSIGNED};
+    /// Per-bone flags for bones excluded by the current animation LOD level. Empty if no bones are excluded.
+    ea::vector<bool> animationLodBoneMask_;
+    /// Bone positions the animation LOD interpolates toward.
+    ea::vector<Vector3> animationLodPositions_;
+    /// Bone rotations the animation LOD interpolates toward.
+    ea::vector<Quaternion> animationLodRotations_;
+    /// Bone scales the animation LOD interpolates toward.
+    ea::vector<Vector3> animationLodScales_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
     /// Animation dirty flag.
@@ -27,6 +27,7 @@
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/Animation.h"
+#include "../Math/BoundingBox.h"
 #include "../IO/Deserializer.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -50,6 +51,96 @@ inline bool CompareKeyFrames(const AnimationKeyFrame& lhs, const AnimationKeyFra
     return lhs.time_ < rhs.time_;
 }
 
+/// Maximum per-component change for a compressed position or scale channel to be stored as constant.
+static const float COMPRESSION_CONSTANT_EPSILON = 0.00001f;
+/// Largest magnitude of the three smallest components of a unit quaternion.
+static const float QUATERNION_COMPONENT_MAX = 0.70710678f;
+/// Maximum value of a quantized rotation component.
+static const unsigned ROTATION_QUANTIZE_MAX = 0x7fff;
+/// Maximum value of a quantized position or scale component.
+static const unsigned RANGE_QUANTIZE_MAX = 0xffff;
+
+/// Return size of one frame of a compressed track in 16-bit units.
+static unsigned GetCompressedTrackFrameSize(AnimationChannelFlags compressedChannelMask)
+{
+    unsigned size = 0;
+    if (compressedChannelMask & CHANNEL_POSITION)
+        size += 3;
+    if (compressedChannelMask & CHANNEL_ROTATION)
+        size += 3;
+    if (compressedChannelMask & CHANNEL_SCALE)
+        size += 3;
+    return size;
+}
+
+/// Quantize a rotation into three 15-bit components, storing the index of the omitted largest component in the top bits.
+static void QuantizeRotation(const Quaternion& rotation, unsigned short* dest)
+{
+    Quaternion normalized = rotation.Normalized();
+    const float components[4] = { normalized.w_, normalized.x_, normalized.y_, normalized.z_ };
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    // The omitted component is reconstructed as positive, so flip the quaternion if needed
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+
+        float value = Clamp(components[i] * sign / QUATERNION_COMPONENT_MAX, -1.0f, 1.0f);
+        auto quantized = (unsigned)RoundToInt((value * 0.5f + 0.5f) * ROTATION_QUANTIZE_MAX);
+        dest[j] = (unsigned short)(quantized | (j < 2 ? ((largest >> j) & 1u) << 15u : 0u));
+        ++j;
+    }
+}
+
+/// Restore a rotation quantized by QuantizeRotation().
+static Quaternion DequantizeRotation(const unsigned short* src)
+{
+    const unsigned largest = (src[0] >> 15u) | ((src[1] >> 15u) << 1u);
+    float components[4];
+    float sumSquares = 0.0f;
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+
+        float value = ((float)(src[j] & ROTATION_QUANTIZE_MAX) / ROTATION_QUANTIZE_MAX * 2.0f - 1.0f) * QUATERNION_COMPONENT_MAX;
+        components[i] = value;
+        sumSquares += value * value;
+        ++j;
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+/// Quantize a vector within a range into three 16-bit components.
+static void QuantizeRange(const Vector3& value, const Vector3& base, const Vector3& range, unsigned short* dest)
+{
+    const float values[3] = { value.x_ - base.x_, value.y_ - base.y_, value.z_ - base.z_ };
+    const float ranges[3] = { range.x_, range.y_, range.z_ };
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        float normalized = ranges[i] > 0.0f ? Clamp(values[i] / ranges[i], 0.0f, 1.0f) : 0.0f;
+        dest[i] = (unsigned short)RoundToInt(normalized * RANGE_QUANTIZE_MAX);
+    }
+}
+
+/// Restore a vector quantized by QuantizeRange().
+static Vector3 DequantizeRange(const unsigned short* src, const Vector3& base, const Vector3& range)
+{
+    return base + range * Vector3((float)src[0], (float)src[1], (float)src[2]) * (1.0f / RANGE_QUANTIZE_MAX);
+}
+
 void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
     if (index < keyFrames_.size())
@@ -125,11 +216,13 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    ea::string fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UANC")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
+    const bool compressed = fileID == "UANC";
 
     // Read name and length
     animationName_ = source.ReadString();
@@ -137,6 +230,24 @@ bool Animation::BeginLoad(Deserializer& source)
     length_ = source.ReadFloat();
     tracks_.clear();
 
+    // Read compressed frame layout
+    sampleRate_ = 0.0f;
+    numCompressedFrames_ = 0;
+    compressedFrameSize_ = 0;
+    compressedFrames_.clear();
+    if (compressed)
+    {
+        sampleRate_ = source.ReadFloat();
+        numCompressedFrames_ = source.ReadUInt();
+        compressedFrameSize_ = source.ReadUInt();
+        if (!(sampleRate_ > 0.0f) || !numCompressedFrames_)
+        {
+            URHO3D_LOGERROR(source.GetName() + " has invalid compressed animation layout");
+            sampleRate_ = 0.0f;
+            return false;
+        }
+    }
+
     unsigned tracks = source.ReadUInt();
     memoryUse += tracks * sizeof(AnimationTrack);
 
@@ -146,6 +257,38 @@ bool Animation::BeginLoad(Deserializer& source)
         AnimationTrack* newTrack = CreateTrack(source.ReadString());
         newTrack->channelMask_ = AnimationChannelFlags(source.ReadUByte());
 
+        if (compressed)
+        {
+            // Read constant values and quantization ranges of the track
+            newTrack->compressedChannelMask_ = AnimationChannelFlags(source.ReadUByte());
+            newTrack->compressedOffset_ = source.ReadUInt();
+            if (newTrack->channelMask_ & CHANNEL_POSITION)
+            {
+                newTrack->positionBase_ = source.ReadVector3();
+                if (newTrack->compressedChannelMask_ & CHANNEL_POSITION)
+                    newTrack->positionRange_ = source.ReadVector3();
+            }
+            if ((newTrack->channelMask_ & CHANNEL_ROTATION) && !(newTrack->compressedChannelMask_ & CHANNEL_ROTATION))
+                newTrack->constantRotation_ = source.ReadQuaternion();
+            if (newTrack->channelMask_ & CHANNEL_SCALE)
+            {
+                newTrack->scaleBase_ = source.ReadVector3();
+                if (newTrack->compressedChannelMask_ & CHANNEL_SCALE)
+                    newTrack->scaleRange_ = source.ReadVector3();
+            }
+
+            // The track's samples must lie within the frame
+            const unsigned trackFrameSize = GetCompressedTrackFrameSize(newTrack->compressedChannelMask_);
+            if ((newTrack->compressedChannelMask_ & ~newTrack->channelMask_) || newTrack->compressedOffset_ > compressedFrameSize_ ||
+                trackFrameSize > compressedFrameSize_ - newTrack->compressedOffset_)
+            {
+                URHO3D_LOGERROR(source.GetName() + " has invalid compressed animation track " + newTrack->name_);
+                sampleRate_ = 0.0f;
+                return false;
+            }
+            continue;
+        }
+
         unsigned keyFrames = source.ReadUInt();
         newTrack->keyFrames_.resize(keyFrames);
         memoryUse += keyFrames * sizeof(AnimationKeyFrame);
@@ -164,6 +307,27 @@ bool Animation::BeginLoad(Deserializer& source)
         }
     }
 
+    if (compressed)
+    {
+        // Check the size against the remaining data before allocating
+        const unsigned long long dataSize = (unsigned long long)numCompressedFrames_ * compressedFrameSize_ * sizeof(unsigned short);
+        if (dataSize > source.GetSize() - source.GetPosition())
+        {
+            URHO3D_LOGERROR(source.GetName() + " has truncated compressed animation data");
+            sampleRate_ = 0.0f;
+            return false;
+        }
+
+        compressedFrames_.resize(numCompressedFrames_ * compressedFrameSize_);
+        if (source.Read(compressedFrames_.data(), (unsigned)dataSize) != dataSize)
+        {
+            URHO3D_LOGERROR(source.GetName() + " has truncated compressed animation data");
+            sampleRate_ = 0.0f;
+            return false;
+        }
+        memoryUse += dataSize;
+    }
+
     // Optionally read triggers from an XML file
     auto* cache = GetSubsystem<ResourceCache>();
     ea::string xmlName = ReplaceExtension(GetName(), ".xml");
@@ -225,10 +389,19 @@ bool Animation::BeginLoad(Deserializer& source)
 bool Animation::Save(Serializer& dest) const
 {
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    const bool compressed = IsCompressed();
+    dest.WriteFileID(compressed ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
+    // Write compressed frame layout
+    if (compressed)
+    {
+        dest.WriteFloat(sampleRate_);
+        dest.WriteUInt(numCompressedFrames_);
+        dest.WriteUInt(compressedFrameSize_);
+    }
+
     // Write tracks
     dest.WriteUInt(tracks_.size());
     for (auto i = tracks_.begin(); i != tracks_.end(); ++i)
@@ -236,6 +409,29 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = i->second;
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
+
+        if (compressed)
+        {
+            // Write constant values and quantization ranges of the track
+            dest.WriteUByte(track.compressedChannelMask_);
+            dest.WriteUInt(track.compressedOffset_);
+            if (track.channelMask_ & CHANNEL_POSITION)
+            {
+                dest.WriteVector3(track.positionBase_);
+                if (track.compressedChannelMask_ & CHANNEL_POSITION)
+                    dest.WriteVector3(track.positionRange_);
+            }
+            if ((track.channelMask_ & CHANNEL_ROTATION) && !(track.compressedChannelMask_ & CHANNEL_ROTATION))
+                dest.WriteQuaternion(track.constantRotation_);
+            if (track.channelMask_ & CHANNEL_SCALE)
+            {
+                dest.WriteVector3(track.scaleBase_);
+                if (track.compressedChannelMask_ & CHANNEL_SCALE)
+                    dest.WriteVector3(track.scaleRange_);
+            }
+            continue;
+        }
+
         dest.WriteUInt(track.keyFrames_.size());
 
         // Write keyframes of the track
@@ -252,6 +448,9 @@ bool Animation::Save(Serializer& dest) const
         }
     }
 
+    if (compressed)
+        dest.Write(compressedFrames_.data(), compressedFrames_.size() * sizeof(unsigned short));
+
     // If triggers have been defined, write an XML file for them
     if (!triggers_.empty() || HasMetadata())
     {
@@ -376,12 +575,269 @@ SharedPtr<Animation> Animation::Clone(const ea::string& cloneName) const
     ret->length_ = length_;
     ret->tracks_ = tracks_;
     ret->triggers_ = triggers_;
+    ret->sampleRate_ = sampleRate_;
+    ret->numCompressedFrames_ = numCompressedFrames_;
+    ret->compressedFrameSize_ = compressedFrameSize_;
+    ret->compressedFrames_ = compressedFrames_;
     ret->CopyMetadata(*this);
     ret->SetMemoryUse(GetMemoryUse());
 
     return ret;
 }
 
+bool Animation::Compress(float sampleRate)
+{
+    if (IsCompressed())
+        return true;
+
+    if (sampleRate <= 0.0f)
+    {
+        URHO3D_LOGERROR("Invalid animation sample rate");
+        return false;
+    }
+
+    URHO3D_PROFILE("CompressAnimation");
+
+    // Frames span the length evenly, so the effective rate may be slightly higher than requested
+    const unsigned numFrames = (unsigned)Max(CeilToInt(length_ * sampleRate), 0) + 1;
+    const float frameInterval = numFrames > 1 ? length_ / (numFrames - 1) : 0.0f;
+    ea::vector<Vector3> positions(numFrames);
+    ea::vector<Quaternion> rotations(numFrames);
+    ea::vector<Vector3> scales(numFrames);
+    // Quantized samples of each track, with the track's frames stored consecutively
+    ea::vector<ea::vector<unsigned short> > trackSamples;
+    trackSamples.reserve(tracks_.size());
+    unsigned frameSize = 0;
+
+    for (auto i = tracks_.begin(); i != tracks_.end(); ++i)
+    {
+        AnimationTrack& track = i->second;
+        trackSamples.emplace_back();
+        ea::vector<unsigned short>& samples = trackSamples.back();
+
+        track.compressedChannelMask_ = CHANNEL_NONE;
+        track.compressedOffset_ = frameSize;
+        if (track.keyFrames_.empty())
+        {
+            // Tracks without keyframes are skipped in playback, keep it that way
+            track.channelMask_ = CHANNEL_NONE;
+            continue;
+        }
+
+        // Resample the keyframes at the uniform rate
+        unsigned keyFrame = 0;
+        for (unsigned j = 0; j < numFrames; ++j)
+        {
+            float time = Min(j * frameInterval, length_);
+            SampleTrack(track, time, false, keyFrame, positions[j], rotations[j], scales[j]);
+        }
+
+        if (track.channelMask_ & CHANNEL_POSITION)
+        {
+            BoundingBox range(positions.data(), numFrames);
+            track.positionBase_ = range.min_;
+            track.positionRange_ = range.Size();
+            if (track.positionRange_.x_ > COMPRESSION_CONSTANT_EPSILON || track.positionRange_.y_ > COMPRESSION_CONSTANT_EPSILON ||
+                track.positionRange_.z_ > COMPRESSION_CONSTANT_EPSILON)
+                track.compressedChannelMask_ |= CHANNEL_POSITION;
+            else
+            {
+                track.positionBase_ = positions[0];
+                track.positionRange_ = Vector3::ZERO;
+            }
+        }
+        if (track.channelMask_ & CHANNEL_ROTATION)
+        {
+            track.constantRotation_ = rotations[0].Normalized();
+            for (unsigned j = 1; j < numFrames; ++j)
+            {
+                if (Abs(track.constantRotation_.DotProduct(rotations[j].Normalized())) < 1.0f - M_EPSILON)
+                {
+                    track.compressedChannelMask_ |= CHANNEL_ROTATION;
+                    break;
+                }
+            }
+        }
+        if (track.channelMask_ & CHANNEL_SCALE)
+        {
+            BoundingBox range(scales.data(), numFrames);
+            track.scaleBase_ = range.min_;
+            track.scaleRange_ = range.Size();
+            if (track.scaleRange_.x_ > COMPRESSION_CONSTANT_EPSILON || track.scaleRange_.y_ > COMPRESSION_CONSTANT_EPSILON ||
+                track.scaleRange_.z_ > COMPRESSION_CONSTANT_EPSILON)
+                track.compressedChannelMask_ |= CHANNEL_SCALE;
+            else
+            {
+                track.scaleBase_ = scales[0];
+                track.scaleRange_ = Vector3::ZERO;
+            }
+        }
+
+        const unsigned trackFrameSize = GetCompressedTrackFrameSize(track.compressedChannelMask_);
+
+        samples.resize(numFrames * trackFrameSize);
+        unsigned short* dest = samples.data();
+        for (unsigned j = 0; j < numFrames; ++j)
+        {
+            if (track.compressedChannelMask_ & CHANNEL_POSITION)
+            {
+                QuantizeRange(positions[j], track.positionBase_, track.positionRange_, dest);
+                dest += 3;
+            }
+            if (track.compressedChannelMask_ & CHANNEL_ROTATION)
+            {
+                QuantizeRotation(rotations[j], dest);
+                dest += 3;
+            }
+            if (track.compressedChannelMask_ & CHANNEL_SCALE)
+            {
+                QuantizeRange(scales[j], track.scaleBase_, track.scaleRange_, dest);
+                dest += 3;
+            }
+        }
+
+        frameSize += trackFrameSize;
+    }
+
+    // Interleave the tracks so that each frame is contiguous
+    compressedFrames_.resize(numFrames * frameSize);
+    unsigned trackIndex = 0;
+    for (auto i = tracks_.begin(); i != tracks_.end(); ++i, ++trackIndex)
+    {
+        AnimationTrack& track = i->second;
+        const ea::vector<unsigned short>& samples = trackSamples[trackIndex];
+        const unsigned trackFrameSize = samples.size() / numFrames;
+        for (unsigned j = 0; j < numFrames; ++j)
+        {
+            for (unsigned k = 0; k < trackFrameSize; ++k)
+                compressedFrames_[j * frameSize + track.compressedOffset_ + k] = samples[j * trackFrameSize + k];
+        }
+
+        track.keyFrames_.clear();
+        track.keyFrames_.shrink_to_fit();
+    }
+
+    sampleRate_ = numFrames > 1 ? 1.0f / frameInterval : sampleRate;
+    numCompressedFrames_ = numFrames;
+    compressedFrameSize_ = frameSize;
+
+    SetMemoryUse(sizeof(Animation) + tracks_.size() * sizeof(AnimationTrack) + triggers_.size() * sizeof(AnimationTriggerPoint) +
+        compressedFrames_.size() * sizeof(unsigned short));
+    return true;
+}
+
+bool Animation::SampleTrack(const AnimationTrack& track, float time, bool looped, unsigned& keyFrameHint, Vector3& position,
+    Quaternion& rotation, Vector3& scale) const
+{
+    const AnimationChannelFlags channelMask = track.channelMask_;
+
+    if (track.keyFrames_.empty())
+    {
+        if (!IsCompressed() || !numCompressedFrames_)
+            return false;
+
+        // Uniform frames need no keyframe search
+        const unsigned lastFrame = numCompressedFrames_ - 1;
+        float frame = Clamp(time, 0.0f, length_) * sampleRate_;
+        unsigned frame0 = Min((unsigned)frame, lastFrame);
+        unsigned frame1 = Min(frame0 + 1, lastFrame);
+        float t = Clamp(frame - frame0, 0.0f, 1.0f);
+
+        // The last frame is at the end of the animation, which is the start again when looping
+        if (looped && lastFrame > 0)
+        {
+            if (frame0 == lastFrame)
+                frame0 = 0;
+            if (frame1 == lastFrame)
+                frame1 = 0;
+        }
+        const unsigned short* src0 = compressedFrames_.data() + frame0 * compressedFrameSize_ + track.compressedOffset_;
+        const unsigned short* src1 = compressedFrames_.data() + frame1 * compressedFrameSize_ + track.compressedOffset_;
+        const AnimationChannelFlags compressedMask = track.compressedChannelMask_;
+
+        if (channelMask & CHANNEL_POSITION)
+        {
+            if (compressedMask & CHANNEL_POSITION)
+            {
+                position = DequantizeRange(src0, track.positionBase_, track.positionRange_).Lerp(
+                    DequantizeRange(src1, track.positionBase_, track.positionRange_), t);
+                src0 += 3;
+                src1 += 3;
+            }
+            else
+                position = track.positionBase_;
+        }
+        if (channelMask & CHANNEL_ROTATION)
+        {
+            // Samples are dense enough for normalized lerp
+            if (compressedMask & CHANNEL_ROTATION)
+            {
+                rotation = DequantizeRotation(src0).Nlerp(DequantizeRotation(src1), t, true);
+                src0 += 3;
+                src1 += 3;
+            }
+            else
+                rotation = track.constantRotation_;
+        }
+        if (channelMask & CHANNEL_SCALE)
+        {
+            if (compressedMask & CHANNEL_SCALE)
+                scale = DequantizeRange(src0, track.scaleBase_, track.scaleRange_).Lerp(
+                    DequantizeRange(src1, track.scaleBase_, track.scaleRange_), t);
+            else
+                scale = track.scaleBase_;
+        }
+
+        return true;
+    }
+
+    unsigned& frame = keyFrameHint;
+    track.GetKeyFrameIndex(time, frame);
+
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    unsigned nextFrame = frame + 1;
+    bool interpolate = true;
+    if (nextFrame >= track.keyFrames_.size())
+    {
+        if (!looped)
+        {
+            nextFrame = frame;
+            interpolate = false;
+        }
+        else
+            nextFrame = 0;
+    }
+
+    const AnimationKeyFrame* keyFrame = &track.keyFrames_[frame];
+
+    if (interpolate)
+    {
+        const AnimationKeyFrame* nextKeyFrame = &track.keyFrames_[nextFrame];
+        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+        if (timeInterval < 0.0f)
+            timeInterval += length_;
+        float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+
+        if (channelMask & CHANNEL_POSITION)
+            position = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+        if (channelMask & CHANNEL_ROTATION)
+            rotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+        if (channelMask & CHANNEL_SCALE)
+            scale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+    }
+    else
+    {
+        if (channelMask & CHANNEL_POSITION)
+            position = keyFrame->position_;
+        if (channelMask & CHANNEL_ROTATION)
+            rotation = keyFrame->rotation_;
+        if (channelMask & CHANNEL_SCALE)
+            scale = keyFrame->scale_;
+    }
+
+    return true;
+}
+
 AnimationTrack* Animation::GetTrack(unsigned index)
 {
     if (index >= GetNumTracks())
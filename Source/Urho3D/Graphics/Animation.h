@@ -106,8 +106,22 @@ struct URHO3D_API AnimationTrack
     StringHash nameHash_;
     /// Bitmask of included data (position, rotation, scale.)
     AnimationChannelFlags channelMask_{};
-    /// Keyframes.
+    /// Keyframes. Empty when the track has been compressed.
     ea::vector<AnimationKeyFrame> keyFrames_;
+    /// Bitmask of channels that vary over time in the compressed frames. The other channels are constant.
+    AnimationChannelFlags compressedChannelMask_{};
+    /// Offset of the track's samples within a compressed frame, in 16-bit units.
+    unsigned compressedOffset_{};
+    /// Compressed constant position, or minimum of the position quantization range.
+    Vector3 positionBase_;
+    /// Compressed position quantization range.
+    Vector3 positionRange_;
+    /// Compressed constant rotation.
+    Quaternion constantRotation_;
+    /// Compressed constant scale, or minimum of the scale quantization range.
+    Vector3 scaleBase_{Vector3::ONE};
+    /// Compressed scale quantization range.
+    Vector3 scaleRange_;
 
     /// Instance equality operator.
     bool operator ==(const AnimationTrack& rhs) const
@@ -191,6 +205,11 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const ea::string& cloneName = EMPTY_STRING) const;
+    /// Convert keyframe tracks to the compressed format. Tracks are resampled at a uniform rate, rounded up so that the frames span the length evenly. Rotations are quantized to 48 bits, positions and scales to 16 bits per component within the track's range, and channels that do not change are stored once. Samples of all tracks are interleaved per frame, so that playback reads one contiguous block. Keyframes are discarded. Return true if successful.
+    bool Compress(float sampleRate = 30.0f);
+    /// Sample a track at time and return the channels in its channel mask. Compressed tracks are read from the uniform frames, otherwise keyframes are interpolated starting the search from the index hint. Return false if the track has no data.
+    bool SampleTrack(const AnimationTrack& track, float time, bool looped, unsigned& keyFrameHint, Vector3& position,
+        Quaternion& rotation, Vector3& scale) const;
 
     /// Return animation name.
     const ea::string& GetAnimationName() const { return animationName_; }
@@ -201,6 +220,12 @@ public:
     /// Return animation length.
     float GetLength() const { return length_; }
 
+    /// Return whether the tracks have been compressed.
+    bool IsCompressed() const { return sampleRate_ > 0.0f; }
+
+    /// Return compressed sample rate, or zero if not compressed. May be slightly higher than the rate requested from Compress().
+    float GetSampleRate() const { return sampleRate_; }
+
     /// Return all animation tracks.
     const ea::unordered_map<StringHash, AnimationTrack>& GetTracks() const { return tracks_; }
 
@@ -237,6 +262,14 @@ private:
     ea::unordered_map<StringHash, AnimationTrack> tracks_;
     /// Animation trigger points.
     ea::vector<AnimationTriggerPoint> triggers_;
+    /// Compressed sample rate.
+    float sampleRate_{};
+    /// Number of compressed frames.
+    unsigned numCompressedFrames_{};
+    /// Compressed frame size in 16-bit units.
+    unsigned compressedFrameSize_{};
+    /// Compressed frames of all tracks.
+    ea::vector<unsigned short> compressedFrames_;
 };
 
 }
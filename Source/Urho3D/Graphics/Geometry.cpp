@@ -48,7 +48,9 @@ Geometry::Geometry(Context* context) :
     vertexCount_(0),
     rawVertexSize_(0),
     rawIndexSize_(0),
-    lodDistance_(0.0f)
+    lodDistance_(0.0f),
+    lodError_(0.0f),
+    uvDensity_(-1.0f)
 {
     SetNumVertexBuffers(1);
 }
@@ -83,12 +85,14 @@ bool Geometry::SetVertexBuffer(unsigned index, VertexBuffer* buffer)
     }
 
     vertexBuffers_[index] = buffer;
+    uvDensity_ = -1.0f;
     return true;
 }
 
 void Geometry::SetIndexBuffer(IndexBuffer* buffer)
 {
     indexBuffer_ = buffer;
+    uvDensity_ = -1.0f;
 }
 
 bool Geometry::SetDrawRange(PrimitiveType type, unsigned indexStart, unsigned indexCount, bool getUsedVertexRange)
@@ -124,6 +128,7 @@ bool Geometry::SetDrawRange(PrimitiveType type, unsigned indexStart, unsigned in
         vertexCount_ = 0;
     }
 
+    uvDensity_ = -1.0f;
     return true;
 }
 
@@ -151,6 +156,7 @@ bool Geometry::SetDrawRange(PrimitiveType type, unsigned indexStart, unsigned in
     indexCount_ = indexCount;
     vertexStart_ = vertexStart;
     vertexCount_ = vertexCount;
+    uvDensity_ = -1.0f;
 
     return true;
 }
@@ -163,11 +169,17 @@ void Geometry::SetLodDistance(float distance)
     lodDistance_ = distance;
 }
 
+void Geometry::SetLodError(float error)
+{
+    lodError_ = Max(error, 0.0f);
+}
+
 void Geometry::SetRawVertexData(const ea::shared_array<unsigned char>& data, const ea::vector<VertexElement>& elements)
 {
     rawVertexData_ = data;
     rawVertexSize_ = VertexBuffer::GetVertexSize(elements);
     rawElements_ = elements;
+    uvDensity_ = -1.0f;
 }
 
 void Geometry::SetRawVertexData(const ea::shared_array<unsigned char>& data, unsigned elementMask)
@@ -175,12 +187,15 @@ void Geometry::SetRawVertexData(const ea::shared_array<unsigned char>& data, uns
     rawVertexData_ = data;
     rawVertexSize_ = VertexBuffer::GetVertexSize(elementMask);
     rawElements_ = VertexBuffer::GetElements(elementMask);
+    VertexBuffer::UpdateOffsets(rawElements_);
+    uvDensity_ = -1.0f;
 }
 
 void Geometry::SetRawIndexData(const ea::shared_array<unsigned char>& data, unsigned indexSize)
 {
     rawIndexData_ = data;
     rawIndexSize_ = indexSize;
+    uvDensity_ = -1.0f;
 }
 
 void Geometry::Draw(Graphics* graphics)
@@ -336,6 +351,65 @@ float Geometry::GetHitDistance(const Ray& ray, Vector3* outNormal, Vector2* outU
         uvOffset) : ray.HitDistance(vertexData, vertexSize, vertexStart_, vertexCount_, outNormal, outUV, uvOffset);
 }
 
+float Geometry::GetUVDensity() const
+{
+    if (uvDensity_ >= 0.0f)
+        return uvDensity_;
+
+    uvDensity_ = 0.0f;
+
+    const unsigned char* vertexData;
+    const unsigned char* indexData;
+    unsigned vertexSize;
+    unsigned indexSize;
+    const ea::vector<VertexElement>* elements;
+
+    GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+
+    if (primitiveType_ != TRIANGLE_LIST || !vertexData || !elements ||
+        VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR3, SEM_POSITION) != 0)
+        return uvDensity_;
+
+    const unsigned uvOffset = VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR2, SEM_TEXCOORD);
+    if (uvOffset == M_MAX_UNSIGNED)
+        return uvDensity_;
+
+    const unsigned start = indexData ? indexStart_ : vertexStart_;
+    const unsigned end = start + (indexData ? indexCount_ : vertexCount_);
+    auto getVertexIndex = [&](unsigned i) -> unsigned
+    {
+        if (!indexData)
+            return i;
+        return indexSize == sizeof(unsigned short) ? reinterpret_cast<const unsigned short*>(indexData)[i] :
+            reinterpret_cast<const unsigned*>(indexData)[i];
+    };
+
+    // Sum twice the triangle areas in model space and in UV space, the factor cancels out in the ratio
+    float area = 0.0f;
+    float uvArea = 0.0f;
+    for (unsigned i = start; i + 2 < end; i += 3)
+    {
+        const unsigned char* v0 = vertexData + getVertexIndex(i) * vertexSize;
+        const unsigned char* v1 = vertexData + getVertexIndex(i + 1) * vertexSize;
+        const unsigned char* v2 = vertexData + getVertexIndex(i + 2) * vertexSize;
+
+        const Vector3& p0 = *reinterpret_cast<const Vector3*>(v0);
+        const Vector3& p1 = *reinterpret_cast<const Vector3*>(v1);
+        const Vector3& p2 = *reinterpret_cast<const Vector3*>(v2);
+        area += (p1 - p0).CrossProduct(p2 - p0).Length();
+
+        const Vector2 t0 = *reinterpret_cast<const Vector2*>(v0 + uvOffset);
+        const Vector2 e1 = *reinterpret_cast<const Vector2*>(v1 + uvOffset) - t0;
+        const Vector2 e2 = *reinterpret_cast<const Vector2*>(v2 + uvOffset) - t0;
+        uvArea += Abs(e1.x_ * e2.y_ - e1.y_ * e2.x_);
+    }
+
+    if (area > M_EPSILON && uvArea > M_EPSILON)
+        uvDensity_ = sqrtf(uvArea / area);
+
+    return uvDensity_;
+}
+
 bool Geometry::IsInside(const Ray& ray) const
 {
     const unsigned char* vertexData;
@@ -62,6 +62,8 @@ public:
         bool checkIllegal = true);
     /// Set the LOD distance.
     void SetLodDistance(float distance);
+    /// Set the LOD geometric error in model space units, relative to the most detailed LOD level.
+    void SetLodError(float error);
     /// Override raw vertex data to be returned for CPU-side operations.
     void SetRawVertexData(const ea::shared_array<unsigned char>& data, const ea::vector<VertexElement>& elements);
     /// Override raw vertex data to be returned for CPU-side operations using a legacy vertex bitmask.
@@ -101,6 +103,9 @@ public:
     /// Return LOD distance.
     float GetLodDistance() const { return lodDistance_; }
 
+    /// Return LOD geometric error.
+    float GetLodError() const { return lodError_; }
+
     /// Return buffers' combined hash value for state sorting.
     unsigned short GetBufferHash() const;
     /// Return raw vertex and index data for CPU operations, or null pointers if not available. Will return data of the first vertex buffer if override data not set.
@@ -110,6 +115,8 @@ public:
         unsigned& indexSize, const ea::vector<VertexElement>*& elements) const;
     /// Return ray hit distance or infinity if no hit. Requires raw data to be set. Optionally return hit normal and hit uv coordinates at intersect point.
     float GetHitDistance(const Ray& ray, Vector3* outNormal = nullptr, Vector2* outUV = nullptr) const;
+    /// Return UV units per model space unit, from the ratio of UV area to surface area of the triangles. Requires raw data with positions and texture coordinates, otherwise return 0. Calculated on first use and cached until the buffers, raw data or draw range change.
+    float GetUVDensity() const;
     /// Return whether or not the ray is inside geometry.
     bool IsInside(const Ray& ray) const;
 
@@ -133,6 +140,8 @@ private:
     unsigned vertexCount_;
     /// LOD distance.
     float lodDistance_;
+    /// LOD geometric error.
+    float lodError_;
     /// Raw vertex data elements.
     ea::vector<VertexElement> rawElements_;
     /// Raw vertex data override.
@@ -143,6 +152,8 @@ private:
     unsigned rawVertexSize_;
     /// Raw index data override size.
     unsigned rawIndexSize_;
+    /// Cached UV density, or negative if not calculated yet.
+    mutable float uvDensity_;
 };
 
 }
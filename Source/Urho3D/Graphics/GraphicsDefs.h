@@ -482,6 +482,7 @@ URHO3D_FLAGSET(VertexMask, VertexMaskFlags);
 static const int MAX_RENDERTARGETS = 4;
 static const int MAX_VERTEX_STREAMS = 4;
 static const int MAX_CONSTANT_REGISTERS = 256;
+static const unsigned MAX_ANIMATION_LOD_LEVELS = 4;
 
 static const int BITS_PER_COMPONENT = 8;
 }
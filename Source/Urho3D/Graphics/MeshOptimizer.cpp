@@ -0,0 +1,357 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/MeshOptimizer.h"
+#include "../Math/Vector3.h"
+
+#include <EASTL/numeric.h>
+#include <EASTL/sort.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Cache size used for vertex scoring.
+const unsigned VERTEX_CACHE_SIZE = 32;
+/// Cache size used to find overdraw cluster boundaries.
+const unsigned OVERDRAW_CACHE_SIZE = 16;
+
+/// Linear-Speed Vertex Cache Optimisation by Tom Forsyth: score of a vertex by cache position and remaining triangles.
+float CalculateVertexScore(int cachePosition, unsigned liveTriangles)
+{
+    const float cacheDecayPower = 1.5f;
+    const float lastTriScore = 0.75f;
+    const float valenceBoostScale = 2.0f;
+    const float valenceBoostPower = 0.5f;
+
+    // No triangle needs this vertex
+    if (!liveTriangles)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // Vertices of the last triangle have a fixed score regardless of their order
+        if (cachePosition < 3)
+            score = lastTriScore;
+        else
+        {
+            const float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+        }
+    }
+
+    // Bonus points for having a low number of triangles still to use the vertex, so lone vertices are finished quickly
+    score += valenceBoostScale * powf(static_cast<float>(liveTriangles), -valenceBoostPower);
+    return score;
+}
+
+/// Return whether all indices are in range.
+bool ValidateIndices(const unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+    for (unsigned i = 0; i < indexCount; ++i)
+    {
+        if (indices[i] >= vertexCount)
+            return false;
+    }
+    return true;
+}
+
+/// Return vertex position.
+const Vector3& GetPosition(const unsigned char* vertexData, unsigned vertexSize, unsigned positionOffset, unsigned index)
+{
+    return *reinterpret_cast<const Vector3*>(vertexData + index * vertexSize + positionOffset);
+}
+
+}
+
+float CalculateACMR(const unsigned* indices, unsigned indexCount, unsigned vertexCount, unsigned cacheSize)
+{
+    const unsigned numTriangles = indexCount / 3;
+    if (!numTriangles)
+        return 0.0f;
+
+    // Simulate FIFO cache with insertion timestamps
+    ea::vector<unsigned> timestamps(vertexCount, 0);
+    unsigned time = cacheSize + 1;
+    unsigned misses = 0;
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+    {
+        const unsigned index = indices[i];
+        if (index >= vertexCount)
+            continue;
+
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            ++misses;
+        }
+    }
+
+    return static_cast<float>(misses) / numTriangles;
+}
+
+void OptimizeVertexCache(unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+    const unsigned numTriangles = indexCount / 3;
+    if (numTriangles < 2 || !ValidateIndices(indices, numTriangles * 3, vertexCount))
+        return;
+
+    // Build vertex to triangle adjacency. Live triangles of each vertex are kept first in its range
+    ea::vector<unsigned> offsets(vertexCount + 1, 0);
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        ++offsets[indices[i] + 1];
+    for (unsigned i = 0; i < vertexCount; ++i)
+        offsets[i + 1] += offsets[i];
+
+    ea::vector<unsigned> adjacency(numTriangles * 3);
+    ea::vector<unsigned> liveTriangles(vertexCount, 0);
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+    {
+        const unsigned vertex = indices[i];
+        adjacency[offsets[vertex] + liveTriangles[vertex]++] = i / 3;
+    }
+
+    // Calculate initial scores
+    ea::vector<int> cachePositions(vertexCount, -1);
+    ea::vector<float> vertexScores(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+        vertexScores[i] = CalculateVertexScore(-1, liveTriangles[i]);
+
+    ea::vector<float> triangleScores(numTriangles);
+    unsigned bestTriangle = 0;
+    for (unsigned i = 0; i < numTriangles; ++i)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+        if (triangleScores[i] > triangleScores[bestTriangle])
+            bestTriangle = i;
+    }
+
+    ea::vector<bool> emitted(numTriangles, false);
+    ea::vector<unsigned> result;
+    result.reserve(numTriangles * 3);
+
+    unsigned cache[VERTEX_CACHE_SIZE + 3];
+    unsigned newCache[VERTEX_CACHE_SIZE + 3];
+    unsigned cacheSize = 0;
+    unsigned scanCursor = 0;
+
+    while (bestTriangle != M_MAX_UNSIGNED)
+    {
+        emitted[bestTriangle] = true;
+        const unsigned triangle[3] = { indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+        result.push_back(triangle[0]);
+        result.push_back(triangle[1]);
+        result.push_back(triangle[2]);
+
+        // Remove the triangle from the live triangles of its vertices
+        for (unsigned vertex : triangle)
+        {
+            unsigned* begin = &adjacency[offsets[vertex]];
+            unsigned* end = begin + liveTriangles[vertex];
+            unsigned* found = ea::find(begin, end, bestTriangle);
+            if (found != end)
+            {
+                ea::swap(*found, *(end - 1));
+                --liveTriangles[vertex];
+            }
+        }
+
+        // Model the cache: push triangle vertices to the front
+        unsigned newCacheSize = 0;
+        for (unsigned vertex : triangle)
+            newCache[newCacheSize++] = vertex;
+        for (unsigned i = 0; i < cacheSize; ++i)
+        {
+            const unsigned vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                newCache[newCacheSize++] = vertex;
+        }
+
+        // Update scores of all vertices that were touched, including those falling out of the cache
+        for (unsigned i = 0; i < newCacheSize; ++i)
+        {
+            const unsigned vertex = newCache[i];
+            cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+            const float score = CalculateVertexScore(cachePositions[vertex], liveTriangles[vertex]);
+            const float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            for (unsigned j = offsets[vertex]; j < offsets[vertex] + liveTriangles[vertex]; ++j)
+                triangleScores[adjacency[j]] += delta;
+        }
+
+        cacheSize = Min(newCacheSize, VERTEX_CACHE_SIZE);
+        for (unsigned i = 0; i < cacheSize; ++i)
+            cache[i] = newCache[i];
+
+        // Find the best triangle among those using the cached vertices
+        bestTriangle = M_MAX_UNSIGNED;
+        float bestScore = -M_INFINITY;
+        for (unsigned i = 0; i < cacheSize; ++i)
+        {
+            const unsigned vertex = cache[i];
+            for (unsigned j = offsets[vertex]; j < offsets[vertex] + liveTriangles[vertex]; ++j)
+            {
+                const unsigned candidate = adjacency[j];
+                if (triangleScores[candidate] > bestScore)
+                {
+                    bestTriangle = candidate;
+                    bestScore = triangleScores[candidate];
+                }
+            }
+        }
+
+        // If the cache has no live triangles left, continue from the next unemitted triangle
+        if (bestTriangle == M_MAX_UNSIGNED)
+        {
+            while (scanCursor < numTriangles && emitted[scanCursor])
+                ++scanCursor;
+            if (scanCursor < numTriangles)
+                bestTriangle = scanCursor;
+        }
+    }
+
+    ea::copy(result.begin(), result.end(), indices);
+}
+
+void OptimizeOverdraw(unsigned* indices, unsigned indexCount, const unsigned char* vertexData, unsigned vertexCount,
+    unsigned vertexSize, unsigned positionOffset, float threshold)
+{
+    const unsigned numTriangles = indexCount / 3;
+    if (numTriangles < 2 || !vertexData || !ValidateIndices(indices, numTriangles * 3, vertexCount))
+        return;
+
+    // Split into clusters where the cache simulation restarts, so that reordering clusters preserves most of the locality
+    ea::vector<unsigned> clusterStarts;
+    {
+        ea::vector<unsigned> timestamps(vertexCount, 0);
+        unsigned time = OVERDRAW_CACHE_SIZE + 1;
+        for (unsigned i = 0; i < numTriangles; ++i)
+        {
+            unsigned misses = 0;
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                const unsigned index = indices[i * 3 + k];
+                if (time - timestamps[index] > OVERDRAW_CACHE_SIZE)
+                {
+                    timestamps[index] = time++;
+                    ++misses;
+                }
+            }
+            if (misses == 3)
+                clusterStarts.push_back(i);
+        }
+    }
+    if (clusterStarts.size() < 2)
+        return;
+
+    // Calculate area weighted centroid and normal of the mesh and each cluster
+    const unsigned numClusters = clusterStarts.size();
+    ea::vector<Vector3> clusterCentroids(numClusters, Vector3::ZERO);
+    ea::vector<Vector3> clusterNormals(numClusters, Vector3::ZERO);
+    ea::vector<float> clusterAreas(numClusters, 0.0f);
+    Vector3 meshCentroid;
+    float meshArea = 0.0f;
+
+    for (unsigned cluster = 0; cluster < numClusters; ++cluster)
+    {
+        const unsigned end = cluster + 1 < numClusters ? clusterStarts[cluster + 1] : numTriangles;
+        for (unsigned i = clusterStarts[cluster]; i < end; ++i)
+        {
+            const Vector3& p0 = GetPosition(vertexData, vertexSize, positionOffset, indices[i * 3]);
+            const Vector3& p1 = GetPosition(vertexData, vertexSize, positionOffset, indices[i * 3 + 1]);
+            const Vector3& p2 = GetPosition(vertexData, vertexSize, positionOffset, indices[i * 3 + 2]);
+            const Vector3 normal = (p1 - p0).CrossProduct(p2 - p0);
+            const float area = normal.Length();
+
+            clusterCentroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+            clusterNormals[cluster] += normal;
+            clusterAreas[cluster] += area;
+        }
+
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterAreas[cluster];
+    }
+    if (meshArea < M_EPSILON)
+        return;
+    meshCentroid /= meshArea;
+
+    // Sort clusters so that those facing away from the mesh center are drawn first
+    ea::vector<float> sortKeys(numClusters, 0.0f);
+    for (unsigned cluster = 0; cluster < numClusters; ++cluster)
+    {
+        if (clusterAreas[cluster] < M_EPSILON)
+            continue;
+        const Vector3 centroid = clusterCentroids[cluster] / clusterAreas[cluster];
+        sortKeys[cluster] = (centroid - meshCentroid).DotProduct(clusterNormals[cluster].Normalized());
+    }
+
+    ea::vector<unsigned> order(numClusters);
+    ea::iota(order.begin(), order.end(), 0u);
+    ea::stable_sort(order.begin(), order.end(), [&](unsigned lhs, unsigned rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+    ea::vector<unsigned> result;
+    result.reserve(numTriangles * 3);
+    for (unsigned cluster : order)
+    {
+        const unsigned end = cluster + 1 < numClusters ? clusterStarts[cluster + 1] : numTriangles;
+        result.insert(result.end(), indices + clusterStarts[cluster] * 3, indices + end * 3);
+    }
+
+    // Keep the new order only if cache efficiency did not suffer too much
+    const float oldACMR = CalculateACMR(indices, numTriangles * 3, vertexCount);
+    const float newACMR = CalculateACMR(result.data(), result.size(), vertexCount);
+    if (newACMR <= oldACMR * threshold)
+        ea::copy(result.begin(), result.end(), indices);
+}
+
+unsigned BuildVertexFetchRemap(ea::vector<unsigned>& remap, const unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+    remap.assign(vertexCount, M_MAX_UNSIGNED);
+
+    unsigned nextVertex = 0;
+    for (unsigned i = 0; i < indexCount; ++i)
+    {
+        const unsigned index = indices[i];
+        if (index < vertexCount && remap[index] == M_MAX_UNSIGNED)
+            remap[index] = nextVertex++;
+    }
+
+    const unsigned numUsedVertices = nextVertex;
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        if (remap[i] == M_MAX_UNSIGNED)
+            remap[i] = nextVertex++;
+    }
+
+    return numUsedVertices;
+}
+
+}
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Urho3D.h>
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+/// Return average cache miss ratio (transformed vertices per triangle) of an indexed triangle list for a FIFO post-transform vertex cache of given size.
+URHO3D_API float CalculateACMR(const unsigned* indices, unsigned indexCount, unsigned vertexCount, unsigned cacheSize = 16);
+/// Reorder triangles of an indexed triangle list for post-transform vertex cache efficiency using linear-speed vertex cache optimisation.
+URHO3D_API void OptimizeVertexCache(unsigned* indices, unsigned indexCount, unsigned vertexCount);
+/// Reorder triangle clusters of a vertex cache optimized triangle list so that outward facing clusters are drawn first to reduce overdraw. Cluster order is only changed if ACMR does not grow more than the threshold ratio.
+URHO3D_API void OptimizeOverdraw(unsigned* indices, unsigned indexCount, const unsigned char* vertexData, unsigned vertexCount,
+    unsigned vertexSize, unsigned positionOffset, float threshold = 1.05f);
+/// Build vertex remap table that orders vertices by first use in index data, unused vertices last. Return number of used vertices.
+URHO3D_API unsigned BuildVertexFetchRemap(ea::vector<unsigned>& remap, const unsigned* indices, unsigned indexCount, unsigned vertexCount);
+
+}
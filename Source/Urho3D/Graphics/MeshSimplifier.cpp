@@ -0,0 +1,320 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/MeshSimplifier.h"
+#include "../Math/Vector3.h"
+
+#include <EASTL/sort.h>
+#include <EASTL/unordered_map.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Symmetric 4x4 error quadric.
+struct Quadric
+{
+    double a_{}, b_{}, c_{}, d_{};
+    double e_{}, f_{}, g_{};
+    double h_{}, i_{};
+    double j_{};
+
+    /// Construct from plane.
+    static Quadric FromPlane(double a, double b, double c, double d)
+    {
+        Quadric q;
+        q.a_ = a * a; q.b_ = a * b; q.c_ = a * c; q.d_ = a * d;
+        q.e_ = b * b; q.f_ = b * c; q.g_ = b * d;
+        q.h_ = c * c; q.i_ = c * d;
+        q.j_ = d * d;
+        return q;
+    }
+
+    /// Accumulate other quadric.
+    Quadric& operator +=(const Quadric& rhs)
+    {
+        a_ += rhs.a_; b_ += rhs.b_; c_ += rhs.c_; d_ += rhs.d_;
+        e_ += rhs.e_; f_ += rhs.f_; g_ += rhs.g_;
+        h_ += rhs.h_; i_ += rhs.i_;
+        j_ += rhs.j_;
+        return *this;
+    }
+
+    /// Return squared distance error at position.
+    double Evaluate(const Vector3& p) const
+    {
+        const double x = p.x_;
+        const double y = p.y_;
+        const double z = p.z_;
+        const double error = a_ * x * x + 2 * b_ * x * y + 2 * c_ * x * z + 2 * d_ * x
+            + e_ * y * y + 2 * f_ * y * z + 2 * g_ * y
+            + h_ * z * z + 2 * i_ * z
+            + j_;
+        return Max(error, 0.0);
+    }
+};
+
+/// Candidate collapse of one vertex onto another.
+struct Collapse
+{
+    /// Vertex to be removed.
+    unsigned from_;
+    /// Vertex to collapse onto.
+    unsigned to_;
+    /// Squared error.
+    float cost_;
+
+    /// Compare by cost.
+    bool operator <(const Collapse& rhs) const { return cost_ < rhs.cost_; }
+};
+
+/// Return whether triangle is degenerate by indices.
+inline bool IsDegenerate(unsigned a, unsigned b, unsigned c)
+{
+    return a == b || b == c || c == a;
+}
+
+}
+
+float SimplifyMesh(ea::vector<unsigned>& destIndices, const ea::vector<unsigned>& sourceIndices,
+    const unsigned char* vertexData, unsigned vertexCount, unsigned vertexSize, unsigned positionOffset,
+    unsigned targetIndexCount, float maxError)
+{
+    destIndices = sourceIndices;
+    destIndices.resize(destIndices.size() / 3 * 3);
+    if (!vertexData || destIndices.size() <= targetIndexCount)
+        return 0.0f;
+
+    for (unsigned index : destIndices)
+    {
+        if (index >= vertexCount)
+        {
+            destIndices = sourceIndices;
+            return 0.0f;
+        }
+    }
+
+    // Fetch positions
+    ea::vector<Vector3> positions(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+        positions[i] = *reinterpret_cast<const Vector3*>(vertexData + i * vertexSize + positionOffset);
+
+    // Weld vertices by position to find seams: vertices sharing position with another vertex are locked
+    ea::vector<unsigned> welded(vertexCount);
+    ea::vector<bool> locked(vertexCount, false);
+    {
+        ea::unordered_map<Vector3, unsigned> firstByPosition;
+        for (unsigned i = 0; i < vertexCount; ++i)
+        {
+            auto result = firstByPosition.emplace(positions[i], i);
+            welded[i] = result.first->second;
+            if (!result.second)
+            {
+                locked[i] = true;
+                locked[welded[i]] = true;
+            }
+        }
+    }
+
+    // Find borders in welded topology: an edge without the opposite half-edge locks both vertices
+    {
+        ea::unordered_map<unsigned long long, unsigned> halfEdges;
+        const auto edgeKey = [](unsigned a, unsigned b) { return (static_cast<unsigned long long>(a) << 32u) | b; };
+        for (unsigned i = 0; i < destIndices.size(); i += 3)
+        {
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                const unsigned a = welded[destIndices[i + k]];
+                const unsigned b = welded[destIndices[i + (k + 1) % 3]];
+                ++halfEdges[edgeKey(a, b)];
+            }
+        }
+        for (unsigned i = 0; i < destIndices.size(); i += 3)
+        {
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                const unsigned v0 = destIndices[i + k];
+                const unsigned v1 = destIndices[i + (k + 1) % 3];
+                if (halfEdges.find(edgeKey(welded[v1], welded[v0])) == halfEdges.end())
+                {
+                    locked[v0] = true;
+                    locked[v1] = true;
+                }
+            }
+        }
+    }
+
+    // Accumulate plane quadrics
+    ea::vector<Quadric> quadrics(vertexCount);
+    for (unsigned i = 0; i < destIndices.size(); i += 3)
+    {
+        const Vector3& p0 = positions[destIndices[i]];
+        const Vector3& p1 = positions[destIndices[i + 1]];
+        const Vector3& p2 = positions[destIndices[i + 2]];
+        Vector3 normal = (p1 - p0).CrossProduct(p2 - p0);
+        const float length = normal.Length();
+        if (length < M_EPSILON)
+            continue;
+        normal /= length;
+
+        const Quadric q = Quadric::FromPlane(normal.x_, normal.y_, normal.z_, -normal.DotProduct(p0));
+        for (unsigned k = 0; k < 3; ++k)
+            quadrics[destIndices[i + k]] += q;
+    }
+
+    const float maxCost = maxError < M_INFINITY ? maxError * maxError : M_INFINITY;
+    float resultCost = 0.0f;
+
+    ea::vector<unsigned> adjacencyOffsets(vertexCount + 1);
+    ea::vector<unsigned> adjacency;
+    ea::vector<Collapse> collapses;
+    ea::vector<unsigned> remap(vertexCount);
+    ea::vector<bool> touched(vertexCount);
+
+    while (destIndices.size() > targetIndexCount)
+    {
+        // Build vertex to triangle adjacency
+        const unsigned numTriangles = destIndices.size() / 3;
+        ea::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+        for (unsigned index : destIndices)
+            ++adjacencyOffsets[index + 1];
+        for (unsigned i = 0; i < vertexCount; ++i)
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        adjacency.resize(destIndices.size());
+        {
+            ea::vector<unsigned> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (unsigned i = 0; i < destIndices.size(); ++i)
+                adjacency[cursor[destIndices[i]]++] = i / 3;
+        }
+
+        // Gather collapse candidates
+        collapses.clear();
+        for (unsigned i = 0; i < destIndices.size(); i += 3)
+        {
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                const unsigned from = destIndices[i + k];
+                const unsigned to = destIndices[i + (k + 1) % 3];
+                if (locked[from])
+                    continue;
+
+                Quadric q = quadrics[from];
+                q += quadrics[to];
+                const auto cost = static_cast<float>(q.Evaluate(positions[to]));
+                if (cost <= maxCost)
+                    collapses.push_back(Collapse{ from, to, cost });
+            }
+        }
+        if (collapses.empty())
+            break;
+
+        ea::sort(collapses.begin(), collapses.end());
+
+        // Apply cheapest collapses that do not interfere with each other
+        for (unsigned i = 0; i < vertexCount; ++i)
+            remap[i] = i;
+        ea::fill(touched.begin(), touched.end(), false);
+
+        unsigned removedTriangles = 0;
+        const unsigned trianglesToRemove = numTriangles - targetIndexCount / 3;
+        unsigned numCollapsed = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (removedTriangles >= trianglesToRemove)
+                break;
+            if (touched[collapse.from_] || touched[collapse.to_])
+                continue;
+
+            // Reject collapses that flip triangles
+            const Vector3& target = positions[collapse.to_];
+            bool flipped = false;
+            unsigned removed = 0;
+            for (unsigned j = adjacencyOffsets[collapse.from_]; j < adjacencyOffsets[collapse.from_ + 1]; ++j)
+            {
+                const unsigned* triangle = &destIndices[adjacency[j] * 3];
+                if (triangle[0] == collapse.to_ || triangle[1] == collapse.to_ || triangle[2] == collapse.to_)
+                {
+                    ++removed;
+                    continue;
+                }
+
+                const unsigned k = triangle[0] == collapse.from_ ? 0 : triangle[1] == collapse.from_ ? 1 : 2;
+                const Vector3& p0 = positions[triangle[k]];
+                const Vector3& p1 = positions[triangle[(k + 1) % 3]];
+                const Vector3& p2 = positions[triangle[(k + 2) % 3]];
+                const Vector3 oldNormal = (p1 - p0).CrossProduct(p2 - p0);
+                const Vector3 newNormal = (p1 - target).CrossProduct(p2 - target);
+                if (oldNormal.DotProduct(newNormal) <= 0.0f)
+                {
+                    flipped = true;
+                    break;
+                }
+            }
+            if (flipped)
+                continue;
+
+            // Lock the neighbourhood for the rest of this pass since adjacency becomes stale
+            for (unsigned j = adjacencyOffsets[collapse.from_]; j < adjacencyOffsets[collapse.from_ + 1]; ++j)
+            {
+                const unsigned* triangle = &destIndices[adjacency[j] * 3];
+                touched[triangle[0]] = true;
+                touched[triangle[1]] = true;
+                touched[triangle[2]] = true;
+            }
+
+            remap[collapse.from_] = collapse.to_;
+            quadrics[collapse.to_] += quadrics[collapse.from_];
+            resultCost = Max(resultCost, collapse.cost_);
+            removedTriangles += removed;
+            ++numCollapsed;
+        }
+
+        if (!numCollapsed)
+            break;
+
+        // Rewrite indices and drop degenerate triangles
+        unsigned writeIndex = 0;
+        for (unsigned i = 0; i < destIndices.size(); i += 3)
+        {
+            const unsigned a = remap[destIndices[i]];
+            const unsigned b = remap[destIndices[i + 1]];
+            const unsigned c = remap[destIndices[i + 2]];
+            if (IsDegenerate(a, b, c))
+                continue;
+
+            destIndices[writeIndex++] = a;
+            destIndices[writeIndex++] = b;
+            destIndices[writeIndex++] = c;
+        }
+        destIndices.resize(writeIndex);
+    }
+
+    return sqrtf(resultCost);
+}
+
+}
@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Urho3D.h>
+
+#include <EASTL/vector.h>
+
+#include "../Math/MathDefs.h"
+
+namespace Urho3D
+{
+
+/// Simplify an indexed triangle list using quadric error metrics. Vertices are collapsed onto their neighbours and never moved, so the result refers to the same vertex data as the source. Borders and UV seams are preserved. Stops when the index count reaches target or the error would exceed max error. Return the geometric error of the result in vertex position units.
+URHO3D_API float SimplifyMesh(ea::vector<unsigned>& destIndices, const ea::vector<unsigned>& sourceIndices,
+    const unsigned char* vertexData, unsigned vertexCount, unsigned vertexSize, unsigned positionOffset,
+    unsigned targetIndexCount, float maxError = M_INFINITY);
+
+}
@@ -28,6 +28,8 @@
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Graphics.h"
+#include "../Graphics/MeshOptimizer.h"
+#include "../Graphics/MeshSimplifier.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../IO/Log.h"
 #include "../IO/File.h"
@@ -35,11 +37,18 @@
 #include "../Resource/ResourceCache.h"
 #include "../Resource/XMLFile.h"
 
+#include <EASTL/tuple.h>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Reference viewport height for screen-space error of generated LOD levels.
+static const float LOD_REFERENCE_VIEW_HEIGHT = 1080.0f;
+/// Reference vertical field of view for screen-space error of generated LOD levels.
+static const float LOD_REFERENCE_FOV = 45.0f;
+
 unsigned LookupVertexBuffer(VertexBuffer* buffer, const ea::vector<SharedPtr<VertexBuffer> >& buffers)
 {
     for (unsigned i = 0; i < buffers.size(); ++i)
@@ -60,6 +69,21 @@ unsigned LookupIndexBuffer(IndexBuffer* buffer, const ea::vector<SharedPtr<Index
     return 0;
 }
 
+/// Return index of the index buffer of a geometry in the model's index buffers, or M_MAX_UNSIGNED if the geometry is not indexed or its index buffer is not owned by the model.
+static unsigned FindGeometryIndexBuffer(Geometry* geometry, const ea::vector<SharedPtr<IndexBuffer> >& buffers)
+{
+    IndexBuffer* buffer = geometry->GetIndexBuffer();
+    if (!buffer)
+        return M_MAX_UNSIGNED;
+
+    for (unsigned i = 0; i < buffers.size(); ++i)
+    {
+        if (buffers[i] == buffer)
+            return i;
+    }
+    return M_MAX_UNSIGNED;
+}
+
 Model::Model(Context* context) :
     ResourceWithMetadata(context)
 {
@@ -307,6 +331,16 @@ bool Model::BeginLoad(Deserializer& source)
         geometryCenters_.push_back(Vector3::ZERO);
     memoryUse += sizeof(Vector3) * geometries_.size();
 
+    // Read LOD errors if present
+    if (!source.IsEof() && source.ReadFileID() == "LODE")
+    {
+        for (unsigned i = 0; i < geometries_.size(); ++i)
+        {
+            for (unsigned j = 0; j < geometries_[i].size(); ++j)
+                geometries_[i][j]->SetLodError(source.ReadFloat());
+        }
+    }
+
     // Read metadata
     auto* cache = GetSubsystem<ResourceCache>();
     ea::string xmlName = ReplaceExtension(GetName(), ".xml");
@@ -461,6 +495,29 @@ bool Model::Save(Serializer& dest) const
     for (unsigned i = 0; i < geometryCenters_.size(); ++i)
         dest.WriteVector3(geometryCenters_[i]);
 
+    // Write LOD errors if any geometry has them
+    bool hasLodErrors = false;
+    for (unsigned i = 0; i < geometries_.size() && !hasLodErrors; ++i)
+    {
+        for (unsigned j = 0; j < geometries_[i].size(); ++j)
+        {
+            if (geometries_[i][j] && geometries_[i][j]->GetLodError() > 0.0f)
+            {
+                hasLodErrors = true;
+                break;
+            }
+        }
+    }
+    if (hasLodErrors)
+    {
+        dest.WriteFileID("LODE");
+        for (unsigned i = 0; i < geometries_.size(); ++i)
+        {
+            for (unsigned j = 0; j < geometries_[i].size(); ++j)
+                dest.WriteFloat(geometries_[i][j] ? geometries_[i][j]->GetLodError() : 0.0f);
+        }
+    }
+
     // Write metadata
     if (HasMetadata())
     {
@@ -614,6 +671,308 @@ void Model::SetMorphs(const ea::vector<ModelMorph>& morphs)
     morphs_ = morphs;
 }
 
+bool Model::GenerateLods(unsigned numLodLevels, float reductionFactor, float maxScreenError)
+{
+    URHO3D_PROFILE("GenerateModelLods");
+
+    if (numLodLevels < 2)
+    {
+        URHO3D_LOGERROR("At least 2 LOD levels required for LOD generation");
+        return false;
+    }
+
+    reductionFactor = Clamp(reductionFactor, 0.01f, 0.99f);
+    maxScreenError = Max(maxScreenError, M_EPSILON);
+
+    // LOD distance is world distance divided by the model size, see Camera::GetLodDistance()
+    const float pixelsPerUnit = LOD_REFERENCE_VIEW_HEIGHT * 0.5f / tanf(LOD_REFERENCE_FOV * M_DEGTORAD * 0.5f);
+    const float scale = Max(boundingBox_.Size().DotProduct(DOT_SCALE), M_EPSILON);
+    unsigned memoryUse = GetMemoryUse();
+
+    for (unsigned i = 0; i < geometries_.size(); ++i)
+    {
+        Geometry* baseGeometry = geometries_[i].empty() ? nullptr : geometries_[i][0].Get();
+        if (!baseGeometry || baseGeometry->GetPrimitiveType() != TRIANGLE_LIST)
+            continue;
+
+        VertexBuffer* vertexBuffer = baseGeometry->GetVertexBuffer(0);
+        IndexBuffer* indexBuffer = baseGeometry->GetIndexBuffer();
+        if (!vertexBuffer || !indexBuffer || !vertexBuffer->GetShadowData() || !indexBuffer->GetShadowData())
+        {
+            URHO3D_LOGWARNING("Skipping LOD generation for geometry " + ea::to_string(i) + " without shadowed buffers");
+            continue;
+        }
+
+        const unsigned positionOffset = VertexBuffer::GetElementOffset(vertexBuffer->GetElements(), TYPE_VECTOR3, SEM_POSITION);
+        if (positionOffset == M_MAX_UNSIGNED)
+            continue;
+
+        // Fetch source indices
+        const unsigned indexStart = baseGeometry->GetIndexStart();
+        const unsigned indexCount = baseGeometry->GetIndexCount();
+        const unsigned char* indexData = indexBuffer->GetShadowData();
+        ea::vector<unsigned> sourceIndices(indexCount);
+        for (unsigned j = 0; j < indexCount; ++j)
+        {
+            sourceIndices[j] = indexBuffer->GetIndexSize() == sizeof(unsigned short)
+                ? reinterpret_cast<const unsigned short*>(indexData)[indexStart + j]
+                : reinterpret_cast<const unsigned*>(indexData)[indexStart + j];
+        }
+
+        // Simplify each level from the source so that the error is measured against the original mesh
+        ea::vector<ea::vector<unsigned> > lodIndices;
+        ea::vector<float> lodErrors;
+        float targetCount = static_cast<float>(indexCount);
+        unsigned previousCount = indexCount;
+        for (unsigned level = 1; level < numLodLevels; ++level)
+        {
+            targetCount *= reductionFactor;
+            ea::vector<unsigned> indices;
+            const float error = SimplifyMesh(indices, sourceIndices, vertexBuffer->GetShadowData(),
+                vertexBuffer->GetVertexCount(), vertexBuffer->GetVertexSize(), positionOffset, static_cast<unsigned>(targetCount));
+            if (indices.empty() || indices.size() >= previousCount)
+                break;
+
+            previousCount = indices.size();
+            lodIndices.push_back(ea::move(indices));
+            lodErrors.push_back(error);
+        }
+
+        if (lodIndices.empty())
+            continue;
+
+        // Store all generated levels of the geometry in one new index buffer
+        unsigned totalIndexCount = 0;
+        for (const ea::vector<unsigned>& indices : lodIndices)
+            totalIndexCount += indices.size();
+
+        const bool largeIndices = vertexBuffer->GetVertexCount() > 65535;
+        SharedPtr<IndexBuffer> lodIndexBuffer(context_->CreateObject<IndexBuffer>());
+        lodIndexBuffer->SetShadowed(true);
+        lodIndexBuffer->SetSize(totalIndexCount, largeIndices);
+
+        ea::vector<unsigned char> lodIndexData(totalIndexCount * lodIndexBuffer->GetIndexSize());
+        unsigned offset = 0;
+        for (const ea::vector<unsigned>& indices : lodIndices)
+        {
+            for (unsigned index : indices)
+            {
+                if (largeIndices)
+                    reinterpret_cast<unsigned*>(lodIndexData.data())[offset++] = index;
+                else
+                    reinterpret_cast<unsigned short*>(lodIndexData.data())[offset++] = static_cast<unsigned short>(index);
+            }
+        }
+        lodIndexBuffer->SetData(lodIndexData.data());
+        indexBuffers_.push_back(lodIndexBuffer);
+        memoryUse += sizeof(IndexBuffer) + lodIndexData.size();
+
+        // Define the LOD geometries
+        geometries_[i].resize(lodIndices.size() + 1);
+        unsigned lodIndexStart = 0;
+        float lodDistance = baseGeometry->GetLodDistance();
+        for (unsigned j = 0; j < lodIndices.size(); ++j)
+        {
+            SharedPtr<Geometry> geometry(context_->CreateObject<Geometry>());
+            geometry->SetNumVertexBuffers(baseGeometry->GetNumVertexBuffers());
+            for (unsigned k = 0; k < baseGeometry->GetNumVertexBuffers(); ++k)
+                geometry->SetVertexBuffer(k, baseGeometry->GetVertexBuffer(k));
+            geometry->SetIndexBuffer(lodIndexBuffer);
+            geometry->SetDrawRange(TRIANGLE_LIST, lodIndexStart, lodIndices[j].size());
+
+            lodDistance = Max(lodDistance + M_EPSILON, lodErrors[j] * pixelsPerUnit / (maxScreenError * scale));
+            geometry->SetLodDistance(lodDistance);
+            geometry->SetLodError(lodErrors[j]);
+
+            geometries_[i][j + 1] = geometry;
+            lodIndexStart += lodIndices[j].size();
+            memoryUse += sizeof(Geometry);
+        }
+    }
+
+    SetMemoryUse(memoryUse);
+    return true;
+}
+
+void Model::OptimizeGeometries(bool optimizeOverdraw, bool optimizeVertexFetch, float* acmrBefore, float* acmrAfter)
+{
+    URHO3D_PROFILE("OptimizeModelGeometries");
+
+    // Decode index buffers
+    ea::vector<ea::vector<unsigned> > indexData(indexBuffers_.size());
+    for (unsigned i = 0; i < indexBuffers_.size(); ++i)
+    {
+        IndexBuffer* buffer = indexBuffers_[i];
+        const unsigned char* data = buffer ? buffer->GetShadowData() : nullptr;
+        if (!data)
+            continue;
+
+        indexData[i].resize(buffer->GetIndexCount());
+        for (unsigned j = 0; j < buffer->GetIndexCount(); ++j)
+        {
+            indexData[i][j] = buffer->GetIndexSize() == sizeof(unsigned short)
+                ? reinterpret_cast<const unsigned short*>(data)[j] : reinterpret_cast<const unsigned*>(data)[j];
+        }
+    }
+
+    // Optimize triangle order of each distinct draw range once
+    ea::vector<ea::tuple<unsigned, unsigned, unsigned> > optimizedRanges;
+    float missesBefore = 0.0f;
+    float missesAfter = 0.0f;
+    unsigned numTriangles = 0;
+    for (const ea::vector<SharedPtr<Geometry> >& lodLevels : geometries_)
+    {
+        for (Geometry* geometry : lodLevels)
+        {
+            if (!geometry || geometry->GetPrimitiveType() != TRIANGLE_LIST || geometry->GetNumVertexBuffers() != 1)
+                continue;
+
+            VertexBuffer* vertexBuffer = geometry->GetVertexBuffer(0);
+            const unsigned ibRef = FindGeometryIndexBuffer(geometry, indexBuffers_);
+            if (!vertexBuffer || !vertexBuffer->GetShadowData() || ibRef == M_MAX_UNSIGNED || indexData[ibRef].empty())
+                continue;
+
+            const unsigned indexStart = geometry->GetIndexStart();
+            const unsigned indexCount = geometry->GetIndexCount() / 3 * 3;
+            const auto range = ea::make_tuple(ibRef, indexStart, indexCount);
+            if (indexStart + indexCount > indexData[ibRef].size() ||
+                ea::find(optimizedRanges.begin(), optimizedRanges.end(), range) != optimizedRanges.end())
+                continue;
+            optimizedRanges.push_back(range);
+
+            unsigned* indices = &indexData[ibRef][indexStart];
+            const unsigned vertexCount = vertexBuffer->GetVertexCount();
+            missesBefore += CalculateACMR(indices, indexCount, vertexCount) * (indexCount / 3);
+
+            OptimizeVertexCache(indices, indexCount, vertexCount);
+            if (optimizeOverdraw)
+            {
+                const unsigned positionOffset = VertexBuffer::GetElementOffset(vertexBuffer->GetElements(), TYPE_VECTOR3, SEM_POSITION);
+                if (positionOffset != M_MAX_UNSIGNED)
+                {
+                    OptimizeOverdraw(indices, indexCount, vertexBuffer->GetShadowData(), vertexCount, vertexBuffer->GetVertexSize(),
+                        positionOffset);
+                }
+            }
+
+            missesAfter += CalculateACMR(indices, indexCount, vertexCount) * (indexCount / 3);
+            numTriangles += indexCount / 3;
+        }
+    }
+
+    // Reorder vertices by first use. Only buffers referenced exclusively through index buffers owned by them are remapped
+    if (optimizeVertexFetch)
+    {
+        for (unsigned i = 0; i < vertexBuffers_.size(); ++i)
+        {
+            VertexBuffer* vertexBuffer = vertexBuffers_[i];
+            if (!vertexBuffer || !vertexBuffer->GetShadowData() || morphRangeCounts_[i])
+                continue;
+
+            ea::vector<unsigned> ibRefs;
+            ea::vector<unsigned> usedIndices;
+            bool canRemap = true;
+            for (const ea::vector<SharedPtr<Geometry> >& lodLevels : geometries_)
+            {
+                for (Geometry* geometry : lodLevels)
+                {
+                    if (!geometry)
+                        continue;
+
+                    const ea::vector<SharedPtr<VertexBuffer> >& geometryBuffers = geometry->GetVertexBuffers();
+                    const bool usesBuffer = ea::find(geometryBuffers.begin(), geometryBuffers.end(), vertexBuffer) != geometryBuffers.end();
+                    if (!usesBuffer)
+                        continue;
+
+                    const unsigned ibRef = FindGeometryIndexBuffer(geometry, indexBuffers_);
+                    if (geometryBuffers.size() != 1 || ibRef == M_MAX_UNSIGNED || indexData[ibRef].empty())
+                    {
+                        canRemap = false;
+                        continue;
+                    }
+
+                    if (ea::find(ibRefs.begin(), ibRefs.end(), ibRef) == ibRefs.end())
+                        ibRefs.push_back(ibRef);
+
+                    const unsigned end = Min(geometry->GetIndexStart() + geometry->GetIndexCount(), indexData[ibRef].size());
+                    for (unsigned j = geometry->GetIndexStart(); j < end; ++j)
+                        usedIndices.push_back(indexData[ibRef][j]);
+                }
+            }
+
+            // Index buffers shared with other vertex buffers can not be remapped
+            for (const ea::vector<SharedPtr<Geometry> >& lodLevels : geometries_)
+            {
+                for (Geometry* geometry : lodLevels)
+                {
+                    if (geometry && geometry->GetVertexBuffer(0) != vertexBuffer &&
+                        ea::find(ibRefs.begin(), ibRefs.end(), FindGeometryIndexBuffer(geometry, indexBuffers_)) != ibRefs.end())
+                        canRemap = false;
+                }
+            }
+
+            if (!canRemap || ibRefs.empty())
+                continue;
+
+            const unsigned vertexCount = vertexBuffer->GetVertexCount();
+            ea::vector<unsigned> remap;
+            BuildVertexFetchRemap(remap, usedIndices.data(), usedIndices.size(), vertexCount);
+
+            for (unsigned ibRef : ibRefs)
+            {
+                for (unsigned& index : indexData[ibRef])
+                {
+                    if (index < vertexCount)
+                        index = remap[index];
+                }
+            }
+
+            const unsigned vertexSize = vertexBuffer->GetVertexSize();
+            const unsigned char* sourceData = vertexBuffer->GetShadowData();
+            ea::vector<unsigned char> vertexData(vertexCount * vertexSize);
+            for (unsigned j = 0; j < vertexCount; ++j)
+                memcpy(&vertexData[remap[j] * vertexSize], sourceData + j * vertexSize, vertexSize);
+            vertexBuffer->SetData(vertexData.data());
+        }
+    }
+
+    // Write back index buffers, using 16-bit indices where possible
+    for (unsigned i = 0; i < indexBuffers_.size(); ++i)
+    {
+        IndexBuffer* buffer = indexBuffers_[i];
+        const ea::vector<unsigned>& indices = indexData[i];
+        if (indices.empty())
+            continue;
+
+        const bool largeIndices = *ea::max_element(indices.begin(), indices.end()) > 65535;
+        if (!largeIndices && buffer->GetIndexSize() == sizeof(unsigned))
+            buffer->SetSize(buffer->GetIndexCount(), false, buffer->IsDynamic());
+
+        if (buffer->GetIndexSize() == sizeof(unsigned short))
+        {
+            ea::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            buffer->SetData(shortIndices.data());
+        }
+        else
+            buffer->SetData(indices.data());
+    }
+
+    // Update vertex ranges
+    for (const ea::vector<SharedPtr<Geometry> >& lodLevels : geometries_)
+    {
+        for (Geometry* geometry : lodLevels)
+        {
+            if (geometry && geometry->GetIndexBuffer())
+                geometry->SetDrawRange(geometry->GetPrimitiveType(), geometry->GetIndexStart(), geometry->GetIndexCount());
+        }
+    }
+
+    if (acmrBefore)
+        *acmrBefore = numTriangles ? missesBefore / numTriangles : 0.0f;
+    if (acmrAfter)
+        *acmrAfter = numTriangles ? missesAfter / numTriangles : 0.0f;
+}
+
 SharedPtr<Model> Model::Clone(const ea::string& cloneName) const
 {
     SharedPtr<Model> ret(context_->CreateObject<Model>());
@@ -705,6 +1064,7 @@ SharedPtr<Model> Model::Clone(const ea::string& cloneName) const
                 cloneGeometry->SetDrawRange(origGeometry->GetPrimitiveType(), origGeometry->GetIndexStart(),
                     origGeometry->GetIndexCount(), origGeometry->GetVertexStart(), origGeometry->GetVertexCount(), false);
                 cloneGeometry->SetLodDistance(origGeometry->GetLodDistance());
+                cloneGeometry->SetLodError(origGeometry->GetLodError());
             }
 
             ret->geometries_[i][j] = cloneGeometry;
@@ -158,6 +158,11 @@ public:
     void SetGeometryBoneMappings(const ea::vector<ea::vector<unsigned> >& geometryBoneMappings);
     /// Set vertex morphs.
     void SetMorphs(const ea::vector<ModelMorph>& morphs);
+    /// Generate LOD levels for all triangle list geometries by mesh simplification, replacing all but the first LOD level. Each level keeps reductionFactor of the previous level's triangles. LOD distances are chosen so that the simplification error stays below maxScreenError pixels at the reference 1080p resolution and 45 degree field of view. Requires shadowed buffers. Return true if successful.
+    bool GenerateLods(unsigned numLodLevels, float reductionFactor = 0.5f, float maxScreenError = 1.0f);
+    /// Optimize triangle order of all triangle list geometries for post-transform vertex cache and overdraw, reorder vertices for fetch locality and use 16-bit indices where possible. Vertex buffers with morphs are not reordered. Requires shadowed buffers. Optionally return the average cache miss ratio before and after.
+    void OptimizeGeometries(bool optimizeOverdraw = true, bool optimizeVertexFetch = true, float* acmrBefore = nullptr,
+        float* acmrAfter = nullptr);
     /// Clone the model. The geometry data is deep-copied and can be modified in the clone without affecting the original.
     SharedPtr<Model> Clone(const ea::string& cloneName = EMPTY_STRING) const;
 
@@ -316,6 +316,9 @@ Octree::Octree(Context* context) :
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, nullptr, this),
     numLevels_(DEFAULT_OCTREE_LEVELS)
 {
+    for (unsigned i = 0; i < MAX_ANIMATION_LOD_LEVELS; ++i)
+        animationLodUpdates_[i] = 0;
+
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
@@ -372,6 +375,13 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
+    // Apply the node movement since the scene update, so that drawables are reinserted with up to date transforms
+    if (Scene* scene = GetScene())
+        scene->UpdateTransforms();
+
+    for (unsigned i = 0; i < MAX_ANIMATION_LOD_LEVELS; ++i)
+        animationLodUpdates_[i] = 0;
+
     // Let drawables update themselves before reinsertion. This can be used for animation
     if (!drawableUpdates_.empty())
     {
@@ -573,6 +583,16 @@ void Octree::CancelUpdate(Drawable* drawable)
     drawable->updateQueued_ = false;
 }
 
+void Octree::AddAnimationLodUpdate(unsigned level)
+{
+    ++animationLodUpdates_[Min(level, MAX_ANIMATION_LOD_LEVELS - 1)];
+}
+
+unsigned Octree::GetNumAnimationLodUpdates(unsigned level) const
+{
+    return level < MAX_ANIMATION_LOD_LEVELS ? animationLodUpdates_[level].load() : 0;
+}
+
 void Octree::DrawDebugGeometry(bool depthTest)
 {
     auto* debug = GetComponent<DebugRenderer>();
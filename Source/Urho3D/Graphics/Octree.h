@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "../Core/Mutex.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
@@ -196,6 +198,10 @@ public:
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
+    /// Count an animated model bone update at an animation LOD level. May be called from a worker thread.
+    void AddAnimationLodUpdate(unsigned level);
+    /// Return number of animated models that updated their bones at an animation LOD level this frame.
+    unsigned GetNumAnimationLodUpdates(unsigned level) const;
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
@@ -215,6 +221,8 @@ private:
     mutable ea::vector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Animated model bone updates per animation LOD level this frame.
+    std::atomic<unsigned> animationLodUpdates_[MAX_ANIMATION_LOD_LEVELS];
 };
 
 }
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/Skinning.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+#ifdef URHO3D_SSE
+/// Load three floats into the low lanes of a vector without reading past the last one.
+static inline __m128 LoadVector3(const float* src)
+{
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)src), _mm_load_ss(src + 2));
+}
+
+/// Store the three low lanes of a vector without writing past the last one.
+static inline void StoreVector3(float* dest, __m128 vec)
+{
+    _mm_storel_pi((__m64*)dest, vec);
+    _mm_store_ss(dest + 2, _mm_movehl_ps(vec, vec));
+}
+
+/// Transform a vector by a matrix given as three rows. Return the result in the three low lanes.
+static inline __m128 TransformRows(__m128 row0, __m128 row1, __m128 row2, __m128 vec)
+{
+    __m128 r0 = _mm_mul_ps(row0, vec);
+    __m128 r1 = _mm_mul_ps(row1, vec);
+    __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+    __m128 r2 = _mm_mul_ps(row2, vec);
+    __m128 r3 = _mm_setzero_ps();
+    __m128 t2 = _mm_add_ps(_mm_unpacklo_ps(r2, r3), _mm_unpackhi_ps(r2, r3));
+    return _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+}
+#endif
+
+/// Add a weighted three-component delta to a vertex attribute.
+static inline void AddWeightedVector3(float* dest, const float* src, float weight)
+{
+#ifdef URHO3D_SSE
+    StoreVector3(dest, _mm_add_ps(LoadVector3(dest), _mm_mul_ps(LoadVector3(src), _mm_set1_ps(weight))));
+#else
+    dest[0] += src[0] * weight;
+    dest[1] += src[1] * weight;
+    dest[2] += src[2] * weight;
+#endif
+}
+
+void ApplyMorphDeltas(unsigned char* destVertexData, unsigned vertexSize, unsigned morphRangeStart,
+    const unsigned char* morphData, unsigned morphVertexCount, VertexMaskFlags elementMask, unsigned normalOffset,
+    unsigned tangentOffset, float weight)
+{
+    const unsigned char* srcData = morphData;
+
+    while (morphVertexCount--)
+    {
+        unsigned vertexIndex = *((const unsigned*)srcData) - morphRangeStart;
+        srcData += sizeof(unsigned);
+        unsigned char* dest = destVertexData + vertexIndex * vertexSize;
+
+        if (elementMask & MASK_POSITION)
+        {
+            AddWeightedVector3((float*)dest, (const float*)srcData, weight);
+            srcData += 3 * sizeof(float);
+        }
+        if (elementMask & MASK_NORMAL)
+        {
+            AddWeightedVector3((float*)(dest + normalOffset), (const float*)srcData, weight);
+            srcData += 3 * sizeof(float);
+        }
+        if (elementMask & MASK_TANGENT)
+        {
+            AddWeightedVector3((float*)(dest + tangentOffset), (const float*)srcData, weight);
+            srcData += 3 * sizeof(float);
+        }
+    }
+}
+
+void SkinVertices(Vector3* destPositions, Vector3* destNormals, const unsigned char* vertexData, unsigned vertexSize,
+    unsigned vertexCount, unsigned positionOffset, unsigned normalOffset, unsigned blendWeightsOffset, unsigned blendIndicesOffset,
+    const Matrix3x4* skinMatrices, unsigned numSkinMatrices)
+{
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        const unsigned char* vertex = vertexData + i * vertexSize;
+        const auto* weights = (const float*)(vertex + blendWeightsOffset);
+        const unsigned char* indices = vertex + blendIndicesOffset;
+        const auto* position = (const float*)(vertex + positionOffset);
+
+#ifdef URHO3D_SSE
+        // Blend the skin matrices row by row, then transform
+        __m128 row0 = _mm_setzero_ps();
+        __m128 row1 = _mm_setzero_ps();
+        __m128 row2 = _mm_setzero_ps();
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            if (weights[j] == 0.0f || indices[j] >= numSkinMatrices)
+                continue;
+            const Matrix3x4& matrix = skinMatrices[indices[j]];
+            __m128 weight = _mm_set1_ps(weights[j]);
+            row0 = _mm_add_ps(row0, _mm_mul_ps(_mm_loadu_ps(&matrix.m00_), weight));
+            row1 = _mm_add_ps(row1, _mm_mul_ps(_mm_loadu_ps(&matrix.m10_), weight));
+            row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_loadu_ps(&matrix.m20_), weight));
+        }
+
+        __m128 vec = _mm_set_ps(1.0f, position[2], position[1], position[0]);
+        StoreVector3(&destPositions[i].x_, TransformRows(row0, row1, row2, vec));
+        if (destNormals)
+        {
+            const auto* normal = (const float*)(vertex + normalOffset);
+            vec = _mm_set_ps(0.0f, normal[2], normal[1], normal[0]);
+            StoreVector3(&destNormals[i].x_, TransformRows(row0, row1, row2, vec));
+        }
+#else
+        Matrix3x4 blended = Matrix3x4::ZERO;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            if (weights[j] == 0.0f || indices[j] >= numSkinMatrices)
+                continue;
+            blended = blended + skinMatrices[indices[j]] * weights[j];
+        }
+
+        destPositions[i] = blended * Vector3(position[0], position[1], position[2]);
+        if (destNormals)
+        {
+            const auto* normal = (const float*)(vertex + normalOffset);
+            destNormals[i] = blended.ToMatrix3() * Vector3(normal[0], normal[1], normal[2]);
+        }
+#endif
+    }
+}
+
+}
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/GraphicsDefs.h"
+#include "../Math/Matrix3x4.h"
+
+namespace Urho3D
+{
+
+/// Add weighted vertex morph deltas to float vertex data. Morph data is packed as <index, data> pairs. Vertex indices are offset by morphRangeStart before addressing the destination.
+URHO3D_API void ApplyMorphDeltas(unsigned char* destVertexData, unsigned vertexSize, unsigned morphRangeStart,
+    const unsigned char* morphData, unsigned morphVertexCount, VertexMaskFlags elementMask, unsigned normalOffset,
+    unsigned tangentOffset, float weight);
+
+/// Transform vertex positions and optionally normals by up to four weighted skin matrices per vertex. Source vertex data must contain float positions, 4-float blend weights and 4-byte blend indices, which index the skin matrix array. Normals are not renormalized.
+URHO3D_API void SkinVertices(Vector3* destPositions, Vector3* destNormals, const unsigned char* vertexData, unsigned vertexSize,
+    unsigned vertexCount, unsigned positionOffset, unsigned normalOffset, unsigned blendWeightsOffset, unsigned blendIndicesOffset,
+    const Matrix3x4* skinMatrices, unsigned numSkinMatrices);
+
+}
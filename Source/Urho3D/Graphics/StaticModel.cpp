@@ -44,9 +44,18 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+static const char* lodModeNames[] =
+{
+    "Distance",
+    "Screen Error",
+    nullptr
+};
+
 StaticModel::StaticModel(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY),
     occlusionLodLevel_(M_MAX_UNSIGNED),
+    lodMode_(LOD_DISTANCE),
+    lodScreenError_(1.0f),
     materialsAttr_(Material::GetTypeStatic())
 {
 }
@@ -69,6 +78,8 @@ void StaticModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_ATTRIBUTE("Occlusion LOD Level", int, occlusionLodLevel_, M_MAX_UNSIGNED, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("LOD Mode", GetLodMode, SetLodMode, StaticModelLodMode, lodModeNames, LOD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("LOD Screen Error", GetLodScreenError, SetLodScreenError, float, 1.0f, AM_DEFAULT);
 }
 
 void StaticModel::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results)
@@ -146,7 +157,20 @@ void StaticModel::UpdateBatches(const FrameInfo& frame)
     float scale = worldBoundingBox.Size().DotProduct(DOT_SCALE);
     float newLodDistance = frame.camera_->GetLodDistance(distance_, scale, lodBias_);
 
-    if (newLodDistance != lodDistance_)
+    if (lodMode_ == LOD_SCREEN_ERROR)
+    {
+        lodDistance_ = newLodDistance;
+
+        // Convert model space error to pixels at the current distance, taking LOD bias into account
+        const Vector3 worldScale = node_->GetWorldScale();
+        const float maxScale = Max(Max(Abs(worldScale.x_), Abs(worldScale.y_)), Abs(worldScale.z_));
+        const float viewExtent = frame.camera_->GetHalfViewSize() * (frame.camera_->IsOrthographic() ? 1.0f : distance_);
+        const float bias = Max(lodBias_ * frame.camera_->GetLodBias(), M_EPSILON);
+        const float errorScale = viewExtent > M_EPSILON ?
+            maxScale * frame.viewSize_.y_ * 0.5f * bias / (viewExtent * Max(lodScreenError_, M_EPSILON)) : M_INFINITY;
+        CalculateScreenErrorLodLevels(errorScale);
+    }
+    else if (newLodDistance != lodDistance_)
     {
         lodDistance_ = newLodDistance;
         CalculateLodLevels();
@@ -299,6 +323,19 @@ void StaticModel::SetOcclusionLodLevel(unsigned level)
     MarkNetworkUpdate();
 }
 
+void StaticModel::SetLodMode(StaticModelLodMode mode)
+{
+    lodMode_ = mode;
+    ResetLodLevels();
+    MarkNetworkUpdate();
+}
+
+void StaticModel::SetLodScreenError(float pixels)
+{
+    lodScreenError_ = Max(pixels, 0.0f);
+    MarkNetworkUpdate();
+}
+
 void StaticModel::ApplyMaterialList(const ea::string& fileName)
 {
     ea::string useFileName = fileName;
@@ -444,6 +481,36 @@ void StaticModel::CalculateLodLevels()
     }
 }
 
+void StaticModel::CalculateScreenErrorLodLevels(float errorScale)
+{
+    for (unsigned i = 0; i < batches_.size(); ++i)
+    {
+        const ea::vector<SharedPtr<Geometry> >& batchGeometries = geometries_[i];
+        if (batchGeometries.size() <= 1)
+            continue;
+
+        // Error grows with LOD level, so pick the last level within the threshold. Fall back to LOD distance for levels without error
+        unsigned j;
+
+        for (j = 1; j < batchGeometries.size(); ++j)
+        {
+            Geometry* geometry = batchGeometries[j];
+            if (!geometry)
+                break;
+            if (geometry->GetLodError() > 0.0f ? geometry->GetLodError() * errorScale > 1.0f :
+                lodDistance_ <= geometry->GetLodDistance())
+                break;
+        }
+
+        unsigned newLodLevel = j - 1;
+        if (geometryData_[i].lodLevel_ != newLodLevel)
+        {
+            geometryData_[i].lodLevel_ = newLodLevel;
+            batches_[i].geometry_ = batchGeometries[newLodLevel];
+        }
+    }
+}
+
 void StaticModel::HandleModelReloadFinished(StringHash eventType, VariantMap& eventData)
 {
     Model* currentModel = model_;
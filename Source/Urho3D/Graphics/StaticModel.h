@@ -29,6 +29,15 @@ namespace Urho3D
 
 class Model;
 
+/// Static model LOD level selection mode.
+enum StaticModelLodMode
+{
+    /// Select LOD levels by LOD distance.
+    LOD_DISTANCE = 0,
+    /// Select the coarsest LOD level whose projected geometric error is below the screen error threshold.
+    LOD_SCREEN_ERROR,
+};
+
 /// Static model per-geometry extra data.
 struct StaticModelGeometryData
 {
@@ -70,6 +79,10 @@ public:
     virtual bool SetMaterial(unsigned index, Material* material);
     /// Set occlusion LOD level. By default (M_MAX_UNSIGNED) same as visible.
     void SetOcclusionLodLevel(unsigned level);
+    /// Set LOD level selection mode.
+    void SetLodMode(StaticModelLodMode mode);
+    /// Set maximum projected LOD geometric error in pixels for screen error LOD mode. Divided by LOD bias.
+    void SetLodScreenError(float pixels);
     /// Apply default materials from a material list file. If filename is empty (default), the model's resource name with extension .txt will be used.
     void ApplyMaterialList(const ea::string& fileName = EMPTY_STRING);
 
@@ -87,6 +100,12 @@ public:
     /// Return occlusion LOD level.
     unsigned GetOcclusionLodLevel() const { return occlusionLodLevel_; }
 
+    /// Return LOD level selection mode.
+    StaticModelLodMode GetLodMode() const { return lodMode_; }
+
+    /// Return maximum projected LOD geometric error in pixels.
+    float GetLodScreenError() const { return lodScreenError_; }
+
     /// Determines if the given world space point is within the model geometry.
     bool IsInside(const Vector3& point) const;
     /// Determines if the given local space point is within the model geometry.
@@ -112,6 +131,8 @@ protected:
     void ResetLodLevels();
     /// Choose LOD levels based on distance.
     void CalculateLodLevels();
+    /// Choose LOD levels based on projected geometric error. Error scale converts model space error to pixels.
+    void CalculateScreenErrorLodLevels(float errorScale);
 
     /// Extra per-geometry data.
     ea::vector<StaticModelGeometryData> geometryData_;
@@ -121,6 +142,10 @@ protected:
     SharedPtr<Model> model_;
     /// Occlusion LOD level.
     unsigned occlusionLodLevel_;
+    /// LOD level selection mode.
+    StaticModelLodMode lodMode_;
+    /// Maximum projected LOD geometric error in pixels.
+    float lodScreenError_;
     /// Material list attribute.
     mutable ResourceRefList materialsAttr_;
 
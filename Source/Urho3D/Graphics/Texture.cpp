@@ -25,6 +25,7 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsImpl.h"
 #include "../Graphics/Material.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
@@ -61,7 +62,14 @@ Texture::Texture(Context* context) :
 {
 }
 
-Texture::~Texture() = default;
+Texture::~Texture()
+{
+    if (IsStreamed())
+    {
+        if (auto* streamer = GetSubsystem<TextureStreamer>())
+            streamer->RemoveTexture(this);
+    }
+}
 
 void Texture::SetNumLevels(unsigned levels)
 {
@@ -123,7 +131,10 @@ void Texture::SetMipsToSkip(MaterialQuality quality, int toSkip)
 
 int Texture::GetMipsToSkip(MaterialQuality quality) const
 {
-    return (quality >= QUALITY_LOW && quality < MAX_TEXTURE_QUALITY_LEVELS) ? mipsToSkip_[quality] : 0;
+    const unsigned mipsToSkip = (quality >= QUALITY_LOW && quality < MAX_TEXTURE_QUALITY_LEVELS) ? mipsToSkip_[quality] : 0;
+    const unsigned levelsToSkip = Max(mipsToSkip, streamedLevel_);
+    // Levels missing from the start of a partially loaded image are already skipped
+    return levelsToSkip > streamImageLevel_ ? levelsToSkip - streamImageLevel_ : 0;
 }
 
 int Texture::GetLevelWidth(unsigned level) const
@@ -32,14 +32,26 @@ namespace Urho3D
 
 static const int MAX_TEXTURE_QUALITY_LEVELS = 3;
 
+class Image;
 class XMLElement;
 class XMLFile;
 
+/// Data prepared for changing the streamed mip levels of a texture. Owned by the streaming request, so that it is not shared between threads.
+struct TextureStreamData
+{
+    /// Image data. Empty when there is nothing to upload.
+    SharedPtr<Image> image_;
+    /// Mip level of the texture the image starts from.
+    unsigned imageLevel_{};
+};
+
 /// Base class for texture resources.
 class URHO3D_API Texture : public ResourceWithMetadata, public GPUObject
 {
     URHO3D_OBJECT(Texture, ResourceWithMetadata);
 
+    friend class TextureStreamer;
+
 public:
     /// Construct.
     explicit Texture(Context* context);
@@ -120,8 +132,14 @@ public:
     /// Return backup texture.
     Texture* GetBackupTexture() const { return backupTexture_; }
 
-    /// Return mip levels to skip on a quality setting when loading.
+    /// Return mip levels to skip on a quality setting when loading. For a streamed texture, at least the levels above the resident level are skipped.
     int GetMipsToSkip(MaterialQuality quality) const;
+    /// Return whether mip levels are streamed by the TextureStreamer.
+    bool IsStreamed() const { return streamingIndex_ != M_MAX_UNSIGNED; }
+
+    /// Return top resident mip level of a streamed texture.
+    unsigned GetStreamedLevel() const { return streamedLevel_; }
+
     /// Return mip level width, or 0 if level does not exist.
     int GetLevelWidth(unsigned level) const;
     /// Return mip level width, or 0 if level does not exist.
@@ -195,6 +213,10 @@ protected:
     void CheckTextureBudget(StringHash type);
     /// Create the GPU texture. Implemented in subclasses.
     virtual bool Create() { return true; }
+    /// Prepare data for making mip levels from the specified level down resident. Called by the TextureStreamer, possibly from a worker thread. Return true if successful.
+    virtual bool BeginStreamLevel(unsigned level, TextureStreamData& data) { return false; }
+    /// Finish making mip levels from the specified level down resident using the prepared data. Called by the TextureStreamer from the main thread. Return true if successful.
+    virtual bool EndStreamLevel(unsigned level, TextureStreamData& data) { return false; }
 
     /// OpenGL target.
     unsigned target_{};
@@ -230,6 +252,12 @@ protected:
     unsigned anisotropy_{};
     /// Mip levels to skip when loading per texture quality setting.
     unsigned mipsToSkip_[MAX_TEXTURE_QUALITY_LEVELS]{2, 1, 0};
+    /// Top resident mip level when streamed.
+    unsigned streamedLevel_{};
+    /// Mip level of the texture the image data being uploaded starts from. Nonzero only while uploading streamed levels.
+    unsigned streamImageLevel_{};
+    /// Index in the TextureStreamer, or M_MAX_UNSIGNED if not streamed.
+    unsigned streamingIndex_{M_MAX_UNSIGNED};
     /// Border color.
     Color borderColor_;
     /// Multisampling level.
@@ -29,6 +29,8 @@
 #include "../Graphics/GraphicsImpl.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture2D.h"
+#include "../Graphics/TextureStreamer.h"
+#include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
@@ -39,6 +41,47 @@
 namespace Urho3D
 {
 
+/// Return whether mip levels of a loaded image can be streamed, and if so, the memory use of each level.
+static bool GetStreamedLevelSizes(const Image* image, XMLFile* parameters, int minResidentSize, ea::vector<unsigned>& levelSizes)
+{
+    if (image->IsCubemap() || image->IsArray() || image->GetDepth() > 1)
+        return false;
+    if (Max(image->GetWidth(), image->GetHeight()) <= minResidentSize)
+        return false;
+
+    // Textures without mipmaps or opting out in the parameter file are loaded as a whole
+    if (parameters)
+    {
+        const XMLElement root = parameters->GetRoot();
+        const XMLElement mipmapElem = root.GetChild("mipmap");
+        const XMLElement streamingElem = root.GetChild("streaming");
+        if ((mipmapElem && !mipmapElem.GetBool("enable")) || (streamingElem && !streamingElem.GetBool("enable")))
+            return false;
+    }
+
+    levelSizes.clear();
+    if (image->IsCompressed())
+    {
+        for (unsigned i = 0; i < image->GetNumCompressedLevels(); ++i)
+            levelSizes.push_back(image->GetCompressedLevel(i).dataSize_);
+    }
+    else
+    {
+        int width = image->GetWidth();
+        int height = image->GetHeight();
+        for (;;)
+        {
+            levelSizes.push_back(width * height * image->GetComponents());
+            if (width == 1 && height == 1)
+                break;
+            width = Max(width / 2, 1);
+            height = Max(height / 2, 1);
+        }
+    }
+
+    return levelSizes.size() > 1;
+}
+
 Texture2D::Texture2D(Context* context) :
     Texture(context)
 {
@@ -79,15 +122,19 @@ bool Texture2D::BeginLoad(Deserializer& source)
         return false;
     }
 
-    // Precalculate mip levels if async loading
-    if (GetAsyncLoadState() == ASYNC_LOADING)
-        loadImage_->PrecalculateLevels();
-
     // Load the optional parameters file
     auto* cache = GetSubsystem<ResourceCache>();
     ea::string xmlName = ReplaceExtension(GetName(), ".xml");
     loadParameters_ = cache->GetTempResource<XMLFile>(xmlName, false);
 
+    // Generate mip levels of sRGB textures in linear space
+    if (sRGB_ || (loadParameters_ && loadParameters_->GetRoot().GetChild("srgb").GetBool("enable")))
+        loadImage_->SetSRGB(true);
+
+    // Precalculate mip levels if async loading
+    if (GetAsyncLoadState() == ASYNC_LOADING)
+        loadImage_->PrecalculateLevels();
+
     return true;
 }
 
@@ -101,6 +148,22 @@ bool Texture2D::EndLoad()
     CheckTextureBudget(GetTypeStatic());
 
     SetParameters(loadParameters_);
+
+    // Stream mip levels if enabled. Only the low-detail levels are made resident for now
+    auto* streamer = GetSubsystem<TextureStreamer>();
+    ea::vector<unsigned> levelSizes;
+    streamedLevel_ = 0;
+    if (streamer && streamer->IsEnabled() && usage_ == TEXTURE_STATIC &&
+        GetStreamedLevelSizes(loadImage_, loadParameters_, streamer->GetMinResidentSize(), levelSizes))
+    {
+        auto* renderer = GetSubsystem<Renderer>();
+        const int qualityMipsToSkip = GetMipsToSkip(renderer ? renderer->GetTextureQuality() : QUALITY_HIGH);
+        streamedLevel_ = streamer->AddTexture(this, loadImage_->GetWidth(), loadImage_->GetHeight(), levelSizes, qualityMipsToSkip);
+        streamSRGB_ = loadImage_->IsSRGB();
+    }
+    else if (streamer && IsStreamed())
+        streamer->RemoveTexture(this);
+
     bool success = SetData(loadImage_);
 
     loadImage_.Reset();
@@ -109,6 +172,72 @@ bool Texture2D::EndLoad()
     return success;
 }
 
+bool Texture2D::BeginStreamLevel(unsigned level, TextureStreamData& data)
+{
+    // In headless mode there is nothing to upload
+    if (!graphics_)
+        return true;
+
+    // Reload the image, as only the resident mip levels are kept
+    auto* cache = GetSubsystem<ResourceCache>();
+    SharedPtr<File> file = cache->GetFile(GetName(), false);
+    if (!file)
+        return false;
+
+    auto image = MakeShared<Image>(context_);
+    const bool isContainer = file->ReadFileID() == "UTEX";
+    file->Seek(0);
+    if (isContainer)
+    {
+        // Texture containers store the level offsets, so only the levels to be made resident are read
+        if (!image->LoadLevels(*file, level))
+            return false;
+        image->SetSRGB(streamSRGB_);
+        data.imageLevel_ = level;
+    }
+    else
+    {
+        if (!image->Load(*file))
+            return false;
+
+        // Generate the mip levels here rather than in the main thread
+        image->SetSRGB(streamSRGB_);
+        if (!image->IsCompressed())
+            image->PrecalculateLevels();
+        data.imageLevel_ = 0;
+    }
+
+    data.image_ = image;
+    return true;
+}
+
+bool Texture2D::EndStreamLevel(unsigned level, TextureStreamData& data)
+{
+    // In headless mode only track the level
+    if (!graphics_)
+    {
+        streamedLevel_ = level;
+        return true;
+    }
+
+    SharedPtr<Image> image = ea::move(data.image_);
+    if (!image || graphics_->IsDeviceLost())
+        return false;
+
+    const unsigned oldLevel = streamedLevel_;
+    streamedLevel_ = level;
+    streamImageLevel_ = data.imageLevel_;
+    const bool success = SetData(image);
+    streamImageLevel_ = 0;
+    if (!success)
+    {
+        streamedLevel_ = oldLevel;
+        return false;
+    }
+
+    return true;
+}
+
 bool Texture2D::SetSize(int width, int height, unsigned format, TextureUsage usage, int multiSample, bool autoResolve)
 {
     if (width <= 0 || height <= 0)
@@ -79,6 +79,10 @@ public:
 protected:
     /// Create the GPU texture.
     bool Create() override;
+    /// Reload the image for making mip levels from the specified level down resident. Texture containers are read from that level only. Called by the TextureStreamer from a worker thread.
+    bool BeginStreamLevel(unsigned level, TextureStreamData& data) override;
+    /// Upload the reloaded image from the specified level down. In headless mode only the level is kept. Called by the TextureStreamer from the main thread.
+    bool EndStreamLevel(unsigned level, TextureStreamData& data) override;
 
 private:
     /// Handle render surface update event.
@@ -90,6 +94,8 @@ private:
     SharedPtr<Image> loadImage_;
     /// Parameter file acquired during BeginLoad.
     SharedPtr<XMLFile> loadParameters_;
+    /// Whether the streamed image is sRGB.
+    bool streamSRGB_{};
 };
 
 }
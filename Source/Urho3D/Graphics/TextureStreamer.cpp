@@ -0,0 +1,419 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include <EASTL/sort.h>
+
+#include <cmath>
+#include <limits>
+
+#include "../Core/CoreEvents.h"
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Texture.h"
+#include "../Graphics/TextureStreamer.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+TextureStreamer::TextureStreamer(Context* context) :
+    Object(context)
+{
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(TextureStreamer, HandleEndFrame));
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // Work items refer to the jobs, so they must finish before the jobs are destroyed
+    if (!jobs_.empty() && GetSubsystem<WorkQueue>())
+        Complete();
+
+    for (const Entry& entry : entries_)
+    {
+        if (entry.texture_)
+            entry.texture_->streamingIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void TextureStreamer::SetEnabled(bool enable)
+{
+    enabled_ = enable;
+}
+
+void TextureStreamer::SetMemoryBudget(unsigned long long budget)
+{
+    memoryBudget_ = budget;
+}
+
+void TextureStreamer::SetMinResidentSize(int size)
+{
+    minResidentSize_ = Max(size, 1);
+}
+
+void TextureStreamer::SetMaxLevelChangesPerFrame(unsigned num)
+{
+    maxLevelChangesPerFrame_ = Max(num, 1U);
+}
+
+void TextureStreamer::SetEvictionDelay(unsigned frames)
+{
+    evictionDelay_ = frames;
+}
+
+void TextureStreamer::SetLevelBias(float bias)
+{
+    levelBias_ = bias;
+}
+
+unsigned TextureStreamer::AddTexture(Texture* texture, int width, int height, const ea::vector<unsigned>& levelSizes, unsigned minLevel)
+{
+    if (!texture || levelSizes.empty())
+        return 0;
+
+    unsigned index = texture->streamingIndex_;
+    if (index == M_MAX_UNSIGNED)
+    {
+        if (!freeEntries_.empty())
+        {
+            index = freeEntries_.back();
+            freeEntries_.pop_back();
+        }
+        else
+        {
+            index = entries_.size();
+            entries_.emplace_back();
+        }
+    }
+
+    Entry& entry = entries_[index];
+    entry = Entry();
+    entry.texture_ = texture;
+    entry.width_ = width;
+    entry.lastUseFrame_ = frameNumber_;
+
+    // Accumulate memory use from the smallest level upwards
+    const unsigned numLevels = levelSizes.size();
+    entry.levelMemory_.resize(numLevels);
+    unsigned long long memory = 0;
+    for (unsigned i = numLevels - 1; i < numLevels; --i)
+    {
+        memory += levelSizes[i];
+        entry.levelMemory_[i] = memory;
+    }
+
+    // Initially make resident the first level that fits the minimum resident size
+    unsigned initialLevel = 0;
+    while (initialLevel < numLevels - 1 && Max(width >> initialLevel, height >> initialLevel) > minResidentSize_)
+        ++initialLevel;
+
+    entry.minLevel_ = Min(minLevel, numLevels - 1);
+    entry.maxLevel_ = Max(initialLevel, entry.minLevel_);
+    entry.residentLevel_ = entry.maxLevel_;
+    entry.pendingLevel_ = entry.maxLevel_;
+    entry.wantedLevel_ = entry.maxLevel_;
+
+    texture->streamingIndex_ = index;
+    return entry.maxLevel_;
+}
+
+void TextureStreamer::RemoveTexture(Texture* texture)
+{
+    if (!texture || texture->streamingIndex_ >= entries_.size())
+        return;
+
+    const unsigned index = texture->streamingIndex_;
+    entries_[index] = Entry();
+    freeEntries_.push_back(index);
+    texture->streamingIndex_ = M_MAX_UNSIGNED;
+}
+
+void TextureStreamer::RequestLevel(Texture* texture, unsigned level)
+{
+    if (!texture || texture->streamingIndex_ >= entries_.size())
+        return;
+
+    Entry& entry = entries_[texture->streamingIndex_];
+    entry.requestedLevel_ = Min(entry.requestedLevel_, level);
+}
+
+void TextureStreamer::RequestScreenSize(Texture* texture, float screenSize)
+{
+    if (!texture || texture->streamingIndex_ >= entries_.size())
+        return;
+
+    // Each mip level halves the texel density. Round towards higher detail
+    Entry& entry = entries_[texture->streamingIndex_];
+    const float ratio = (float)entry.width_ / Max(screenSize, 1.0f);
+    const float level = log2f(Max(ratio, 1.0f)) + levelBias_;
+    const unsigned requested = level > 0.0f ? (unsigned)level : 0;
+    entry.requestedLevel_ = Min(entry.requestedLevel_, requested);
+}
+
+void TextureStreamer::RequestMaterial(Material* material, float screenSize)
+{
+    if (!material || entries_.empty())
+        return;
+
+    // Repeating UVs need more texels over the same screen area
+    float uvScale = 1.0f;
+    const ea::unordered_map<StringHash, MaterialShaderParameter>& parameters = material->GetShaderParameters();
+    auto uOffset = parameters.find(VSP_UOFFSET);
+    auto vOffset = parameters.find(VSP_VOFFSET);
+    if (uOffset != parameters.end() && vOffset != parameters.end())
+    {
+        const Vector4& u = uOffset->second.value_.GetVector4();
+        const Vector4& v = vOffset->second.value_.GetVector4();
+        uvScale = Max(Vector2(u.x_, u.y_).Length(), Vector2(v.x_, v.y_).Length());
+    }
+
+    const float texels = screenSize / Max(uvScale, M_EPSILON);
+    for (const auto& pair : material->GetTextures())
+    {
+        Texture* texture = pair.second;
+        if (texture && texture->IsStreamed())
+            RequestScreenSize(texture, texels);
+    }
+}
+
+void TextureStreamer::Update()
+{
+    URHO3D_PROFILE("UpdateTextureStreaming");
+
+    ApplyLevelChanges(false);
+
+    ++frameNumber_;
+
+    // Decide the wanted levels. Textures not requested for a while fall back to their initial level
+    ea::vector<unsigned> upgrades;
+    ea::vector<unsigned> downgrades;
+    unsigned long long memoryUse = 0;
+    for (unsigned i = 0; i < entries_.size(); ++i)
+    {
+        Entry& entry = entries_[i];
+        if (!entry.texture_)
+            continue;
+
+        if (entry.requestedLevel_ != M_MAX_UNSIGNED)
+        {
+            entry.wantedLevel_ = Clamp(entry.requestedLevel_, entry.minLevel_, entry.maxLevel_);
+            entry.lastUseFrame_ = frameNumber_;
+            entry.requestedLevel_ = M_MAX_UNSIGNED;
+        }
+        else if (frameNumber_ - entry.lastUseFrame_ > evictionDelay_)
+            entry.wantedLevel_ = entry.maxLevel_;
+
+        memoryUse += entry.levelMemory_[entry.pendingLevel_];
+
+        if (entry.pendingLevel_ != entry.residentLevel_)
+            continue;
+        if (entry.wantedLevel_ < entry.residentLevel_)
+            upgrades.push_back(i);
+        else if (entry.wantedLevel_ > entry.residentLevel_)
+            downgrades.push_back(i);
+    }
+
+    // Evict least recently used textures first
+    ea::sort(downgrades.begin(), downgrades.end(), [this](unsigned lhs, unsigned rhs)
+    {
+        return entries_[lhs].lastUseFrame_ > entries_[rhs].lastUseFrame_;
+    });
+    // Load textures missing the most detail first
+    ea::sort(upgrades.begin(), upgrades.end(), [this](unsigned lhs, unsigned rhs)
+    {
+        const Entry& lhsEntry = entries_[lhs];
+        const Entry& rhsEntry = entries_[rhs];
+        const unsigned lhsMissing = lhsEntry.residentLevel_ - lhsEntry.wantedLevel_;
+        const unsigned rhsMissing = rhsEntry.residentLevel_ - rhsEntry.wantedLevel_;
+        if (lhsMissing != rhsMissing)
+            return lhsMissing > rhsMissing;
+        return lhsEntry.levelMemory_[lhsEntry.wantedLevel_] < rhsEntry.levelMemory_[rhsEntry.wantedLevel_];
+    });
+
+    unsigned numChanges = 0;
+    const unsigned long long budget = memoryBudget_ ? memoryBudget_ : std::numeric_limits<unsigned long long>::max();
+
+    // Evict until the level changes in progress and the already resident levels fit the budget
+    auto evict = [&]()
+    {
+        if (downgrades.empty() || numChanges >= maxLevelChangesPerFrame_)
+            return false;
+
+        const unsigned index = downgrades.back();
+        downgrades.pop_back();
+        Entry& entry = entries_[index];
+        memoryUse -= entry.levelMemory_[entry.residentLevel_] - entry.levelMemory_[entry.wantedLevel_];
+        StartLevelChange(index, entry.wantedLevel_);
+        ++numChanges;
+        return true;
+    };
+
+    while (memoryUse > budget && evict())
+    {
+    }
+
+    for (unsigned index : upgrades)
+    {
+        if (numChanges >= maxLevelChangesPerFrame_)
+            break;
+
+        Entry& entry = entries_[index];
+        const unsigned long long currentMemory = entry.levelMemory_[entry.residentLevel_];
+
+        // Make room by evicting. If that is not enough, settle for less detail
+        unsigned level = entry.wantedLevel_;
+        while (memoryUse + entry.levelMemory_[level] - currentMemory > budget && evict())
+        {
+        }
+        while (level < entry.residentLevel_ && memoryUse + entry.levelMemory_[level] - currentMemory > budget)
+            ++level;
+        if (level >= entry.residentLevel_ || numChanges >= maxLevelChangesPerFrame_)
+            continue;
+
+        memoryUse += entry.levelMemory_[level] - currentMemory;
+        StartLevelChange(index, level);
+        ++numChanges;
+    }
+}
+
+void TextureStreamer::Complete()
+{
+    ApplyLevelChanges(true);
+}
+
+unsigned long long TextureStreamer::GetMemoryUse() const
+{
+    unsigned long long memoryUse = 0;
+    for (const Entry& entry : entries_)
+    {
+        if (entry.texture_)
+            memoryUse += entry.levelMemory_[entry.pendingLevel_];
+    }
+    return memoryUse;
+}
+
+unsigned TextureStreamer::GetNumTextures() const
+{
+    return entries_.size() - freeEntries_.size();
+}
+
+unsigned TextureStreamer::GetResidentLevel(Texture* texture) const
+{
+    if (!texture || texture->streamingIndex_ >= entries_.size())
+        return 0;
+    return entries_[texture->streamingIndex_].residentLevel_;
+}
+
+unsigned TextureStreamer::GetWantedLevel(Texture* texture) const
+{
+    if (!texture || texture->streamingIndex_ >= entries_.size())
+        return 0;
+    return entries_[texture->streamingIndex_].wantedLevel_;
+}
+
+void TextureStreamer::StartLevelChange(unsigned index, unsigned level)
+{
+    Entry& entry = entries_[index];
+    entry.pendingLevel_ = level;
+
+    auto job = ea::make_unique<Job>();
+    job->index_ = index;
+    job->level_ = level;
+    job->texture_ = entry.texture_.Lock();
+    job->success_ = false;
+    job->done_ = false;
+
+    // Prepare the data in a worker thread with low priority, so that frame work completion does not wait for it
+    Job* jobPtr = job.get();
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (queue)
+    {
+        queue->AddWorkItem([jobPtr]()
+        {
+            jobPtr->success_ = jobPtr->texture_->BeginStreamLevel(jobPtr->level_, jobPtr->data_);
+            jobPtr->done_ = true;
+        }, 0);
+    }
+    else
+    {
+        job->success_ = job->texture_->BeginStreamLevel(level, job->data_);
+        job->done_ = true;
+    }
+
+    jobs_.push_back(ea::move(job));
+}
+
+void TextureStreamer::ApplyLevelChanges(bool waitAll)
+{
+    if (jobs_.empty())
+        return;
+
+    if (waitAll)
+    {
+        if (auto* queue = GetSubsystem<WorkQueue>())
+            queue->Complete(0);
+    }
+
+    // Texture references may be the last ones, so release them only after the job list is consistent
+    ea::vector<SharedPtr<Texture> > finishedTextures;
+    for (unsigned i = 0; i < jobs_.size();)
+    {
+        Job& job = *jobs_[i];
+        if (!job.done_)
+        {
+            ++i;
+            continue;
+        }
+
+        // The texture may have been reloaded or unregistered in the meantime
+        Texture* texture = job.texture_;
+        Entry* entry = texture->streamingIndex_ == job.index_ ? &entries_[job.index_] : nullptr;
+        if (entry && entry->pendingLevel_ == job.level_)
+        {
+            if (job.success_ && texture->EndStreamLevel(job.level_, job.data_))
+                entry->residentLevel_ = job.level_;
+            else
+            {
+                URHO3D_LOGWARNING("Failed to stream mip level " + ea::to_string(job.level_) + " of texture " + texture->GetName());
+                // Do not try again for more detail than is resident now
+                entry->minLevel_ = Max(entry->minLevel_, entry->residentLevel_);
+                entry->wantedLevel_ = entry->residentLevel_;
+            }
+            entry->pendingLevel_ = entry->residentLevel_;
+        }
+
+        finishedTextures.push_back(job.texture_);
+        jobs_.erase(jobs_.begin() + i);
+    }
+}
+
+void TextureStreamer::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    Update();
+}
+
+}
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/unique_ptr.h>
+
+#include <atomic>
+
+#include "../Container/Ptr.h"
+#include "../Core/Object.h"
+#include "../Graphics/Texture.h"
+
+namespace Urho3D
+{
+
+class Material;
+
+/// Texture mip level streaming subsystem. Keeps only the mip levels that are visible on screen resident within a memory budget. Views request levels from the UV density of the drawn geometry, or from the screen size of the bounding box when the geometry has no CPU-side UV data.
+class URHO3D_API TextureStreamer : public Object
+{
+    URHO3D_OBJECT(TextureStreamer, Object);
+
+public:
+    /// Construct.
+    explicit TextureStreamer(Context* context);
+    /// Destruct.
+    ~TextureStreamer() override;
+
+    /// Set whether textures loaded from now on are streamed.
+    void SetEnabled(bool enable);
+    /// Set memory budget in bytes for all streamed textures. Zero means unlimited.
+    void SetMemoryBudget(unsigned long long budget);
+    /// Set maximum width or height of the mip level that is made resident when a texture is loaded.
+    void SetMinResidentSize(int size);
+    /// Set maximum number of level changes started per frame.
+    void SetMaxLevelChangesPerFrame(unsigned num);
+    /// Set number of frames a texture keeps its requested level after it was last requested.
+    void SetEvictionDelay(unsigned frames);
+    /// Set bias added to the mip levels computed from screen size. Positive values prefer lower detail.
+    void SetLevelBias(float bias);
+
+    /// Register a texture for streaming. Level sizes are the memory use of each mip level, starting from the full resolution level. Levels above minLevel are never made resident. Return the level that should be made resident initially.
+    unsigned AddTexture(Texture* texture, int width, int height, const ea::vector<unsigned>& levelSizes, unsigned minLevel = 0);
+    /// Unregister a texture. Called by the texture on destruction.
+    void RemoveTexture(Texture* texture);
+    /// Request a top mip level for a texture for the current frame. Requests from several views are combined.
+    void RequestLevel(Texture* texture, unsigned level);
+    /// Request a top mip level for a texture from the number of pixels its full width covers on screen.
+    void RequestScreenSize(Texture* texture, float screenSize);
+    /// Request top mip levels for the streamed textures of a material. The screen size is the number of pixels a texture repeat covers without the material UV transform, which is applied here.
+    void RequestMaterial(Material* material, float screenSize);
+    /// Process finished level changes, then decide and start new ones for the requests of the last frame. Called automatically at the end of each frame.
+    void Update();
+    /// Wait for all level changes in progress to finish and apply them. Must be called from the main thread.
+    void Complete();
+
+    /// Return whether textures loaded from now on are streamed.
+    bool IsEnabled() const { return enabled_; }
+
+    /// Return memory budget in bytes.
+    unsigned long long GetMemoryBudget() const { return memoryBudget_; }
+
+    /// Return maximum width or height of the initially resident mip level.
+    int GetMinResidentSize() const { return minResidentSize_; }
+
+    /// Return maximum number of level changes started per frame.
+    unsigned GetMaxLevelChangesPerFrame() const { return maxLevelChangesPerFrame_; }
+
+    /// Return number of frames a texture keeps its requested level.
+    unsigned GetEvictionDelay() const { return evictionDelay_; }
+
+    /// Return mip level bias.
+    float GetLevelBias() const { return levelBias_; }
+
+    /// Return memory use of the streamed textures, counting level changes in progress at their target level.
+    unsigned long long GetMemoryUse() const;
+    /// Return number of streamed textures.
+    unsigned GetNumTextures() const;
+    /// Return number of level changes in progress.
+    unsigned GetNumPendingChanges() const { return jobs_.size(); }
+
+    /// Return resident top mip level of a streamed texture, or 0 if the texture is not streamed.
+    unsigned GetResidentLevel(Texture* texture) const;
+    /// Return top mip level a streamed texture is heading to, or 0 if the texture is not streamed.
+    unsigned GetWantedLevel(Texture* texture) const;
+
+private:
+    /// Streamed texture state.
+    struct Entry
+    {
+        /// Texture.
+        WeakPtr<Texture> texture_;
+        /// Full resolution width.
+        int width_{};
+        /// Memory use when each level is the top resident level.
+        ea::vector<unsigned long long> levelMemory_;
+        /// Highest detail level allowed.
+        unsigned minLevel_{};
+        /// Lowest detail level, made resident initially.
+        unsigned maxLevel_{};
+        /// Current top resident level.
+        unsigned residentLevel_{};
+        /// Level being made resident. Same as the resident level when no change is in progress.
+        unsigned pendingLevel_{};
+        /// Best level requested during the current frame, or M_MAX_UNSIGNED if none.
+        unsigned requestedLevel_{M_MAX_UNSIGNED};
+        /// Level the texture is heading to.
+        unsigned wantedLevel_{};
+        /// Frame number when last requested.
+        unsigned lastUseFrame_{};
+    };
+
+    /// Level change in progress.
+    struct Job
+    {
+        /// Entry index.
+        unsigned index_;
+        /// Target level.
+        unsigned level_;
+        /// Texture, kept alive until the change is applied.
+        SharedPtr<Texture> texture_;
+        /// Data prepared by the texture, handed over to the main thread with the job.
+        TextureStreamData data_;
+        /// Result of preparing the data.
+        bool success_;
+        /// Whether preparing the data has finished. Work items are recycled by the WorkQueue, so they can not be polled.
+        std::atomic<bool> done_;
+    };
+
+    /// Start changing the top resident level of an entry.
+    void StartLevelChange(unsigned index, unsigned level);
+    /// Apply finished level changes. Optionally wait for all to finish.
+    void ApplyLevelChanges(bool waitAll);
+    /// Handle end of frame.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Streamed textures. Removed entries are reused.
+    ea::vector<Entry> entries_;
+    /// Indices of removed entries.
+    ea::vector<unsigned> freeEntries_;
+    /// Level changes in progress.
+    ea::vector<ea::unique_ptr<Job> > jobs_;
+    /// Frame counter.
+    unsigned frameNumber_{};
+    /// Enabled flag.
+    bool enabled_{};
+    /// Memory budget in bytes.
+    unsigned long long memoryBudget_{};
+    /// Maximum size of the initially resident level.
+    int minResidentSize_{64};
+    /// Maximum number of level changes started per frame.
+    unsigned maxLevelChangesPerFrame_{4};
+    /// Frames a texture keeps its requested level after last requested.
+    unsigned evictionDelay_{60};
+    /// Mip level bias.
+    float levelBias_{};
+};
+
+}
@@ -45,6 +45,7 @@
 #include "../Graphics/Texture2DArray.h"
 #include "../Graphics/Texture3D.h"
 #include "../Graphics/TextureCube.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../Graphics/View.h"
 #include "../IO/FileSystem.h"
@@ -1195,6 +1196,13 @@ void View::GetBaseBatches()
 {
     URHO3D_PROFILE("GetBaseBatches");
 
+    // Pixels covered by an object of unit size at unit distance, for requesting streamed texture mip levels
+    auto* textureStreamer = GetSubsystem<TextureStreamer>();
+    if (textureStreamer && !textureStreamer->GetNumTextures())
+        textureStreamer = nullptr;
+    const bool orthographic = cullCamera_->IsOrthographic();
+    const float pixelsPerUnit = cullCamera_->GetProjection().m11_ * viewSize_.y_ * 0.5f;
+
     for (auto i = geometries_.begin(); i != geometries_.end(); ++i)
     {
         Drawable* drawable = *i;
@@ -1207,10 +1215,32 @@ void View::GetBaseBatches()
         const ea::vector<SourceBatch>& batches = drawable->GetBatches();
         bool vertexLightsProcessed = false;
 
+        float pixelsPerWorldUnit = 0.0f;
+        float screenSize = 0.0f;
+        if (textureStreamer)
+        {
+            pixelsPerWorldUnit = orthographic ? pixelsPerUnit : pixelsPerUnit / Max(drawable->GetDistance(), M_EPSILON);
+            screenSize = drawable->GetWorldBoundingBox().Size().Length() * pixelsPerWorldUnit;
+        }
+
         for (unsigned j = 0; j < batches.size(); ++j)
         {
             const SourceBatch& srcBatch = batches[j];
 
+            if (textureStreamer)
+            {
+                // The full texture width covers 1 / density model space units. Without UV data, assume it covers the bounding box
+                const float uvDensity = srcBatch.geometry_ ? srcBatch.geometry_->GetUVDensity() : 0.0f;
+                if (uvDensity > 0.0f)
+                {
+                    const Vector3 scale = srcBatch.worldTransform_ ? srcBatch.worldTransform_->Scale() : Vector3::ONE;
+                    const float maxScale = Max(Max(scale.x_, scale.y_), scale.z_);
+                    textureStreamer->RequestMaterial(srcBatch.material_, maxScale * pixelsPerWorldUnit / uvDensity);
+                }
+                else
+                    textureStreamer->RequestMaterial(srcBatch.material_, screenSize);
+            }
+
             // Check here if the material refers to a rendertarget texture with camera(s) attached
             // Only check this for backbuffer views (null rendertarget)
             if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
@@ -0,0 +1,853 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Thread.h"
+#include "../IO/AsyncIO.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+
+#include <EASTL/sort.h>
+#include <LZ4/lz4.h>
+
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(URHO3D_THREADING) && defined(__linux__) && !defined(__ANDROID__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URHO3D_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Size of the header preceding each compressed package block.
+static const unsigned COMPRESSED_BLOCK_HEADER_SIZE = 4;
+/// Maximum uncompressed or compressed size of a package block.
+static const unsigned MAX_PACKAGE_BLOCK_SIZE = 65535;
+/// Number of io_uring submission queue entries.
+static const unsigned IO_URING_ENTRIES = 128;
+/// Completion user data that wakes the completion thread for shutdown.
+static const unsigned long long IO_URING_WAKE_UP = 0xffffffffffffffffULL;
+
+bool DecompressPackageBlocks(const unsigned char* src, unsigned long long srcSize, unsigned char* dest, unsigned size,
+    const ea::vector<unsigned char>* dictionary)
+{
+    unsigned long long srcPos = 0;
+    unsigned destPos = 0;
+    while (destPos < size)
+    {
+        if (srcPos + COMPRESSED_BLOCK_HEADER_SIZE > srcSize)
+            return false;
+
+        const unsigned unpackedSize = src[srcPos] | (src[srcPos + 1] << 8u);
+        const unsigned packedSize = src[srcPos + 2] | (src[srcPos + 3] << 8u);
+        srcPos += COMPRESSED_BLOCK_HEADER_SIZE;
+        if (srcPos + packedSize > srcSize || destPos + unpackedSize > size)
+            return false;
+
+        int decompressedSize;
+        if (dictionary)
+        {
+            decompressedSize = LZ4_decompress_safe_usingDict((const char*)src + srcPos, (char*)dest + destPos, packedSize,
+                unpackedSize, (const char*)dictionary->data(), dictionary->size());
+        }
+        else
+            decompressedSize = LZ4_decompress_safe((const char*)src + srcPos, (char*)dest + destPos, packedSize, unpackedSize);
+
+        if (decompressedSize != (int)unpackedSize)
+            return false;
+
+        srcPos += packedSize;
+        destPos += unpackedSize;
+    }
+
+    return true;
+}
+
+/// Read and decompress package blocks of unknown total compressed size block by block. Return true if successful.
+static bool ReadCompressedBlocks(const AsyncFileHandle& handle, unsigned long long offset, unsigned char* dest, unsigned size,
+    const ea::vector<unsigned char>* dictionary, unsigned long long& bytesRead)
+{
+    unsigned char block[COMPRESSED_BLOCK_HEADER_SIZE + MAX_PACKAGE_BLOCK_SIZE];
+    unsigned destPos = 0;
+    while (destPos < size)
+    {
+        if (handle.ReadAt(offset, block, COMPRESSED_BLOCK_HEADER_SIZE) != COMPRESSED_BLOCK_HEADER_SIZE)
+            return false;
+
+        const unsigned packedSize = block[2] | (block[3] << 8u);
+        if (handle.ReadAt(offset + COMPRESSED_BLOCK_HEADER_SIZE, block + COMPRESSED_BLOCK_HEADER_SIZE, packedSize) != packedSize)
+            return false;
+
+        const unsigned unpackedSize = block[0] | (block[1] << 8u);
+        if (destPos + unpackedSize > size ||
+            !DecompressPackageBlocks(block, COMPRESSED_BLOCK_HEADER_SIZE + packedSize, dest + destPos, unpackedSize, dictionary))
+            return false;
+
+        offset += COMPRESSED_BLOCK_HEADER_SIZE + packedSize;
+        bytesRead += COMPRESSED_BLOCK_HEADER_SIZE + packedSize;
+        destPos += unpackedSize;
+    }
+
+    return true;
+}
+
+#ifdef URHO3D_IO_URING
+/// Submission and completion rings of a Linux io_uring.
+struct AsyncIORing
+{
+    /// In-flight read.
+    struct Slot
+    {
+        /// Request being read.
+        ea::shared_ptr<AsyncReadRequest> request_;
+        /// Destination of the read.
+        iovec iovec_;
+    };
+
+    /// Destruct. Unmap the rings and close the io_uring.
+    ~AsyncIORing()
+    {
+        if (sqes_)
+            munmap(sqes_, sqesSize_);
+        if (cqRing_ && cqRing_ != sqRing_)
+            munmap(cqRing_, cqRingSize_);
+        if (sqRing_)
+            munmap(sqRing_, sqRingSize_);
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    /// Set up the io_uring. Return false if the kernel does not support it or it is not permitted.
+    bool Initialize(unsigned entries)
+    {
+        io_uring_params params{};
+        fd_ = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (fd_ < 0)
+            return false;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            sqRingSize_ = cqRingSize_ = Max(sqRingSize_, cqRingSize_);
+
+        sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED)
+        {
+            sqRing_ = nullptr;
+            return false;
+        }
+
+        if (singleMap)
+            cqRing_ = sqRing_;
+        else
+        {
+            cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED)
+            {
+                cqRing_ = nullptr;
+                return false;
+            }
+        }
+
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return false;
+        sqes_ = (io_uring_sqe*)sqes;
+
+        auto* sq = (unsigned char*)sqRing_;
+        sqHead_ = (unsigned*)(sq + params.sq_off.head);
+        sqTail_ = (unsigned*)(sq + params.sq_off.tail);
+        sqMask_ = *(unsigned*)(sq + params.sq_off.ring_mask);
+        sqArray_ = (unsigned*)(sq + params.sq_off.array);
+
+        auto* cq = (unsigned char*)cqRing_;
+        cqHead_ = (unsigned*)(cq + params.cq_off.head);
+        cqTail_ = (unsigned*)(cq + params.cq_off.tail);
+        cqMask_ = *(unsigned*)(cq + params.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+        entries_ = params.sq_entries;
+        slots_.resize(entries_);
+        freeSlots_.reserve(entries_);
+        for (unsigned i = entries_; i > 0; --i)
+            freeSlots_.push_back(i - 1);
+        return true;
+    }
+
+    /// Return whether another read can be put in flight.
+    bool HasRoom() const { return !freeSlots_.empty(); }
+
+    /// Put a read in the submission queue. Requires HasRoom().
+    void PushRead(const ea::shared_ptr<AsyncReadRequest>& request, void* dest, unsigned size, unsigned long long offset, int fd)
+    {
+        const unsigned slotIndex = freeSlots_.back();
+        freeSlots_.pop_back();
+        Slot& slot = slots_[slotIndex];
+        slot.request_ = request;
+        slot.iovec_.iov_base = dest;
+        slot.iovec_.iov_len = size;
+
+        io_uring_sqe& sqe = PushEntry();
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.addr = (unsigned long long)&slot.iovec_;
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = slotIndex;
+    }
+
+    /// Put a no-op in the submission queue that wakes the completion thread.
+    void PushWakeUp()
+    {
+        io_uring_sqe& sqe = PushEntry();
+        sqe.opcode = IORING_OP_NOP;
+        sqe.user_data = IO_URING_WAKE_UP;
+    }
+
+    /// Submit pushed entries to the kernel.
+    void Submit()
+    {
+        while (numUnsubmitted_)
+        {
+            int submitted = (int)syscall(__NR_io_uring_enter, fd_, numUnsubmitted_, 0, 0, nullptr, 0);
+            if (submitted < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    continue;
+                URHO3D_LOGERROR("Failed to submit asynchronous reads");
+                break;
+            }
+            numUnsubmitted_ -= submitted;
+        }
+    }
+
+    /// Wait for at least one completion.
+    void WaitCompletion() const
+    {
+        syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+
+    /// Return the next submission queue entry, cleared.
+    io_uring_sqe& PushEntry()
+    {
+        const unsigned tail = *sqTail_;
+        const unsigned index = tail & sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        memset(&sqe, 0, sizeof sqe);
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++numUnsubmitted_;
+        return sqe;
+    }
+
+    /// io_uring file descriptor.
+    int fd_{-1};
+    /// Number of submission queue entries.
+    unsigned entries_{};
+    /// Entries pushed but not yet submitted.
+    unsigned numUnsubmitted_{};
+    /// Submission ring mapping.
+    void* sqRing_{};
+    /// Completion ring mapping.
+    void* cqRing_{};
+    /// Submission queue entries mapping.
+    io_uring_sqe* sqes_{};
+    /// Submission ring mapping size.
+    size_t sqRingSize_{};
+    /// Completion ring mapping size.
+    size_t cqRingSize_{};
+    /// Submission queue entries mapping size.
+    size_t sqesSize_{};
+    /// Submission ring head.
+    unsigned* sqHead_{};
+    /// Submission ring tail.
+    unsigned* sqTail_{};
+    /// Submission ring index mask.
+    unsigned sqMask_{};
+    /// Submission ring index array.
+    unsigned* sqArray_{};
+    /// Completion ring head.
+    unsigned* cqHead_{};
+    /// Completion ring tail.
+    unsigned* cqTail_{};
+    /// Completion ring index mask.
+    unsigned cqMask_{};
+    /// Completion queue entries.
+    io_uring_cqe* cqes_{};
+    /// In-flight reads by slot index.
+    ea::vector<Slot> slots_;
+    /// Unused slot indices.
+    ea::vector<unsigned> freeSlots_;
+};
+#else
+/// Placeholder when io_uring is not available.
+struct AsyncIORing
+{
+};
+#endif
+
+/// I/O thread of the asynchronous I/O subsystem.
+class AsyncIOThread : public Thread
+{
+public:
+    /// Construct.
+    AsyncIOThread(AsyncIO* owner, bool ringCompletion) :
+        Thread("AsyncIO"),
+        owner_(owner),
+        ringCompletion_(ringCompletion)
+    {
+    }
+
+    /// Process requests until the owner shuts down.
+    void ThreadFunction() override
+    {
+        if (ringCompletion_)
+            owner_->ProcessRingCompletions();
+        else
+            owner_->ProcessRequests();
+    }
+
+private:
+    /// Owner subsystem.
+    AsyncIO* owner_;
+    /// Whether reaps io_uring completions instead of performing reads.
+    bool ringCompletion_;
+};
+
+AsyncFileHandle::AsyncFileHandle(const ea::string& fileName)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(GetWideNativePath(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle != INVALID_HANDLE_VALUE)
+        handle_ = handle;
+#else
+    descriptor_ = open(GetNativePath(fileName).c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+AsyncFileHandle::AsyncFileHandle(void* stdioFile)
+{
+    if (!stdioFile)
+        return;
+
+#ifdef _WIN32
+    // A reopened handle has its own file pointer, unlike a duplicated one
+    auto original = (HANDLE)_get_osfhandle(_fileno((FILE*)stdioFile));
+    HANDLE handle = ReOpenFile(original, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0);
+    if (handle != INVALID_HANDLE_VALUE)
+        handle_ = handle;
+#else
+    descriptor_ = fcntl(fileno((FILE*)stdioFile), F_DUPFD_CLOEXEC, 0);
+#endif
+}
+
+AsyncFileHandle::~AsyncFileHandle()
+{
+#ifdef _WIN32
+    if (handle_)
+        CloseHandle((HANDLE)handle_);
+#else
+    if (descriptor_ >= 0)
+        close(descriptor_);
+#endif
+}
+
+bool AsyncFileHandle::IsOpen() const
+{
+#ifdef _WIN32
+    return handle_ != nullptr;
+#else
+    return descriptor_ >= 0;
+#endif
+}
+
+unsigned AsyncFileHandle::ReadAt(unsigned long long offset, void* dest, unsigned size) const
+{
+    unsigned totalRead = 0;
+    auto* destPtr = (unsigned char*)dest;
+    while (totalRead < size)
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        overlapped.Offset = (DWORD)(offset + totalRead);
+        overlapped.OffsetHigh = (DWORD)((offset + totalRead) >> 32u);
+        DWORD bytesRead = 0;
+        if (!handle_ || !ReadFile((HANDLE)handle_, destPtr + totalRead, size - totalRead, &bytesRead, &overlapped) || !bytesRead)
+            break;
+#else
+        ssize_t bytesRead = pread(descriptor_, destPtr + totalRead, size - totalRead, (off_t)(offset + totalRead));
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead <= 0)
+            break;
+#endif
+        totalRead += (unsigned)bytesRead;
+    }
+
+    return totalRead;
+}
+
+AsyncReadRequest::AsyncReadRequest(const ea::string& name, const ea::shared_ptr<AsyncFileHandle>& handle,
+    unsigned long long offset, unsigned size) :
+    name_(name),
+    handle_(handle),
+    offset_(offset),
+    size_(size)
+{
+    data_.resize(size);
+}
+
+void AsyncReadRequest::SetCompressed(unsigned packedSize, const ea::shared_ptr<ea::vector<unsigned char> >& dictionary)
+{
+    compressed_ = true;
+    packedSize_ = packedSize;
+    dictionary_ = dictionary;
+}
+
+void AsyncReadRequest::Complete(bool success)
+{
+    success_ = success;
+    handle_.reset();
+    packedData_.clear();
+    packedData_.shrink_to_fit();
+    if (!success)
+        URHO3D_LOGERROR("Failed to read " + name_ + " asynchronously");
+
+    if (callback_)
+    {
+        callback_(*this);
+        callback_ = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        completed_.store(true, std::memory_order_release);
+    }
+    waitCondition_.notify_all();
+}
+
+void AsyncReadRequest::Wait()
+{
+    if (IsCompleted())
+        return;
+
+    std::unique_lock<std::mutex> lock(waitMutex_);
+    waitCondition_.wait(lock, [this] { return IsCompleted(); });
+}
+
+AsyncIO::AsyncIO(Context* context) :
+    Object(context),
+#ifdef URHO3D_THREADING
+    backend_(ASYNC_IO_THREAD_POOL),
+#else
+    backend_(ASYNC_IO_SYNCHRONOUS),
+#endif
+    numThreads_(4),
+    useIOUring_(true),
+    started_(false),
+    shutDown_(false)
+{
+}
+
+AsyncIO::~AsyncIO()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        shutDown_ = true;
+#ifdef URHO3D_IO_URING
+        // Wake up the completion thread. It exits once all reads in flight have completed
+        if (ring_)
+        {
+            ring_->PushWakeUp();
+            ring_->Submit();
+        }
+#endif
+    }
+    queueCondition_.notify_all();
+
+    for (auto& thread : threads_)
+        thread->Stop();
+    threads_.clear();
+    ring_.reset();
+}
+
+void AsyncIO::SetNumThreads(unsigned num)
+{
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (!started_)
+        numThreads_ = Max(num, 1u);
+}
+
+void AsyncIO::SetUseIOUring(bool enable)
+{
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (!started_)
+        useIOUring_ = enable;
+}
+
+void AsyncIO::Read(const ea::shared_ptr<AsyncReadRequest>& request, const AsyncReadCallback& callback)
+{
+    if (!request)
+        return;
+
+    if (callback)
+        request->SetCallback(callback);
+
+#ifdef URHO3D_THREADING
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!shutDown_)
+        {
+            queued = true;
+            StartThreads();
+            QueueRequest(request);
+#ifdef URHO3D_IO_URING
+            if (ring_)
+            {
+                SubmitRingRequests();
+                ring_->Submit();
+            }
+#endif
+        }
+    }
+    queueCondition_.notify_one();
+
+    if (queued)
+        return;
+#endif
+
+    ReadSynchronous(*request);
+}
+
+void AsyncIO::Read(const ea::vector<ea::shared_ptr<AsyncReadRequest> >& requests, const AsyncReadCallback& callback)
+{
+    // Sort by file and offset so that reads of the same file proceed sequentially
+    ea::vector<ea::shared_ptr<AsyncReadRequest> > sorted;
+    sorted.reserve(requests.size());
+    for (const auto& request : requests)
+    {
+        if (!request)
+            continue;
+        if (callback)
+            request->SetCallback(callback);
+        sorted.push_back(request);
+    }
+
+    ea::sort(sorted.begin(), sorted.end(), [](const ea::shared_ptr<AsyncReadRequest>& lhs, const ea::shared_ptr<AsyncReadRequest>& rhs)
+    {
+        if (lhs->handle_ != rhs->handle_)
+            return lhs->handle_ < rhs->handle_;
+        return lhs->offset_ < rhs->offset_;
+    });
+
+#ifdef URHO3D_THREADING
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!shutDown_)
+        {
+            queued = true;
+            StartThreads();
+            for (const auto& request : sorted)
+                QueueRequest(request);
+#ifdef URHO3D_IO_URING
+            if (ring_)
+            {
+                SubmitRingRequests();
+                ring_->Submit();
+            }
+#endif
+        }
+    }
+    queueCondition_.notify_all();
+
+    if (queued)
+        return;
+#endif
+
+    for (const auto& request : sorted)
+        ReadSynchronous(*request);
+}
+
+void AsyncIO::ReadSynchronous(AsyncReadRequest& request)
+{
+    if (request.IsCompleted())
+        return;
+
+    if (!request.handle_ || !request.handle_->IsOpen())
+    {
+        request.Complete(false);
+        return;
+    }
+
+    bool success;
+    if (!request.compressed_)
+        success = request.handle_->ReadAt(request.offset_, request.data_.data(), request.size_) == request.size_;
+    else if (request.packedSize_)
+    {
+        request.packedData_.resize(request.packedSize_);
+        success = request.handle_->ReadAt(request.offset_, request.packedData_.data(), request.packedSize_) == request.packedSize_ &&
+            DecompressPackageBlocks(request.packedData_.data(), request.packedSize_, request.data_.data(), request.size_,
+                request.dictionary_.get());
+    }
+    else
+    {
+        unsigned long long bytesRead = 0;
+        success = ReadCompressedBlocks(*request.handle_, request.offset_, request.data_.data(), request.size_,
+            request.dictionary_.get(), bytesRead);
+    }
+
+    request.Complete(success);
+}
+
+void AsyncIO::StartThreads()
+{
+    if (started_)
+        return;
+    started_ = true;
+
+#ifdef URHO3D_IO_URING
+    if (useIOUring_)
+    {
+        ring_ = ea::make_unique<AsyncIORing>();
+        if (ring_->Initialize(IO_URING_ENTRIES))
+        {
+            backend_ = ASYNC_IO_URING;
+            threads_.push_back(ea::make_unique<AsyncIOThread>(this, true));
+            threads_.back()->Run();
+        }
+        else
+        {
+            URHO3D_LOGDEBUG("io_uring is not available, using I/O threads for asynchronous reads");
+            ring_.reset();
+        }
+    }
+#endif
+
+    // Thread pool requests are also used with io_uring for compressed data of unknown size
+    for (unsigned i = 0; i < numThreads_; ++i)
+    {
+        threads_.push_back(ea::make_unique<AsyncIOThread>(this, false));
+        threads_.back()->Run();
+    }
+}
+
+void AsyncIO::QueueRequest(const ea::shared_ptr<AsyncReadRequest>& request)
+{
+    numPending_.fetch_add(1, std::memory_order_relaxed);
+
+    // Compressed data of unknown size is read block by block by the thread pool
+    if (ring_ && !(request->compressed_ && !request->packedSize_) && request->handle_ && request->handle_->IsOpen())
+        ringQueue_.push_back(request);
+    else
+        poolQueue_.push_back(request);
+}
+
+void AsyncIO::FinishRequest(AsyncReadRequest& request, unsigned bytesRead)
+{
+    bytesRead_.fetch_add(bytesRead, std::memory_order_relaxed);
+
+    bool success;
+    if (request.compressed_)
+    {
+        success = bytesRead == request.packedSize_ && DecompressPackageBlocks(request.packedData_.data(), request.packedSize_,
+            request.data_.data(), request.size_, request.dictionary_.get());
+    }
+    else
+        success = bytesRead == request.size_;
+
+    request.Complete(success);
+    numPending_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void AsyncIO::ProcessRequests()
+{
+    for (;;)
+    {
+        ea::shared_ptr<AsyncReadRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCondition_.wait(lock, [this] { return shutDown_ || !poolQueue_.empty(); });
+            if (poolQueue_.empty())
+                return;
+            request = poolQueue_.front();
+            poolQueue_.pop_front();
+        }
+
+        if (!request->handle_ || !request->handle_->IsOpen())
+        {
+            request->Complete(false);
+            numPending_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (request->compressed_ && !request->packedSize_)
+        {
+            unsigned long long bytesRead = 0;
+            bool success = ReadCompressedBlocks(*request->handle_, request->offset_, request->data_.data(), request->size_,
+                request->dictionary_.get(), bytesRead);
+            bytesRead_.fetch_add(bytesRead, std::memory_order_relaxed);
+            request->Complete(success);
+            numPending_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        unsigned char* dest = request->data_.data();
+        unsigned size = request->size_;
+        if (request->compressed_)
+        {
+            request->packedData_.resize(request->packedSize_);
+            dest = request->packedData_.data();
+            size = request->packedSize_;
+        }
+
+        FinishRequest(*request, request->handle_->ReadAt(request->offset_, dest, size));
+    }
+}
+
+void AsyncIO::SubmitRingRequests()
+{
+#ifdef URHO3D_IO_URING
+    while (!ringQueue_.empty() && ring_->HasRoom())
+    {
+        ea::shared_ptr<AsyncReadRequest> request = ringQueue_.front();
+        ringQueue_.pop_front();
+
+        unsigned char* dest = request->data_.data();
+        unsigned size = request->size_;
+        if (request->compressed_)
+        {
+            request->packedData_.resize(request->packedSize_);
+            dest = request->packedData_.data();
+            size = request->packedSize_;
+        }
+
+        ring_->PushRead(request, dest, size, request->offset_, request->handle_->GetDescriptor());
+    }
+#endif
+}
+
+void AsyncIO::ProcessRingCompletions()
+{
+#ifdef URHO3D_IO_URING
+    struct Completion
+    {
+        ea::shared_ptr<AsyncReadRequest> request_;
+        int result_;
+    };
+    ea::vector<Completion> completions;
+    bool wokenUp = false;
+
+    for (;;)
+    {
+        ring_->WaitCompletion();
+
+        // Only this thread consumes the completion ring
+        unsigned head = *ring_->cqHead_;
+        const unsigned tail = __atomic_load_n(ring_->cqTail_, __ATOMIC_ACQUIRE);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = ring_->cqes_[head & ring_->cqMask_];
+                if (cqe.user_data == IO_URING_WAKE_UP)
+                {
+                    wokenUp = true;
+                    continue;
+                }
+
+                AsyncIORing::Slot& slot = ring_->slots_[(unsigned)cqe.user_data];
+                completions.push_back(Completion{ea::move(slot.request_), cqe.res});
+                ring_->freeSlots_.push_back((unsigned)cqe.user_data);
+            }
+            __atomic_store_n(ring_->cqHead_, head, __ATOMIC_RELEASE);
+
+            // Refill the ring with queued requests
+            if (!shutDown_)
+            {
+                SubmitRingRequests();
+                ring_->Submit();
+            }
+        }
+
+        for (Completion& completion : completions)
+        {
+            AsyncReadRequest& request = *completion.request_;
+            unsigned char* dest = request.compressed_ ? request.packedData_.data() : request.data_.data();
+            unsigned size = request.compressed_ ? request.packedSize_ : request.size_;
+
+            unsigned bytesRead = completion.result_ > 0 ? (unsigned)completion.result_ : 0;
+            // Finish short reads synchronously
+            if (completion.result_ >= 0 && bytesRead < size)
+                bytesRead += request.handle_->ReadAt(request.offset_ + bytesRead, dest + bytesRead, size - bytesRead);
+
+            FinishRequest(request, bytesRead);
+        }
+        completions.clear();
+
+        if (wokenUp)
+        {
+            // Requests that never made it into the ring are read here, reads in flight must still complete
+            ea::deque<ea::shared_ptr<AsyncReadRequest> > remaining;
+            bool idle;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex_);
+                remaining.swap(ringQueue_);
+                idle = ring_->freeSlots_.size() == ring_->entries_;
+            }
+
+            for (const auto& request : remaining)
+            {
+                ReadSynchronous(*request);
+                numPending_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            if (idle)
+                return;
+        }
+    }
+#endif
+}
+
+}
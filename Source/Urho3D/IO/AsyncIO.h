@@ -0,0 +1,248 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/deque.h>
+#include <EASTL/shared_ptr.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/vector.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+class AsyncIOThread;
+class AsyncReadRequest;
+struct AsyncIORing;
+
+/// Backend used for asynchronous reads.
+enum AsyncIOBackend
+{
+    /// Reads are performed in the calling thread. Used when threading is disabled.
+    ASYNC_IO_SYNCHRONOUS = 0,
+    /// Reads are performed by a pool of I/O threads using positional reads.
+    ASYNC_IO_THREAD_POOL,
+    /// Reads are submitted to a Linux io_uring and completed by an I/O thread.
+    ASYNC_IO_URING
+};
+
+/// Decompress LZ4 package blocks from src until size bytes are written to dest. The dictionary is used for blocks compressed against it. Return true if successful.
+URHO3D_API bool DecompressPackageBlocks(const unsigned char* src, unsigned long long srcSize, unsigned char* dest, unsigned size,
+    const ea::vector<unsigned char>* dictionary);
+
+/// Callback invoked when an asynchronous read completes. Called from an I/O thread unless the read completed immediately.
+using AsyncReadCallback = std::function<void(AsyncReadRequest& request)>;
+
+/// Operating system file handle for positional reads. Shared by the read requests that use it and closed when the last one is done.
+class URHO3D_API AsyncFileHandle
+{
+public:
+    /// Construct by opening a file for reading. Check IsOpen() for success.
+    explicit AsyncFileHandle(const ea::string& fileName);
+    /// Construct from an open C stdio file. The handle is duplicated so that reads do not move the stdio file position and the stdio file may be closed while reads are in flight.
+    explicit AsyncFileHandle(void* stdioFile);
+    /// Prevent copy construction.
+    AsyncFileHandle(const AsyncFileHandle& rhs) = delete;
+    /// Prevent assignment.
+    AsyncFileHandle& operator =(const AsyncFileHandle& rhs) = delete;
+    /// Destruct. Close the handle.
+    ~AsyncFileHandle();
+
+    /// Read from an absolute file offset, blocking until done. Return number of bytes read.
+    unsigned ReadAt(unsigned long long offset, void* dest, unsigned size) const;
+
+    /// Return whether the handle is open.
+    bool IsOpen() const;
+
+    /// Return the file descriptor. Not valid on Windows.
+    int GetDescriptor() const { return descriptor_; }
+
+private:
+#ifdef _WIN32
+    /// Win32 file handle.
+    void* handle_{};
+#endif
+    /// POSIX file descriptor.
+    int descriptor_{-1};
+};
+
+/// Asynchronous read of a file range into memory, optionally decompressing package blocks. Shared between the issuing thread and the I/O threads.
+class URHO3D_API AsyncReadRequest
+{
+    friend class AsyncIO;
+
+public:
+    /// Construct for reading size bytes at an absolute offset of the file handle. The handle may be null if the request is completed directly.
+    AsyncReadRequest(const ea::string& name, const ea::shared_ptr<AsyncFileHandle>& handle, unsigned long long offset, unsigned size);
+
+    /// Set the data to be stored as compressed package blocks of packedSize bytes, zero if not known. The optional dictionary is used for blocks compressed against it.
+    void SetCompressed(unsigned packedSize, const ea::shared_ptr<ea::vector<unsigned char> >& dictionary);
+    /// Set the completion callback. Must be set before the request is queued.
+    void SetCallback(const AsyncReadCallback& callback) { callback_ = callback; }
+    /// Mark the request completed and invoke the callback. Called by the I/O backend or when the data is available immediately.
+    void Complete(bool success);
+    /// Wait until the request is completed.
+    void Wait();
+
+    /// Return whether the request is completed, successfully or not.
+    bool IsCompleted() const { return completed_.load(std::memory_order_acquire); }
+
+    /// Return whether the data was read successfully. Valid after completion.
+    bool IsSuccess() const { return success_; }
+
+    /// Return name of the file being read.
+    const ea::string& GetName() const { return name_; }
+
+    /// Return absolute file offset of the read.
+    unsigned long long GetOffset() const { return offset_; }
+
+    /// Return uncompressed size of the data.
+    unsigned GetSize() const { return size_; }
+
+    /// Return whether the data is stored compressed.
+    bool IsCompressed() const { return compressed_; }
+
+    /// Return the data buffer. Sized on construction and filled on successful completion.
+    ea::vector<unsigned char>& GetData() { return data_; }
+
+private:
+    /// File name.
+    ea::string name_;
+    /// File handle.
+    ea::shared_ptr<AsyncFileHandle> handle_;
+    /// Compression dictionary.
+    ea::shared_ptr<ea::vector<unsigned char> > dictionary_;
+    /// Data.
+    ea::vector<unsigned char> data_;
+    /// Compressed data read before decompression.
+    ea::vector<unsigned char> packedData_;
+    /// Completion callback.
+    AsyncReadCallback callback_;
+    /// Absolute file offset.
+    unsigned long long offset_;
+    /// Uncompressed size.
+    unsigned size_;
+    /// Compressed size, zero if not known.
+    unsigned packedSize_{};
+    /// Compression flag.
+    bool compressed_{};
+    /// Success flag.
+    bool success_{};
+    /// Completion flag.
+    std::atomic<bool> completed_{};
+    /// Mutex for waiting on completion.
+    std::mutex waitMutex_;
+    /// Condition signaled on completion.
+    std::condition_variable waitCondition_;
+};
+
+/// %Asynchronous I/O subsystem. Issues many file reads in flight so that loading overlaps disk latency. Uses io_uring on Linux when the kernel allows it and a pool of I/O threads otherwise.
+class URHO3D_API AsyncIO : public Object
+{
+    URHO3D_OBJECT(AsyncIO, Object);
+
+    friend class AsyncIOThread;
+
+public:
+    /// Construct.
+    explicit AsyncIO(Context* context);
+    /// Destruct. Wait for reads in flight to complete.
+    ~AsyncIO() override;
+
+    /// Set number of I/O threads. Only has effect before the first read. Default 4.
+    void SetNumThreads(unsigned num);
+    /// Set whether io_uring may be used when available. Only has effect before the first read. Default true.
+    void SetUseIOUring(bool enable);
+    /// Queue a read request. The callback, if any, is invoked on completion.
+    void Read(const ea::shared_ptr<AsyncReadRequest>& request, const AsyncReadCallback& callback = nullptr);
+    /// Queue several read requests at once. Requests are submitted in file offset order. The callback, if any, is invoked for each request.
+    void Read(const ea::vector<ea::shared_ptr<AsyncReadRequest> >& requests, const AsyncReadCallback& callback = nullptr);
+
+    /// Perform a read request in the calling thread.
+    static void ReadSynchronous(AsyncReadRequest& request);
+
+    /// Return the backend in use. Chosen on the first read.
+    AsyncIOBackend GetBackend() const { return backend_; }
+
+    /// Return number of I/O threads.
+    unsigned GetNumThreads() const { return numThreads_; }
+
+    /// Return whether io_uring may be used.
+    bool GetUseIOUring() const { return useIOUring_; }
+
+    /// Return number of queued and in-flight requests.
+    unsigned GetNumPendingRequests() const { return numPending_.load(std::memory_order_relaxed); }
+
+    /// Return total number of bytes read from disk.
+    unsigned long long GetBytesRead() const { return bytesRead_.load(std::memory_order_relaxed); }
+
+private:
+    /// Choose the backend and start the I/O threads if not started yet. Called with the queue mutex held.
+    void StartThreads();
+    /// Queue a request with the queue mutex held.
+    void QueueRequest(const ea::shared_ptr<AsyncReadRequest>& request);
+    /// Finish a request after its raw data has been read.
+    void FinishRequest(AsyncReadRequest& request, unsigned bytesRead);
+    /// Process thread pool requests until shut down.
+    void ProcessRequests();
+    /// Submit queued io_uring requests while there is room in the ring. Called with the queue mutex held.
+    void SubmitRingRequests();
+    /// Reap io_uring completions until shut down.
+    void ProcessRingCompletions();
+
+    /// Mutex for the request queues.
+    std::mutex queueMutex_;
+    /// Condition signaled when thread pool requests are queued or on shutdown.
+    std::condition_variable queueCondition_;
+    /// Requests for the thread pool.
+    ea::deque<ea::shared_ptr<AsyncReadRequest> > poolQueue_;
+    /// Requests waiting for room in the io_uring.
+    ea::deque<ea::shared_ptr<AsyncReadRequest> > ringQueue_;
+    /// I/O threads.
+    ea::vector<ea::unique_ptr<AsyncIOThread> > threads_;
+    /// io_uring state when in use.
+    ea::unique_ptr<AsyncIORing> ring_;
+    /// Backend.
+    AsyncIOBackend backend_;
+    /// Number of thread pool threads.
+    unsigned numThreads_;
+    /// Queued and in-flight request count.
+    std::atomic<unsigned> numPending_{};
+    /// Bytes read.
+    std::atomic<unsigned long long> bytesRead_{};
+    /// io_uring enable flag.
+    bool useIOUring_;
+    /// Threads started flag.
+    bool started_;
+    /// Shutdown flag.
+    bool shutDown_;
+};
+
+}
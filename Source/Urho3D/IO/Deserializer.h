@@ -52,6 +52,8 @@ public:
     virtual unsigned GetChecksum();
     /// Return whether the end of stream has been reached.
     virtual bool IsEof() const { return position_ >= size_; }
+    /// Return pointer to the whole data if the source is backed by memory that stays valid while the source is alive, or null otherwise. Lets loaders read large blocks without copying.
+    virtual const unsigned char* GetMemoryView() const { return nullptr; }
 
     /// Set position relative to current position. Return actual new position.
     unsigned SeekRelative(int delta);
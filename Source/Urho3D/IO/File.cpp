@@ -63,6 +63,8 @@ static const char* openMode[] =
 static const unsigned READ_BUFFER_SIZE = 32768;
 #endif
 static const unsigned SKIP_BUFFER_SIZE = 1024;
+/// Block sizes are stored as 16-bit values in compressed packages.
+static const unsigned MAX_COMPRESSED_BLOCK_SIZE = 65535;
 
 File::File(Context* context) :
     Object(context),
@@ -74,6 +76,8 @@ File::File(Context* context) :
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
+    packedSize_(0),
+    mappedPosition_(0),
     checksum_(0),
     compressed_(false),
     readSyncNeeded_(false),
@@ -91,6 +95,8 @@ File::File(Context* context, const ea::string& fileName, FileMode mode) :
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
+    packedSize_(0),
+    mappedPosition_(0),
     checksum_(0),
     compressed_(false),
     readSyncNeeded_(false),
@@ -109,6 +115,8 @@ File::File(Context* context, PackageFile* package, const ea::string& fileName) :
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
+    packedSize_(0),
+    mappedPosition_(0),
     checksum_(0),
     compressed_(false),
     readSyncNeeded_(false),
@@ -136,6 +144,28 @@ bool File::Open(PackageFile* package, const ea::string& fileName)
     if (!entry)
         return false;
 
+    if (package->IsMemoryMapped())
+    {
+        Close();
+
+        // Read directly from the package mapping without a file handle
+        fileName_ = fileName;
+        mode_ = FILE_READ;
+        position_ = 0;
+        offset_ = entry->offset_;
+        packedSize_ = entry->packedSize_;
+        checksum_ = entry->checksum_;
+        size_ = entry->size_;
+        compressed_ = entry->codec_ != PACKAGE_CODEC_STORE;
+        if (entry->codec_ == PACKAGE_CODEC_LZ4HC_DICT)
+            dictionary_ = package->GetDictionary();
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
+        mapping_ = package->GetMapping();
+        mappedPosition_ = offset_;
+        return true;
+    }
+
     bool success = OpenInternal(package->GetName(), FILE_READ, true);
     if (!success)
     {
@@ -145,9 +175,12 @@ bool File::Open(PackageFile* package, const ea::string& fileName)
 
     fileName_ = fileName;
     offset_ = entry->offset_;
+    packedSize_ = entry->packedSize_;
     checksum_ = entry->checksum_;
     size_ = entry->size_;
-    compressed_ = package->IsCompressed();
+    compressed_ = entry->codec_ != PACKAGE_CODEC_STORE;
+    if (entry->codec_ == PACKAGE_CODEC_LZ4HC_DICT)
+        dictionary_ = package->GetDictionary();
 
     // Seek to beginning of package entry's file data
     SeekInternal(offset_);
@@ -218,21 +251,64 @@ unsigned File::Read(void* dest, unsigned size)
             if (!readBuffer_ || readBufferOffset_ >= readBufferSize_)
             {
                 unsigned char blockHeaderBytes[4];
-                ReadInternal(blockHeaderBytes, sizeof blockHeaderBytes);
+                if (!ReadInternal(blockHeaderBytes, sizeof blockHeaderBytes))
+                {
+                    URHO3D_LOGERROR("Unexpected end of compressed file " + GetName());
+                    SetCompressedEof();
+                    break;
+                }
 
                 MemoryBuffer blockHeader(&blockHeaderBytes[0], sizeof blockHeaderBytes);
                 unsigned unpackedSize = blockHeader.ReadUShort();
                 unsigned packedSize = blockHeader.ReadUShort();
 
-                if (!readBuffer_)
+                // Decompress whole blocks straight into the destination, use the read buffer only for partial blocks
+                const bool direct = sizeLeft >= unpackedSize;
+                if (!direct && !readBuffer_)
+                    readBuffer_ = new unsigned char[MAX_COMPRESSED_BLOCK_SIZE];
+                unsigned char* blockDest = direct ? destPtr : readBuffer_.get();
+
+                // From a mapped package the packed data is decompressed in place, otherwise read it first
+                const unsigned char* packedData = nullptr;
+                if (mapping_)
                 {
-                    readBuffer_ = new unsigned char[unpackedSize];
-                    inputBuffer_ = new unsigned char[LZ4_compressBound(unpackedSize)];
+                    if (mappedPosition_ + packedSize <= mapping_->GetSize())
+                        packedData = mapping_->GetData() + mappedPosition_;
+                    mappedPosition_ += packedSize;
+                }
+                else
+                {
+                    if (!inputBuffer_)
+                        inputBuffer_ = new unsigned char[LZ4_compressBound(MAX_COMPRESSED_BLOCK_SIZE)];
+                    if (ReadInternal(inputBuffer_.get(), packedSize))
+                        packedData = inputBuffer_.get();
+                }
+
+                int decompressedSize = -1;
+                if (packedData && dictionary_)
+                {
+                    decompressedSize = LZ4_decompress_safe_usingDict((const char*)packedData, (char*)blockDest, packedSize,
+                        unpackedSize, (const char*)dictionary_->data(), dictionary_->size());
+                }
+                else if (packedData)
+                    decompressedSize = LZ4_decompress_safe((const char*)packedData, (char*)blockDest, packedSize, unpackedSize);
+
+                if (decompressedSize != (int)unpackedSize)
+                {
+                    URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                    SetCompressedEof();
+                    break;
                 }
 
-                /// \todo Handle errors
-                ReadInternal(inputBuffer_.get(), packedSize);
-                LZ4_decompress_fast((const char*)inputBuffer_.get(), (char*)readBuffer_.get(), unpackedSize);
+                if (direct)
+                {
+                    destPtr += unpackedSize;
+                    sizeLeft -= unpackedSize;
+                    position_ += unpackedSize;
+                    readBufferOffset_ = 0;
+                    readBufferSize_ = 0;
+                    continue;
+                }
 
                 readBufferSize_ = unpackedSize;
                 readBufferOffset_ = 0;
@@ -246,6 +322,13 @@ unsigned File::Read(void* dest, unsigned size)
             position_ += copySize;
         }
 
+        return size - sizeLeft;
+    }
+
+    if (mapping_)
+    {
+        memcpy(dest, mapping_->GetData() + offset_ + position_, size);
+        position_ += size;
         return size;
     }
 
@@ -296,7 +379,10 @@ unsigned File::Seek(unsigned position)
         {
             unsigned char skipBuffer[SKIP_BUFFER_SIZE];
             while (position > position_)
-                Read(skipBuffer, Min(position - position_, SKIP_BUFFER_SIZE));
+            {
+                if (!Read(skipBuffer, Min(position - position_, SKIP_BUFFER_SIZE)))
+                    break;
+            }
         }
         else
             URHO3D_LOGERROR("Seeking backward in a compressed file is not supported");
@@ -304,6 +390,12 @@ unsigned File::Seek(unsigned position)
         return position_;
     }
 
+    if (mapping_)
+    {
+        position_ = position;
+        return position_;
+    }
+
     SeekInternal(position + offset_);
     position_ = position;
     readSyncNeeded_ = false;
@@ -392,6 +484,18 @@ void File::Close()
 
     readBuffer_.reset();
     inputBuffer_.reset();
+    dictionary_.reset();
+
+    if (mapping_)
+    {
+        mapping_.reset();
+        mappedPosition_ = 0;
+        position_ = 0;
+        size_ = 0;
+        offset_ = 0;
+        packedSize_ = 0;
+        checksum_ = 0;
+    }
 
     if (handle_)
     {
@@ -400,6 +504,7 @@ void File::Close()
         position_ = 0;
         size_ = 0;
         offset_ = 0;
+        packedSize_ = 0;
         checksum_ = 0;
     }
 }
@@ -418,12 +523,25 @@ void File::SetName(const ea::string& name)
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || assetHandle_ != 0 || mapping_ != nullptr;
 #else
-    return handle_ != nullptr;
+    return handle_ != nullptr || mapping_ != nullptr;
 #endif
 }
 
+void File::SetCompressedEof()
+{
+    // The rest of the data is unreadable, so make further reads and seeks stop here
+    position_ = size_;
+    readBufferOffset_ = 0;
+    readBufferSize_ = 0;
+}
+
+const unsigned char* File::GetMemoryView() const
+{
+    return mapping_ != nullptr && !compressed_ ? mapping_->GetData() + offset_ : nullptr;
+}
+
 bool File::OpenInternal(const ea::string& fileName, FileMode mode, bool fromPackage)
 {
     Close();
@@ -524,6 +642,15 @@ bool File::OpenInternal(const ea::string& fileName, FileMode mode, bool fromPack
 
 bool File::ReadInternal(void* dest, unsigned size)
 {
+    if (mapping_)
+    {
+        if (mappedPosition_ + size > mapping_->GetSize())
+            return false;
+        memcpy(dest, mapping_->GetData() + mappedPosition_, size);
+        mappedPosition_ += size;
+        return true;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_)
     {
@@ -536,6 +663,12 @@ bool File::ReadInternal(void* dest, unsigned size)
 
 void File::SeekInternal(unsigned newPosition)
 {
+    if (mapping_)
+    {
+        mappedPosition_ = newPosition;
+        return;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_)
     {
@@ -549,6 +682,77 @@ void File::SeekInternal(unsigned newPosition)
         fseek((FILE*)handle_, newPosition, SEEK_SET);
 }
 
+ea::shared_ptr<AsyncReadRequest> File::ReadAsync(const AsyncReadCallback& callback)
+{
+    if (!IsOpen() || mode_ == FILE_WRITE)
+    {
+        auto request = ea::make_shared<AsyncReadRequest>(fileName_, nullptr, 0, 0);
+        request->SetCallback(callback);
+        request->Complete(false);
+        return request;
+    }
+
+    // Memory mapped data is available right away
+    if (mapping_)
+    {
+        auto request = ea::make_shared<AsyncReadRequest>(fileName_, nullptr, offset_, size_);
+        request->SetCallback(callback);
+
+        bool success = false;
+        if (offset_ < mapping_->GetSize())
+        {
+            const unsigned char* src = mapping_->GetData() + offset_;
+            const unsigned long long srcSize = mapping_->GetSize() - offset_;
+            if (compressed_)
+                success = DecompressPackageBlocks(src, srcSize, request->GetData().data(), size_, dictionary_.get());
+            else if (size_ <= srcSize)
+            {
+                memcpy(request->GetData().data(), src, size_);
+                success = true;
+            }
+        }
+
+        request->Complete(success);
+        return request;
+    }
+
+#ifdef __ANDROID__
+    // Asset files can not be read with positional reads, read them here and restore the position
+    if (assetHandle_)
+    {
+        auto request = ea::make_shared<AsyncReadRequest>(fileName_, nullptr, offset_, size_);
+        request->SetCallback(callback);
+
+        const unsigned oldPosition = position_;
+        Seek(0);
+        const bool success = Read(request->GetData().data(), size_) == size_;
+        Seek(0);
+        Seek(oldPosition);
+
+        request->Complete(success);
+        return request;
+    }
+#endif
+
+    // Make buffered writes visible to the positional reads
+    if (readSyncNeeded_)
+        Flush();
+
+    auto request = ea::make_shared<AsyncReadRequest>(fileName_, ea::make_shared<AsyncFileHandle>(handle_), offset_, size_);
+    if (compressed_)
+        request->SetCompressed(packedSize_, dictionary_);
+
+    if (auto* asyncIO = GetSubsystem<AsyncIO>())
+        asyncIO->Read(request, callback);
+    else
+    {
+        request->SetCallback(callback);
+        AsyncIO::ReadSynchronous(*request);
+    }
+
+    return request;
+}
+
 void File::ReadBinary(ea::vector<unsigned char>& buffer)
 {
     buffer.clear();
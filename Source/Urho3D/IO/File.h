@@ -25,9 +25,11 @@
 #pragma once
 
 #include <EASTL/shared_array.h>
+#include <EASTL/shared_ptr.h>
 
 #include "../Core/Object.h"
 #include "../IO/AbstractFile.h"
+#include "../IO/AsyncIO.h"
 
 #ifdef __ANDROID__
 struct SDL_RWops;
@@ -59,6 +61,7 @@ enum FileMode
 };
 
 class PackageFile;
+class PackageMapping;
 
 /// %File opened either through the filesystem or from within a package file.
 class URHO3D_API File : public Object, public AbstractFile
@@ -84,6 +87,8 @@ public:
 
     /// Return the file name.
     const ea::string& GetName() const override { return fileName_; }
+    /// Return pointer to the file data inside a memory mapped package, or null if the file is not mapped or is compressed.
+    const unsigned char* GetMemoryView() const override;
 
     /// Return a checksum of the file contents using the SDBM hash algorithm.
     unsigned GetChecksum() override;
@@ -105,12 +110,18 @@ public:
     /// Return whether is open.
     bool IsOpen() const;
 
+    /// Return whether the file is read from a memory mapped package.
+    bool IsMemoryMapped() const { return mapping_ != nullptr; }
+
     /// Return the file handle.
     void* GetHandle() const { return handle_; }
 
     /// Return whether the file originates from a package.
     bool IsPackaged() const { return offset_ != 0; }
 
+    /// Read the whole file contents asynchronously without changing the file position. Compressed package files are decompressed by the I/O thread. The callback is invoked on completion, from an I/O thread unless the data was available immediately, such as from a memory mapped package. Return the request, which can also be waited on.
+    ea::shared_ptr<AsyncReadRequest> ReadAsync(const AsyncReadCallback& callback = nullptr);
+
     /// Reads a binary file to buffer.
     void ReadBinary(ea::vector<unsigned char>& buffer);
 
@@ -134,6 +145,8 @@ private:
     bool ReadInternal(void* dest, unsigned size);
     /// Seek in file internally using either C standard IO functions or SDL RWops for Android asset files.
     void SeekInternal(unsigned newPosition);
+    /// Move to the end of a compressed file after a read error, so that reads and seeks terminate.
+    void SetCompressedEof();
 
     /// File name.
     ea::string fileName_;
@@ -149,12 +162,20 @@ private:
     ea::shared_array<unsigned char> readBuffer_;
     /// Decompression input buffer for compressed file loading.
     ea::shared_array<unsigned char> inputBuffer_;
+    /// Compression dictionary of the package entry, if it uses one.
+    ea::shared_ptr<ea::vector<unsigned char> > dictionary_;
     /// Read buffer position.
     unsigned readBufferOffset_;
     /// Bytes in the current read buffer.
     unsigned readBufferSize_;
     /// Start position within a package file, 0 for regular files.
     unsigned offset_;
+    /// Stored size of compressed package file data, zero if not known.
+    unsigned packedSize_;
+    /// Package memory mapping when reading from a mapped package.
+    ea::shared_ptr<PackageMapping> mapping_;
+    /// Read position within the package memory mapping.
+    unsigned long long mappedPosition_;
     /// Content checksum.
     unsigned checksum_;
     /// Compression flag.
@@ -49,6 +49,8 @@ public:
 
     /// Return memory area.
     unsigned char* GetData() { return buffer_; }
+    /// Return memory area as a read-only view.
+    const unsigned char* GetMemoryView() const override { return buffer_; }
 
     /// Return whether buffer is read-only.
     bool IsReadOnly() { return readOnly_; }
@@ -0,0 +1,364 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+#include "../IO/PackageBuilder.h"
+
+#include <LZ4/lz4.h>
+#include <LZ4/lz4hc.h>
+
+#include <EASTL/sort.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Length of the byte sequences counted when training a dictionary.
+static const unsigned DICTIONARY_DMER_SIZE = 8;
+/// Length of the segments a dictionary is assembled from.
+static const unsigned DICTIONARY_SEGMENT_SIZE = 256;
+/// Maximum amount of sample data considered when training a dictionary.
+static const unsigned MAX_DICTIONARY_SAMPLE_DATA = 8 * 1024 * 1024;
+/// Number of bits in the sequence frequency table used for dictionary training.
+static const unsigned DICTIONARY_HASH_BITS = 20;
+
+/// File extensions of formats that are already compressed.
+static const char* compressedExtensions[] = {
+    ".jpg", ".jpeg", ".webp", ".ogg", ".mp3", ".zip", ".pak", ".woff", ".woff2"
+};
+
+static unsigned HashDmer(const unsigned char* data)
+{
+    unsigned long long value;
+    memcpy(&value, data, sizeof value);
+    return (unsigned)((value * 0x9e3779b97f4a7c15ULL) >> (64 - DICTIONARY_HASH_BITS));
+}
+
+PackageBuilder::PackageBuilder(Context* context) :
+    Object(context)
+{
+}
+
+PackageBuilder::~PackageBuilder()
+{
+    if (IsOpen())
+        Close();
+    if (stream_)
+        LZ4_freeStreamHC(stream_);
+}
+
+bool PackageBuilder::Open(const ea::string& fileName)
+{
+    if (IsOpen())
+        Close();
+
+    file_ = new File(context_);
+    if (!file_->Open(fileName, FILE_WRITE))
+    {
+        file_.Reset();
+        return false;
+    }
+
+    index_.clear();
+    names_.clear();
+    checksum_ = 0;
+    totalDataSize_ = 0;
+
+    // Header is rewritten with the index offset on close
+    WriteHeader(0);
+    return true;
+}
+
+void PackageBuilder::SetAlignment(unsigned alignment)
+{
+    if (!alignment || !IsPowerOfTwo(alignment))
+    {
+        URHO3D_LOGERROR("Package alignment must be a power of two");
+        return;
+    }
+
+    alignment_ = alignment;
+}
+
+void PackageBuilder::SetDictionary(const ea::vector<unsigned char>& dictionary)
+{
+    if (!index_.empty())
+    {
+        URHO3D_LOGERROR("Package dictionary must be set before appending files");
+        return;
+    }
+
+    if (dictionary.size() > MAX_PACKAGE_DICTIONARY_SIZE)
+        dictionary_.assign(dictionary.end() - MAX_PACKAGE_DICTIONARY_SIZE, dictionary.end());
+    else
+        dictionary_ = dictionary;
+}
+
+bool PackageBuilder::Append(const ea::string& name, const void* data, unsigned size, PackageCodec codec)
+{
+    if (!IsOpen())
+    {
+        URHO3D_LOGERROR("Package is not open for writing");
+        return false;
+    }
+
+    if (codec == PACKAGE_CODEC_LZ4HC_DICT && dictionary_.empty())
+        codec = PACKAGE_CODEC_LZ4HC;
+
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    PackageIndexEntry record{};
+    record.nameHash_ = StringHash(name).Value();
+    record.nameOffset_ = names_.size();
+    record.entry_.size_ = size;
+    for (unsigned i = 0; i < size; ++i)
+    {
+        checksum_ = SDBMHash(checksum_, bytes[i]);
+        record.entry_.checksum_ = SDBMHash(record.entry_.checksum_, bytes[i]);
+    }
+
+    unsigned packedSize = size;
+    if (codec != PACKAGE_CODEC_STORE && size)
+    {
+        packedSize = CompressBlocks(bytes, size, codec);
+        if (!packedSize || packedSize >= size)
+        {
+            codec = PACKAGE_CODEC_STORE;
+            packedSize = size;
+        }
+    }
+    else
+        codec = PACKAGE_CODEC_STORE;
+
+    // Pad to the alignment so that the data can be used in place from a memory mapping
+    static const unsigned char padding[256] = {};
+    unsigned offset = file_->GetSize();
+    while (offset & (alignment_ - 1))
+        offset += file_->Write(padding, Min(alignment_ - (offset & (alignment_ - 1)), (unsigned)sizeof padding));
+
+    record.entry_.offset_ = offset;
+    record.entry_.packedSize_ = packedSize;
+    record.entry_.codec_ = codec;
+
+    const void* storedData = codec == PACKAGE_CODEC_STORE ? data : compressBuffer_.data();
+    if (packedSize && file_->Write(storedData, packedSize) != packedSize)
+    {
+        URHO3D_LOGERROR("Could not write " + name + " to package " + file_->GetName());
+        return false;
+    }
+
+    index_.push_back(record);
+    names_.insert(names_.end(), name.c_str(), name.c_str() + name.length() + 1);
+    totalDataSize_ += size;
+    return true;
+}
+
+bool PackageBuilder::Close()
+{
+    if (!IsOpen())
+        return false;
+
+    // Dictionary goes after the file data
+    const unsigned dictionaryOffset = file_->GetSize();
+    if (!dictionary_.empty())
+        file_->Write(dictionary_.data(), dictionary_.size());
+
+    // The index is sorted so that readers can binary search it by name hash without parsing names
+    ea::vector<PackageIndexEntry> sortedIndex = index_;
+    ea::stable_sort(sortedIndex.begin(), sortedIndex.end(), [this](const PackageIndexEntry& lhs, const PackageIndexEntry& rhs)
+    {
+        if (lhs.nameHash_ != rhs.nameHash_)
+            return lhs.nameHash_ < rhs.nameHash_;
+        return strcmp(GetIndexEntryName(lhs), GetIndexEntryName(rhs)) < 0;
+    });
+
+    const unsigned indexOffset = file_->GetSize();
+    file_->WriteUInt(alignment_);
+    file_->WriteUInt(dictionaryOffset);
+    file_->WriteUInt(dictionary_.size());
+    file_->WriteUInt(names_.size());
+    file_->Write(sortedIndex.data(), sortedIndex.size() * sizeof(PackageIndexEntry));
+    file_->Write(names_.data(), names_.size());
+
+    // Write package size to the end of file to allow finding it linked to an executable file
+    const unsigned currentSize = file_->GetSize();
+    file_->WriteUInt(currentSize + sizeof(unsigned));
+
+    WriteHeader(indexOffset);
+    file_->Close();
+    file_.Reset();
+    return true;
+}
+
+bool PackageBuilder::IsOpen() const
+{
+    return file_ && file_->IsOpen();
+}
+
+unsigned PackageBuilder::GetPackageSize() const
+{
+    return file_ ? file_->GetSize() : 0;
+}
+
+PackageCodec PackageBuilder::SelectCodec(const ea::string& fileName, PackageCodec preferred)
+{
+    const ea::string extension = GetExtension(fileName);
+    for (const char* compressedExtension : compressedExtensions)
+    {
+        if (extension == compressedExtension)
+            return PACKAGE_CODEC_STORE;
+    }
+    return preferred;
+}
+
+ea::vector<unsigned char> PackageBuilder::TrainDictionary(const ea::vector<ea::vector<unsigned char> >& samples, unsigned maxSize)
+{
+    maxSize = Min(maxSize, MAX_PACKAGE_DICTIONARY_SIZE);
+
+    // Take an equal share of each sample so that large files do not dominate
+    unsigned totalSize = 0;
+    for (const ea::vector<unsigned char>& sample : samples)
+        totalSize += sample.size();
+    const unsigned sampleShare = samples.empty() ? 0 : Max(MAX_DICTIONARY_SAMPLE_DATA / samples.size(), DICTIONARY_SEGMENT_SIZE);
+
+    ea::vector<unsigned char> data;
+    data.reserve(Min(totalSize, MAX_DICTIONARY_SAMPLE_DATA));
+    for (const ea::vector<unsigned char>& sample : samples)
+        data.insert(data.end(), sample.begin(), sample.begin() + Min((unsigned)sample.size(), sampleShare));
+
+    if (data.size() <= maxSize)
+        return data;
+
+    // Count how often each byte sequence occurs
+    ea::vector<unsigned> frequencies(1u << DICTIONARY_HASH_BITS);
+    const unsigned numDmers = data.size() - DICTIONARY_DMER_SIZE + 1;
+    for (unsigned i = 0; i < numDmers; ++i)
+        ++frequencies[HashDmer(&data[i])];
+
+    // Split the data into epochs and take the segment covering the most frequent sequences from each
+    // A dictionary smaller than one segment still takes one, truncated
+    const unsigned numSegments = Max(maxSize / DICTIONARY_SEGMENT_SIZE, 1u);
+    const unsigned epochSize = Max(data.size() / numSegments, DICTIONARY_SEGMENT_SIZE);
+    const unsigned windowDmers = DICTIONARY_SEGMENT_SIZE - DICTIONARY_DMER_SIZE + 1;
+
+    ea::vector<unsigned char> dictionary;
+    dictionary.reserve(maxSize);
+    for (unsigned epochStart = 0; epochStart + DICTIONARY_SEGMENT_SIZE <= data.size() && dictionary.size() < maxSize;
+        epochStart += epochSize)
+    {
+        const unsigned epochEnd = Min(epochStart + epochSize, (unsigned)data.size());
+
+        unsigned long long score = 0;
+        for (unsigned i = 0; i < windowDmers; ++i)
+            score += frequencies[HashDmer(&data[epochStart + i])];
+
+        unsigned long long bestScore = score;
+        unsigned bestStart = epochStart;
+        for (unsigned start = epochStart + 1; start + DICTIONARY_SEGMENT_SIZE <= epochEnd; ++start)
+        {
+            score -= frequencies[HashDmer(&data[start - 1])];
+            score += frequencies[HashDmer(&data[start + windowDmers - 1])];
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestStart = start;
+            }
+        }
+
+        // Sequences already in the dictionary do not add value to later segments
+        for (unsigned i = 0; i < windowDmers; ++i)
+            frequencies[HashDmer(&data[bestStart + i])] = 0;
+
+        const unsigned segmentSize = Min(DICTIONARY_SEGMENT_SIZE, maxSize - (unsigned)dictionary.size());
+        dictionary.insert(dictionary.end(), data.begin() + bestStart, data.begin() + bestStart + segmentSize);
+    }
+
+    return dictionary;
+}
+
+unsigned PackageBuilder::CompressBlocks(const unsigned char* data, unsigned size, PackageCodec codec)
+{
+    const unsigned numBlocks = (size + PACKAGE_COMPRESSED_BLOCK_SIZE - 1) / PACKAGE_COMPRESSED_BLOCK_SIZE;
+    const unsigned blockBound = LZ4_compressBound(PACKAGE_COMPRESSED_BLOCK_SIZE);
+    compressBuffer_.resize(numBlocks * (blockBound + 2 * sizeof(unsigned short)));
+
+    if (codec == PACKAGE_CODEC_LZ4HC_DICT && !stream_)
+        stream_ = LZ4_createStreamHC();
+
+    unsigned packedSize = 0;
+    for (unsigned pos = 0; pos < size; pos += PACKAGE_COMPRESSED_BLOCK_SIZE)
+    {
+        const unsigned unpackedBlockSize = Min(size - pos, PACKAGE_COMPRESSED_BLOCK_SIZE);
+        const auto* src = reinterpret_cast<const char*>(data + pos);
+        auto* header = &compressBuffer_[packedSize];
+        auto* dest = reinterpret_cast<char*>(header + 2 * sizeof(unsigned short));
+
+        // Blocks are compressed independently so that readers can start from any entry without history
+        int packedBlockSize = 0;
+        switch (codec)
+        {
+        case PACKAGE_CODEC_LZ4:
+            packedBlockSize = LZ4_compress_default(src, dest, unpackedBlockSize, blockBound);
+            break;
+
+        case PACKAGE_CODEC_LZ4HC:
+            packedBlockSize = LZ4_compress_HC(src, dest, unpackedBlockSize, blockBound, LZ4HC_CLEVEL_DEFAULT);
+            break;
+
+        case PACKAGE_CODEC_LZ4HC_DICT:
+            LZ4_resetStreamHC(stream_, LZ4HC_CLEVEL_DEFAULT);
+            LZ4_loadDictHC(stream_, reinterpret_cast<const char*>(dictionary_.data()), dictionary_.size());
+            packedBlockSize = LZ4_compress_HC_continue(stream_, src, dest, unpackedBlockSize, blockBound);
+            break;
+
+        default:
+            break;
+        }
+
+        if (packedBlockSize <= 0)
+            return 0;
+
+        const unsigned short blockHeader[2] = { (unsigned short)unpackedBlockSize, (unsigned short)packedBlockSize };
+        memcpy(header, blockHeader, sizeof blockHeader);
+        packedSize += sizeof blockHeader + packedBlockSize;
+    }
+
+    return packedSize;
+}
+
+void PackageBuilder::WriteHeader(unsigned long long indexOffset)
+{
+    file_->Seek(0);
+    file_->WriteFileID("RPAK");
+    file_->WriteUInt(index_.size());
+    file_->WriteUInt(checksum_);
+    file_->WriteUInt(PACKAGE_VERSION_INDEXED);
+    file_->WriteInt64(indexOffset);
+}
+
+}
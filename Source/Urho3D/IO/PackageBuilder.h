@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../IO/PackageFile.h"
+
+union LZ4_streamHC_u;
+
+namespace Urho3D
+{
+
+class File;
+
+/// Writes indexed package files. Entry data is aligned for memory mapping, each entry has its own compression codec, compressed entries may share a dictionary, and a sorted hashed index is written at the end of the file.
+class URHO3D_API PackageBuilder : public Object
+{
+    URHO3D_OBJECT(PackageBuilder, Object);
+
+public:
+    /// Construct.
+    explicit PackageBuilder(Context* context);
+    /// Destruct. Close the package if still open.
+    ~PackageBuilder() override;
+
+    /// Create the package file for writing. Return true if successful.
+    bool Open(const ea::string& fileName);
+    /// Set alignment of entry data in bytes. Must be a power of two. Affects files appended afterwards.
+    void SetAlignment(unsigned alignment);
+    /// Set compression dictionary for PACKAGE_CODEC_LZ4HC_DICT entries. Only the last MAX_PACKAGE_DICTIONARY_SIZE bytes are kept. Must be set before appending files.
+    void SetDictionary(const ea::vector<unsigned char>& dictionary);
+    /// Append a file. Compressed codecs fall back to storing the data if compression does not reduce its size. Return true if successful.
+    bool Append(const ea::string& name, const void* data, unsigned size, PackageCodec codec);
+    /// Write the dictionary, index and header, then close the file. Return true if successful.
+    bool Close();
+
+    /// Return whether the package is open for writing.
+    bool IsOpen() const;
+
+    /// Return the index records of appended files in append order.
+    const ea::vector<PackageIndexEntry>& GetIndex() const { return index_; }
+
+    /// Return name of an index record.
+    const char* GetIndexEntryName(const PackageIndexEntry& record) const { return &names_[record.nameOffset_]; }
+
+    /// Return number of appended files.
+    unsigned GetNumFiles() const { return index_.size(); }
+
+    /// Return total uncompressed size of appended files.
+    unsigned GetTotalDataSize() const { return totalDataSize_; }
+
+    /// Return checksum of appended file data.
+    unsigned GetChecksum() const { return checksum_; }
+
+    /// Return current size of the package file.
+    unsigned GetPackageSize() const;
+
+    /// Return codec for a file: formats that are already compressed are stored, others use the preferred codec.
+    static PackageCodec SelectCodec(const ea::string& fileName, PackageCodec preferred);
+    /// Train a compression dictionary from sample file contents by picking the segments whose byte sequences are most frequent across the samples.
+    static ea::vector<unsigned char> TrainDictionary(const ea::vector<ea::vector<unsigned char> >& samples,
+        unsigned maxSize = MAX_PACKAGE_DICTIONARY_SIZE);
+
+private:
+    /// Compress data into compressed blocks. Return compressed size, or 0 if compression failed.
+    unsigned CompressBlocks(const unsigned char* data, unsigned size, PackageCodec codec);
+    /// Write the package header.
+    void WriteHeader(unsigned long long indexOffset);
+
+    /// Output file.
+    SharedPtr<File> file_;
+    /// Index records in append order.
+    ea::vector<PackageIndexEntry> index_;
+    /// Zero-terminated entry names referenced by the index.
+    ea::vector<char> names_;
+    /// Compression dictionary.
+    ea::vector<unsigned char> dictionary_;
+    /// Compressed data of the file being appended.
+    ea::vector<unsigned char> compressBuffer_;
+    /// LZ4 high compression stream for dictionary compression.
+    LZ4_streamHC_u* stream_{};
+    /// Entry data alignment.
+    unsigned alignment_{DEFAULT_PACKAGE_ALIGNMENT};
+    /// Checksum of all file data.
+    unsigned checksum_{};
+    /// Total uncompressed size of all files.
+    unsigned totalDataSize_{};
+};
+
+}
@@ -27,9 +27,92 @@
 #include "../IO/PackageFile.h"
 #include "../IO/FileSystem.h"
 
+#include <EASTL/sort.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../DebugNew.h"
+
 namespace Urho3D
 {
 
+PackageMapping::PackageMapping(const ea::string& fileName)
+{
+#if defined(__ANDROID__)
+    // Assets inside the APK can not be mapped
+    if (URHO3D_IS_ASSET(fileName))
+        return;
+#endif
+
+#if defined(_WIN32)
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER fileSize;
+    HANDLE mappingHandle = nullptr;
+    if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+        mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+    {
+        CloseHandle(fileHandle);
+        return;
+    }
+
+    data_ = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!data_)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return;
+    }
+
+    fileHandle_ = fileHandle;
+    mappingHandle_ = mappingHandle;
+    size_ = (unsigned long long)fileSize.QuadPart;
+#elif !defined(__EMSCRIPTEN__)
+    int fd = open(GetNativePath(fileName).c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && (unsigned long long)st.st_size <= (unsigned long long)SIZE_MAX)
+    {
+        void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            data_ = (const unsigned char*)data;
+            size_ = (unsigned long long)st.st_size;
+        }
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+#endif
+}
+
+PackageMapping::~PackageMapping()
+{
+    if (!data_)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data_);
+    CloseHandle((HANDLE)mappingHandle_);
+    CloseHandle((HANDLE)fileHandle_);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(const_cast<unsigned char*>(data_), (size_t)size_);
+#endif
+}
+
 PackageFile::PackageFile(Context* context) :
     Object(context),
     totalSize_(0),
@@ -51,6 +134,33 @@ PackageFile::PackageFile(Context* context, const ea::string& fileName, unsigned
 
 PackageFile::~PackageFile() = default;
 
+bool PackageFile::MapMemory()
+{
+    if (mapping_)
+        return true;
+
+    if (fileName_.empty())
+    {
+        URHO3D_LOGERROR("Package file must be opened before it can be memory mapped");
+        return false;
+    }
+
+    auto mapping = ea::make_shared<PackageMapping>(fileName_);
+    if (!mapping->GetData() || mapping->GetSize() < totalSize_)
+    {
+        URHO3D_LOGWARNING("Could not memory map package file " + fileName_ + ", falling back to file reads");
+        return false;
+    }
+
+    mapping_ = mapping;
+    return true;
+}
+
+void PackageFile::UnmapMemory()
+{
+    mapping_.reset();
+}
+
 bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
 {
     SharedPtr<File> file(new File(context_, fileName));
@@ -94,75 +204,260 @@ bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
     if (id == "RPAK" || id == "RLZ4")
     {
         // New PAK file format includes two extra PAK header fields:
-        // * Version. At this time this field is unused and is always 0. It will be used in the future if PAK format needs to be extended.
+        // * Version. 0 for a plain file list, PACKAGE_VERSION_INDEXED for a sorted hashed index with per-entry codecs.
         // * File list offset. New format writes file list in the end of the file. This allows PAK creation without knowing entire file list
         //   beforehand.
-        unsigned version = file->ReadUInt();                        // Reserved for future use.
-        assert(version == 0);
+        version_ = file->ReadUInt();
         int64_t fileListOffset = file->ReadInt64();                 // New format has file list at the end of the file.
+        // The version 0 file list offset is absolute, while the indexed format stores it relative to the package start
+        if (version_ == PACKAGE_VERSION_INDEXED)
+            fileListOffset += startOffset;
         file->Seek(fileListOffset);                                 // TODO: Serializer/Deserializer do not support files bigger than 4 GB
     }
 
+    if (version_ == PACKAGE_VERSION_INDEXED)
+        return ReadIndex(*file, numFiles, startOffset);
+    else if (version_ == 0)
+        return ReadEntryList(*file, numFiles, startOffset);
+
+    URHO3D_LOGERRORF("Unsupported version %u of package file %s", version_, fileName.c_str());
+    return false;
+}
+
+bool PackageFile::ReadIndex(Deserializer& source, unsigned numFiles, unsigned startOffset)
+{
+    alignment_ = source.ReadUInt();
+    unsigned dictionaryOffset = source.ReadUInt();
+    unsigned dictionarySize = source.ReadUInt();
+    unsigned namesSize = source.ReadUInt();
+
+    // Check the counts against the file before allocating, as a corrupted header could request gigabytes
+    const unsigned long long indexSize64 = (unsigned long long)numFiles * sizeof(PackageIndexEntry);
+    if (indexSize64 + namesSize > source.GetSize() - source.GetPosition())
+    {
+        URHO3D_LOGERROR("Truncated index in package file " + fileName_);
+        return false;
+    }
+
+    // Records and names are read in bulk, nothing is parsed per entry
+    index_.resize(numFiles);
+    names_.resize(namesSize);
+    const unsigned indexSize = static_cast<unsigned>(indexSize64);
+    if (source.Read(index_.data(), indexSize) != indexSize || source.Read(names_.data(), namesSize) != namesSize ||
+        (namesSize && names_.back() != '\0'))
+    {
+        URHO3D_LOGERROR("Truncated index in package file " + fileName_);
+        return false;
+    }
+
+    compressed_ = false;
+    for (PackageIndexEntry& record : index_)
+    {
+        PackageEntry& entry = record.entry_;
+        const unsigned storedSize = entry.codec_ == PACKAGE_CODEC_STORE ? entry.size_ : entry.packedSize_;
+        if (record.nameOffset_ >= namesSize || entry.codec_ >= MAX_PACKAGE_CODECS ||
+            (unsigned long long)entry.offset_ + storedSize + startOffset > totalSize_)
+        {
+            URHO3D_LOGERROR("Invalid file entry in package file " + fileName_);
+            return false;
+        }
+
+        entry.offset_ += startOffset;
+        totalDataSize_ += entry.size_;
+        compressed_ |= entry.codec_ != PACKAGE_CODEC_STORE;
+    }
+
+    if (dictionarySize)
+    {
+        if (dictionarySize > MAX_PACKAGE_DICTIONARY_SIZE)
+        {
+            URHO3D_LOGERROR("Invalid compression dictionary in package file " + fileName_);
+            return false;
+        }
+
+        dictionary_ = ea::make_shared<ea::vector<unsigned char> >(dictionarySize);
+        source.Seek(dictionaryOffset + startOffset);
+        if (source.Read(dictionary_->data(), dictionarySize) != dictionarySize)
+        {
+            URHO3D_LOGERROR("Truncated compression dictionary in package file " + fileName_);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PackageFile::ReadEntryList(Deserializer& source, unsigned numFiles, unsigned startOffset)
+{
+    index_.reserve(numFiles);
     for (unsigned i = 0; i < numFiles; ++i)
     {
-        ea::string entryName = file->ReadString();
+        ea::string entryName = source.ReadString();
         PackageEntry newEntry{};
-        newEntry.offset_ = file->ReadUInt() + startOffset;
-        totalDataSize_ += (newEntry.size_ = file->ReadUInt());
-        newEntry.checksum_ = file->ReadUInt();
+        newEntry.offset_ = source.ReadUInt() + startOffset;
+        totalDataSize_ += (newEntry.size_ = source.ReadUInt());
+        newEntry.checksum_ = source.ReadUInt();
+        newEntry.codec_ = compressed_ ? PACKAGE_CODEC_LZ4 : PACKAGE_CODEC_STORE;
+        if (!compressed_)
+            newEntry.packedSize_ = newEntry.size_;
         if (!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_)
         {
             URHO3D_LOGERROR("File entry " + entryName + " outside package file");
             return false;
         }
-        else
-            entries_[entryName] = newEntry;
+
+        PackageIndexEntry record{};
+        record.nameHash_ = StringHash(entryName).Value();
+        record.nameOffset_ = names_.size();
+        record.entry_ = newEntry;
+        index_.push_back(record);
+        names_.insert(names_.end(), entryName.c_str(), entryName.c_str() + entryName.length() + 1);
     }
 
+    // Build the same sorted index that indexed packages store on disk
+    ea::stable_sort(index_.begin(), index_.end(), [this](const PackageIndexEntry& lhs, const PackageIndexEntry& rhs)
+    {
+        if (lhs.nameHash_ != rhs.nameHash_)
+            return lhs.nameHash_ < rhs.nameHash_;
+        return strcmp(&names_[lhs.nameOffset_], &names_[rhs.nameOffset_]) < 0;
+    });
+
     return true;
 }
 
 bool PackageFile::Exists(const ea::string& fileName) const
 {
-    bool found = entries_.find(fileName) != entries_.end();
+    return GetEntry(fileName) != nullptr;
+}
+
+const PackageEntry* PackageFile::GetEntry(const ea::string& fileName) const
+{
+    const unsigned nameHash = StringHash(fileName).Value();
+    auto i = ea::lower_bound(index_.begin(), index_.end(), nameHash,
+        [](const PackageIndexEntry& record, unsigned hash) { return record.nameHash_ < hash; });
+    for (; i != index_.end() && i->nameHash_ == nameHash; ++i)
+    {
+        if (fileName == GetIndexEntryName(*i))
+            return &i->entry_;
+    }
 
 #ifdef _WIN32
     // On Windows perform a fallback case-insensitive search
-    if (!found)
+    for (const PackageIndexEntry& record : index_)
+    {
+        if (!fileName.comparei(GetIndexEntryName(record)))
+            return &record.entry_;
+    }
+#endif
+
+    return nullptr;
+}
+
+ea::vector<ea::shared_ptr<AsyncReadRequest> > PackageFile::ReadAsync(const ea::vector<ea::string>& fileNames,
+    const AsyncReadCallback& callback)
+{
+    ea::vector<ea::shared_ptr<AsyncReadRequest> > requests;
+    requests.reserve(fileNames.size());
+
+    // Without a mapping all reads share one handle to the package file
+    ea::shared_ptr<AsyncFileHandle> handle;
+    if (!mapping_)
     {
-        for (auto i = entries_.begin(); i != entries_.end(); ++i)
+        handle = ea::make_shared<AsyncFileHandle>(fileName_);
+        if (!handle->IsOpen())
         {
-            if (!i->first.comparei(fileName))
+            // Fall back to files that may read through other means, such as Android assets
+            for (const ea::string& name : fileNames)
             {
-                found = true;
-                break;
+                File file(context_, this, name);
+                requests.push_back(file.ReadAsync(callback));
             }
+            return requests;
         }
     }
-#endif
 
-    return found;
-}
+    ea::vector<ea::shared_ptr<AsyncReadRequest> > queued;
+    for (const ea::string& name : fileNames)
+    {
+        const PackageEntry* entry = GetEntry(name);
+        auto request = ea::make_shared<AsyncReadRequest>(name, handle, entry ? entry->offset_ : 0, entry ? entry->size_ : 0);
+        requests.push_back(request);
 
-const PackageEntry* PackageFile::GetEntry(const ea::string& fileName) const
-{
-    auto i = entries_.find(fileName);
-    if (i != entries_.end())
-        return &i->second;
+        if (!entry)
+        {
+            request->SetCallback(callback);
+            request->Complete(false);
+            continue;
+        }
 
-#ifdef _WIN32
-    // On Windows perform a fallback case-insensitive search
-    else
+        const bool compressed = entry->codec_ != PACKAGE_CODEC_STORE;
+        const ea::shared_ptr<ea::vector<unsigned char> > dictionary =
+            entry->codec_ == PACKAGE_CODEC_LZ4HC_DICT ? dictionary_ : ea::shared_ptr<ea::vector<unsigned char> >();
+
+        if (mapping_)
+        {
+            // Mapped data is available right away
+            request->SetCallback(callback);
+            bool success = false;
+            if (entry->offset_ < mapping_->GetSize())
+            {
+                const unsigned char* src = mapping_->GetData() + entry->offset_;
+                const unsigned long long srcSize = mapping_->GetSize() - entry->offset_;
+                if (compressed)
+                    success = DecompressPackageBlocks(src, srcSize, request->GetData().data(), entry->size_, dictionary.get());
+                else if (entry->size_ <= srcSize)
+                {
+                    memcpy(request->GetData().data(), src, entry->size_);
+                    success = true;
+                }
+            }
+            request->Complete(success);
+            continue;
+        }
+
+        if (compressed)
+            request->SetCompressed(entry->packedSize_, dictionary);
+        queued.push_back(request);
+    }
+
+    if (!queued.empty())
     {
-        for (auto j = entries_.begin(); j != entries_.end(); ++j)
+        if (auto* asyncIO = GetSubsystem<AsyncIO>())
+            asyncIO->Read(queued, callback);
+        else
         {
-            if (!j->first.comparei(fileName))
-                return &j->second;
+            for (const auto& request : queued)
+            {
+                request->SetCallback(callback);
+                AsyncIO::ReadSynchronous(*request);
+            }
         }
     }
-#endif
 
-    return nullptr;
+    return requests;
+}
+
+const ea::unordered_map<ea::string, PackageEntry>& PackageFile::GetEntries() const
+{
+    MutexLock lock(entriesMutex_);
+    if (!entriesBuilt_)
+    {
+        entries_.clear();
+        entries_.reserve(index_.size());
+        for (const PackageIndexEntry& record : index_)
+            entries_[GetIndexEntryName(record)] = record.entry_;
+        entriesBuilt_ = true;
+    }
+    return entries_;
+}
+
+const ea::vector<ea::string> PackageFile::GetEntryNames() const
+{
+    ea::vector<ea::string> names;
+    names.reserve(index_.size());
+    for (const PackageIndexEntry& record : index_)
+        names.push_back(GetIndexEntryName(record));
+    return names;
 }
 
 void PackageFile::Scan(ea::vector<ea::string>& result, const ea::string& pathName, const ea::string& filter, bool recursive) const
@@ -180,7 +475,7 @@ void PackageFile::Scan(ea::vector<ea::string>& result, const ea::string& pathNam
     caseSensitive = false;
 #endif
 
-    const StringVector& entryNames = GetEntryNames();
+    const StringVector entryNames = GetEntryNames();
     for (auto i = entryNames.begin(); i != entryNames.end(); ++i)
     {
         ea::string entryName = GetSanitizedPath(*i);
@@ -22,11 +22,41 @@
 
 #pragma once
 
+#include <EASTL/shared_ptr.h>
+
+#include "../Core/Mutex.h"
 #include "../Core/Object.h"
+#include "../IO/AsyncIO.h"
 
 namespace Urho3D
 {
 
+class Deserializer;
+
+/// Package format version written to the header of indexed packages. All offsets in indexed packages, including the file list offset, are relative to the package start, while version 0 stores an absolute file list offset.
+static const unsigned PACKAGE_VERSION_INDEXED = 1;
+/// Default alignment of entry data in indexed packages.
+static const unsigned DEFAULT_PACKAGE_ALIGNMENT = 16;
+/// Maximum size of a package compression dictionary. LZ4 can not reference further back.
+static const unsigned MAX_PACKAGE_DICTIONARY_SIZE = 65536;
+/// Uncompressed size of the blocks written by package compression.
+static const unsigned PACKAGE_COMPRESSED_BLOCK_SIZE = 32768;
+
+/// Compression codec of a package file entry.
+enum PackageCodec : unsigned
+{
+    /// Stored uncompressed.
+    PACKAGE_CODEC_STORE = 0,
+    /// LZ4 compressed blocks.
+    PACKAGE_CODEC_LZ4,
+    /// LZ4 high compression blocks. Decompressed the same way as LZ4.
+    PACKAGE_CODEC_LZ4HC,
+    /// LZ4 high compression blocks referencing the package dictionary.
+    PACKAGE_CODEC_LZ4HC_DICT,
+    /// Number of codecs.
+    MAX_PACKAGE_CODECS
+};
+
 /// %File entry within the package file.
 struct PackageEntry
 {
@@ -36,6 +66,55 @@ struct PackageEntry
     unsigned size_;
     /// File checksum.
     unsigned checksum_;
+    /// Stored size of the file data, zero if not known.
+    unsigned packedSize_;
+    /// Compression codec.
+    PackageCodec codec_;
+};
+
+/// Package index record. Indexed packages store these as is, sorted by name hash and name.
+struct PackageIndexEntry
+{
+    /// Hash of the entry name.
+    unsigned nameHash_;
+    /// Offset of the zero-terminated entry name in the name table.
+    unsigned nameOffset_;
+    /// File entry.
+    PackageEntry entry_;
+};
+
+static_assert(sizeof(PackageIndexEntry) == 28, "Package index records must have a fixed layout");
+
+/// Read-only memory mapping of a package file. Shared so that files opened from the package can outlive an unmap.
+class URHO3D_API PackageMapping
+{
+public:
+    /// Construct and map the file. Check GetData() for success.
+    explicit PackageMapping(const ea::string& fileName);
+    /// Prevent copy construction.
+    PackageMapping(const PackageMapping& rhs) = delete;
+    /// Prevent assignment.
+    PackageMapping& operator =(const PackageMapping& rhs) = delete;
+    /// Destruct. Unmap the file.
+    ~PackageMapping();
+
+    /// Return pointer to the mapped file data, or null if the mapping failed.
+    const unsigned char* GetData() const { return data_; }
+
+    /// Return size of the mapped region.
+    unsigned long long GetSize() const { return size_; }
+
+private:
+    /// Mapped file data.
+    const unsigned char* data_{};
+    /// Mapped size.
+    unsigned long long size_{};
+#ifdef _WIN32
+    /// Win32 file handle.
+    void* fileHandle_{};
+    /// Win32 file mapping handle.
+    void* mappingHandle_{};
+#endif
 };
 
 /// Stores files of a directory tree sequentially for convenient access.
@@ -53,13 +132,25 @@ public:
 
     /// Open the package file. Return true if successful.
     bool Open(const ea::string& fileName, unsigned startOffset = 0);
+    /// Map the whole package file into memory. Files opened from a mapped package read directly from the mapping, and uncompressed entries expose their data as memory views without copying. Not supported for Android asset or Web builds. Return true if successful.
+    bool MapMemory();
+    /// Release the memory mapping. Files already opened from the package keep the mapping alive until closed. Should not be called while resources are being loaded from the package.
+    void UnmapMemory();
     /// Check if a file exists within the package file. This will be case-insensitive on Windows and case-sensitive on other platforms.
     bool Exists(const ea::string& fileName) const;
     /// Return the file entry corresponding to the name, or null if not found. This will be case-insensitive on Windows and case-sensitive on other platforms.
     const PackageEntry* GetEntry(const ea::string& fileName) const;
+    /// Read the contents of several files asynchronously as one batch in package order, decompressing as necessary. Return one request per name in the same order; requests for files that do not exist complete unsuccessfully. The callback is invoked for each request.
+    ea::vector<ea::shared_ptr<AsyncReadRequest> > ReadAsync(const ea::vector<ea::string>& fileNames, const AsyncReadCallback& callback = nullptr);
+
+    /// Return all file entries. The map is built on first use, lookups through GetEntry() use the sorted index instead.
+    const ea::unordered_map<ea::string, PackageEntry>& GetEntries() const;
 
-    /// Return all file entries.
-    const ea::unordered_map<ea::string, PackageEntry>& GetEntries() const { return entries_; }
+    /// Return the sorted package index.
+    const ea::vector<PackageIndexEntry>& GetIndex() const { return index_; }
+
+    /// Return name of an index record.
+    const char* GetIndexEntryName(const PackageIndexEntry& record) const { return &names_[record.nameOffset_]; }
 
     /// Return the package file name.
     const ea::string& GetName() const { return fileName_; }
@@ -68,7 +159,7 @@ public:
     StringHash GetNameHash() const { return nameHash_; }
 
     /// Return number of files.
-    unsigned GetNumFiles() const { return entries_.size(); }
+    unsigned GetNumFiles() const { return index_.size(); }
 
     /// Return total size of the package file.
     unsigned GetTotalSize() const { return totalSize_; }
@@ -79,17 +170,33 @@ public:
     /// Return checksum of the package file contents.
     unsigned GetChecksum() const { return checksum_; }
 
-    /// Return whether the files are compressed.
+    /// Return whether the files are compressed. Indexed packages return true if any file is compressed.
     bool IsCompressed() const { return compressed_; }
 
+    /// Return package format version. Zero for packages without a sorted index.
+    unsigned GetVersion() const { return version_; }
+
+    /// Return entry data alignment, 1 if the package does not align data.
+    unsigned GetAlignment() const { return alignment_; }
+
+    /// Return the compression dictionary, or null if the package has none.
+    const ea::shared_ptr<ea::vector<unsigned char> >& GetDictionary() const { return dictionary_; }
+
+    /// Return whether the package file is memory mapped.
+    bool IsMemoryMapped() const { return mapping_ != nullptr; }
+
+    /// Return the memory mapping of the package file, or null if not mapped.
+    const ea::shared_ptr<PackageMapping>& GetMapping() const { return mapping_; }
+
     /// Return list of file names in the package.
-    const ea::vector<ea::string> GetEntryNames() const { return entries_.keys(); }
+    const ea::vector<ea::string> GetEntryNames() const;
 
     /// Return a file name in the package at the specified index
     const ea::string& GetEntryName(unsigned index) const
     {
+        const ea::unordered_map<ea::string, PackageEntry>& entries = GetEntries();
         unsigned nn = 0;
-        for (auto j = entries_.begin(); j != entries_.end(); ++j)
+        for (auto j = entries.begin(); j != entries.end(); ++j)
         {
             if (nn == index) return j->first;
             nn++;
@@ -101,8 +208,23 @@ public:
     void Scan(ea::vector<ea::string>& result, const ea::string& pathName, const ea::string& filter, bool recursive) const;
 
 private:
-    /// File entries.
-    ea::unordered_map<ea::string, PackageEntry> entries_;
+    /// Read the name table and sorted index records of an indexed package. Return true if successful.
+    bool ReadIndex(Deserializer& source, unsigned numFiles, unsigned startOffset);
+    /// Read and index the entry list of a package without a sorted index. Return true if successful.
+    bool ReadEntryList(Deserializer& source, unsigned numFiles, unsigned startOffset);
+
+    /// Sorted index records.
+    ea::vector<PackageIndexEntry> index_;
+    /// Zero-terminated entry names referenced by the index.
+    ea::vector<char> names_;
+    /// File entries by name, built on demand.
+    mutable ea::unordered_map<ea::string, PackageEntry> entries_;
+    /// Whether the entries map has been built.
+    mutable bool entriesBuilt_{};
+    /// Mutex for building the entries map.
+    mutable Mutex entriesMutex_;
+    /// Compression dictionary.
+    ea::shared_ptr<ea::vector<unsigned char> > dictionary_;
     /// File name.
     ea::string fileName_;
     /// Package file name hash.
@@ -115,6 +237,12 @@ private:
     unsigned checksum_;
     /// Compressed flag.
     bool compressed_;
+    /// Format version.
+    unsigned version_{};
+    /// Entry data alignment.
+    unsigned alignment_{1};
+    /// Memory mapping, or null if not mapped.
+    ea::shared_ptr<PackageMapping> mapping_;
 };
 
 }
@@ -63,6 +63,8 @@ public:
 
     /// Return data.
     const unsigned char* GetData() const { return size_ ? &buffer_[0] : nullptr; }
+    /// Return data as a read-only view.
+    const unsigned char* GetMemoryView() const override { return GetData(); }
 
     /// Return non-const data.
     unsigned char* GetModifiableData() { return size_ ? &buffer_[0] : nullptr; }
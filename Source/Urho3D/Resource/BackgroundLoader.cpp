@@ -25,8 +25,10 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
 #include "../Resource/BackgroundLoader.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
@@ -36,76 +38,291 @@
 namespace Urho3D
 {
 
+/// Maximum size of a resource file read ahead by the loader threads.
+static const unsigned MAX_PREFETCH_SIZE = 64 * 1024 * 1024;
+
+/// Resource file contents read ahead into memory, keeping the file name and checksum of the file.
+class PrefetchedFile : public MemoryBuffer
+{
+public:
+    /// Construct from read data.
+    PrefetchedFile(const ea::string& name, const ea::vector<unsigned char>& data) :
+        MemoryBuffer(data),
+        name_(name)
+    {
+    }
+
+    /// Return the file name.
+    const ea::string& GetName() const override { return name_; }
+
+    /// Return a checksum of the file contents using the same SDBM hash as File.
+    unsigned GetChecksum() override
+    {
+        if (!checksum_)
+        {
+            const unsigned char* data = GetMemoryView();
+            for (unsigned i = 0; i < GetSize(); ++i)
+                checksum_ = SDBMHash(checksum_, data[i]);
+        }
+        return checksum_;
+    }
+
+private:
+    /// File name.
+    ea::string name_;
+    /// Content checksum.
+    unsigned checksum_{};
+};
+
+/// Background loader worker thread.
+class BackgroundLoaderThread : public Thread
+{
+public:
+    /// Construct.
+    explicit BackgroundLoaderThread(BackgroundLoader* loader) :
+        Thread("BackgroundLoader"),
+        loader_(loader),
+        generation_(loader->GetThreadGeneration())
+    {
+    }
+
+    /// Load queued resources until stopped. Sleep while there are none.
+    void ThreadFunction() override
+    {
+        while (shouldRun_)
+        {
+            const unsigned serial = loader_->GetWakeSerial();
+            if (!loader_->ProcessNextResource() && !loader_->WaitForWork(serial, generation_))
+                break;
+        }
+    }
+
+private:
+    /// Owner loader.
+    BackgroundLoader* loader_;
+    /// Generation of the loader threads this thread belongs to.
+    unsigned generation_;
+};
+
 BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
-    owner_(owner)
+    owner_(owner),
+    numThreads_(Clamp(GetNumLogicalCPUs(), 2u, 9u) - 1),
+    numPrefetchResources_(16),
+    batchQueued_(0),
+    batchLoaded_(0),
+    batchFinished_(0),
+    batchFailed_(0),
+    batchBytes_(0),
+    batchLoadTime_(0),
+    batchFinishTime_(0),
+    batchElapsed_(0),
+    batchActive_(false),
+    shutdown_(false)
 {
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
+    backgroundLoadMutex_.Acquire();
+    shutdown_ = true;
+    pendingQueue_.clear();
+    backgroundLoadMutex_.Release();
+
+    StopThreads();
+
     MutexLock lock(backgroundLoadMutex_);
 
     backgroundLoadQueue_.clear();
+    finishQueue_.clear();
 }
 
-void BackgroundLoader::ThreadFunction()
+void BackgroundLoader::SetNumThreads(unsigned num)
 {
-    while (shouldRun_)
+    num = Max(num, 1u);
+
     {
-        backgroundLoadMutex_.Acquire();
+        MutexLock lock(backgroundLoadMutex_);
+        if (num == numThreads_)
+            return;
+        numThreads_ = num;
+    }
+
+    // Restart with the new thread count right away if there is work left, otherwise on the next queued resource
+    StopThreads();
 
-        // Search for a queued resource that has not been loaded yet
-        auto i = backgroundLoadQueue_.begin();
-        while (i != backgroundLoadQueue_.end())
+    MutexLock lock(backgroundLoadMutex_);
+    if (!pendingQueue_.empty())
+        StartThreads();
+}
+
+bool BackgroundLoader::ProcessNextResource()
+{
+    BackgroundLoadItem* item = nullptr;
+
+    {
+        MutexLock lock(backgroundLoadMutex_);
+
+        // Claim the first queued resource. Entries may be stale if the main thread already loaded the resource itself
+        while (!pendingQueue_.empty())
         {
-            if (i->second.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+            auto i = backgroundLoadQueue_.find(pendingQueue_.front());
+            pendingQueue_.pop_front();
+            if (i != backgroundLoadQueue_.end() && i->second.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+            {
+                item = &i->second;
+                // We can be sure that the item is not removed from the queue as long as it is in the
+                // "queued" or "loading" state
+                item->resource_->SetAsyncLoadState(ASYNC_LOADING);
                 break;
-            else
-                ++i;
+            }
         }
+    }
 
-        if (i == backgroundLoadQueue_.end())
+    if (!item)
+        return false;
+
+    PrefetchResources();
+    BeginBackgroundLoading(*item);
+    return true;
+}
+
+unsigned BackgroundLoader::GetWakeSerial()
+{
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    return wakeSerial_;
+}
+
+unsigned BackgroundLoader::GetThreadGeneration()
+{
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    return threadGeneration_;
+}
+
+bool BackgroundLoader::WaitForWork(unsigned serial, unsigned generation)
+{
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wakeCondition_.wait(lock, [this, serial, generation] { return threadGeneration_ != generation || wakeSerial_ != serial; });
+    return threadGeneration_ == generation;
+}
+
+void BackgroundLoader::WakeThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        ++wakeSerial_;
+    }
+    wakeCondition_.notify_one();
+}
+
+void BackgroundLoader::PrefetchResources()
+{
+    if (!numPrefetchResources_)
+        return;
+
+    ea::vector<ea::pair<ea::pair<StringHash, StringHash>, ea::string> > prefetches;
+
+    {
+        MutexLock lock(backgroundLoadMutex_);
+
+        const unsigned count = Min((unsigned)pendingQueue_.size(), numPrefetchResources_);
+        for (unsigned i = 0; i < count; ++i)
         {
-            // No resources to load found
-            backgroundLoadMutex_.Release();
-            Time::Sleep(5);
+            auto j = backgroundLoadQueue_.find(pendingQueue_[i]);
+            if (j == backgroundLoadQueue_.end() || j->second.prefetchStarted_ ||
+                j->second.resource_->GetAsyncLoadState() != ASYNC_QUEUED)
+                continue;
+
+            j->second.prefetchStarted_ = true;
+            prefetches.emplace_back(j->first, j->second.resource_->GetName());
         }
-        else
+    }
+
+    for (const auto& prefetch : prefetches)
+    {
+        // Failures are reported when the resource is actually loaded. Mapped files are read in place instead
+        SharedPtr<File> file = owner_->GetFile(prefetch.second, false);
+        if (!file || file->IsMemoryMapped() || file->GetSize() > MAX_PREFETCH_SIZE)
+            continue;
+
+        ea::shared_ptr<AsyncReadRequest> request = file->ReadAsync();
+
+        MutexLock lock(backgroundLoadMutex_);
+        auto i = backgroundLoadQueue_.find(prefetch.first);
+        if (i != backgroundLoadQueue_.end() && i->second.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+            i->second.prefetch_ = request;
+    }
+}
+
+void BackgroundLoader::BeginBackgroundLoading(BackgroundLoadItem& item)
+{
+    Resource* resource = item.resource_;
+    HiresTimer loadTimer;
+
+    ea::shared_ptr<AsyncReadRequest> prefetch;
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        prefetch = ea::move(item.prefetch_);
+    }
+
+    bool success = false;
+    unsigned size = 0;
+    if (prefetch)
+    {
+        // Load from the data read ahead, or open the file normally if the read failed
+        prefetch->Wait();
+        if (!prefetch->IsSuccess())
+            prefetch.reset();
+    }
+
+    if (prefetch)
+    {
+        PrefetchedFile source(prefetch->GetName(), prefetch->GetData());
+        size = source.GetSize();
+        success = resource->BeginLoad(source);
+    }
+    else
+    {
+        SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
+        if (file)
         {
-            BackgroundLoadItem& item = i->second;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
-
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
+            size = file->GetSize();
+            success = resource->BeginLoad(*file);
+        }
+    }
 
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            ea::pair<StringHash, StringHash> key = ea::make_pair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.size())
-            {
-                for (auto i = item.dependents_.begin(); i != item.dependents_.end(); ++i)
-                {
-                    auto j = backgroundLoadQueue_.find(*i);
-                    if (j != backgroundLoadQueue_.end())
-                        j->second.dependencies_.erase(key);
-                }
+    long long loadTime = loadTimer.GetUSec(false);
 
-                item.dependents_.clear();
-            }
+    // Process dependencies now
+    // Need to lock the queue again when manipulating other entries
+    ea::pair<StringHash, StringHash> key = ea::make_pair(resource->GetType(), resource->GetNameHash());
+    MutexLock lock(backgroundLoadMutex_);
 
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+    if (item.dependencies_.empty())
+        finishQueue_.push_back(key);
+
+    if (item.dependents_.size())
+    {
+        for (auto i = item.dependents_.begin(); i != item.dependents_.end(); ++i)
+        {
+            auto j = backgroundLoadQueue_.find(*i);
+            if (j == backgroundLoadQueue_.end())
+                continue;
+
+            // Dependent becomes ready to finish when its own load is done and this was the last dependency
+            BackgroundLoadItem& dependent = j->second;
+            dependent.dependencies_.erase(key);
+            AsyncLoadState state = dependent.resource_->GetAsyncLoadState();
+            if (dependent.dependencies_.empty() && (state == ASYNC_SUCCESS || state == ASYNC_FAIL))
+                finishQueue_.push_back(*i);
         }
+
+        item.dependents_.clear();
     }
+
+    ++batchLoaded_;
+    batchBytes_ += size;
+    batchLoadTime_ += loadTime;
 }
 
 bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bool sendEventOnFailure, Resource* caller)
@@ -121,6 +338,7 @@ bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bo
 
     BackgroundLoadItem& item = backgroundLoadQueue_[key];
     item.sendEventOnFailure_ = sendEventOnFailure;
+    item.prefetchStarted_ = false;
 
     // Make sure the pointer is non-null and is a Resource subclass
     item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
@@ -146,6 +364,17 @@ bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bo
     item.resource_->SetName(name);
     item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
 
+    // Start a new batch when the queue was empty
+    if (!batchActive_)
+    {
+        batchActive_ = true;
+        batchTimer_.Reset();
+        batchQueued_ = batchLoaded_ = batchFinished_ = batchFailed_ = 0;
+        batchBytes_ = 0;
+        batchLoadTime_ = batchFinishTime_ = batchElapsed_ = 0;
+    }
+    ++batchQueued_;
+
     // If this is a resource calling for the background load of more resources, mark the dependency as necessary
     if (caller)
     {
@@ -161,11 +390,16 @@ bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bo
         else
             URHO3D_LOGWARNING("Resource " + caller->GetName() +
                        " requested for a background loaded resource but was not in the background load queue");
+
+        // Load dependencies first so that the resource requesting them can finish as early as possible
+        pendingQueue_.push_front(key);
     }
+    else
+        pendingQueue_.push_back(key);
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+    // Start the background loader threads now, or wake up an idle one
+    StartThreads();
+    WakeThread();
 
     return true;
 }
@@ -180,17 +414,28 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
         key);
     if (i != backgroundLoadQueue_.end())
     {
+        Resource* resource = i->second.resource_;
+
+        // If no loader thread has picked up the resource yet, load it here instead of waiting for the queue to drain
+        bool loadHere = resource->GetAsyncLoadState() == ASYNC_QUEUED;
+        if (loadHere)
+            resource->SetAsyncLoadState(ASYNC_LOADING);
         backgroundLoadMutex_.Release();
 
+        if (loadHere)
+            BeginBackgroundLoading(i->second);
+
         {
-            Resource* resource = i->second.resource_;
             HiresTimer waitTimer;
             bool didWait = false;
 
             for (;;)
             {
+                backgroundLoadMutex_.Acquire();
                 unsigned numDeps = i->second.dependencies_.size();
                 AsyncLoadState state = resource->GetAsyncLoadState();
+                backgroundLoadMutex_.Release();
+
                 if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
                 {
                     didWait = true;
@@ -206,11 +451,12 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
         }
 
         // This may take a long time and may potentially wait on other resources, so it is important we do not hold the mutex during this
-        FinishBackgroundLoading(i->second);
+        SharedPtr<Resource> finishedResource(resource);
+        HiresTimer finishTimer;
+        const bool stored = FinishBackgroundLoading(i->second);
+        long long finishTime = finishTimer.GetUSec(false);
 
-        backgroundLoadMutex_.Acquire();
-        backgroundLoadQueue_.erase(i);
-        backgroundLoadMutex_.Release();
+        RemoveFinishedResource(key, stored ? finishedResource.Get() : nullptr, finishTime);
     }
     else
         backgroundLoadMutex_.Release();
@@ -218,37 +464,50 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
-    {
-        HiresTimer timer;
+    HiresTimer timer;
 
-        backgroundLoadMutex_.Acquire();
+    backgroundLoadMutex_.Acquire();
 
-        for (auto i = backgroundLoadQueue_.begin();
-             i != backgroundLoadQueue_.end();)
-        {
-            Resource* resource = i->second.resource_;
-            unsigned numDeps = i->second.dependencies_.size();
-            AsyncLoadState state = resource->GetAsyncLoadState();
-            if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                ++i;
-            else
-            {
-                // Finishing a resource may need it to wait for other resources to load, in which case we can not
-                // hold on to the mutex
-                backgroundLoadMutex_.Release();
-                FinishBackgroundLoading(i->second);
-                backgroundLoadMutex_.Acquire();
-                i = backgroundLoadQueue_.erase(i);
-            }
+    while (!finishQueue_.empty())
+    {
+        // Skip entries already finished by WaitForResource() or that gained new dependencies after becoming ready;
+        // the latter are queued again once those dependencies are loaded
+        auto i = backgroundLoadQueue_.find(finishQueue_.front());
+        finishQueue_.pop_front();
+        if (i == backgroundLoadQueue_.end())
+            continue;
 
-            // Break when the time limit passed so that we keep sufficient FPS
-            if (timer.GetUSec(false) >= maxMs * 1000LL)
-                break;
-        }
+        AsyncLoadState state = i->second.resource_->GetAsyncLoadState();
+        if (!i->second.dependencies_.empty() || (state != ASYNC_SUCCESS && state != ASYNC_FAIL))
+            continue;
 
+        // Finishing a resource may need it to wait for other resources to load, in which case we can not
+        // hold on to the mutex
         backgroundLoadMutex_.Release();
+        const ea::pair<StringHash, StringHash> key = i->first;
+        SharedPtr<Resource> resource = i->second.resource_;
+        HiresTimer finishTimer;
+        const bool stored = FinishBackgroundLoading(i->second);
+        long long finishTime = finishTimer.GetUSec(false);
+        RemoveFinishedResource(key, stored ? resource.Get() : nullptr, finishTime);
+        backgroundLoadMutex_.Acquire();
+
+        // Break when the time limit passed so that we keep sufficient FPS
+        if (timer.GetUSec(false) >= maxMs * 1000LL)
+            break;
+    }
+
+    // Report the batch once everything queued has been finished
+    if (batchActive_ && backgroundLoadQueue_.empty())
+    {
+        batchActive_ = false;
+        batchElapsed_ = batchTimer_.GetUSec(false);
+        URHO3D_LOGDEBUGF("Background loaded %u resources (%u failed, %.2f MB) in %.1f ms using %u threads, %.1f MB/s",
+            batchFinished_, batchFailed_, batchBytes_ / 1048576.0, batchElapsed_ / 1000.0, numThreads_,
+            batchElapsed_ > 0 ? batchBytes_ / 1048576.0 * 1000000.0 / batchElapsed_ : 0.0);
     }
+
+    backgroundLoadMutex_.Release();
 }
 
 unsigned BackgroundLoader::GetNumQueuedResources() const
@@ -257,7 +516,79 @@ unsigned BackgroundLoader::GetNumQueuedResources() const
     return backgroundLoadQueue_.size();
 }
 
-void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
+bool BackgroundLoader::IsQueued(StringHash type, StringHash nameHash) const
+{
+    MutexLock lock(backgroundLoadMutex_);
+    return backgroundLoadQueue_.contains(ea::make_pair(type, nameHash));
+}
+
+BackgroundLoadStats BackgroundLoader::GetStats() const
+{
+    MutexLock lock(backgroundLoadMutex_);
+
+    BackgroundLoadStats stats;
+    stats.numQueued_ = batchQueued_;
+    stats.numLoaded_ = batchLoaded_;
+    stats.numFinished_ = batchFinished_;
+    stats.numFailed_ = batchFailed_;
+    stats.bytesLoaded_ = batchBytes_;
+    stats.loadTime_ = batchLoadTime_;
+    stats.finishTime_ = batchFinishTime_;
+    stats.elapsedTime_ = batchActive_ ? batchTimer_.GetUSec(false) : batchElapsed_;
+    stats.numThreads_ = numThreads_;
+    stats.active_ = batchActive_;
+    return stats;
+}
+
+void BackgroundLoader::StartThreads()
+{
+    if (!threads_.empty() || shutdown_)
+        return;
+
+    for (unsigned i = 0; i < numThreads_; ++i)
+    {
+        threads_.push_back(ea::make_unique<BackgroundLoaderThread>(this));
+        threads_.back()->Run();
+    }
+}
+
+void BackgroundLoader::StopThreads()
+{
+    // The threads may still queue dependencies while stopping, so do not hold the mutex while waiting for them
+    ea::vector<ea::unique_ptr<BackgroundLoaderThread> > threads;
+    backgroundLoadMutex_.Acquire();
+    threads.swap(threads_);
+    backgroundLoadMutex_.Release();
+
+    if (threads.empty())
+        return;
+
+    // Wake up the idle threads so that they exit. Threads started after this keep running
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        ++threadGeneration_;
+    }
+    wakeCondition_.notify_all();
+
+    // Thread::Stop() waits for the thread to finish its current resource
+    for (auto& thread : threads)
+        thread->Stop();
+}
+
+void BackgroundLoader::RemoveFinishedResource(const ea::pair<StringHash, StringHash>& key, Resource* resource, long long finishTime)
+{
+    // Leave the queue and complete the requests while holding the request mutex, so that RequestResource() either
+    // finds the resource still queued and waits for it, or finds it stored, instead of queuing a second load
+    MutexLock requestLock(owner_->requestMutex_);
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        backgroundLoadQueue_.erase(key);
+        batchFinishTime_ += finishTime;
+    }
+    owner_->CompleteResourceRequest(key.first, key.second, resource);
+}
+
+bool BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
     Resource* resource = item.resource_;
 
@@ -267,10 +598,19 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
     {
         URHO3D_PROFILE(ea::string("Finish" + resource->GetTypeName()).c_str());
         URHO3D_LOGDEBUG("Finishing background loaded resource " + resource->GetName());
+        owner_->loadingResources_.push_back(resource);
         success = resource->EndLoad();
+        owner_->loadingResources_.pop_back();
     }
     resource->SetAsyncLoadState(ASYNC_DONE);
 
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        ++batchFinished_;
+        if (!success)
+            ++batchFailed_;
+    }
+
     if (!success && item.sendEventOnFailure_)
     {
         using namespace LoadFailed;
@@ -280,9 +620,10 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
         owner_->SendEvent(E_LOADFAILED, eventData);
     }
 
-    // Store to the cache just before sending the event; use same mechanism as for manual resources
-    if (success || owner_->GetReturnFailedResources())
-        owner_->AddManualResource(resource);
+    // Store to the cache just before sending the event. Requests are completed once the resource has left the queue
+    const bool stored = success || owner_->GetReturnFailedResources();
+    if (stored)
+        owner_->StoreResource(resource, false);
 
     // Send event, either success or failure
     {
@@ -294,6 +635,8 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
         eventData[P_RESOURCE] = resource;
         owner_->SendEvent(E_RESOURCEBACKGROUNDLOADED, eventData);
     }
+
+    return stored;
 }
 
 }
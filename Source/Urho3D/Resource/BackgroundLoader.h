@@ -22,19 +22,29 @@
 
 #pragma once
 
+#include <EASTL/deque.h>
 #include <EASTL/hash_set.h>
+#include <EASTL/shared_ptr.h>
+#include <EASTL/unique_ptr.h>
 #include <EASTL/unordered_map.h>
 
 #include "../Core/Mutex.h"
 #include "../Container/Ptr.h"
 #include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../Math/StringHash.h"
 
+#include <condition_variable>
+#include <mutex>
+
 namespace Urho3D
 {
 
+class AsyncReadRequest;
+class BackgroundLoaderThread;
 class Resource;
 class ResourceCache;
+struct BackgroundLoadStats;
 
 /// Queue item for background loading of a resource.
 struct URHO3D_API BackgroundLoadItem
@@ -45,36 +55,72 @@ struct URHO3D_API BackgroundLoadItem
     ea::hash_set<ea::pair<StringHash, StringHash> > dependencies_;
     /// Resources that depend on this resource's loading.
     ea::hash_set<ea::pair<StringHash, StringHash> > dependents_;
+    /// Asynchronous read of the resource file issued ahead of loading.
+    ea::shared_ptr<AsyncReadRequest> prefetch_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
+    /// Whether reading ahead has been attempted.
+    bool prefetchStarted_;
 };
 
-/// Background loader of resources. Owned by the ResourceCache.
-class URHO3D_API BackgroundLoader : public RefCounted, public Thread
+/// Background loader of resources. Owned by the ResourceCache. Runs BeginLoad() of queued resources in a pool of loader threads and EndLoad() in the main thread in queue order, so that dependencies finish before the resources that requested them.
+class URHO3D_API BackgroundLoader : public RefCounted
 {
+    friend class BackgroundLoaderThread;
+
 public:
     /// Construct.
     explicit BackgroundLoader(ResourceCache* owner);
 
-    /// Destruct. Forcibly clear the load queue.
+    /// Destruct. Stop the loader threads and forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
-    void ThreadFunction() override;
-
+    /// Set number of loader threads. Running threads are stopped after finishing their current resource and restarted on demand. Default is the number of logical CPUs minus one, at most 8.
+    void SetNumThreads(unsigned num);
     /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
     bool QueueResource(StringHash type, const ea::string& name, bool sendEventOnFailure, Resource* caller);
-    /// Wait and finish possible loading of a resource when being requested from the cache.
+    /// Wait and finish possible loading of a resource when being requested from the cache. A resource not yet picked up by a loader thread is loaded in the calling thread.
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
 
+    /// Set how many queued resources the loader threads read ahead asynchronously, so that many reads are in flight while resources are being loaded. Zero disables reading ahead. Default 16.
+    void SetNumPrefetchResources(unsigned num) { numPrefetchResources_ = num; }
+
+    /// Return number of loader threads.
+    unsigned GetNumThreads() const { return numThreads_; }
+    /// Return how many queued resources are read ahead.
+    unsigned GetNumPrefetchResources() const { return numPrefetchResources_; }
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
+    /// Return whether a resource is in the load queue.
+    bool IsQueued(StringHash type, StringHash nameHash) const;
+    /// Return progress and throughput of the current or last finished batch of background loads.
+    BackgroundLoadStats GetStats() const;
 
 private:
-    /// Finish one background loaded resource.
-    void FinishBackgroundLoading(BackgroundLoadItem& item);
+    /// Load the next queued resource if any. Called from the loader threads. Return true if a resource was loaded.
+    bool ProcessNextResource();
+    /// Return the wake-up serial. Read by a loader thread before looking for work.
+    unsigned GetWakeSerial();
+    /// Return the generation of the loader threads being started.
+    unsigned GetThreadGeneration();
+    /// Block an idle loader thread until resources are queued after the given wake-up serial was read. Return false if the threads of the given generation are being stopped.
+    bool WaitForWork(unsigned serial, unsigned generation);
+    /// Wake up an idle loader thread after queuing resources.
+    void WakeThread();
+    /// Issue asynchronous reads for the resources next in the queue that have not been read ahead yet.
+    void PrefetchResources();
+    /// Run BeginLoad() of a resource claimed for loading and release its dependents.
+    void BeginBackgroundLoading(BackgroundLoadItem& item);
+    /// Remove a finished resource from the queue and complete its requests. Called from the main thread without the queue mutex held.
+    void RemoveFinishedResource(const ea::pair<StringHash, StringHash>& key, Resource* resource, long long finishTime);
+    /// Finish one background loaded resource. Return true if it was stored to the cache.
+    bool FinishBackgroundLoading(BackgroundLoadItem& item);
+    /// Start the loader threads if not running. Called with the queue mutex held.
+    void StartThreads();
+    /// Stop the loader threads.
+    void StopThreads();
 
     /// Resource cache.
     ResourceCache* owner_;
@@ -82,6 +128,46 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     ea::unordered_map<ea::pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Resources waiting for a loader thread. Dependencies requested by a loading resource are put first.
+    ea::deque<ea::pair<StringHash, StringHash> > pendingQueue_;
+    /// Resources that have finished BeginLoad() with no outstanding dependencies, in the order they became ready.
+    ea::deque<ea::pair<StringHash, StringHash> > finishQueue_;
+    /// Loader threads.
+    ea::vector<ea::unique_ptr<BackgroundLoaderThread> > threads_;
+    /// Number of loader threads.
+    unsigned numThreads_;
+    /// Number of queued resources to read ahead.
+    unsigned numPrefetchResources_;
+    /// Timer for the current batch.
+    mutable HiresTimer batchTimer_;
+    /// Number of resources queued in the current batch.
+    unsigned batchQueued_;
+    /// Number of resources that finished BeginLoad() in the current batch.
+    unsigned batchLoaded_;
+    /// Number of resources finished in the current batch.
+    unsigned batchFinished_;
+    /// Number of resources that failed to load in the current batch.
+    unsigned batchFailed_;
+    /// Bytes read by BeginLoad() in the current batch.
+    unsigned long long batchBytes_;
+    /// Accumulated BeginLoad() time of the current batch in microseconds.
+    long long batchLoadTime_;
+    /// Accumulated EndLoad() time of the current batch in microseconds.
+    long long batchFinishTime_;
+    /// Wall clock time of the last finished batch in microseconds.
+    long long batchElapsed_;
+    /// Whether a batch is in progress.
+    bool batchActive_;
+    /// Whether the loader is being destroyed and must not start threads.
+    bool shutdown_;
+    /// Mutex for waking up idle loader threads.
+    std::mutex wakeMutex_;
+    /// Condition signaled when resources are queued or the loader threads are stopped.
+    std::condition_variable wakeCondition_;
+    /// Incremented whenever resources are queued, so that a thread does not miss work queued while it was looking.
+    unsigned wakeSerial_{};
+    /// Generation of the running loader threads. Incremented when they are stopped, so that threads started afterwards keep running.
+    unsigned threadGeneration_{};
 };
 
 }
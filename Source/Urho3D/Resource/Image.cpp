@@ -24,10 +24,13 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../Resource/Decompress.h"
+#include "../Resource/ImageKernels.h"
 
 #include <SDL/SDL_surface.h>
 #include <STB/stb_image.h>
@@ -85,9 +88,71 @@ static const unsigned DDS_DXGI_FORMAT_BC2_UNORM_SRGB = 75;
 static const unsigned DDS_DXGI_FORMAT_BC3_UNORM = 77;
 static const unsigned DDS_DXGI_FORMAT_BC3_UNORM_SRGB = 78;
 
+// Texture container version and flags
+static const unsigned UTEX_VERSION = 1;
+static const unsigned UTEX_DATA_ALIGNMENT = 16;
+static const unsigned UTEX_CUBEMAP = 0x1;
+static const unsigned UTEX_ARRAY = 0x2;
+static const unsigned UTEX_SRGB = 0x4;
+
 namespace Urho3D
 {
 
+/// Minimum number of processed pixels before image operations are split across worker threads.
+static const unsigned PARALLEL_PIXEL_THRESHOLD = 256 * 256;
+/// Number of destination rows resampled at once. Limits the size of the intermediate buffer.
+static const int RESAMPLE_BAND_ROWS = 64;
+
+/// Return the data size of one face or layer of a texture container, following the level layout of GetCompressedLevel().
+static unsigned long long GetUTEXImageDataSize(CompressedFormat format, unsigned width, unsigned height, unsigned depth, unsigned numLevels)
+{
+    unsigned long long dataSize = 0;
+    for (unsigned i = 0; i < numLevels; ++i)
+    {
+        const unsigned levelWidth = Max(width >> Min(i, 31u), 1u);
+        const unsigned levelHeight = Max(height >> Min(i, 31u), 1u);
+        const unsigned levelDepth = Max(depth >> Min(i, 31u), 1u);
+
+        if (format == CF_RGBA)
+            dataSize += (unsigned long long)levelWidth * levelHeight * levelDepth * 4;
+        else if (format < CF_PVRTC_RGB_2BPP)
+        {
+            const unsigned blockSize = (format == CF_DXT1 || format == CF_ETC1 || format == CF_ETC2_RGB) ? 8 : 16;
+            dataSize += (unsigned long long)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * levelDepth * blockSize;
+        }
+        else
+        {
+            const unsigned bitsPerPixel = format < CF_PVRTC_RGB_4BPP ? 2 : 4;
+            const unsigned long long dataWidth = Max(levelWidth, bitsPerPixel == 2 ? 16u : 8u);
+            const unsigned long long dataHeight = Max(levelHeight, 8u);
+            dataSize += (dataWidth * dataHeight * bitsPerPixel + 7) >> 3;
+        }
+    }
+    return dataSize;
+}
+
+/// Process a range of rows, split across worker threads if the image is large and called from the main thread.
+static void ProcessRows(Context* context, unsigned numRows, unsigned pixelsPerRow, const std::function<void(unsigned, unsigned)>& work)
+{
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    const unsigned numThreads = queue && Thread::IsMainThread() && !queue->IsCompleting() ? queue->GetNumThreads() : 0;
+    if (!numThreads || numRows < 2 || numRows * pixelsPerRow < PARALLEL_PIXEL_THRESHOLD)
+    {
+        work(0, numRows);
+        return;
+    }
+
+    // One item per worker thread and one for the main thread
+    const unsigned numItems = Min(numThreads + 1, numRows);
+    const unsigned rowsPerItem = (numRows + numItems - 1) / numItems;
+    for (unsigned start = 0; start < numRows; start += rowsPerItem)
+    {
+        const unsigned end = Min(start + rowsPerItem, numRows);
+        queue->AddWorkItem([&work, start, end]() { work(start, end); }, M_MAX_UNSIGNED);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
 /// DirectDraw color key definition.
 struct DDColorKey
 {
@@ -263,7 +328,7 @@ void Image::RegisterObject(Context* context)
 
 bool Image::BeginLoad(Deserializer& source)
 {
-    // Check for DDS, KTX or PVR compressed format
+    // Check for DDS, KTX, PVR or UTEX compressed format
     ea::string fileID = source.ReadFileID();
 
     if (fileID == "DDS ")
@@ -769,6 +834,11 @@ bool Image::BeginLoad(Deserializer& source)
         source.Read(data_.get(), dataSize);
         SetMemoryUse(dataSize);
     }
+    else if (fileID == "UTEX")
+    {
+        // Texture container: block compressed or RGBA data of all mip levels, ready for upload without decoding
+        return LoadUTEX(source, 0);
+    }
 #ifdef URHO3D_WEBP
     else if (fileID == "RIFF")
     {
@@ -800,17 +870,24 @@ bool Image::BeginLoad(Deserializer& source)
             return false;
         }
 
-        // Read the file to buffer.
+        // Decode straight from memory backed sources, otherwise read the file to buffer.
         size_t dataSize(source.GetSize());
-        ea::shared_array<uint8_t> data(new uint8_t[dataSize]);
-
-        memset(data.get(), 0, sizeof(uint8_t) * dataSize);
+        ea::shared_array<uint8_t> data;
         source.Seek(0);
-        source.Read(data.get(), dataSize);
+        const uint8_t* webpData = source.GetMemoryView();
+        if (webpData && source.GetPosition() == 0)
+            source.Seek(dataSize);
+        else
+        {
+            data = new uint8_t[dataSize];
+            memset(data.get(), 0, sizeof(uint8_t) * dataSize);
+            source.Read(data.get(), dataSize);
+            webpData = data.get();
+        }
 
         WebPBitstreamFeatures features;
 
-        if (WebPGetFeatures(data.get(), dataSize, &features) != VP8_STATUS_OK)
+        if (WebPGetFeatures(webpData, dataSize, &features) != VP8_STATUS_OK)
         {
             URHO3D_LOGERROR("Error reading WebP image: " + source.GetName());
             return false;
@@ -822,11 +899,11 @@ bool Image::BeginLoad(Deserializer& source)
         bool decodeError(false);
         if (features.has_alpha)
         {
-            decodeError = WebPDecodeRGBAInto(data.get(), dataSize, pixelData.get(), imgSize, 4 * features.width) == nullptr;
+            decodeError = WebPDecodeRGBAInto(webpData, dataSize, pixelData.get(), imgSize, 4 * features.width) == nullptr;
         }
         else
         {
-            decodeError = WebPDecodeRGBInto(data.get(), dataSize, pixelData.get(), imgSize, 3 * features.width) == nullptr;
+            decodeError = WebPDecodeRGBInto(webpData, dataSize, pixelData.get(), imgSize, 3 * features.width) == nullptr;
         }
         if (decodeError)
         {
@@ -840,7 +917,7 @@ bool Image::BeginLoad(Deserializer& source)
 #endif
     else
     {
-        // Not DDS, KTX or PVR, use STBImage to load other image formats as uncompressed
+        // Not DDS, KTX, PVR or texture container, use STBImage to load other image formats as uncompressed
         source.Seek(0);
         int width, height;
         unsigned components;
@@ -885,6 +962,8 @@ bool Image::SaveFile(const ea::string& fileName) const
 {
     if (fileName.ends_with(".dds", false))
         return SaveDDS(fileName);
+    else if (fileName.ends_with(".utex", false))
+        return SaveUTEX(fileName);
     else if (fileName.ends_with(".bmp", false))
         return SaveBMP(fileName);
     else if (fileName.ends_with(".jpg", false) || fileName.ends_with(".jpeg", false))
@@ -994,7 +1073,7 @@ bool Image::LoadColorLUT(Deserializer& source)
 {
     ea::string fileID = source.ReadFileID();
 
-    if (fileID == "DDS " || fileID == "\253KTX" || fileID == "PVR\3")
+    if (fileID == "DDS " || fileID == "\253KTX" || fileID == "PVR\3" || fileID == "UTEX")
     {
         URHO3D_LOGERROR("Invalid image format, can not load image");
         return false;
@@ -1041,6 +1120,107 @@ bool Image::LoadColorLUT(Deserializer& source)
     return true;
 }
 
+bool Image::LoadLevels(Deserializer& source, unsigned firstLevel)
+{
+    if (source.ReadFileID() != "UTEX")
+    {
+        URHO3D_LOGERROR("Only texture containers can be loaded from a mip level");
+        return false;
+    }
+
+    return LoadUTEX(source, firstLevel);
+}
+
+bool Image::LoadUTEX(Deserializer& source, unsigned firstLevel)
+{
+    unsigned version = source.ReadUInt();
+    unsigned format = source.ReadUInt();
+    unsigned flags = source.ReadUInt();
+    unsigned width = source.ReadUInt();
+    unsigned height = source.ReadUInt();
+    unsigned depth = source.ReadUInt();
+    unsigned components = source.ReadUInt();
+    unsigned numLevels = source.ReadUInt();
+    unsigned numImages = source.ReadUInt();
+    unsigned imageDataSize = source.ReadUInt();
+    unsigned dataOffset = source.ReadUInt();
+
+    if (version != UTEX_VERSION)
+    {
+        URHO3D_LOGERROR("Unsupported texture container version " + ea::to_string(version));
+        return false;
+    }
+
+    if (format < CF_RGBA || format > CF_PVRTC_RGBA_4BPP || !numLevels || !numImages || components < 1 || components > 4 ||
+        !width || !height || !depth)
+    {
+        URHO3D_LOGERROR("Invalid texture container header");
+        return false;
+    }
+
+    // The stored size must match the mip chain described by the header, as the levels are located from it
+    if (imageDataSize != GetUTEXImageDataSize((CompressedFormat)format, width, height, depth, numLevels))
+    {
+        URHO3D_LOGERROR("Texture container data size does not match its dimensions and format");
+        return false;
+    }
+
+    if (dataOffset < source.GetPosition() || (unsigned long long)imageDataSize * numImages > source.GetSize() - dataOffset)
+    {
+        URHO3D_LOGERROR("Texture container data size exceeds file size");
+        return false;
+    }
+
+    if (firstLevel >= numLevels)
+    {
+        URHO3D_LOGERROR("Texture container mip level " + ea::to_string(firstLevel) + " out of bounds");
+        return false;
+    }
+
+    // Levels are stored from the highest detail down, so the skipped levels are a prefix of each face or layer
+    const unsigned skippedDataSize = (unsigned)GetUTEXImageDataSize((CompressedFormat)format, width, height, depth, firstLevel);
+    const unsigned levelDataSize = imageDataSize - skippedDataSize;
+
+    compressedFormat_ = (CompressedFormat)format;
+    components_ = components;
+    cubemap_ = (flags & UTEX_CUBEMAP) != 0;
+    array_ = (flags & UTEX_ARRAY) != 0;
+    sRGB_ = (flags & UTEX_SRGB) != 0;
+
+    // The payload of each face or layer is read with a single call, which is a plain copy from a memory mapped package
+    Image* currentImage = this;
+    for (unsigned imageIndex = 0; imageIndex < numImages; ++imageIndex)
+    {
+        currentImage->data_ = new unsigned char[levelDataSize];
+        currentImage->cubemap_ = cubemap_;
+        currentImage->array_ = array_;
+        currentImage->sRGB_ = sRGB_;
+        currentImage->components_ = components_;
+        currentImage->compressedFormat_ = compressedFormat_;
+        currentImage->width_ = Max(width >> firstLevel, 1u);
+        currentImage->height_ = Max(height >> firstLevel, 1u);
+        currentImage->depth_ = Max(depth >> firstLevel, 1u);
+        currentImage->numCompressedLevels_ = numLevels - firstLevel;
+        currentImage->SetMemoryUse(levelDataSize);
+
+        const unsigned levelOffset = dataOffset + imageIndex * imageDataSize + skippedDataSize;
+        if (source.Seek(levelOffset) != levelOffset || source.Read(currentImage->data_.get(), levelDataSize) != levelDataSize)
+        {
+            URHO3D_LOGERROR("Could not read texture container data from " + source.GetName());
+            return false;
+        }
+
+        if (imageIndex < numImages - 1)
+        {
+            SharedPtr<Image> nextImage(context_->CreateObject<Image>());
+            currentImage->nextSibling_ = nextImage;
+            currentImage = nextImage;
+        }
+    }
+
+    return true;
+}
+
 bool Image::FlipHorizontal()
 {
     if (!data_)
@@ -1168,7 +1348,7 @@ bool Image::FlipVertical()
     return true;
 }
 
-bool Image::Resize(int width, int height)
+bool Image::Resize(int width, int height, ImageResampleFilter filter)
 {
     URHO3D_PROFILE("ResizeImage");
 
@@ -1187,40 +1367,27 @@ bool Image::Resize(int width, int height)
     if (!data_ || width <= 0 || height <= 0)
         return false;
 
-    /// \todo Reducing image size does not sample all needed pixels
+    ImageResampleWeights horizontal;
+    ImageResampleWeights vertical;
+    horizontal.Define(width_, width, filter);
+    vertical.Define(height_, height, filter);
+
     ea::shared_array<unsigned char> newData(new unsigned char[width * height * components_]);
-    for (int y = 0; y < height; ++y)
+    unsigned char* dest = newData.get();
+    const unsigned char* src = data_.get();
+    ProcessRows(context_, height, width, [&](unsigned startRow, unsigned endRow)
     {
-        for (int x = 0; x < width; ++x)
+        for (int row = startRow; row < (int)endRow; row += RESAMPLE_BAND_ROWS)
         {
-            // Calculate float coordinates between 0 - 1 for resampling
-            float xF = (width_ > 1) ? (float)x / (float)(width - 1) : 0.0f;
-            float yF = (height_ > 1) ? (float)y / (float)(height - 1) : 0.0f;
-            unsigned uintColor = GetPixelBilinear(xF, yF).ToUInt();
-            unsigned char* dest = newData.get() + (y * width + x) * components_;
-            auto* src = (unsigned char*)&uintColor;
-
-            switch (components_)
-            {
-            case 4:
-                dest[3] = src[3];
-                // Fall through
-            case 3:
-                dest[2] = src[2];
-                // Fall through
-            case 2:
-                dest[1] = src[1];
-                // Fall through
-            default:
-                dest[0] = src[0];
-                break;
-            }
+            ResampleRows(dest, width, width * components_, src, width_, components_, sRGB_, horizontal, vertical, row,
+                Min(row + RESAMPLE_BAND_ROWS, (int)endRow));
         }
-    }
+    });
 
     width_ = width;
     height_ = height;
     data_ = newData;
+    nextLevel_.Reset();
     SetMemoryUse(width * height * depth_ * components_);
     return true;
 }
@@ -1391,6 +1558,123 @@ bool Image::SaveDDS(const ea::string& fileName) const
     return true;
 }
 
+bool Image::SaveUTEX(const ea::string& fileName) const
+{
+    URHO3D_PROFILE("SaveImageUTEX");
+
+    if (!data_)
+    {
+        URHO3D_LOGERROR("Can not save zero-sized image " + GetName());
+        return false;
+    }
+
+    // Gather the images to store: all faces or layers if compressed, otherwise an RGBA mip chain of each face or layer
+    // calculated here
+    ea::vector<SharedPtr<Image> > images;
+    unsigned numImages = 0;
+    unsigned numLevels = 0;
+    unsigned imageDataSize = 0;
+    if (IsCompressed())
+    {
+        numLevels = numCompressedLevels_;
+        for (unsigned i = 0; i < numLevels; ++i)
+        {
+            const CompressedLevel level = GetCompressedLevel(i);
+            if (!level.data_)
+                return false;
+            imageDataSize += level.dataSize_;
+        }
+
+        for (const Image* image = this; image; image = image->nextSibling_)
+        {
+            if (image->GetMemoryUse() < imageDataSize)
+            {
+                URHO3D_LOGERROR("Can not save image with incomplete faces or layers to texture container");
+                return false;
+            }
+            images.emplace_back(const_cast<Image*>(image));
+        }
+        numImages = images.size();
+    }
+    else
+    {
+        for (const Image* image = this; image; image = image->nextSibling_)
+        {
+            if (image->GetWidth() != width_ || image->GetHeight() != height_ || image->GetDepth() != depth_)
+            {
+                URHO3D_LOGERROR("Can not save image with faces or layers of different sizes to texture container");
+                return false;
+            }
+
+            SharedPtr<Image> level = image->ConvertToRGBA();
+            if (!level)
+                return false;
+
+            // All faces have the same size, so the first one defines the mip chain
+            while (level)
+            {
+                images.emplace_back(level);
+                if (!numImages)
+                {
+                    imageDataSize += level->GetWidth() * level->GetHeight() * level->GetDepth() * 4;
+                    ++numLevels;
+                }
+                if (level->GetWidth() == 1 && level->GetHeight() == 1 && level->GetDepth() == 1)
+                    break;
+                level = level->GetNextLevel();
+            }
+            ++numImages;
+        }
+    }
+
+    File outFile(context_, fileName, FILE_WRITE);
+    if (!outFile.IsOpen())
+    {
+        URHO3D_LOGERROR("Access denied to " + fileName);
+        return false;
+    }
+
+    unsigned flags = 0;
+    if (cubemap_)
+        flags |= UTEX_CUBEMAP;
+    if (array_)
+        flags |= UTEX_ARRAY;
+    if (sRGB_)
+        flags |= UTEX_SRGB;
+
+    outFile.WriteFileID("UTEX");
+    outFile.WriteUInt(UTEX_VERSION);
+    outFile.WriteUInt(IsCompressed() ? compressedFormat_ : CF_RGBA);
+    outFile.WriteUInt(flags);
+    outFile.WriteUInt(width_);
+    outFile.WriteUInt(height_);
+    outFile.WriteUInt(depth_);
+    outFile.WriteUInt(IsCompressed() ? components_ : 4);
+    outFile.WriteUInt(numLevels);
+    outFile.WriteUInt(numImages);
+    outFile.WriteUInt(imageDataSize);
+
+    // Align the payload so that it can be handed to the graphics API in place
+    const unsigned headerSize = outFile.GetPosition() + sizeof(unsigned);
+    const unsigned dataOffset = (headerSize + UTEX_DATA_ALIGNMENT - 1) & ~(UTEX_DATA_ALIGNMENT - 1);
+    outFile.WriteUInt(dataOffset);
+    for (unsigned i = headerSize; i < dataOffset; ++i)
+        outFile.WriteUByte(0);
+
+    if (IsCompressed())
+    {
+        for (const Image* image : images)
+            outFile.Write(image->GetData(), imageDataSize);
+    }
+    else
+    {
+        for (const Image* level : images)
+            outFile.Write(level->GetData(), level->GetWidth() * level->GetHeight() * level->GetDepth() * 4);
+    }
+
+    return true;
+}
+
 bool Image::SaveWEBP(const ea::string& fileName, float compression /* = 0.0f */) const
 {
 #ifdef URHO3D_WEBP
@@ -1636,137 +1920,27 @@ SharedPtr<Image> Image::GetNextLevel() const
         mipImage->SetSize(widthOut, heightOut, depthOut, components_);
     else
         mipImage->SetSize(widthOut, heightOut, components_);
+    mipImage->sRGB_ = sRGB_;
 
     const unsigned char* pixelDataIn = data_.get();
     unsigned char* pixelDataOut = mipImage->data_.get();
 
-    // 1D case
+    // 1D case: the pixels are contiguous in either orientation
     if (depth_ == 1 && (height_ == 1 || width_ == 1))
-    {
-        // Loop using the larger dimension
-        if (widthOut < heightOut)
-            widthOut = heightOut;
-
-        switch (components_)
-        {
-        case 1:
-            for (int x = 0; x < widthOut; ++x)
-                pixelDataOut[x] = (unsigned char)(((unsigned)pixelDataIn[x * 2] + pixelDataIn[x * 2 + 1]) >> 1);
-            break;
-
-        case 2:
-            for (int x = 0; x < widthOut * 2; x += 2)
-            {
-                pixelDataOut[x] = (unsigned char)(((unsigned)pixelDataIn[x * 2] + pixelDataIn[x * 2 + 2]) >> 1);
-                pixelDataOut[x + 1] = (unsigned char)(((unsigned)pixelDataIn[x * 2 + 1] + pixelDataIn[x * 2 + 3]) >> 1);
-            }
-            break;
-
-        case 3:
-            for (int x = 0; x < widthOut * 3; x += 3)
-            {
-                pixelDataOut[x] = (unsigned char)(((unsigned)pixelDataIn[x * 2] + pixelDataIn[x * 2 + 3]) >> 1);
-                pixelDataOut[x + 1] = (unsigned char)(((unsigned)pixelDataIn[x * 2 + 1] + pixelDataIn[x * 2 + 4]) >> 1);
-                pixelDataOut[x + 2] = (unsigned char)(((unsigned)pixelDataIn[x * 2 + 2] + pixelDataIn[x * 2 + 5]) >> 1);
-            }
-            break;
-
-        case 4:
-            for (int x = 0; x < widthOut * 4; x += 4)
-            {
-                pixelDataOut[x] = (unsigned char)(((unsigned)pixelDataIn[x * 2] + pixelDataIn[x * 2 + 4]) >> 1);
-                pixelDataOut[x + 1] = (unsigned char)(((unsigned)pixelDataIn[x * 2 + 1] + pixelDataIn[x * 2 + 5]) >> 1);
-                pixelDataOut[x + 2] = (unsigned char)(((unsigned)pixelDataIn[x * 2 + 2] + pixelDataIn[x * 2 + 6]) >> 1);
-                pixelDataOut[x + 3] = (unsigned char)(((unsigned)pixelDataIn[x * 2 + 3] + pixelDataIn[x * 2 + 7]) >> 1);
-            }
-            break;
-
-        default:
-            assert(false);  // Should never reach here
-            break;
-        }
-    }
+        DownsampleRow2x2(pixelDataOut, pixelDataIn, pixelDataIn, Max(widthOut, heightOut), components_, sRGB_);
     // 2D case
     else if (depth_ == 1)
     {
-        switch (components_)
+        const unsigned rowSize = width_ * components_;
+        const unsigned rowSizeOut = widthOut * components_;
+        ProcessRows(context_, heightOut, widthOut, [&](unsigned startRow, unsigned endRow)
         {
-        case 1:
-            for (int y = 0; y < heightOut; ++y)
+            for (unsigned y = startRow; y < endRow; ++y)
             {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_];
-                unsigned char* out = &pixelDataOut[y * widthOut];
-
-                for (int x = 0; x < widthOut; ++x)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 1] +
-                                              inLower[x * 2] + inLower[x * 2 + 1]) >> 2);
-                }
+                DownsampleRow2x2(&pixelDataOut[y * rowSizeOut], &pixelDataIn[(y * 2) * rowSize], &pixelDataIn[(y * 2 + 1) * rowSize],
+                    widthOut, components_, sRGB_);
             }
-            break;
-
-        case 2:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 2];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 2];
-                unsigned char* out = &pixelDataOut[y * widthOut * 2];
-
-                for (int x = 0; x < widthOut * 2; x += 2)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 2] +
-                                              inLower[x * 2] + inLower[x * 2 + 2]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 3] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 3]) >> 2);
-                }
-            }
-            break;
-
-        case 3:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 3];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 3];
-                unsigned char* out = &pixelDataOut[y * widthOut * 3];
-
-                for (int x = 0; x < widthOut * 3; x += 3)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 3] +
-                                              inLower[x * 2] + inLower[x * 2 + 3]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 4] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 5]) >> 2);
-                }
-            }
-            break;
-
-        case 4:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 4];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 4];
-                unsigned char* out = &pixelDataOut[y * widthOut * 4];
-
-                for (int x = 0; x < widthOut * 4; x += 4)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 4] +
-                                              inLower[x * 2] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 5]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 6] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 6]) >> 2);
-                    out[x + 3] = (unsigned char)(((unsigned)inUpper[x * 2 + 3] + inUpper[x * 2 + 7] +
-                                                  inLower[x * 2 + 3] + inLower[x * 2 + 7]) >> 2);
-                }
-            }
-            break;
-
-        default:
-            assert(false);  // Should never reach here
-            break;
-        }
+        });
     }
     // 3D case
     else
@@ -1888,6 +2062,10 @@ SharedPtr<Image> Image::GetNextLevel() const
                                                       inOuterLower[x * 2 + 2] + inOuterLower[x * 2 + 6] +
                                                       inInnerUpper[x * 2 + 2] + inInnerUpper[x * 2 + 6] +
                                                       inInnerLower[x * 2 + 2] + inInnerLower[x * 2 + 6]) >> 3);
+                        out[x + 3] = (unsigned char)(((unsigned)inOuterUpper[x * 2 + 3] + inOuterUpper[x * 2 + 7] +
+                                                      inOuterLower[x * 2 + 3] + inOuterLower[x * 2 + 7] +
+                                                      inInnerUpper[x * 2 + 3] + inInnerUpper[x * 2 + 7] +
+                                                      inInnerLower[x * 2 + 3] + inInnerLower[x * 2 + 7]) >> 3);
                     }
                 }
             }
@@ -1926,48 +2104,15 @@ SharedPtr<Image> Image::ConvertToRGBA() const
 
     SharedPtr<Image> ret(context_->CreateObject<Image>());
     ret->SetSize(width_, height_, depth_, 4);
+    ret->sRGB_ = sRGB_;
 
     const unsigned char* src = data_.get();
     unsigned char* dest = ret->GetData();
-
-    switch (components_)
+    ProcessRows(context_, height_ * depth_, width_, [&](unsigned startRow, unsigned endRow)
     {
-    case 1:
-        for (unsigned i = 0; i < static_cast<unsigned>(width_ * height_ * depth_); ++i)
-        {
-            unsigned char pixel = *src++;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = 255;
-        }
-        break;
-
-    case 2:
-        for (unsigned i = 0; i < static_cast<unsigned>(width_ * height_ * depth_); ++i)
-        {
-            unsigned char pixel = *src++;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = *src++;
-        }
-        break;
-
-    case 3:
-        for (unsigned i = 0; i < static_cast<unsigned>(width_ * height_ * depth_); ++i)
-        {
-            *dest++ = *src++;
-            *dest++ = *src++;
-            *dest++ = *src++;
-            *dest++ = 255;
-        }
-        break;
-
-    default:
-        assert(false);  // Should never reach nere
-        break;
-    }
+        ConvertPixelsToRGBA(dest + startRow * width_ * 4, src + startRow * width_ * components_, (endRow - startRow) * width_,
+            components_);
+    });
 
     return ret;
 }
@@ -2335,6 +2480,14 @@ unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height
 {
     unsigned dataSize = source.GetSize();
 
+    // Decode straight from memory backed sources such as memory mapped packages, starting from the current position as Read() does
+    if (const unsigned char* view = source.GetMemoryView())
+    {
+        const unsigned position = Min(source.GetPosition(), dataSize);
+        source.Seek(dataSize);
+        return stbi_load_from_memory(view + position, dataSize - position, &width, &height, (int*)&components, 0);
+    }
+
     ea::shared_array<unsigned char> buffer(new unsigned char[dataSize]);
     source.Read(buffer.get(), dataSize);
     return stbi_load_from_memory(buffer.get(), dataSize, &width, &height, (int*)&components, 0);
@@ -2393,22 +2546,14 @@ bool Image::SetSubimage(const Image* image, const IntRect& rect)
     }
     else
     {
-        unsigned char* dest = data_.get() + (rect.top_ * width_ + rect.left_) * components_;
-        for (int y = 0; y < destHeight; ++y)
-        {
-            for (int x = 0; x < destWidth; ++x)
-            {
-                // Calculate float coordinates between 0 - 1 for resampling
-                const float xF = (image->width_ > 1) ? static_cast<float>(x) / (destWidth - 1) : 0.0f;
-                const float yF = (image->height_ > 1) ? static_cast<float>(y) / (destHeight - 1) : 0.0f;
-                const unsigned uintColor = image->GetPixelBilinear(xF, yF).ToUInt();
-
-                memcpy(dest, reinterpret_cast<const unsigned char*>(&uintColor), components_);
+        ImageResampleWeights horizontal;
+        ImageResampleWeights vertical;
+        horizontal.Define(image->width_, destWidth, RESAMPLE_BILINEAR);
+        vertical.Define(image->height_, destHeight, RESAMPLE_BILINEAR);
 
-                dest += components_;
-            }
-            dest += (width_ - destWidth) * components_;
-        }
+        unsigned char* dest = data_.get() + (rect.top_ * width_ + rect.left_) * components_;
+        ResampleRows(dest, destWidth, width_ * components_, image->GetData(), image->width_, components_, sRGB_, horizontal, vertical,
+            0, destHeight);
     }
 
     return true;
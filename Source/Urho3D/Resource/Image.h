@@ -52,6 +52,15 @@ enum CompressedFormat
     CF_PVRTC_RGBA_4BPP,
 };
 
+/// Image resampling filter.
+enum ImageResampleFilter
+{
+    /// Bilinear filter. When downscaling, the filter widens to average all covered source pixels.
+    RESAMPLE_BILINEAR = 0,
+    /// Three-lobe Lanczos filter. Sharper than bilinear, may ring at hard edges.
+    RESAMPLE_LANCZOS3,
+};
+
 /// Compressed image mip level.
 struct URHO3D_API CompressedLevel
 {
@@ -114,12 +123,14 @@ public:
     void SetPixelInt(int x, int y, int z, unsigned uintColor);
     /// Load as color LUT. Return true if successful.
     bool LoadColorLUT(Deserializer& source);
+    /// Load a texture container from the specified mip level down, without reading the data of the higher detail levels. The image size is that of the first loaded level. Other formats are not supported. Return true if successful.
+    bool LoadLevels(Deserializer& source, unsigned firstLevel);
     /// Flip image horizontally. Return true if successful.
     bool FlipHorizontal();
     /// Flip image vertically. Return true if successful.
     bool FlipVertical();
-    /// Resize image by bilinear resampling. Return true if successful.
-    bool Resize(int width, int height);
+    /// Resize image by separable resampling with the specified filter. Large images are resampled in worker threads. Return true if successful.
+    bool Resize(int width, int height, ImageResampleFilter filter = RESAMPLE_BILINEAR);
     /// Clear the image with a color.
     void Clear(const Color& color);
     /// Clear the image with an integer color. R component is in the 8 lowest bits.
@@ -134,13 +145,17 @@ public:
     bool SaveJPG(const ea::string& fileName, int quality) const;
     /// Save in DDS format. Only uncompressed RGBA images are supported. Return true if successful.
     bool SaveDDS(const ea::string& fileName) const;
+    /// Save in the UTEX texture container with all mip levels, cube faces or array layers. Compressed data is stored as is. Uncompressed images are stored as RGBA with a full mip chain calculated at save time. The container is loaded without decoding or mip generation. Return true if successful.
+    bool SaveUTEX(const ea::string& fileName) const;
     /// Save in WebP format with minimum (fastest) or specified compression. Return true if successful. Fails always if WebP support is not compiled in.
     bool SaveWEBP(const ea::string& fileName, float compression = 0.0f) const;
-    /// Whether this texture is detected as a cubemap, only relevant for DDS.
+    /// Set whether color data is sRGB encoded. Mip levels and resizing of sRGB images filter color in linear space.
+    void SetSRGB(bool enable) { sRGB_ = enable; }
+    /// Whether this texture is detected as a cubemap, only relevant for DDS and UTEX.
     bool IsCubemap() const { return cubemap_; }
-    /// Whether this texture has been detected as a volume, only relevant for DDS.
+    /// Whether this texture has been detected as a volume, only relevant for DDS and UTEX.
     bool IsArray() const { return array_; }
-    /// Whether this texture is in sRGB, only relevant for DDS.
+    /// Whether this texture is in sRGB. Detected from DDS and UTEX, otherwise set with SetSRGB().
     bool IsSRGB() const { return sRGB_; }
 
     /// Return a 2D pixel color.
@@ -210,6 +225,8 @@ private:
     static unsigned char* GetImageData(Deserializer& source, int& width, int& height, unsigned& components);
     /// Free an image file's pixel data.
     static void FreeImageData(unsigned char* pixelData);
+    /// Load a texture container after its file ID from the specified mip level down.
+    bool LoadUTEX(Deserializer& source, unsigned firstLevel);
 
     /// Width.
     int width_{};
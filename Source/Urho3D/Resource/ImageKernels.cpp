@@ -0,0 +1,407 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Math/MathDefs.h"
+#include "../Resource/ImageKernels.h"
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Number of entries in the linear to sRGB lookup table.
+static const unsigned LINEAR_TO_SRGB_ENTRIES = 4096;
+
+/// Lookup tables for sRGB conversion.
+struct SRGBTables
+{
+    /// Construct and fill the tables.
+    SRGBTables()
+    {
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            const float value = i / 255.0f;
+            toLinear_[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+            identity_[i] = value;
+        }
+
+        for (unsigned i = 0; i < LINEAR_TO_SRGB_ENTRIES; ++i)
+        {
+            const float value = (float)i / (LINEAR_TO_SRGB_ENTRIES - 1);
+            const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+            fromLinear_[i] = (unsigned char)(encoded * 255.0f + 0.5f);
+        }
+    }
+
+    /// sRGB to linear values.
+    float toLinear_[256];
+    /// 8-bit to normalized values.
+    float identity_[256];
+    /// Quantized linear to sRGB values.
+    unsigned char fromLinear_[LINEAR_TO_SRGB_ENTRIES];
+};
+
+static const SRGBTables& GetSRGBTables()
+{
+    static const SRGBTables tables;
+    return tables;
+}
+
+/// Convert a normalized value to 8 bits with rounding and clamping.
+static inline unsigned char ToUByte(float value)
+{
+    return (unsigned char)Clamp((int)(value * 255.0f + 0.5f), 0, 255);
+}
+
+/// Convert a linear value to sRGB with the lookup table.
+static inline unsigned char ToSRGB(const SRGBTables& tables, float value)
+{
+    return tables.fromLinear_[Clamp((int)(value * (LINEAR_TO_SRGB_ENTRIES - 1) + 0.5f), 0, (int)LINEAR_TO_SRGB_ENTRIES - 1)];
+}
+
+/// Evaluate a resampling filter at a distance measured in source pixels.
+static float EvaluateFilter(ImageResampleFilter filter, float x)
+{
+    x = Abs(x);
+    if (filter == RESAMPLE_LANCZOS3)
+    {
+        if (x < M_EPSILON)
+            return 1.0f;
+        if (x >= 3.0f)
+            return 0.0f;
+        const float piX = M_PI * x;
+        return 3.0f * sinf(piX) * sinf(piX / 3.0f) / (piX * piX);
+    }
+    else
+        return Max(1.0f - x, 0.0f);
+}
+
+float SRGBToLinear(unsigned char value)
+{
+    return GetSRGBTables().toLinear_[value];
+}
+
+unsigned char LinearToSRGB(float value)
+{
+    return ToSRGB(GetSRGBTables(), value);
+}
+
+void DownsampleRow2x2(unsigned char* dest, const unsigned char* srcUpper, const unsigned char* srcLower, unsigned destWidth,
+    unsigned components, bool sRGB)
+{
+    if (sRGB && components >= 3)
+    {
+        const SRGBTables& tables = GetSRGBTables();
+        for (unsigned x = 0; x < destWidth; ++x)
+        {
+            const unsigned char* upper = srcUpper + x * 2 * components;
+            const unsigned char* lower = srcLower + x * 2 * components;
+            unsigned char* out = dest + x * components;
+            for (unsigned i = 0; i < 3; ++i)
+            {
+                const float sum = tables.toLinear_[upper[i]] + tables.toLinear_[upper[i + components]] + tables.toLinear_[lower[i]] +
+                    tables.toLinear_[lower[i + components]];
+                out[i] = ToSRGB(tables, sum * 0.25f);
+            }
+            if (components == 4)
+                out[3] = (unsigned char)(((unsigned)upper[3] + upper[7] + lower[3] + lower[7]) >> 2);
+        }
+        return;
+    }
+
+    unsigned x = 0;
+#ifdef URHO3D_SSE
+    const __m128i zero = _mm_setzero_si128();
+    if (components == 4)
+    {
+        // 8 source pixels of both rows per iteration. Pixels are widened to 16 bits, then horizontal neighbours are added
+        for (; x + 4 <= destWidth; x += 4)
+        {
+            const __m128i upper0 = _mm_loadu_si128((const __m128i*)(srcUpper + x * 8));
+            const __m128i upper1 = _mm_loadu_si128((const __m128i*)(srcUpper + x * 8 + 16));
+            const __m128i lower0 = _mm_loadu_si128((const __m128i*)(srcLower + x * 8));
+            const __m128i lower1 = _mm_loadu_si128((const __m128i*)(srcLower + x * 8 + 16));
+
+            const __m128i sum0 = _mm_add_epi16(_mm_unpacklo_epi8(upper0, zero), _mm_unpacklo_epi8(lower0, zero));
+            const __m128i sum1 = _mm_add_epi16(_mm_unpackhi_epi8(upper0, zero), _mm_unpackhi_epi8(lower0, zero));
+            const __m128i sum2 = _mm_add_epi16(_mm_unpacklo_epi8(upper1, zero), _mm_unpacklo_epi8(lower1, zero));
+            const __m128i sum3 = _mm_add_epi16(_mm_unpackhi_epi8(upper1, zero), _mm_unpackhi_epi8(lower1, zero));
+
+            const __m128i pixel0 = _mm_add_epi16(sum0, _mm_srli_si128(sum0, 8));
+            const __m128i pixel1 = _mm_add_epi16(sum1, _mm_srli_si128(sum1, 8));
+            const __m128i pixel2 = _mm_add_epi16(sum2, _mm_srli_si128(sum2, 8));
+            const __m128i pixel3 = _mm_add_epi16(sum3, _mm_srli_si128(sum3, 8));
+
+            const __m128i pixels01 = _mm_srli_epi16(_mm_unpacklo_epi64(pixel0, pixel1), 2);
+            const __m128i pixels23 = _mm_srli_epi16(_mm_unpacklo_epi64(pixel2, pixel3), 2);
+            _mm_storeu_si128((__m128i*)(dest + x * 4), _mm_packus_epi16(pixels01, pixels23));
+        }
+    }
+    else if (components == 1)
+    {
+        // 16 source pixels of both rows per iteration. Even and odd pixels are split into 16-bit lanes and added
+        const __m128i lowByte = _mm_set1_epi16(0xff);
+        for (; x + 8 <= destWidth; x += 8)
+        {
+            const __m128i upper = _mm_loadu_si128((const __m128i*)(srcUpper + x * 2));
+            const __m128i lower = _mm_loadu_si128((const __m128i*)(srcLower + x * 2));
+            const __m128i sumUpper = _mm_add_epi16(_mm_and_si128(upper, lowByte), _mm_srli_epi16(upper, 8));
+            const __m128i sumLower = _mm_add_epi16(_mm_and_si128(lower, lowByte), _mm_srli_epi16(lower, 8));
+            const __m128i average = _mm_srli_epi16(_mm_add_epi16(sumUpper, sumLower), 2);
+            _mm_storel_epi64((__m128i*)(dest + x), _mm_packus_epi16(average, average));
+        }
+    }
+#endif
+
+    for (; x < destWidth; ++x)
+    {
+        const unsigned char* upper = srcUpper + x * 2 * components;
+        const unsigned char* lower = srcLower + x * 2 * components;
+        unsigned char* out = dest + x * components;
+        for (unsigned i = 0; i < components; ++i)
+            out[i] = (unsigned char)(((unsigned)upper[i] + upper[i + components] + lower[i] + lower[i + components]) >> 2);
+    }
+}
+
+void ConvertPixelsToRGBA(unsigned char* dest, const unsigned char* src, unsigned numPixels, unsigned components)
+{
+    unsigned i = 0;
+    switch (components)
+    {
+    case 1:
+#ifdef URHO3D_SSE
+        {
+            // Replicate each luminance byte to four lanes and set the alpha byte
+            const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+            for (; i + 16 <= numPixels; i += 16)
+            {
+                const __m128i lum = _mm_loadu_si128((const __m128i*)(src + i));
+                const __m128i lum2Lo = _mm_unpacklo_epi8(lum, lum);
+                const __m128i lum2Hi = _mm_unpackhi_epi8(lum, lum);
+                _mm_storeu_si128((__m128i*)(dest + i * 4), _mm_or_si128(_mm_unpacklo_epi16(lum2Lo, lum2Lo), alpha));
+                _mm_storeu_si128((__m128i*)(dest + i * 4 + 16), _mm_or_si128(_mm_unpackhi_epi16(lum2Lo, lum2Lo), alpha));
+                _mm_storeu_si128((__m128i*)(dest + i * 4 + 32), _mm_or_si128(_mm_unpacklo_epi16(lum2Hi, lum2Hi), alpha));
+                _mm_storeu_si128((__m128i*)(dest + i * 4 + 48), _mm_or_si128(_mm_unpackhi_epi16(lum2Hi, lum2Hi), alpha));
+            }
+        }
+#endif
+        for (; i < numPixels; ++i)
+        {
+            dest[i * 4] = dest[i * 4 + 1] = dest[i * 4 + 2] = src[i];
+            dest[i * 4 + 3] = 255;
+        }
+        break;
+
+    case 2:
+#ifdef URHO3D_SSE
+        {
+            // Widen luminance-alpha pairs to 32 bits, then replicate luminance and move alpha to the top byte
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lowByte = _mm_set1_epi32(0xff);
+            for (; i + 8 <= numPixels; i += 8)
+            {
+                const __m128i pairs = _mm_loadu_si128((const __m128i*)(src + i * 2));
+                const __m128i halves[2] = { _mm_unpacklo_epi16(pairs, zero), _mm_unpackhi_epi16(pairs, zero) };
+                for (unsigned j = 0; j < 2; ++j)
+                {
+                    const __m128i lum = _mm_and_si128(halves[j], lowByte);
+                    const __m128i alpha = _mm_slli_epi32(_mm_srli_epi32(halves[j], 8), 24);
+                    const __m128i rgb = _mm_or_si128(_mm_or_si128(lum, _mm_slli_epi32(lum, 8)), _mm_slli_epi32(lum, 16));
+                    _mm_storeu_si128((__m128i*)(dest + i * 4 + j * 16), _mm_or_si128(rgb, alpha));
+                }
+            }
+        }
+#endif
+        for (; i < numPixels; ++i)
+        {
+            dest[i * 4] = dest[i * 4 + 1] = dest[i * 4 + 2] = src[i * 2];
+            dest[i * 4 + 3] = src[i * 2 + 1];
+        }
+        break;
+
+    case 3:
+        for (; i < numPixels; ++i)
+        {
+            dest[i * 4] = src[i * 3];
+            dest[i * 4 + 1] = src[i * 3 + 1];
+            dest[i * 4 + 2] = src[i * 3 + 2];
+            dest[i * 4 + 3] = 255;
+        }
+        break;
+
+    default:
+        memcpy(dest, src, (size_t)numPixels * 4);
+        break;
+    }
+}
+
+void ImageResampleWeights::Define(int srcSize, int destSize, ImageResampleFilter filter)
+{
+    const float scale = (float)destSize / (float)srcSize;
+    const float filterScale = Min(scale, 1.0f);
+    const float radius = (filter == RESAMPLE_LANCZOS3 ? 3.0f : 1.0f) / filterScale;
+
+    numTaps_ = (unsigned)ceilf(radius * 2.0f) + 1;
+    indices_.resize(destSize * numTaps_);
+    weights_.resize(destSize * numTaps_);
+
+    for (int i = 0; i < destSize; ++i)
+    {
+        const float center = (i + 0.5f) / scale;
+        const int first = (int)floorf(center - radius);
+        int* indices = &indices_[i * numTaps_];
+        float* weights = &weights_[i * numTaps_];
+
+        float totalWeight = 0.0f;
+        for (unsigned j = 0; j < numTaps_; ++j)
+        {
+            const int index = first + (int)j;
+            indices[j] = Clamp(index, 0, srcSize - 1);
+            weights[j] = EvaluateFilter(filter, (index + 0.5f - center) * filterScale);
+            totalWeight += weights[j];
+        }
+
+        if (totalWeight != 0.0f)
+        {
+            for (unsigned j = 0; j < numTaps_; ++j)
+                weights[j] /= totalWeight;
+        }
+    }
+}
+
+void ResampleRows(unsigned char* dest, int destWidth, unsigned destStride, const unsigned char* src, int srcWidth,
+    unsigned components, bool sRGB, const ImageResampleWeights& horizontal, const ImageResampleWeights& vertical, int firstRow,
+    int lastRow)
+{
+    if (firstRow >= lastRow)
+        return;
+
+    const SRGBTables& tables = GetSRGBTables();
+    sRGB = sRGB && components >= 3;
+    const float* decodeTables[4] = { sRGB ? tables.toLinear_ : tables.identity_, sRGB ? tables.toLinear_ : tables.identity_,
+        sRGB ? tables.toLinear_ : tables.identity_, tables.identity_ };
+
+    // Find the source rows used by this range of destination rows
+    const unsigned verticalTaps = vertical.numTaps_;
+    int minRow = vertical.indices_[firstRow * verticalTaps];
+    int maxRow = minRow;
+    for (unsigned i = firstRow * verticalTaps; i < lastRow * verticalTaps; ++i)
+    {
+        minRow = Min(minRow, vertical.indices_[i]);
+        maxRow = Max(maxRow, vertical.indices_[i]);
+    }
+
+    // Filter the source rows horizontally to floats
+    const unsigned horizontalTaps = horizontal.numTaps_;
+    const unsigned destRowFloats = destWidth * components;
+    ea::vector<float> srcRow(srcWidth * components);
+    ea::vector<float> filteredRows((maxRow - minRow + 1) * destRowFloats);
+    for (int row = minRow; row <= maxRow; ++row)
+    {
+        const unsigned char* srcPixels = src + row * srcWidth * components;
+        for (int x = 0; x < srcWidth; ++x)
+        {
+            for (unsigned i = 0; i < components; ++i)
+                srcRow[x * components + i] = decodeTables[i][srcPixels[x * components + i]];
+        }
+
+        float* out = &filteredRows[(row - minRow) * destRowFloats];
+        for (int x = 0; x < destWidth; ++x)
+        {
+            const int* indices = &horizontal.indices_[x * horizontalTaps];
+            const float* weights = &horizontal.weights_[x * horizontalTaps];
+#ifdef URHO3D_SSE
+            if (components == 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (unsigned j = 0; j < horizontalTaps; ++j)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&srcRow[indices[j] * 4]), _mm_set1_ps(weights[j])));
+                _mm_storeu_ps(out + x * 4, sum);
+                continue;
+            }
+#endif
+            for (unsigned i = 0; i < components; ++i)
+            {
+                float sum = 0.0f;
+                for (unsigned j = 0; j < horizontalTaps; ++j)
+                    sum += srcRow[indices[j] * components + i] * weights[j];
+                out[x * components + i] = sum;
+            }
+        }
+    }
+
+    // Filter vertically and encode to the destination rows
+    ea::vector<float> sums(destRowFloats);
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+        ea::fill(sums.begin(), sums.end(), 0.0f);
+        for (unsigned j = 0; j < verticalTaps; ++j)
+        {
+            const float weight = vertical.weights_[y * verticalTaps + j];
+            if (weight == 0.0f)
+                continue;
+
+            const float* in = &filteredRows[(vertical.indices_[y * verticalTaps + j] - minRow) * destRowFloats];
+            unsigned i = 0;
+#ifdef URHO3D_SSE
+            const __m128 weights = _mm_set1_ps(weight);
+            for (; i + 4 <= destRowFloats; i += 4)
+                _mm_storeu_ps(&sums[i], _mm_add_ps(_mm_loadu_ps(&sums[i]), _mm_mul_ps(_mm_loadu_ps(in + i), weights)));
+#endif
+            for (; i < destRowFloats; ++i)
+                sums[i] += in[i] * weight;
+        }
+
+        unsigned char* out = dest + y * destStride;
+        if (sRGB)
+        {
+            for (unsigned i = 0; i < destRowFloats; ++i)
+                out[i] = (i % components) == 3 ? ToUByte(sums[i]) : ToSRGB(tables, sums[i]);
+            continue;
+        }
+
+        unsigned i = 0;
+#ifdef URHO3D_SSE
+        // Saturating packs clamp the results to 0-255
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 16 <= destRowFloats; i += 16)
+        {
+            const __m128i v0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&sums[i]), scale), half));
+            const __m128i v1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&sums[i + 4]), scale), half));
+            const __m128i v2 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&sums[i + 8]), scale), half));
+            const __m128i v3 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&sums[i + 12]), scale), half));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3)));
+        }
+#endif
+        for (; i < destRowFloats; ++i)
+            out[i] = ToUByte(sums[i]);
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Resource/Image.h"
+
+namespace Urho3D
+{
+
+/// Return linear value of an sRGB encoded 8-bit color component.
+URHO3D_API float SRGBToLinear(unsigned char value);
+/// Return sRGB encoded 8-bit color component of a linear value. The value is clamped to the range 0-1.
+URHO3D_API unsigned char LinearToSRGB(float value);
+
+/// Calculate one row of a mip level by averaging 2x2 pixel blocks of two source rows. With sRGB the color components are averaged in linear space, alpha is always linear.
+URHO3D_API void DownsampleRow2x2(unsigned char* dest, const unsigned char* srcUpper, const unsigned char* srcLower, unsigned destWidth,
+    unsigned components, bool sRGB);
+/// Expand pixels with 1-4 components to RGBA. Luminance is replicated to RGB and missing alpha is set opaque.
+URHO3D_API void ConvertPixelsToRGBA(unsigned char* dest, const unsigned char* src, unsigned numPixels, unsigned components);
+
+/// Separable resampling filter weights of one image axis.
+struct URHO3D_API ImageResampleWeights
+{
+    /// Calculate source indices and normalized weights for resampling an axis from source size to destination size. Downscaling widens the filter to cover all source pixels.
+    void Define(int srcSize, int destSize, ImageResampleFilter filter);
+
+    /// Number of taps per destination pixel.
+    unsigned numTaps_{};
+    /// Clamped source pixel index per destination pixel and tap.
+    ea::vector<int> indices_;
+    /// Filter weight per destination pixel and tap.
+    ea::vector<float> weights_;
+};
+
+/// Resample rows [firstRow, lastRow) of the destination image. Destination rows are destStride bytes apart. Color components of sRGB images are filtered in linear space.
+URHO3D_API void ResampleRows(unsigned char* dest, int destWidth, unsigned destStride, const unsigned char* src, int srcWidth,
+    unsigned components, bool sRGB, const ImageResampleWeights& horizontal, const ImageResampleWeights& vertical, int firstRow,
+    int lastRow);
+
+}
@@ -0,0 +1,673 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Core/StringUtils.h"
+#include "../IO/Deserializer.h"
+#include "../Math/MathDefs.h"
+#include "../Resource/JSONStreamArchive.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Syntax error message. Placeholders: {offset}.
+static const char* errorSyntax_offset = "JSON syntax error at offset {}";
+
+/// Maximum length of a number token.
+static const unsigned MAX_NUMBER_LENGTH = 63;
+
+/// Return whether the character ends a scalar value.
+static bool IsValueDelimiter(char c)
+{
+    return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '/';
+}
+
+/// Parse four hexadecimal digits.
+static bool ParseHex4(const char* src, unsigned& value)
+{
+    value = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        const char c = src[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9')
+            value |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            value |= c - 'A' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+JSONStreamInputArchive::JSONStreamInputArchive(Context* context, ea::string_view text, const ea::string& name)
+    : context_(context)
+    , name_(name)
+    , text_(text.data())
+    , pos_(text.data())
+    , end_(text.data() + text.size())
+{
+}
+
+JSONStreamInputArchive::JSONStreamInputArchive(Context* context, Deserializer& source)
+    : context_(context)
+    , name_(source.GetName())
+{
+    buffer_.resize(source.GetSize() - source.GetPosition());
+    buffer_.resize(source.Read(buffer_.data(), buffer_.size()));
+    text_ = buffer_.data();
+    pos_ = text_;
+    end_ = buffer_.data() + buffer_.size();
+}
+
+ea::string JSONStreamInputArchive::GetCurrentStackString()
+{
+    ea::string result;
+    for (const Block& block : stack_)
+    {
+        if (!result.empty())
+            result += "/";
+        result += ea::string{ block.GetName() };
+    }
+    return result;
+}
+
+bool JSONStreamInputArchive::BeginBlock(const char* name, unsigned& sizeHint, bool safe, ArchiveBlockType type)
+{
+    if (!CheckEOF(name, name))
+        return false;
+
+    // Root block starts at the first value, nested blocks at the next element
+    if (stack_.empty())
+        SkipWhitespace();
+    else if (!ReadElement(name))
+        return false;
+
+    Block block{ name ? name : "", type };
+    sizeHint = 0;
+
+    // Null value is an empty block of any type
+    if (end_ - pos_ >= 4 && !strncmp(pos_, "null", 4))
+    {
+        pos_ += 4;
+        stack_.push_back(block);
+        return true;
+    }
+
+    const char openingBracket = IsArchiveBlockJSONArray(type) ? '[' : '{';
+    if (pos_ >= end_ || *pos_ != openingBracket)
+    {
+        SetErrorFormatted(ArchiveBase::errorUnexpectedBlockType_blockName, name);
+        return false;
+    }
+
+    block.begin_ = ++pos_;
+    if (type == ArchiveBlockType::Array || type == ArchiveBlockType::Map)
+        sizeHint = CountMembers(block);
+    stack_.push_back(block);
+    return !HasError();
+}
+
+bool JSONStreamInputArchive::EndBlock()
+{
+    if (stack_.empty())
+    {
+        SetErrorFormatted(ArchiveBase::fatalUnexpectedEndBlock);
+        return false;
+    }
+
+    // Skip the members that were not read
+    const Block& block = GetCurrentBlock();
+    if (block.begin_ && !HasError())
+    {
+        const bool isObject = IsArchiveBlockJSONObject(block.type_);
+        while (NextMember())
+        {
+            if ((isObject && !ReadKey(tempString_)) || !SkipValue())
+                break;
+        }
+        SkipWhitespace();
+        if (pos_ < end_)
+            ++pos_;
+    }
+
+    stack_.pop_back();
+    if (stack_.empty())
+        CloseArchive();
+    return true;
+}
+
+bool JSONStreamInputArchive::SerializeKey(ea::string& key)
+{
+    if (!CheckEOFAndRoot("", ArchiveBase::keyElementName_))
+        return false;
+
+    Block& block = GetCurrentBlock();
+    if (block.type_ != ArchiveBlockType::Map)
+    {
+        SetErrorFormatted(ArchiveBase::fatalUnexpectedKeySerialization);
+        assert(0);
+        return false;
+    }
+
+    if (block.keyRead_)
+    {
+        SetErrorFormatted(ArchiveBase::fatalDuplicateKeySerialization);
+        assert(0);
+        return false;
+    }
+
+    if (!block.begin_ || !NextMember())
+    {
+        SetErrorFormatted(ArchiveBase::errorElementNotFound_elementName, ArchiveBase::keyElementName_);
+        return false;
+    }
+
+    if (!ReadKey(key))
+        return false;
+
+    block.keyRead_ = true;
+    return true;
+}
+
+bool JSONStreamInputArchive::SerializeKey(unsigned& key)
+{
+    ea::string stringKey;
+    if (SerializeKey(stringKey))
+    {
+        key = ToUInt(stringKey);
+        return true;
+    }
+    return false;
+}
+
+bool JSONStreamInputArchive::Serialize(const char* name, bool& value)
+{
+    if (!ReadElement(name))
+        return false;
+
+    if (end_ - pos_ >= 4 && !strncmp(pos_, "true", 4))
+    {
+        pos_ += 4;
+        value = true;
+        return true;
+    }
+    if (end_ - pos_ >= 5 && !strncmp(pos_, "false", 5))
+    {
+        pos_ += 5;
+        value = false;
+        return true;
+    }
+
+    SkipValue();
+    return false;
+}
+
+bool JSONStreamInputArchive::Serialize(const char* name, long long& value)
+{
+    if (!ReadElement(name))
+        return false;
+
+    if (!ReadString(tempString_))
+        return false;
+
+    sscanf(tempString_.c_str(), "%lld", &value);
+    return true;
+}
+
+bool JSONStreamInputArchive::Serialize(const char* name, unsigned long long& value)
+{
+    if (!ReadElement(name))
+        return false;
+
+    if (!ReadString(tempString_))
+        return false;
+
+    sscanf(tempString_.c_str(), "%llu", &value);
+    return true;
+}
+
+bool JSONStreamInputArchive::Serialize(const char* name, ea::string& value)
+{
+    return ReadElement(name) && ReadString(value);
+}
+
+bool JSONStreamInputArchive::SerializeBytes(const char* name, void* bytes, unsigned size)
+{
+    if (!ReadElement(name) || !ReadString(tempString_))
+        return false;
+
+    if (!HexStringToBuffer(tempBuffer_, tempString_))
+        return false;
+    if (size != tempBuffer_.size())
+        return false;
+    ea::copy(tempBuffer_.begin(), tempBuffer_.end(), static_cast<unsigned char*>(bytes));
+    return true;
+}
+
+bool JSONStreamInputArchive::SerializeVLE(const char* name, unsigned& value)
+{
+    double number{};
+    if (ReadElement(name) && ReadNumber(number))
+    {
+        value = (unsigned)number;
+        return true;
+    }
+    return false;
+}
+
+bool JSONStreamInputArchive::CheckEOF(const char* elementName, const char* debugName)
+{
+    if (HasError())
+        return false;
+
+    if (!ValidateName(elementName))
+    {
+        SetErrorFormatted(ArchiveBase::fatalInvalidName, debugName);
+        return false;
+    }
+
+    if (IsEOF())
+    {
+        SetErrorFormatted(ArchiveBase::errorEOF_elementName, debugName);
+        return false;
+    }
+
+    return true;
+}
+
+bool JSONStreamInputArchive::CheckEOFAndRoot(const char* elementName, const char* debugName)
+{
+    if (!CheckEOF(elementName, debugName))
+        return false;
+
+    if (stack_.empty())
+    {
+        SetErrorFormatted(ArchiveBase::fatalRootBlockNotOpened_elementName, debugName);
+        assert(0);
+        return false;
+    }
+
+    return true;
+}
+
+bool JSONStreamInputArchive::ReadElement(const char* name)
+{
+    if (!CheckEOFAndRoot(name, name))
+        return false;
+
+    Block& block = GetCurrentBlock();
+    switch (block.type_)
+    {
+    case ArchiveBlockType::Sequential:
+    case ArchiveBlockType::Array:
+        if (!block.begin_ || !NextMember())
+        {
+            SetErrorFormatted(ArchiveBase::errorElementNotFound_elementName, name);
+            return false;
+        }
+        return true;
+
+    case ArchiveBlockType::Unordered:
+        if (!name)
+        {
+            SetErrorFormatted(ArchiveBase::fatalMissingElementName);
+            assert(0);
+            return false;
+        }
+        // Not an error in Unordered block
+        return block.begin_ && FindMember(block, name);
+
+    case ArchiveBlockType::Map:
+        if (!block.keyRead_)
+        {
+            SetErrorFormatted(ArchiveBase::fatalMissingKeySerialization);
+            assert(0);
+            return false;
+        }
+        block.keyRead_ = false;
+        return true;
+
+    default:
+        assert(0);
+        return false;
+    }
+}
+
+bool JSONStreamInputArchive::FindMember(Block& block, const char* name)
+{
+    // Members are usually stored in the order they are read, so scan forward first
+    const char* nextMember = pos_;
+    bool skipped = false;
+    while (NextMember())
+    {
+        if (!ReadKey(tempString_))
+            return false;
+        if (tempString_ == name)
+        {
+            block.inOrder_ &= !skipped;
+            return true;
+        }
+        if (!SkipValue())
+            return false;
+        skipped = true;
+    }
+
+    // Members before the position were already read if the block was read in order
+    if (!block.inOrder_)
+    {
+        pos_ = block.begin_;
+        while (pos_ < nextMember && NextMember())
+        {
+            if (!ReadKey(tempString_))
+                return false;
+            if (tempString_ == name)
+                return true;
+            if (!SkipValue())
+                return false;
+        }
+    }
+
+    pos_ = nextMember;
+    return false;
+}
+
+unsigned JSONStreamInputArchive::CountMembers(const Block& block)
+{
+    const char* begin = pos_;
+    const bool isObject = IsArchiveBlockJSONObject(block.type_);
+
+    unsigned count = 0;
+    while (NextMember())
+    {
+        if ((isObject && !ReadKey(tempString_)) || !SkipValue())
+            break;
+        ++count;
+    }
+
+    pos_ = begin;
+    return count;
+}
+
+bool JSONStreamInputArchive::ReadNumber(double& value)
+{
+    const char* begin = pos_;
+    while (pos_ < end_ && !IsValueDelimiter(*pos_))
+        ++pos_;
+
+    const unsigned length = pos_ - begin;
+    if (length == 0 || length > MAX_NUMBER_LENGTH || !(*begin == '-' || (*begin >= '0' && *begin <= '9')))
+    {
+        pos_ = begin;
+        SkipValue();
+        return false;
+    }
+
+    // The text is not null-terminated in general
+    char number[MAX_NUMBER_LENGTH + 1];
+    memcpy(number, begin, length);
+    number[length] = 0;
+    value = strtod(number, nullptr);
+    return true;
+}
+
+bool JSONStreamInputArchive::ReadString(ea::string& value)
+{
+    if (pos_ >= end_ || *pos_ != '"')
+    {
+        SkipValue();
+        return false;
+    }
+
+    value.clear();
+    const char* begin = ++pos_;
+    while (pos_ < end_)
+    {
+        const char c = *pos_;
+        if (c == '"')
+        {
+            value.append(begin, pos_);
+            ++pos_;
+            return true;
+        }
+        else if (c == '\\')
+        {
+            value.append(begin, pos_);
+            if (++pos_ >= end_)
+                break;
+
+            switch (*pos_++)
+            {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u':
+            {
+                unsigned code{};
+                if (end_ - pos_ < 4 || !ParseHex4(pos_, code))
+                {
+                    SetSyntaxError();
+                    return false;
+                }
+                pos_ += 4;
+
+                // Combine surrogate pair
+                unsigned lowSurrogate{};
+                if (code >= 0xd800 && code <= 0xdbff && end_ - pos_ >= 6 && pos_[0] == '\\' && pos_[1] == 'u'
+                    && ParseHex4(pos_ + 2, lowSurrogate) && lowSurrogate >= 0xdc00 && lowSurrogate <= 0xdfff)
+                {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (lowSurrogate - 0xdc00);
+                    pos_ += 6;
+                }
+                AppendUTF8(value, code);
+                break;
+            }
+            default:
+                SetSyntaxError();
+                return false;
+            }
+            begin = pos_;
+        }
+        else
+            ++pos_;
+    }
+
+    SetSyntaxError();
+    return false;
+}
+
+bool JSONStreamInputArchive::ReadKey(ea::string& key)
+{
+    if (pos_ >= end_ || *pos_ != '"' || !ReadString(key))
+    {
+        SetSyntaxError();
+        return false;
+    }
+
+    SkipWhitespace();
+    if (pos_ >= end_ || *pos_ != ':')
+    {
+        SetSyntaxError();
+        return false;
+    }
+
+    ++pos_;
+    SkipWhitespace();
+    return true;
+}
+
+void JSONStreamInputArchive::SkipWhitespace()
+{
+    while (pos_ < end_)
+    {
+        const char c = *pos_;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            ++pos_;
+        else if (c == '/' && end_ - pos_ >= 2 && pos_[1] == '/')
+        {
+            while (pos_ < end_ && *pos_ != '\n')
+                ++pos_;
+        }
+        else if (c == '/' && end_ - pos_ >= 2 && pos_[1] == '*')
+        {
+            pos_ += 2;
+            while (end_ - pos_ >= 2 && !(pos_[0] == '*' && pos_[1] == '/'))
+                ++pos_;
+            pos_ = Min(pos_ + 2, end_);
+        }
+        else
+            break;
+    }
+}
+
+bool JSONStreamInputArchive::SkipString()
+{
+    for (++pos_; pos_ < end_; ++pos_)
+    {
+        if (*pos_ == '\\')
+            ++pos_;
+        else if (*pos_ == '"')
+        {
+            ++pos_;
+            return true;
+        }
+    }
+
+    SetSyntaxError();
+    return false;
+}
+
+bool JSONStreamInputArchive::SkipValue()
+{
+    SkipWhitespace();
+    if (pos_ >= end_)
+    {
+        SetSyntaxError();
+        return false;
+    }
+
+    const char c = *pos_;
+    if (c == '"')
+        return SkipString();
+
+    if (c != '{' && c != '[')
+    {
+        const char* begin = pos_;
+        while (pos_ < end_ && !IsValueDelimiter(*pos_))
+            ++pos_;
+
+        // A delimiter such as a stray slash can not start a value
+        if (pos_ == begin)
+        {
+            SetSyntaxError();
+            return false;
+        }
+        return true;
+    }
+
+    // Skip nested objects and arrays by tracking the bracket depth
+    unsigned depth = 0;
+    while (pos_ < end_)
+    {
+        const char ch = *pos_;
+        if (ch == '"')
+        {
+            if (!SkipString())
+                return false;
+        }
+        else if (ch == '/')
+        {
+            // Outside of strings a slash may only start a comment
+            const char* slash = pos_;
+            SkipWhitespace();
+            if (pos_ == slash)
+            {
+                SetSyntaxError();
+                return false;
+            }
+        }
+        else
+        {
+            ++pos_;
+            if (ch == '{' || ch == '[')
+                ++depth;
+            else if ((ch == '}' || ch == ']') && --depth == 0)
+                return true;
+        }
+    }
+
+    SetSyntaxError();
+    return false;
+}
+
+bool JSONStreamInputArchive::NextMember()
+{
+    SkipWhitespace();
+    if (pos_ < end_ && *pos_ == ',')
+    {
+        ++pos_;
+        SkipWhitespace();
+    }
+
+    return pos_ < end_ && *pos_ != '}' && *pos_ != ']';
+}
+
+void JSONStreamInputArchive::SetSyntaxError()
+{
+    SetErrorFormatted(errorSyntax_offset, static_cast<unsigned>(pos_ - text_));
+}
+
+// Generate serialization implementation (streaming JSON input)
+#define URHO3D_JSON_STREAM_IN_IMPL(type) \
+    bool JSONStreamInputArchive::Serialize(const char* name, type& value) \
+    { \
+        double number{}; \
+        if (ReadElement(name) && ReadNumber(number)) \
+        { \
+            value = static_cast<type>(number); \
+            return true; \
+        } \
+        return false; \
+    }
+
+URHO3D_JSON_STREAM_IN_IMPL(signed char);
+URHO3D_JSON_STREAM_IN_IMPL(short);
+URHO3D_JSON_STREAM_IN_IMPL(int);
+URHO3D_JSON_STREAM_IN_IMPL(unsigned char);
+URHO3D_JSON_STREAM_IN_IMPL(unsigned short);
+URHO3D_JSON_STREAM_IN_IMPL(unsigned int);
+URHO3D_JSON_STREAM_IN_IMPL(float);
+URHO3D_JSON_STREAM_IN_IMPL(double);
+
+#undef URHO3D_JSON_STREAM_IN_IMPL
+
+}
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/Archive.h"
+#include "../Resource/JSONArchive.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+
+/// Streaming JSON input archive block. Internal.
+struct JSONStreamInputArchiveBlock
+{
+    /// Block name.
+    ea::string_view name_;
+    /// Block type.
+    ArchiveBlockType type_{};
+    /// First character after the opening bracket, or null for a null value.
+    const char* begin_{};
+    /// Whether the key was read (for Map blocks).
+    bool keyRead_{};
+    /// Whether the members before the current position were read in order (for Unordered blocks).
+    bool inOrder_{ true };
+
+    /// Return name.
+    ea::string_view GetName() const { return name_; }
+    /// Return block type.
+    ArchiveBlockType GetType() const { return type_; }
+};
+
+/// JSON input archive that reads directly from JSON text without building a JSONValue tree. Reads the same data as JSONInputArchive, including comments and trailing commas. Members of Unordered blocks are found fastest when they are stored in serialization order; a member that was already read in order is not found again. Map block elements are read in document order. Size hints are provided for Array and Map blocks only.
+class URHO3D_API JSONStreamInputArchive : public ArchiveBaseT<true, true>
+{
+public:
+    /// Construct from JSON text. The text must outlive the archive.
+    JSONStreamInputArchive(Context* context, ea::string_view text, const ea::string& name = EMPTY_STRING);
+    /// Construct from stream. The remaining stream content is read into an internal buffer.
+    JSONStreamInputArchive(Context* context, Deserializer& source);
+
+    /// Get context.
+    Context* GetContext() final { return context_; }
+    /// Return name of the archive.
+    ea::string_view GetName() const final { return name_; }
+
+    /// Whether the unordered element access is supported for Unordered blocks.
+    bool IsUnorderedSupportedNow() const final { return !stack_.empty() && stack_.back().GetType() == ArchiveBlockType::Unordered; }
+    /// Return current string stack.
+    ea::string GetCurrentStackString() final;
+
+    /// Begin archive block.
+    bool BeginBlock(const char* name, unsigned& sizeHint, bool safe, ArchiveBlockType type) final;
+    /// End archive block.
+    bool EndBlock() final;
+
+    /// Serialize string key. Used with Map block only.
+    bool SerializeKey(ea::string& key) final;
+    /// Serialize unsigned integer key. Used with Map block only.
+    bool SerializeKey(unsigned& key) final;
+
+    /// Serialize bool.
+    bool Serialize(const char* name, bool& value) final;
+    /// Serialize signed char.
+    bool Serialize(const char* name, signed char& value) final;
+    /// Serialize unsigned char.
+    bool Serialize(const char* name, unsigned char& value) final;
+    /// Serialize signed short.
+    bool Serialize(const char* name, short& value) final;
+    /// Serialize unsigned short.
+    bool Serialize(const char* name, unsigned short& value) final;
+    /// Serialize signed int.
+    bool Serialize(const char* name, int& value) final;
+    /// Serialize unsigned int.
+    bool Serialize(const char* name, unsigned int& value) final;
+    /// Serialize signed long.
+    bool Serialize(const char* name, long long& value) final;
+    /// Serialize unsigned long.
+    bool Serialize(const char* name, unsigned long long& value) final;
+    /// Serialize float.
+    bool Serialize(const char* name, float& value) final;
+    /// Serialize double.
+    bool Serialize(const char* name, double& value) final;
+    /// Serialize string.
+    bool Serialize(const char* name, ea::string& value) final;
+
+    /// Serialize bytes. Size is not encoded and should be provided externally!
+    bool SerializeBytes(const char* name, void* bytes, unsigned size) final;
+    /// Serialize Variable Length Encoded unsigned integer, up to 29 significant bits.
+    bool SerializeVLE(const char* name, unsigned& value) final;
+
+private:
+    /// Block type.
+    using Block = JSONStreamInputArchiveBlock;
+
+    /// Get current block.
+    Block& GetCurrentBlock() { return stack_.back(); }
+    /// Check EOF.
+    bool CheckEOF(const char* elementName, const char* debugName);
+    /// Check EOF and root block.
+    bool CheckEOFAndRoot(const char* elementName, const char* debugName);
+    /// Position at the value of the next element of the current block. Return false if not found.
+    bool ReadElement(const char* name);
+    /// Position at the value of the named member of an Unordered block. Return false if not found.
+    bool FindMember(Block& block, const char* name);
+    /// Count the remaining members of a block without moving.
+    unsigned CountMembers(const Block& block);
+    /// Read number at the current position.
+    bool ReadNumber(double& value);
+    /// Read string at the current position.
+    bool ReadString(ea::string& value);
+    /// Read object member key and the following colon.
+    bool ReadKey(ea::string& key);
+    /// Skip whitespace and comments.
+    void SkipWhitespace();
+    /// Skip string at the current position.
+    bool SkipString();
+    /// Skip value at the current position.
+    bool SkipValue();
+    /// Move to the next member of a block, skipping the separator. Return false at the end of the block.
+    bool NextMember();
+    /// Set syntax error at the current position.
+    void SetSyntaxError();
+
+    /// Context.
+    Context* context_{};
+    /// Archive name.
+    ea::string name_;
+    /// Text storage when reading from a stream.
+    ea::vector<char> buffer_;
+    /// Beginning of text.
+    const char* text_{};
+    /// Current position.
+    const char* pos_{};
+    /// End of text.
+    const char* end_{};
+    /// Blocks stack.
+    ea::vector<Block> stack_;
+    /// Temporary string.
+    ea::string tempString_;
+    /// Temporary buffer.
+    ea::vector<unsigned char> tempBuffer_;
+};
+
+}
@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../Resource/PreloadManifest.h"
+#include "../Resource/XMLFile.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+PreloadManifest::PreloadManifest(Context* context) :
+    Resource(context),
+    sourceChecksum_(0)
+{
+}
+
+PreloadManifest::~PreloadManifest() = default;
+
+void PreloadManifest::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PreloadManifest>();
+}
+
+bool PreloadManifest::BeginLoad(Deserializer& source)
+{
+    Clear();
+
+    XMLFile xmlFile(context_);
+    if (!xmlFile.Load(source))
+        return false;
+
+    XMLElement rootElem = xmlFile.GetRoot("preload");
+    if (!rootElem)
+    {
+        URHO3D_LOGERROR("Invalid preload manifest " + source.GetName());
+        return false;
+    }
+
+    sourceChecksum_ = rootElem.GetUInt("checksum");
+
+    // Add all entries first, as dependencies of cyclic resources may refer forward
+    for (XMLElement resourceElem = rootElem.GetChild("resource"); resourceElem; resourceElem = resourceElem.GetNext("resource"))
+        AddResource(StringHash(resourceElem.GetAttribute("type")), resourceElem.GetAttribute("name"));
+
+    unsigned index = 0;
+    for (XMLElement resourceElem = rootElem.GetChild("resource"); resourceElem; resourceElem = resourceElem.GetNext("resource"), ++index)
+    {
+        const ea::vector<ea::string> dependencies = resourceElem.GetAttribute("dependencies").split(' ');
+        for (const ea::string& dependency : dependencies)
+            AddDependency(index, ToUInt(dependency));
+    }
+
+    SetMemoryUse(entries_.size() * sizeof(PreloadManifestEntry));
+    return true;
+}
+
+bool PreloadManifest::Save(Serializer& dest) const
+{
+    XMLFile xmlFile(context_);
+    XMLElement rootElem = xmlFile.CreateRoot("preload");
+    rootElem.SetUInt("checksum", sourceChecksum_);
+
+    for (const PreloadManifestEntry& entry : entries_)
+    {
+        XMLElement resourceElem = rootElem.CreateChild("resource");
+        resourceElem.SetAttribute("type", context_->GetTypeName(entry.type_));
+        resourceElem.SetAttribute("name", entry.name_);
+
+        if (!entry.dependencies_.empty())
+        {
+            ea::vector<ea::string> dependencies;
+            for (unsigned dependency : entry.dependencies_)
+                dependencies.push_back(ea::to_string(dependency));
+            resourceElem.SetAttribute("dependencies", ea::string::joined(dependencies, " "));
+        }
+    }
+
+    return xmlFile.Save(dest);
+}
+
+unsigned PreloadManifest::AddResource(StringHash type, const ea::string& name)
+{
+    const auto key = ea::make_pair(type, StringHash(name));
+    auto i = entryIndices_.find(key);
+    if (i != entryIndices_.end())
+        return i->second;
+
+    const unsigned index = entries_.size();
+    entries_.push_back({type, name, {}});
+    entryIndices_[key] = index;
+    return index;
+}
+
+void PreloadManifest::AddDependency(unsigned index, unsigned dependencyIndex)
+{
+    if (index >= entries_.size() || dependencyIndex >= entries_.size() || index == dependencyIndex)
+        return;
+
+    ea::vector<unsigned>& dependencies = entries_[index].dependencies_;
+    if (!dependencies.contains(dependencyIndex))
+        dependencies.push_back(dependencyIndex);
+}
+
+void PreloadManifest::SortByDependencies()
+{
+    // Depth-first post-order traversal, so that each entry is emitted after everything it depends on
+    enum VisitState : unsigned char { NOT_VISITED, VISITING, VISITED };
+    ea::vector<VisitState> states(entries_.size(), NOT_VISITED);
+    ea::vector<unsigned> order;
+    order.reserve(entries_.size());
+
+    ea::vector<ea::pair<unsigned, unsigned> > stack;
+    for (unsigned root = 0; root < entries_.size(); ++root)
+    {
+        if (states[root] != NOT_VISITED)
+            continue;
+
+        states[root] = VISITING;
+        stack.emplace_back(root, 0u);
+        while (!stack.empty())
+        {
+            auto& top = stack.back();
+            const ea::vector<unsigned>& dependencies = entries_[top.first].dependencies_;
+            if (top.second < dependencies.size())
+            {
+                const unsigned dependency = dependencies[top.second++];
+                if (states[dependency] == NOT_VISITED)
+                {
+                    states[dependency] = VISITING;
+                    stack.emplace_back(dependency, 0u);
+                }
+            }
+            else
+            {
+                states[top.first] = VISITED;
+                order.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+    }
+
+    ea::vector<unsigned> newIndices(entries_.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        newIndices[order[i]] = i;
+
+    ea::vector<PreloadManifestEntry> sortedEntries(entries_.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        PreloadManifestEntry& entry = sortedEntries[i];
+        entry = ea::move(entries_[order[i]]);
+        for (unsigned& dependency : entry.dependencies_)
+            dependency = newIndices[dependency];
+        entryIndices_[ea::make_pair(entry.type_, StringHash(entry.name_))] = i;
+    }
+
+    entries_ = ea::move(sortedEntries);
+}
+
+void PreloadManifest::Clear()
+{
+    entries_.clear();
+    entryIndices_.clear();
+    sourceChecksum_ = 0;
+}
+
+}
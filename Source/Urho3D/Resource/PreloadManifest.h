@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Resource/Resource.h"
+
+namespace Urho3D
+{
+
+/// Resource listed in a preload manifest.
+struct PreloadManifestEntry
+{
+    /// Resource type.
+    StringHash type_;
+    /// Resource name.
+    ea::string name_;
+    /// Indices of the entries this resource requested while loading.
+    ea::vector<unsigned> dependencies_;
+};
+
+/// Resources used by a scene or object prefab and the dependencies between them, as recorded by the resource cache. When sorted, dependencies come before the resources that requested them, so that all entries can be queued for background loading at once in that order.
+class URHO3D_API PreloadManifest : public Resource
+{
+    URHO3D_OBJECT(PreloadManifest, Resource);
+
+public:
+    /// Construct.
+    explicit PreloadManifest(Context* context);
+    /// Destruct.
+    ~PreloadManifest() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    bool BeginLoad(Deserializer& source) override;
+    /// Save resource. Return true if successful.
+    bool Save(Serializer& dest) const override;
+
+    /// Add a resource if not listed yet. Return its entry index.
+    unsigned AddResource(StringHash type, const ea::string& name);
+    /// Add a dependency between two entries.
+    void AddDependency(unsigned index, unsigned dependencyIndex);
+    /// Sort entries so that dependencies come before the resources that requested them, otherwise keeping the order the resources were added in. Cyclic dependencies are broken at the first entry encountered.
+    void SortByDependencies();
+    /// Set checksum of the file the manifest was recorded for.
+    void SetSourceChecksum(unsigned checksum) { sourceChecksum_ = checksum; }
+    /// Remove all entries.
+    void Clear();
+
+    /// Return entries.
+    const ea::vector<PreloadManifestEntry>& GetEntries() const { return entries_; }
+
+    /// Return number of entries.
+    unsigned GetNumEntries() const { return entries_.size(); }
+
+    /// Return checksum of the file the manifest was recorded for.
+    unsigned GetSourceChecksum() const { return sourceChecksum_; }
+
+    /// Return name of the manifest belonging to a scene or object prefab file.
+    static ea::string GetManifestName(const ea::string& sourceName) { return sourceName + ".preload"; }
+
+private:
+    /// Entries.
+    ea::vector<PreloadManifestEntry> entries_;
+    /// Entry indices by resource type and name hash.
+    ea::unordered_map<ea::pair<StringHash, StringHash>, unsigned> entryIndices_;
+    /// Checksum of the file the manifest was recorded for.
+    unsigned sourceChecksum_;
+};
+
+}
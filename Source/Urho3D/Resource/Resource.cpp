@@ -35,6 +35,8 @@ namespace Urho3D
 Resource::Resource(Context* context) :
     Object(context),
     memoryUse_(0),
+    lastUsedFrame_(0),
+    evictionPriority_(0),
     asyncLoadState_(ASYNC_DONE)
 {
 }
@@ -79,6 +79,10 @@ public:
     void SetMemoryUse(unsigned size);
     /// Reset last used timer.
     void ResetUseTimer();
+    /// Set the frame number the resource was last used in. Called by ResourceCache.
+    void SetLastUsedFrame(unsigned frameNumber) { lastUsedFrame_ = frameNumber; }
+    /// Set eviction priority. When a memory budget is exceeded, unused resources with lower priority are released first. Default 0.
+    void SetEvictionPriority(int priority) { evictionPriority_ = priority; }
     /// Set the asynchronous loading state. Called by ResourceCache. Resources in the middle of asynchronous loading are not normally returned to user.
     void SetAsyncLoadState(AsyncLoadState newState);
 
@@ -94,6 +98,12 @@ public:
     /// Return time since last use in milliseconds. If referred to elsewhere than in the resource cache, returns always zero.
     unsigned GetUseTimer();
 
+    /// Return the frame number the resource was last used in.
+    unsigned GetLastUsedFrame() const { return lastUsedFrame_; }
+
+    /// Return eviction priority.
+    int GetEvictionPriority() const { return evictionPriority_; }
+
     /// Return the asynchronous loading state.
     AsyncLoadState GetAsyncLoadState() const { return asyncLoadState_; }
 
@@ -106,6 +116,10 @@ private:
     Timer useTimer_;
     /// Memory use in bytes.
     unsigned memoryUse_;
+    /// Frame number of last use.
+    unsigned lastUsedFrame_;
+    /// Eviction priority.
+    int evictionPriority_;
     /// Asynchronous loading state.
     AsyncLoadState asyncLoadState_;
 };
@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include <EASTL/sort.h>
+
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
@@ -34,6 +36,7 @@
 #include "../Resource/Image.h"
 #include "../Resource/JSONFile.h"
 #include "../Resource/PListFile.h"
+#include "../Resource/PreloadManifest.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 #include "../Resource/XMLFile.h"
@@ -67,13 +70,24 @@ static const char* checkDirs[] =
 
 static const SharedPtr<Resource> noResource;
 
+/// How often in frames to check soft memory budgets.
+static const unsigned SOFT_BUDGET_CHECK_INTERVAL = 16;
+/// Maximum number of released resources remembered for counting reloads.
+static const unsigned MAX_EVICTED_RESOURCE_HISTORY = 16384;
+
 ResourceCache::ResourceCache(Context* context) :
     Object(context),
     autoReloadResources_(false),
     returnFailedResources_(false),
     searchPackagesFirst_(true),
+    mapPackages_(false),
     isRouting_(false),
-    finishBackgroundResourcesMs_(5)
+    finishBackgroundResourcesMs_(5),
+    totalMemoryBudget_(0),
+    totalSoftMemoryBudget_(0),
+    evictionAge_(60),
+    frameNumber_(0),
+    budgetWarningFrame_(M_MAX_UNSIGNED)
 {
     // Register Resource library object factories
     RegisterResourceLibrary(context_);
@@ -93,6 +107,12 @@ ResourceCache::~ResourceCache()
     // Shut down the background loader first
     backgroundLoader_.Reset();
 #endif
+
+    // Fail requests that were not finished
+    MutexLock lock(requestMutex_);
+    for (auto& request : pendingRequests_)
+        request.second.promise_.set_value(SharedPtr<Resource>());
+    pendingRequests_.clear();
 }
 
 bool ResourceCache::AddResourceDir(const ea::string& pathName, unsigned priority)
@@ -144,6 +164,10 @@ bool ResourceCache::AddPackageFile(PackageFile* package, unsigned priority)
         return false;
     }
 
+    // Falls back to regular file reads if mapping is not possible
+    if (mapPackages_)
+        package->MapMemory();
+
     if (priority < packages_.size())
         packages_.insert_at(priority, SharedPtr<PackageFile>(package));
     else
@@ -174,9 +198,7 @@ bool ResourceCache::AddManualResource(Resource* resource)
         return false;
     }
 
-    resource->ResetUseTimer();
-    resourceGroups_[resource->GetType()].resources_[resource->GetNameHash()] = resource;
-    UpdateResourceGroup(resource->GetType());
+    StoreResource(resource);
     return true;
 }
 
@@ -253,7 +275,10 @@ void ResourceCache::ReleaseResource(StringHash type, const ea::string& name, boo
     // If other references exist, do not release, unless forced
     if ((existingRes.Refs() == 1 && existingRes.WeakRefs() == 0) || force)
     {
-        resourceGroups_[type].resources_.erase(nameHash);
+        {
+            MutexLock lock(resourceGroupsMutex_);
+            resourceGroups_[type].resources_.erase(nameHash);
+        }
         UpdateResourceGroup(type);
     }
 }
@@ -272,7 +297,10 @@ void ResourceCache::ReleaseResources(StringHash type, bool force)
             // If other references exist, do not release, unless forced
             if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
             {
-                i->second.resources_.erase(current);
+                {
+                    MutexLock lock(resourceGroupsMutex_);
+                    i->second.resources_.erase(current);
+                }
                 released = true;
             }
         }
@@ -298,7 +326,10 @@ void ResourceCache::ReleaseResources(StringHash type, const ea::string& partialN
                 // If other references exist, do not release, unless forced
                 if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                 {
-                    i->second.resources_.erase(current);
+                    {
+                        MutexLock lock(resourceGroupsMutex_);
+                        i->second.resources_.erase(current);
+                    }
                     released = true;
                 }
             }
@@ -330,7 +361,10 @@ void ResourceCache::ReleaseResources(const ea::string& partialName, bool force)
                     // If other references exist, do not release, unless forced
                     if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                     {
-                        i->second.resources_.erase(current);
+                        {
+                            MutexLock lock(resourceGroupsMutex_);
+                            i->second.resources_.erase(current);
+                        }
                         released = true;
                     }
                 }
@@ -359,7 +393,10 @@ void ResourceCache::ReleaseAllResources(bool force)
                 // If other references exist, do not release, unless forced
                 if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                 {
-                    i->second.resources_.erase(current);
+                    {
+                        MutexLock lock(resourceGroupsMutex_);
+                        i->second.resources_.erase(current);
+                    }
                     released = true;
                 }
             }
@@ -385,6 +422,7 @@ bool ResourceCache::ReloadResource(Resource* resource)
     if (success)
     {
         resource->ResetUseTimer();
+        resource->SetLastUsedFrame(frameNumber_);
         UpdateResourceGroup(resource->GetType());
         resource->SendEvent(E_RELOADFINISHED);
         return true;
@@ -437,7 +475,32 @@ void ResourceCache::ReloadResourceWithDependencies(const ea::string& fileName)
 
 void ResourceCache::SetMemoryBudget(StringHash type, unsigned long long budget)
 {
-    resourceGroups_[type].memoryBudget_ = budget;
+    {
+        MutexLock lock(resourceGroupsMutex_);
+        resourceGroups_[type].memoryBudget_ = budget;
+    }
+    UpdateResourceGroup(type);
+}
+
+void ResourceCache::SetMemoryBudget(StringHash type, unsigned long long softBudget, unsigned long long hardBudget)
+{
+    {
+        MutexLock lock(resourceGroupsMutex_);
+        resourceGroups_[type].softMemoryBudget_ = softBudget;
+    }
+    SetMemoryBudget(type, hardBudget);
+}
+
+void ResourceCache::SetTotalMemoryBudget(unsigned long long softBudget, unsigned long long hardBudget)
+{
+    totalSoftMemoryBudget_ = softBudget;
+    totalMemoryBudget_ = hardBudget;
+
+    if (totalMemoryBudget_ && GetTotalMemoryUse() > totalMemoryBudget_)
+    {
+        EvictResources(StringHash::ZERO, totalMemoryBudget_, 1);
+        WarnOverBudget(StringHash::ZERO, GetTotalMemoryUse(), totalMemoryBudget_);
+    }
 }
 
 void ResourceCache::SetAutoReloadResources(bool enable)
@@ -552,9 +615,79 @@ Resource* ResourceCache::GetExistingResource(StringHash type, const ea::string&
     StringHash nameHash(sanitatedName);
 
     const SharedPtr<Resource>& existing = FindResource(type, nameHash);
+    if (existing)
+        existing->SetLastUsedFrame(frameNumber_);
     return existing;
 }
 
+SharedPtr<Resource> ResourceCache::GetLoadedResource(StringHash type, const ea::string& name)
+{
+    ea::string sanitatedName = SanitateResourceName(name);
+
+    // If empty name, return null pointer immediately
+    if (sanitatedName.empty())
+        return SharedPtr<Resource>();
+
+    StringHash nameHash(sanitatedName);
+
+    // Take the reference while holding the lock, so that the resource can not be released in the meanwhile
+    SharedMutexLock lock(resourceGroupsMutex_);
+
+    auto i = resourceGroups_.find(type);
+    if (i == resourceGroups_.end())
+        return SharedPtr<Resource>();
+    auto j = i->second.resources_.find(nameHash);
+    if (j == i->second.resources_.end() || j->second->GetAsyncLoadState() != ASYNC_DONE)
+        return SharedPtr<Resource>();
+
+    return j->second;
+}
+
+ResourceFuture ResourceCache::RequestResource(StringHash type, const ea::string& name, bool sendEventOnFailure)
+{
+    ea::string sanitatedName = SanitateResourceName(name);
+    StringHash nameHash(sanitatedName);
+    const ea::pair<StringHash, StringHash> key = ea::make_pair(type, nameHash);
+
+    // Hold the request mutex while checking for the loaded resource, so that a resource stored concurrently is guaranteed
+    // to complete the request created here
+    MutexLock lock(requestMutex_);
+
+    auto i = pendingRequests_.find(key);
+    if (i != pendingRequests_.end())
+        return i->second.future_;
+
+    std::promise<SharedPtr<Resource> > promise;
+    ResourceFuture future = promise.get_future().share();
+
+    SharedPtr<Resource> resource = GetLoadedResource(type, sanitatedName);
+    if (resource || sanitatedName.empty())
+    {
+        promise.set_value(resource);
+        return future;
+    }
+
+#ifdef URHO3D_THREADING
+    // If the resource was not queued, it either got loaded since the check above or can not be loaded at all
+    if (!backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, nullptr) &&
+        !backgroundLoader_->IsQueued(type, nameHash))
+    {
+        promise.set_value(GetLoadedResource(type, sanitatedName));
+        return future;
+    }
+
+    // Finishing the resource in the main thread needs the request mutex to complete the request, so it can not be missed
+    PendingResourceRequest& request = pendingRequests_[key];
+    request.promise_ = std::move(promise);
+    request.future_ = future;
+#else
+    // When threading not supported, fall back to synchronous loading
+    promise.set_value(SharedPtr<Resource>(GetResource(type, sanitatedName, sendEventOnFailure)));
+#endif
+
+    return future;
+}
+
 Resource* ResourceCache::GetResource(StringHash type, const ea::string& name, bool sendEventOnFailure)
 {
     ea::string sanitatedName = SanitateResourceName(name);
@@ -576,9 +709,15 @@ Resource* ResourceCache::GetResource(StringHash type, const ea::string& name, bo
     backgroundLoader_->WaitForResource(type, nameHash);
 #endif
 
+    Resource* requester = loadingResources_.empty() ? nullptr : loadingResources_.back();
+
     const SharedPtr<Resource>& existing = FindResource(type, nameHash);
     if (existing)
+    {
+        existing->SetLastUsedFrame(frameNumber_);
+        RecordResource(type, sanitatedName, requester);
         return existing;
+    }
 
     SharedPtr<Resource> resource;
     // Make sure the pointer is non-null and is a Resource subclass
@@ -607,7 +746,12 @@ Resource* ResourceCache::GetResource(StringHash type, const ea::string& name, bo
     URHO3D_LOGDEBUG("Loading resource " + sanitatedName);
     resource->SetName(sanitatedName);
 
-    if (!resource->Load(*(file.Get())))
+    // Track the resource being loaded, so that resources it requests get recorded as its dependencies
+    loadingResources_.push_back(resource);
+    const bool success = resource->Load(*(file.Get()));
+    loadingResources_.pop_back();
+
+    if (!success)
     {
         // Error should already been logged by corresponding resource descendant class
         if (sendEventOnFailure)
@@ -624,9 +768,9 @@ Resource* ResourceCache::GetResource(StringHash type, const ea::string& name, bo
     }
 
     // Store to cache
-    resource->ResetUseTimer();
-    resourceGroups_[type].resources_[nameHash] = resource;
-    UpdateResourceGroup(type);
+    StoreResource(resource);
+    if (success)
+        RecordResource(type, sanitatedName, requester);
 
     return resource;
 }
@@ -639,6 +783,8 @@ bool ResourceCache::BackgroundLoadResource(StringHash type, const ea::string& na
     if (sanitatedName.empty())
         return false;
 
+    RecordResource(type, sanitatedName, caller);
+
     // First check if already exists as a loaded resource
     StringHash nameHash(sanitatedName);
     if (FindResource(type, nameHash) != noResource)
@@ -713,6 +859,47 @@ unsigned ResourceCache::GetNumBackgroundLoadResources() const
 #endif
 }
 
+void ResourceCache::SetNumBackgroundLoadThreads(unsigned num)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumThreads(num);
+#endif
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumThreads();
+#else
+    return 0;
+#endif
+}
+
+void ResourceCache::SetNumBackgroundLoadPrefetch(unsigned num)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumPrefetchResources(num);
+#endif
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadPrefetch() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumPrefetchResources();
+#else
+    return 0;
+#endif
+}
+
+BackgroundLoadStats ResourceCache::GetBackgroundLoadStats() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetStats();
+#else
+    return BackgroundLoadStats();
+#endif
+}
+
 void ResourceCache::GetResources(ea::vector<Resource*>& result, StringHash type) const
 {
     result.clear();
@@ -758,6 +945,12 @@ unsigned long long ResourceCache::GetMemoryBudget(StringHash type) const
     return i != resourceGroups_.end() ? i->second.memoryBudget_ : 0;
 }
 
+unsigned long long ResourceCache::GetSoftMemoryBudget(StringHash type) const
+{
+    auto i = resourceGroups_.find(type);
+    return i != resourceGroups_.end() ? i->second.softMemoryBudget_ : 0;
+}
+
 unsigned long long ResourceCache::GetMemoryUse(StringHash type) const
 {
     auto i = resourceGroups_.find(type);
@@ -911,13 +1104,15 @@ void ResourceCache::ResetDependencies(Resource* resource)
 
 ea::string ResourceCache::PrintMemoryUsage() const
 {
-    ea::string output = "Resource Type                 Cnt       Avg       Max    Budget     Total\n\n";
+    ea::string output = "Resource Type                 Cnt       Avg       Max      Soft    Budget      Peak     Total  Evicted  Reloaded\n\n";
     char outputLine[256];
 
     unsigned totalResourceCt = 0;
     unsigned long long totalLargest = 0;
     unsigned long long totalAverage = 0;
     unsigned long long totalUse = GetTotalMemoryUse();
+    unsigned totalEvictions = 0;
+    unsigned totalReloads = 0;
 
     for (auto cit = resourceGroups_.begin(); cit !=
         resourceGroups_.end(); ++cit)
@@ -942,13 +1137,20 @@ ea::string ResourceCache::PrintMemoryUsage() const
         const ea::string countString = ea::to_string(cit->second.resources_.size());
         const ea::string memUseString = GetFileSizeString(average);
         const ea::string memMaxString = GetFileSizeString(largest);
+        const ea::string memSoftBudgetString = GetFileSizeString(cit->second.softMemoryBudget_);
         const ea::string memBudgetString = GetFileSizeString(cit->second.memoryBudget_);
+        const ea::string memPeakString = GetFileSizeString(cit->second.peakMemoryUse_);
         const ea::string memTotalString = GetFileSizeString(cit->second.memoryUse_);
         const ea::string resTypeName = context_->GetTypeName(cit->first);
 
+        totalEvictions += cit->second.numEvictions_;
+        totalReloads += cit->second.numReloads_;
+
         memset(outputLine, ' ', 256);
         outputLine[255] = 0;
-        sprintf(outputLine, "%-28s %4s %9s %9s %9s %9s\n", resTypeName.c_str(), countString.c_str(), memUseString.c_str(), memMaxString.c_str(), memBudgetString.c_str(), memTotalString.c_str());
+        sprintf(outputLine, "%-28s %4s %9s %9s %9s %9s %9s %9s %8u %9u\n", resTypeName.c_str(), countString.c_str(),
+            memUseString.c_str(), memMaxString.c_str(), memSoftBudgetString.c_str(), memBudgetString.c_str(),
+            memPeakString.c_str(), memTotalString.c_str(), cit->second.numEvictions_, cit->second.numReloads_);
 
         output += ((const char*)outputLine);
     }
@@ -959,11 +1161,15 @@ ea::string ResourceCache::PrintMemoryUsage() const
     const ea::string countString = ea::to_string(totalResourceCt);
     const ea::string memUseString = GetFileSizeString(totalAverage);
     const ea::string memMaxString = GetFileSizeString(totalLargest);
+    const ea::string memSoftBudgetString = totalSoftMemoryBudget_ ? GetFileSizeString(totalSoftMemoryBudget_) : "-";
+    const ea::string memBudgetString = totalMemoryBudget_ ? GetFileSizeString(totalMemoryBudget_) : "-";
     const ea::string memTotalString = GetFileSizeString(totalUse);
 
     memset(outputLine, ' ', 256);
     outputLine[255] = 0;
-    sprintf(outputLine, "%-28s %4s %9s %9s %9s %9s\n", "All", countString.c_str(), memUseString.c_str(), memMaxString.c_str(), "-", memTotalString.c_str());
+    sprintf(outputLine, "%-28s %4s %9s %9s %9s %9s %9s %9s %8u %9u\n", "All", countString.c_str(), memUseString.c_str(),
+        memMaxString.c_str(), memSoftBudgetString.c_str(), memBudgetString.c_str(), "-", memTotalString.c_str(), totalEvictions,
+        totalReloads);
     output += ((const char*)outputLine);
 
     return output;
@@ -971,7 +1177,7 @@ ea::string ResourceCache::PrintMemoryUsage() const
 
 const SharedPtr<Resource>& ResourceCache::FindResource(StringHash type, StringHash nameHash)
 {
-    MutexLock lock(resourceMutex_);
+    SharedMutexLock lock(resourceGroupsMutex_);
 
     auto i = resourceGroups_.find(type);
     if (i == resourceGroups_.end())
@@ -985,7 +1191,7 @@ const SharedPtr<Resource>& ResourceCache::FindResource(StringHash type, StringHa
 
 const SharedPtr<Resource>& ResourceCache::FindResource(StringHash nameHash)
 {
-    MutexLock lock(resourceMutex_);
+    SharedMutexLock lock(resourceGroupsMutex_);
 
     for (auto i = resourceGroups_.begin(); i !=
         resourceGroups_.end(); ++i)
@@ -1017,7 +1223,10 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
                 // If other references exist, do not release, unless forced
                 if ((k->second.Refs() == 1 && k->second.WeakRefs() == 0) || force)
                 {
-                    j->second.resources_.erase(k);
+                    {
+                        MutexLock lock(resourceGroupsMutex_);
+                        j->second.resources_.erase(k);
+                    }
                     affectedGroups.insert(j->first);
                 }
                 break;
@@ -1035,42 +1244,179 @@ void ResourceCache::UpdateResourceGroup(StringHash type)
     if (i == resourceGroups_.end())
         return;
 
-    for (;;)
+    ResourceGroup& group = i->second;
+    unsigned long long totalSize = 0;
+    for (auto j = group.resources_.begin(); j != group.resources_.end(); ++j)
+        totalSize += j->second->GetMemoryUse();
+
+    group.memoryUse_ = totalSize;
+    group.peakMemoryUse_ = Max(group.peakMemoryUse_, totalSize);
+
+    // If a hard memory budget is exceeded, release unused resources right away. Resources used during the current frame
+    // are kept, as the caller may still hold a plain pointer to them, so the budget may be exceeded until the next frame
+    if (group.memoryBudget_ && group.memoryUse_ > group.memoryBudget_)
+    {
+        EvictResources(type, group.memoryBudget_, 1);
+        WarnOverBudget(type, group.memoryUse_, group.memoryBudget_);
+    }
+    if (totalMemoryBudget_ && GetTotalMemoryUse() > totalMemoryBudget_)
+    {
+        EvictResources(StringHash::ZERO, totalMemoryBudget_, 1);
+        WarnOverBudget(StringHash::ZERO, GetTotalMemoryUse(), totalMemoryBudget_);
+    }
+}
+
+void ResourceCache::WarnOverBudget(StringHash type, unsigned long long memoryUse, unsigned long long budget)
+{
+    // Warn once per frame, as every resource stored during the frame would repeat it
+    if (memoryUse <= budget || budgetWarningFrame_ == frameNumber_)
+        return;
+
+    budgetWarningFrame_ = frameNumber_;
+    const ea::string groupName = type != StringHash::ZERO ? context_->GetTypeName(type) : ea::string("All resources");
+    URHO3D_LOGWARNING("{} over hard memory budget ({} / {} bytes), resources used during this frame can not be released",
+        groupName, memoryUse, budget);
+}
+
+unsigned ResourceCache::EvictResources(StringHash type, unsigned long long targetUse, unsigned minUnusedFrames)
+{
+    struct EvictionCandidate
     {
-        unsigned totalSize = 0;
-        unsigned oldestTimer = 0;
-        auto oldestResource = i->second.resources_.end();
+        ResourceGroup* group_;
+        Resource* resource_;
+    };
 
-        for (auto j = i->second.resources_.begin();
-             j != i->second.resources_.end(); ++j)
-        {
-            totalSize += j->second->GetMemoryUse();
-            unsigned useTimer = j->second->GetUseTimer();
-            if (useTimer > oldestTimer)
-            {
-                oldestTimer = useTimer;
-                oldestResource = j;
-            }
-        }
+    ea::vector<EvictionCandidate> candidates;
+    unsigned long long memoryUse = 0;
+
+    for (auto i = resourceGroups_.begin(); i != resourceGroups_.end(); ++i)
+    {
+        if (type != StringHash::ZERO && i->first != type)
+            continue;
 
-        i->second.memoryUse_ = totalSize;
+        ResourceGroup& group = i->second;
+        memoryUse += group.memoryUse_;
 
-        // If memory budget defined and is exceeded, remove the oldest resource and loop again
-        // (resources in use always return a zero timer and can not be removed)
-        if (i->second.memoryBudget_ && i->second.memoryUse_ > i->second.memoryBudget_ &&
-            oldestResource != i->second.resources_.end())
+        for (auto j = group.resources_.begin(); j != group.resources_.end(); ++j)
         {
-            URHO3D_LOGDEBUG("Resource group " + oldestResource->second->GetTypeName() + " over memory budget, releasing resource " +
-                     oldestResource->second->GetName());
-            i->second.resources_.erase(oldestResource);
+            Resource* resource = j->second;
+            // Resources referred to elsewhere can not be released, but count as used so that they are kept for a while
+            // after the last reference is gone
+            if (j->second.Refs() > 1)
+                resource->SetLastUsedFrame(frameNumber_);
+            else if (frameNumber_ - resource->GetLastUsedFrame() >= minUnusedFrames)
+                candidates.push_back({&group, resource});
         }
-        else
+    }
+
+    if (memoryUse <= targetUse || candidates.empty())
+        return 0;
+
+    // Release lowest priority first, then least recently used
+    ea::sort(candidates.begin(), candidates.end(), [this](const EvictionCandidate& lhs, const EvictionCandidate& rhs)
+    {
+        if (lhs.resource_->GetEvictionPriority() != rhs.resource_->GetEvictionPriority())
+            return lhs.resource_->GetEvictionPriority() < rhs.resource_->GetEvictionPriority();
+        return frameNumber_ - lhs.resource_->GetLastUsedFrame() > frameNumber_ - rhs.resource_->GetLastUsedFrame();
+    });
+
+    unsigned numEvicted = 0;
+    for (const EvictionCandidate& candidate : candidates)
+    {
+        if (memoryUse <= targetUse)
             break;
+
+        ResourceGroup& group = *candidate.group_;
+        Resource* resource = candidate.resource_;
+        const unsigned resourceMemoryUse = resource->GetMemoryUse();
+
+        URHO3D_LOGDEBUG("Resource group " + resource->GetTypeName() + " over memory budget, releasing resource " +
+            resource->GetName());
+
+        memoryUse -= Min((unsigned long long)resourceMemoryUse, memoryUse);
+        group.memoryUse_ -= Min((unsigned long long)resourceMemoryUse, group.memoryUse_);
+        group.evictedMemory_ += resourceMemoryUse;
+        ++group.numEvictions_;
+        // The history only feeds the reload statistics, so forget it rather than let it grow without bound
+        if (evictedResources_.size() >= MAX_EVICTED_RESOURCE_HISTORY)
+            evictedResources_.clear();
+        evictedResources_.insert(resource->GetNameHash());
+        ++numEvicted;
+
+        MutexLock lock(resourceGroupsMutex_);
+        group.resources_.erase(resource->GetNameHash());
+    }
+
+    return numEvicted;
+}
+
+void ResourceCache::UpdateSoftMemoryBudgets()
+{
+    URHO3D_PROFILE("UpdateSoftMemoryBudgets");
+
+    for (auto i = resourceGroups_.begin(); i != resourceGroups_.end(); ++i)
+    {
+        const ResourceGroup& group = i->second;
+        if (group.softMemoryBudget_ && group.memoryUse_ > group.softMemoryBudget_)
+            EvictResources(i->first, group.softMemoryBudget_, evictionAge_);
+    }
+
+    if (totalSoftMemoryBudget_ && GetTotalMemoryUse() > totalSoftMemoryBudget_)
+        EvictResources(StringHash::ZERO, totalSoftMemoryBudget_, evictionAge_);
+}
+
+void ResourceCache::StoreResource(Resource* resource, bool completeRequest)
+{
+    const StringHash type = resource->GetType();
+    const StringHash nameHash = resource->GetNameHash();
+
+    resource->ResetUseTimer();
+    resource->SetLastUsedFrame(frameNumber_);
+
+    {
+        MutexLock lock(resourceGroupsMutex_);
+        ResourceGroup& group = resourceGroups_[type];
+        group.resources_[nameHash] = resource;
+
+        // Count resources that were released to stay within budget and are now needed again
+        if (evictedResources_.erase(nameHash))
+            ++group.numReloads_;
+    }
+
+    if (completeRequest)
+        CompleteResourceRequest(type, nameHash, resource);
+    UpdateResourceGroup(type);
+}
+
+void ResourceCache::RecordResource(StringHash type, const ea::string& name, Resource* requester)
+{
+    MutexLock lock(recordMutex_);
+    if (!recordedResources_)
+        return;
+
+    const unsigned index = recordedResources_->AddResource(type, name);
+    if (requester)
+    {
+        const unsigned requesterIndex = recordedResources_->AddResource(requester->GetType(), requester->GetName());
+        recordedResources_->AddDependency(requesterIndex, index);
+    }
+}
+
+void ResourceCache::CompleteResourceRequest(StringHash type, StringHash nameHash, Resource* resource)
+{
+    MutexLock lock(requestMutex_);
+
+    auto i = pendingRequests_.find(ea::make_pair(type, nameHash));
+    if (i != pendingRequests_.end())
+    {
+        i->second.promise_.set_value(SharedPtr<Resource>(resource));
+        pendingRequests_.erase(i);
     }
 }
 
 void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
+    ++frameNumber_;
     for (unsigned i = 0; i < fileWatchers_.size(); ++i)
     {
         FileChange change;
@@ -1102,6 +1448,10 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
         backgroundLoader_->FinishResources(finishBackgroundResourcesMs_);
     }
 #endif
+
+    // Release resources that have been unused for a while if over a soft memory budget
+    if (frameNumber_ % SOFT_BUDGET_CHECK_INTERVAL == 0)
+        UpdateSoftMemoryBudgets();
 }
 
 File* ResourceCache::SearchResourceDirs(const ea::string& name)
@@ -1142,6 +1492,7 @@ void RegisterResourceLibrary(Context* context)
     Image::RegisterObject(context);
     JSONFile::RegisterObject(context);
     PListFile::RegisterObject(context);
+    PreloadManifest::RegisterObject(context);
     XMLFile::RegisterObject(context);
 }
 
@@ -1277,9 +1628,12 @@ bool ResourceCache::RenameResource(const ea::string& source, const ea::string& d
                 ignoreResourceAutoReload_.emplace_back(resource->GetName());
             }
 
-            groupPair.second.resources_.erase(resource->GetNameHash());
-            resource->SetName(newName);
-            groupPair.second.resources_[resource->GetNameHash()] = resource;
+            {
+                MutexLock lock(resourceGroupsMutex_);
+                groupPair.second.resources_.erase(resource->GetNameHash());
+                resource->SetName(newName);
+                groupPair.second.resources_[resource->GetNameHash()] = resource;
+            }
             movedAny = true;
 
             using namespace ResourceRenamed;
@@ -1320,9 +1674,39 @@ void ResourceCache::RouteResourceName(ea::string& name, ResourceRequest requestT
     }
 }
 
+bool ResourceCache::BeginResourceRecording()
+{
+    MutexLock lock(recordMutex_);
+    if (recordedResources_)
+        return false;
+
+    recordedResources_ = context_->CreateObject<PreloadManifest>();
+    return true;
+}
+
+SharedPtr<PreloadManifest> ResourceCache::EndResourceRecording()
+{
+    MutexLock lock(recordMutex_);
+
+    SharedPtr<PreloadManifest> recordedResources;
+    recordedResources.Swap(recordedResources_);
+    if (recordedResources)
+        recordedResources->SortByDependencies();
+    return recordedResources;
+}
+
+bool ResourceCache::IsRecordingResources() const
+{
+    MutexLock lock(recordMutex_);
+    return recordedResources_ != nullptr;
+}
+
 void ResourceCache::Clear()
 {
-    resourceGroups_.clear();
+    {
+        MutexLock lock(resourceGroupsMutex_);
+        resourceGroups_.clear();
+    }
     dependentResources_.clear();
 }
 
@@ -27,6 +27,8 @@
 #include <EASTL/unique_ptr.h>
 #include <EASTL/hash_set.h>
 
+#include <future>
+
 #include "../Container/Ptr.h"
 #include "../Core/Mutex.h"
 #include "../IO/File.h"
@@ -38,6 +40,10 @@ namespace Urho3D
 class BackgroundLoader;
 class FileWatcher;
 class PackageFile;
+class PreloadManifest;
+
+/// Result of a thread-safe resource request. Holds null if the resource failed to load.
+using ResourceFuture = std::shared_future<SharedPtr<Resource> >;
 
 /// Sets to priority so that a package or file is pushed to the end of the vector.
 static const unsigned PRIORITY_LAST = 0xffffffff;
@@ -48,18 +54,65 @@ struct ResourceGroup
     /// Construct with defaults.
     ResourceGroup() :
         memoryBudget_(0),
-        memoryUse_(0)
+        softMemoryBudget_(0),
+        memoryUse_(0),
+        peakMemoryUse_(0),
+        evictedMemory_(0),
+        numEvictions_(0),
+        numReloads_(0)
     {
     }
 
-    /// Memory budget.
+    /// Hard memory budget. Exceeding it releases unused resources immediately.
     unsigned long long memoryBudget_;
+    /// Soft memory budget. Exceeding it releases resources that have been unused for a while at the start of a frame.
+    unsigned long long softMemoryBudget_;
     /// Current memory use.
     unsigned long long memoryUse_;
+    /// Highest memory use seen.
+    unsigned long long peakMemoryUse_;
+    /// Total memory of resources released to stay within budget.
+    unsigned long long evictedMemory_;
+    /// Number of resources released to stay within budget.
+    unsigned numEvictions_;
+    /// Number of released resources that were loaded again.
+    unsigned numReloads_;
     /// Resources.
     ea::unordered_map<StringHash, SharedPtr<Resource> > resources_;
 };
 
+/// Progress and throughput of a batch of background loaded resources. A batch starts when a resource is queued to an empty background load queue and ends when the queue is empty again.
+struct URHO3D_API BackgroundLoadStats
+{
+    /// Return fraction of the batch's resources that are finished.
+    float GetProgress() const { return numQueued_ ? (float)numFinished_ / (float)numQueued_ : 1.0f; }
+    /// Return loaded bytes per second of wall clock time.
+    float GetBytesPerSecond() const { return elapsedTime_ > 0 ? (float)bytesLoaded_ * 1000000.0f / (float)elapsedTime_ : 0.0f; }
+    /// Return finished resources per second of wall clock time.
+    float GetResourcesPerSecond() const { return elapsedTime_ > 0 ? (float)numFinished_ * 1000000.0f / (float)elapsedTime_ : 0.0f; }
+
+    /// Number of resources queued.
+    unsigned numQueued_{};
+    /// Number of resources that have finished BeginLoad() in the loader threads.
+    unsigned numLoaded_{};
+    /// Number of resources that have finished EndLoad() in the main thread.
+    unsigned numFinished_{};
+    /// Number of resources that failed to load.
+    unsigned numFailed_{};
+    /// Number of resource file bytes read.
+    unsigned long long bytesLoaded_{};
+    /// Time spent in BeginLoad() summed over all loader threads in microseconds.
+    long long loadTime_{};
+    /// Time spent in EndLoad() in the main thread in microseconds.
+    long long finishTime_{};
+    /// Wall clock time since the batch started in microseconds.
+    long long elapsedTime_{};
+    /// Number of loader threads.
+    unsigned numThreads_{};
+    /// Whether the batch is still in progress.
+    bool active_{};
+};
+
 /// Resource request types.
 enum ResourceRequest
 {
@@ -85,6 +138,7 @@ public:
 class URHO3D_API ResourceCache : public Object
 {
     URHO3D_OBJECT(ResourceCache, Object);
+    friend class BackgroundLoader;
 
 public:
     /// Construct.
@@ -120,8 +174,14 @@ public:
     bool ReloadResource(Resource* resource);
     /// Reload a resource based on filename. Causes also reload of dependent resources if necessary.
     void ReloadResourceWithDependencies(const ea::string& fileName);
-    /// Set memory budget for a specific resource type, default 0 is unlimited.
+    /// Set memory budget for a specific resource type, default 0 is unlimited. Unused resources are released in least recently used order when exceeded.
     void SetMemoryBudget(StringHash type, unsigned long long budget);
+    /// Set soft and hard memory budgets for a specific resource type, 0 is unlimited. Over the soft budget, resources unused for the eviction age are released at the start of a frame. Over the hard budget, any resource not used in the current frame is released immediately. Resources used in the current frame are kept, so the hard budget may be exceeded until the next frame, which is logged as a warning. Released resources are loaded again on the next request.
+    void SetMemoryBudget(StringHash type, unsigned long long softBudget, unsigned long long hardBudget);
+    /// Set soft and hard memory budgets for all resources combined, 0 is unlimited.
+    void SetTotalMemoryBudget(unsigned long long softBudget, unsigned long long hardBudget);
+    /// Set how many frames a resource must be unused before it can be released to stay within a soft budget. Default 60.
+    void SetEvictionAge(unsigned frames) { evictionAge_ = Max(frames, 1u); }
     /// Enable or disable automatic reloading of resources as files are modified. Default false.
     void SetAutoReloadResources(bool enable);
     /// Enable or disable returning resources that failed to load. Default false. This may be useful in editing to not lose resource ref attributes.
@@ -130,8 +190,15 @@ public:
     /// Define whether when getting resources should check package files or directories first. True for packages, false for directories.
     void SetSearchPackagesFirst(bool value) { searchPackagesFirst_ = value; }
 
+    /// Define whether package files added from now on are memory mapped. Mapped packages are read without file handles and expose uncompressed files as memory views. Default false.
+    void SetMapPackages(bool enable) { mapPackages_ = enable; }
+
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
+    /// Set number of threads used for background loading. Default is the number of logical CPUs minus one, at most 8.
+    void SetNumBackgroundLoadThreads(unsigned num);
+    /// Set how many queued background loaded resources are read ahead asynchronously. Zero disables reading ahead. Default 16.
+    void SetNumBackgroundLoadPrefetch(unsigned num);
 
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
@@ -148,10 +215,20 @@ public:
     bool BackgroundLoadResource(StringHash type, const ea::string& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
     /// Return number of pending background-loaded resources.
     unsigned GetNumBackgroundLoadResources() const;
+    /// Return number of threads used for background loading.
+    unsigned GetNumBackgroundLoadThreads() const;
+    /// Return how many queued background loaded resources are read ahead.
+    unsigned GetNumBackgroundLoadPrefetch() const;
+    /// Return progress and throughput of the current or last batch of background loaded resources.
+    BackgroundLoadStats GetBackgroundLoadStats() const;
     /// Return all loaded resources of a specific type.
     void GetResources(ea::vector<Resource*>& result, StringHash type) const;
     /// Return an already loaded resource of specific type & name, or null if not found. Will not load if does not exist.
     Resource* GetExistingResource(StringHash type, const ea::string& name);
+    /// Return an already loaded resource of specific type & name, or null if not found or still loading. Will not load if does not exist. Can be called from outside the main thread.
+    SharedPtr<Resource> GetLoadedResource(StringHash type, const ea::string& name);
+    /// Return a future for a resource of specific type & name. Ready immediately if the resource is loaded, otherwise the resource is queued for background loading and the future becomes ready once it has been finished in the main thread. Concurrent requests for the same resource share the future. Can be called from outside the main thread, but do not wait on the future from the main thread unless the resource is loaded.
+    ResourceFuture RequestResource(StringHash type, const ea::string& name, bool sendEventOnFailure = true);
 
     /// Return all loaded resources.
     const ea::unordered_map<StringHash, ResourceGroup>& GetAllResources() const { return resourceGroups_; }
@@ -166,6 +243,10 @@ public:
     template <class T> T* GetResource(const ea::string& name, bool sendEventOnFailure = true);
     /// Template version of returning an existing resource by name.
     template <class T> T* GetExistingResource(const ea::string& name);
+    /// Template version of returning a loaded resource by name from any thread.
+    template <class T> SharedPtr<T> GetLoadedResource(const ea::string& name);
+    /// Template version of requesting a resource from any thread.
+    template <class T> ResourceFuture RequestResource(const ea::string& name, bool sendEventOnFailure = true);
     /// Template version of loading a resource without storing it to the cache.
     template <class T> SharedPtr<T> GetTempResource(const ea::string& name, bool sendEventOnFailure = true);
     /// Template version of releasing a resource by name.
@@ -176,8 +257,23 @@ public:
     template <class T> void GetResources(ea::vector<T*>& result) const;
     /// Return whether a file exists in the resource directories or package files. Does not check manually added in-memory resources.
     bool Exists(const ea::string& name) const;
-    /// Return memory budget for a resource type.
+    /// Return hard memory budget for a resource type.
     unsigned long long GetMemoryBudget(StringHash type) const;
+    /// Return soft memory budget for a resource type.
+    unsigned long long GetSoftMemoryBudget(StringHash type) const;
+
+    /// Return hard memory budget for all resources combined.
+    unsigned long long GetTotalMemoryBudget() const { return totalMemoryBudget_; }
+
+    /// Return soft memory budget for all resources combined.
+    unsigned long long GetTotalSoftMemoryBudget() const { return totalSoftMemoryBudget_; }
+
+    /// Return how many frames a resource must be unused before it can be released to stay within a soft budget.
+    unsigned GetEvictionAge() const { return evictionAge_; }
+
+    /// Return the frame number used for least recently used tracking.
+    unsigned GetFrameNumber() const { return frameNumber_; }
+
     /// Return total memory use for a resource type.
     unsigned long long GetMemoryUse(StringHash type) const;
     /// Return total memory use for all resources.
@@ -194,6 +290,9 @@ public:
     /// Return whether when getting resources should check package files or directories first.
     bool GetSearchPackagesFirst() const { return searchPackagesFirst_; }
 
+    /// Return whether added package files are memory mapped.
+    bool GetMapPackages() const { return mapPackages_; }
+
     /// Return how many milliseconds maximum to spend on finishing background loaded resources.
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
 
@@ -233,6 +332,12 @@ public:
     void RouteResourceName(ea::string& name, ResourceRequest requestType) const;
     /// Clear all resources from resource cache.
     void Clear();
+    /// Begin recording the resources that are requested and the dependencies between them, for example to write a preload manifest of a scene. Return false if already recording.
+    bool BeginResourceRecording();
+    /// End recording. Return the recorded resources sorted by dependencies, or null if not recording.
+    SharedPtr<PreloadManifest> EndResourceRecording();
+    /// Return whether resources are being recorded.
+    bool IsRecordingResources() const;
 
 private:
     /// Find a resource.
@@ -249,9 +354,42 @@ private:
     File* SearchResourceDirs(const ea::string& name);
     /// Search resource packages for file.
     File* SearchPackages(const ea::string& name);
+    /// Release unused resources of a type, or of all types if zero, in eviction priority and least recently used order until memory use is at most targetUse. Only resources unused for minUnusedFrames are released. Return number of resources released.
+    unsigned EvictResources(StringHash type, unsigned long long targetUse, unsigned minUnusedFrames);
+    /// Enforce soft memory budgets. Called at the start of a frame.
+    void UpdateSoftMemoryBudgets();
+    /// Log a warning if memory use of a type, or of all types if zero, is still over its hard budget after evicting. Logged at most once per frame.
+    void WarnOverBudget(StringHash type, unsigned long long memoryUse, unsigned long long budget);
+    /// Store a loaded resource to its group and enforce memory budgets. Optionally complete the pending requests of the resource.
+    void StoreResource(Resource* resource, bool completeRequest = true);
+    /// Make pending requests of a resource ready. Called when a resource has been stored or has failed to load.
+    void CompleteResourceRequest(StringHash type, StringHash nameHash, Resource* resource);
+    /// Record a requested resource and the resource that requested it, if any, while recording.
+    void RecordResource(StringHash type, const ea::string& name, Resource* requester);
+
+    /// Pending request of a resource from RequestResource().
+    struct PendingResourceRequest
+    {
+        /// Promise to fulfill when the resource is ready.
+        std::promise<SharedPtr<Resource> > promise_;
+        /// Future shared by all requests of the resource.
+        ResourceFuture future_;
+    };
 
     /// Mutex for thread-safe access to the resource directories, resource packages and resource dependencies.
     mutable Mutex resourceMutex_;
+    /// Mutex for thread-safe lookups of loaded resources. Structural changes of the resource groups are done in the main thread holding exclusive access, other threads read with shared access.
+    mutable SharedMutex resourceGroupsMutex_;
+    /// Mutex for pending resource requests.
+    Mutex requestMutex_;
+    /// Pending resource requests by type and name hash.
+    ea::unordered_map<ea::pair<StringHash, StringHash>, PendingResourceRequest> pendingRequests_;
+    /// Mutex for resource recording.
+    mutable Mutex recordMutex_;
+    /// Resources recorded since BeginResourceRecording(), or null if not recording.
+    SharedPtr<PreloadManifest> recordedResources_;
+    /// Resources being loaded in the main thread, innermost last. Used to find which resource requested another.
+    ea::vector<Resource*> loadingResources_;
     /// Resources by type.
     ea::unordered_map<StringHash, ResourceGroup> resourceGroups_;
     /// Resource load directories.
@@ -272,10 +410,24 @@ private:
     bool returnFailedResources_;
     /// Search priority flag.
     bool searchPackagesFirst_;
+    /// Package memory mapping flag.
+    bool mapPackages_;
     /// Resource routing flag to prevent endless recursion.
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
     int finishBackgroundResourcesMs_;
+    /// Hard memory budget for all resources combined.
+    unsigned long long totalMemoryBudget_;
+    /// Soft memory budget for all resources combined.
+    unsigned long long totalSoftMemoryBudget_;
+    /// Frames a resource must be unused before it is released to stay within a soft budget.
+    unsigned evictionAge_;
+    /// Frame number for least recently used tracking.
+    unsigned frameNumber_;
+    /// Name hashes of resources released to stay within budget and not loaded again since. Cleared when it reaches MAX_EVICTED_RESOURCE_HISTORY entries.
+    ea::hash_set<StringHash> evictedResources_;
+    /// Frame number of the last over budget warning.
+    unsigned budgetWarningFrame_;
     /// List of resources that will not be auto-reloaded if reloading event triggers.
     ea::vector<ea::string> ignoreResourceAutoReload_;
 };
@@ -286,6 +438,18 @@ template <class T> T* ResourceCache::GetExistingResource(const ea::string& name)
     return static_cast<T*>(GetExistingResource(type, name));
 }
 
+template <class T> SharedPtr<T> ResourceCache::GetLoadedResource(const ea::string& name)
+{
+    StringHash type = T::GetTypeStatic();
+    return StaticCast<T>(GetLoadedResource(type, name));
+}
+
+template <class T> ResourceFuture ResourceCache::RequestResource(const ea::string& name, bool sendEventOnFailure)
+{
+    StringHash type = T::GetTypeStatic();
+    return RequestResource(type, name, sendEventOnFailure);
+}
+
 template <class T> T* ResourceCache::GetResource(const ea::string& name, bool sendEventOnFailure)
 {
     StringHash type = T::GetTypeStatic();
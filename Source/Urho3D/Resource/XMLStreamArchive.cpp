@@ -0,0 +1,658 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Core/StringUtils.h"
+#include "../IO/Deserializer.h"
+#include "../Resource/XMLStreamArchive.h"
+
+#include <EASTL/algorithm.h>
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Syntax error message. Placeholders: {offset}.
+static const char* errorSyntax_offset = "XML syntax error at offset {}";
+/// Name of the root element if not specified.
+static const char* defaultRootName = "root";
+/// Name of the value attribute of block elements.
+static const char* valueAttribute = "value";
+/// Name of the key attribute of Map block elements.
+static const char* keyAttribute = "key";
+
+/// Return whether the character is XML whitespace.
+static bool IsXMLWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// Return pointer after the first occurrence of the sequence, or null if not found.
+static const char* SkipPastSequence(const char* begin, const char* end, ea::string_view sequence)
+{
+    const char* found = ea::search(begin, end, sequence.begin(), sequence.end());
+    return found != end ? found + sequence.size() : nullptr;
+}
+
+/// Decode attribute value the same way pugixml does by default: expand entities and replace whitespace characters with spaces.
+static void DecodeAttributeValue(const char* begin, const char* end, ea::string& value)
+{
+    value.clear();
+    const char* chunk = begin;
+    for (const char* ptr = begin; ptr < end; )
+    {
+        const char c = *ptr;
+        if (c != '&' && c != '\t' && c != '\n' && c != '\r')
+        {
+            ++ptr;
+            continue;
+        }
+
+        value.append(chunk, ptr);
+        if (c == '&')
+        {
+            const char* semicolon = static_cast<const char*>(memchr(ptr, ';', end - ptr));
+            const ea::string_view entity = semicolon ? ea::string_view(ptr + 1, semicolon - ptr - 1) : ea::string_view{};
+            if (entity == ea::string_view("lt"))
+                value += '<';
+            else if (entity == ea::string_view("gt"))
+                value += '>';
+            else if (entity == ea::string_view("amp"))
+                value += '&';
+            else if (entity == ea::string_view("quot"))
+                value += '"';
+            else if (entity == ea::string_view("apos"))
+                value += '\'';
+            else if (entity.size() > 1 && entity[0] == '#')
+            {
+                const ea::string code{ entity.substr(entity[1] == 'x' ? 2 : 1) };
+                AppendUTF8(value, ToUInt(code, entity[1] == 'x' ? 16 : 10));
+            }
+            else
+            {
+                // Unknown entity is kept as is
+                value += '&';
+                chunk = ++ptr;
+                continue;
+            }
+            ptr = semicolon + 1;
+        }
+        else
+        {
+            // Line endings are normalized before whitespace conversion
+            if (c == '\r' && ptr + 1 < end && ptr[1] == '\n')
+                ++ptr;
+            value += ' ';
+            ++ptr;
+        }
+        chunk = ptr;
+    }
+    value.append(chunk, end);
+}
+
+XMLStreamInputArchive::XMLStreamInputArchive(Context* context, ea::string_view text, const ea::string& name, bool serializeRootName)
+    : context_(context)
+    , name_(name)
+    , serializeRootName_(serializeRootName)
+    , text_(text.data())
+    , pos_(text.data())
+    , end_(text.data() + text.size())
+{
+}
+
+XMLStreamInputArchive::XMLStreamInputArchive(Context* context, Deserializer& source, bool serializeRootName)
+    : context_(context)
+    , name_(source.GetName())
+    , serializeRootName_(serializeRootName)
+{
+    buffer_.resize(source.GetSize() - source.GetPosition());
+    buffer_.resize(source.Read(buffer_.data(), buffer_.size()));
+    text_ = buffer_.data();
+    pos_ = text_;
+    end_ = buffer_.data() + buffer_.size();
+}
+
+ea::string XMLStreamInputArchive::GetCurrentStackString()
+{
+    ea::string result;
+    for (const Block& block : stack_)
+    {
+        if (!result.empty())
+            result += "/";
+        result += ea::string{ block.GetName() };
+    }
+    return result;
+}
+
+bool XMLStreamInputArchive::BeginBlock(const char* name, unsigned& sizeHint, bool safe, ArchiveBlockType type)
+{
+    if (!CheckEOF(name, name))
+        return false;
+
+    ElementStart element;
+    if (stack_.empty())
+    {
+        // Open root block
+        pos_ = text_;
+        if (!NextChild())
+        {
+            SetErrorFormatted(ArchiveBase::errorElementNotFound_elementName, name);
+            return false;
+        }
+
+        if (!ParseElementStart(element))
+            return false;
+
+        if (serializeRootName_ && element.name_ != ea::string_view(name ? name : defaultRootName))
+        {
+            SetErrorFormatted(ArchiveBase::errorElementNotFound_elementName, name);
+            return false;
+        }
+    }
+    else if (!ReadChild(name, element))
+        return false;
+
+    Block block{ name ? name : "", type, element.attributes_, element.content_ };
+    sizeHint = 0;
+    if (block.content_ && (type == ArchiveBlockType::Array || type == ArchiveBlockType::Map))
+        sizeHint = CountChildren();
+    stack_.push_back(block);
+    return !HasError();
+}
+
+bool XMLStreamInputArchive::EndBlock()
+{
+    if (stack_.empty())
+    {
+        SetErrorFormatted(ArchiveBase::fatalUnexpectedEndBlock);
+        return false;
+    }
+
+    if (GetCurrentBlock().content_ && !HasError())
+        SkipRemainingContent();
+
+    stack_.pop_back();
+    if (stack_.empty())
+        CloseArchive();
+    return true;
+}
+
+bool XMLStreamInputArchive::SerializeKey(ea::string& key)
+{
+    if (!CheckEOFAndRoot("", ArchiveBase::keyElementName_))
+        return false;
+
+    Block& block = GetCurrentBlock();
+    if (block.type_ != ArchiveBlockType::Map)
+    {
+        SetErrorFormatted(ArchiveBase::fatalUnexpectedKeySerialization);
+        assert(0);
+        return false;
+    }
+
+    if (block.keyRead_)
+    {
+        SetErrorFormatted(ArchiveBase::fatalDuplicateKeySerialization);
+        assert(0);
+        return false;
+    }
+
+    // Start tag of the element is reused when the value is read
+    if (!block.content_ || !NextChild() || !ParseElementStart(keyElement_))
+    {
+        SetErrorFormatted(ArchiveBase::errorElementNotFound_elementName, ArchiveBase::keyElementName_);
+        return false;
+    }
+
+    if (!FindAttribute(keyElement_.attributes_, keyAttribute, key))
+    {
+        SetErrorFormatted(ArchiveBase::errorMissingMapKey);
+        return false;
+    }
+
+    block.keyRead_ = true;
+    return true;
+}
+
+bool XMLStreamInputArchive::SerializeKey(unsigned& key)
+{
+    ea::string stringKey;
+    if (SerializeKey(stringKey))
+    {
+        key = ToUInt(stringKey);
+        return true;
+    }
+    return false;
+}
+
+bool XMLStreamInputArchive::SerializeBytes(const char* name, void* bytes, unsigned size)
+{
+    if (ReadValue(name))
+    {
+        if (!HexStringToBuffer(tempBuffer_, tempString_))
+            return false;
+        if (tempBuffer_.size() != size)
+            return false;
+        ea::copy(tempBuffer_.begin(), tempBuffer_.end(), static_cast<unsigned char*>(bytes));
+        return true;
+    }
+    return false;
+}
+
+bool XMLStreamInputArchive::SerializeVLE(const char* name, unsigned& value)
+{
+    if (ReadValue(name))
+    {
+        value = ToUInt(tempString_);
+        return true;
+    }
+    return false;
+}
+
+bool XMLStreamInputArchive::CheckEOF(const char* elementName, const char* debugName)
+{
+    if (HasError())
+        return false;
+
+    if (!ValidateName(elementName))
+    {
+        SetErrorFormatted(ArchiveBase::fatalInvalidName, debugName);
+        return false;
+    }
+
+    if (IsEOF())
+    {
+        SetErrorFormatted(ArchiveBase::errorEOF_elementName, debugName);
+        return false;
+    }
+
+    return true;
+}
+
+bool XMLStreamInputArchive::CheckEOFAndRoot(const char* elementName, const char* debugName)
+{
+    if (!CheckEOF(elementName, debugName))
+        return false;
+
+    if (stack_.empty())
+    {
+        SetErrorFormatted(ArchiveBase::fatalRootBlockNotOpened_elementName, debugName);
+        assert(0);
+        return false;
+    }
+
+    return true;
+}
+
+bool XMLStreamInputArchive::ReadChild(const char* name, ElementStart& element)
+{
+    Block& block = GetCurrentBlock();
+    if (block.type_ == ArchiveBlockType::Unordered)
+    {
+        if (!name)
+        {
+            SetErrorFormatted(ArchiveBase::fatalMissingElementName);
+            assert(0);
+            return false;
+        }
+
+        // Not an error in Unordered block
+        return block.content_ && FindChild(block, name, element);
+    }
+
+    if (block.type_ == ArchiveBlockType::Map)
+    {
+        if (!block.keyRead_)
+        {
+            SetErrorFormatted(ArchiveBase::fatalMissingKeySerialization);
+            assert(0);
+            return false;
+        }
+
+        element = keyElement_;
+        block.keyRead_ = false;
+        return true;
+    }
+
+    if (!block.content_ || !NextChild())
+    {
+        SetErrorFormatted(ArchiveBase::errorElementNotFound_elementName, name);
+        return false;
+    }
+
+    return ParseElementStart(element);
+}
+
+bool XMLStreamInputArchive::ReadValue(const char* name)
+{
+    if (!CheckEOFAndRoot(name, name))
+        return false;
+
+    // Values of Unordered block are stored in attributes
+    const Block& block = GetCurrentBlock();
+    if (block.type_ == ArchiveBlockType::Unordered)
+    {
+        if (!name)
+        {
+            SetErrorFormatted(ArchiveBase::fatalMissingElementName);
+            assert(0);
+            return false;
+        }
+
+        return FindAttribute(block.attributes_, name, tempString_);
+    }
+
+    ElementStart element;
+    if (!ReadChild(name, element))
+        return false;
+
+    if (!FindAttribute(element.attributes_, valueAttribute, tempString_))
+        tempString_.clear();
+    return SkipElement(element);
+}
+
+bool XMLStreamInputArchive::FindChild(Block& block, const char* name, ElementStart& element)
+{
+    const ea::string_view elementName{ name };
+
+    // Children are usually stored in the order they are read, so scan forward first
+    const char* nextChild = pos_;
+    bool skipped = false;
+    while (NextChild())
+    {
+        if (!ParseElementStart(element))
+            return false;
+        if (element.name_ == elementName)
+        {
+            block.inOrder_ &= !skipped;
+            return true;
+        }
+        if (!SkipElement(element))
+            return false;
+        skipped = true;
+    }
+
+    // Children before the position were already read if the block was read in order
+    if (!block.inOrder_)
+    {
+        pos_ = block.content_;
+        while (pos_ < nextChild && NextChild())
+        {
+            if (!ParseElementStart(element))
+                return false;
+            if (element.name_ == elementName)
+                return true;
+            if (!SkipElement(element))
+                return false;
+        }
+    }
+
+    pos_ = nextChild;
+    return false;
+}
+
+unsigned XMLStreamInputArchive::CountChildren()
+{
+    const char* begin = pos_;
+
+    unsigned count = 0;
+    ElementStart element;
+    while (NextChild())
+    {
+        if (!ParseElementStart(element) || !SkipElement(element))
+            break;
+        ++count;
+    }
+
+    pos_ = begin;
+    return count;
+}
+
+bool XMLStreamInputArchive::FindAttribute(const char* attributes, ea::string_view name, ea::string& value)
+{
+    // Attributes were validated when the start tag was parsed
+    const char* ptr = attributes;
+    while (true)
+    {
+        while (IsXMLWhitespace(*ptr))
+            ++ptr;
+        if (*ptr == '/' || *ptr == '>')
+            return false;
+
+        const char* nameBegin = ptr;
+        while (*ptr != '=' && !IsXMLWhitespace(*ptr))
+            ++ptr;
+        const ea::string_view attributeName(nameBegin, ptr - nameBegin);
+
+        while (*ptr != '"' && *ptr != '\'')
+            ++ptr;
+        const char quote = *ptr++;
+        const char* valueBegin = ptr;
+        while (*ptr != quote)
+            ++ptr;
+
+        if (attributeName == name)
+        {
+            DecodeAttributeValue(valueBegin, ptr, value);
+            return true;
+        }
+        ++ptr;
+    }
+}
+
+bool XMLStreamInputArchive::ParseElementStart(ElementStart& element)
+{
+    const char* nameBegin = ++pos_;
+    while (pos_ < end_ && !IsXMLWhitespace(*pos_) && *pos_ != '/' && *pos_ != '>')
+        ++pos_;
+    element.name_ = ea::string_view(nameBegin, pos_ - nameBegin);
+    element.attributes_ = pos_;
+
+    while (pos_ < end_)
+    {
+        const char c = *pos_;
+        if (IsXMLWhitespace(c))
+            ++pos_;
+        else if (c == '>')
+        {
+            element.content_ = ++pos_;
+            return true;
+        }
+        else if (c == '/' && end_ - pos_ >= 2 && pos_[1] == '>')
+        {
+            element.content_ = nullptr;
+            pos_ += 2;
+            return true;
+        }
+        else
+        {
+            // Skip attribute
+            while (pos_ < end_ && *pos_ != '=' && !IsXMLWhitespace(*pos_))
+                ++pos_;
+            while (pos_ < end_ && IsXMLWhitespace(*pos_))
+                ++pos_;
+            if (pos_ >= end_ || *pos_ != '=')
+                break;
+            ++pos_;
+            while (pos_ < end_ && IsXMLWhitespace(*pos_))
+                ++pos_;
+            if (pos_ >= end_ || (*pos_ != '"' && *pos_ != '\''))
+                break;
+
+            const char* closingQuote = static_cast<const char*>(memchr(pos_ + 1, *pos_, end_ - pos_ - 1));
+            if (!closingQuote)
+                break;
+            pos_ = closingQuote + 1;
+        }
+    }
+
+    SetSyntaxError();
+    return false;
+}
+
+bool XMLStreamInputArchive::SkipElement(const ElementStart& element)
+{
+    return !element.content_ || SkipRemainingContent();
+}
+
+bool XMLStreamInputArchive::SkipRemainingContent()
+{
+    // Track the element depth instead of recursing into children
+    ElementStart child;
+    unsigned depth = 1;
+    while (depth > 0)
+    {
+        if (NextChild())
+        {
+            if (!ParseElementStart(child))
+                return false;
+            if (child.content_)
+                ++depth;
+        }
+        else
+        {
+            if (!SkipEndTag())
+                return false;
+            --depth;
+        }
+    }
+    return true;
+}
+
+bool XMLStreamInputArchive::NextChild()
+{
+    while (pos_ < end_)
+    {
+        // Skip text
+        if (*pos_ != '<')
+        {
+            const char* tag = static_cast<const char*>(memchr(pos_, '<', end_ - pos_));
+            pos_ = tag ? tag : end_;
+            continue;
+        }
+
+        const char* next = nullptr;
+        switch (pos_ + 1 < end_ ? pos_[1] : '\0')
+        {
+        case '/':
+            return false;
+
+        case '?':
+            next = SkipPastSequence(pos_, end_, "?>");
+            break;
+
+        case '!':
+        {
+            const ea::string_view tail(pos_, end_ - pos_);
+            if (tail.starts_with("<!--"))
+                next = SkipPastSequence(pos_, end_, "-->");
+            else if (tail.starts_with("<![CDATA["))
+                next = SkipPastSequence(pos_, end_, "]]>");
+            else
+            {
+                // Document type declaration may contain internal subset in brackets
+                const char* subset = static_cast<const char*>(memchr(pos_, '[', end_ - pos_));
+                const char* closing = static_cast<const char*>(memchr(pos_, '>', end_ - pos_));
+                if (subset && closing && subset < closing)
+                    next = SkipPastSequence(subset, end_, "]>");
+                else
+                    next = closing ? closing + 1 : nullptr;
+            }
+            break;
+        }
+
+        default:
+            return true;
+        }
+
+        if (!next)
+        {
+            SetSyntaxError();
+            return false;
+        }
+        pos_ = next;
+    }
+    return false;
+}
+
+bool XMLStreamInputArchive::SkipEndTag()
+{
+    if (end_ - pos_ < 2 || pos_[0] != '<' || pos_[1] != '/')
+    {
+        SetSyntaxError();
+        return false;
+    }
+
+    const char* closing = static_cast<const char*>(memchr(pos_, '>', end_ - pos_));
+    if (!closing)
+    {
+        SetSyntaxError();
+        return false;
+    }
+
+    pos_ = closing + 1;
+    return true;
+}
+
+void XMLStreamInputArchive::SetSyntaxError()
+{
+    SetErrorFormatted(errorSyntax_offset, static_cast<unsigned>(pos_ - text_));
+}
+
+// Generate serialization implementation (streaming XML input)
+#define URHO3D_XML_STREAM_IN_IMPL(type, function) \
+    bool XMLStreamInputArchive::Serialize(const char* name, type& value) \
+    { \
+        if (ReadValue(name)) \
+        { \
+            value = function(tempString_); \
+            return true; \
+        } \
+        return false; \
+    }
+
+URHO3D_XML_STREAM_IN_IMPL(bool, ToBool);
+URHO3D_XML_STREAM_IN_IMPL(signed char, ToInt);
+URHO3D_XML_STREAM_IN_IMPL(short, ToInt);
+URHO3D_XML_STREAM_IN_IMPL(int, ToInt);
+URHO3D_XML_STREAM_IN_IMPL(long long, ToInt64);
+URHO3D_XML_STREAM_IN_IMPL(unsigned char, ToUInt);
+URHO3D_XML_STREAM_IN_IMPL(unsigned short, ToUInt);
+URHO3D_XML_STREAM_IN_IMPL(unsigned int, ToUInt);
+URHO3D_XML_STREAM_IN_IMPL(unsigned long long, ToUInt64);
+URHO3D_XML_STREAM_IN_IMPL(float, ToFloat);
+URHO3D_XML_STREAM_IN_IMPL(double, ToDouble);
+
+#undef URHO3D_XML_STREAM_IN_IMPL
+
+bool XMLStreamInputArchive::Serialize(const char* name, ea::string& value)
+{
+    if (ReadValue(name))
+    {
+        value = tempString_;
+        return true;
+    }
+    return false;
+}
+
+}
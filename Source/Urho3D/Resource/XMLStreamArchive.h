@@ -0,0 +1,181 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../IO/Archive.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+
+/// Streaming XML input archive block. Internal.
+struct XMLStreamInputArchiveBlock
+{
+    /// Block name.
+    ea::string_view name_;
+    /// Block type.
+    ArchiveBlockType type_{};
+    /// Attributes of the block element.
+    const char* attributes_{};
+    /// First character of the block element content, or null if the element is empty.
+    const char* content_{};
+    /// Whether the key was read (for Map blocks).
+    bool keyRead_{};
+    /// Whether the children before the current position were read in order (for Unordered blocks).
+    bool inOrder_{ true };
+
+    /// Return name.
+    ea::string_view GetName() const { return name_; }
+    /// Return block type.
+    ArchiveBlockType GetType() const { return type_; }
+};
+
+/// XML input archive that reads directly from XML text without building an XMLElement tree. Reads the same data as XMLInputArchive. Children of Unordered blocks are found fastest when they are stored in serialization order; a child that was already read in order is not found again. Size hints are provided for Array and Map blocks only.
+class URHO3D_API XMLStreamInputArchive : public ArchiveBaseT<true, true>
+{
+public:
+    /// Construct from XML text. The text must outlive the archive.
+    XMLStreamInputArchive(Context* context, ea::string_view text, const ea::string& name = EMPTY_STRING, bool serializeRootName = true);
+    /// Construct from stream. The remaining stream content is read into an internal buffer.
+    XMLStreamInputArchive(Context* context, Deserializer& source, bool serializeRootName = true);
+
+    /// Get context.
+    Context* GetContext() final { return context_; }
+    /// Return name of the archive.
+    ea::string_view GetName() const final { return name_; }
+
+    /// Whether the unordered element access is supported for Unordered blocks.
+    bool IsUnorderedSupportedNow() const final { return !stack_.empty() && stack_.back().GetType() == ArchiveBlockType::Unordered; }
+    /// Return current string stack.
+    ea::string GetCurrentStackString() final;
+
+    /// Begin archive block.
+    bool BeginBlock(const char* name, unsigned& sizeHint, bool safe, ArchiveBlockType type) final;
+    /// End archive block.
+    bool EndBlock() final;
+
+    /// Serialize string key. Used with Map block only.
+    bool SerializeKey(ea::string& key) final;
+    /// Serialize unsigned integer key. Used with Map block only.
+    bool SerializeKey(unsigned& key) final;
+
+    /// Serialize bool.
+    bool Serialize(const char* name, bool& value) final;
+    /// Serialize signed char.
+    bool Serialize(const char* name, signed char& value) final;
+    /// Serialize unsigned char.
+    bool Serialize(const char* name, unsigned char& value) final;
+    /// Serialize signed short.
+    bool Serialize(const char* name, short& value) final;
+    /// Serialize unsigned short.
+    bool Serialize(const char* name, unsigned short& value) final;
+    /// Serialize signed int.
+    bool Serialize(const char* name, int& value) final;
+    /// Serialize unsigned int.
+    bool Serialize(const char* name, unsigned int& value) final;
+    /// Serialize signed long.
+    bool Serialize(const char* name, long long& value) final;
+    /// Serialize unsigned long.
+    bool Serialize(const char* name, unsigned long long& value) final;
+    /// Serialize float.
+    bool Serialize(const char* name, float& value) final;
+    /// Serialize double.
+    bool Serialize(const char* name, double& value) final;
+    /// Serialize string.
+    bool Serialize(const char* name, ea::string& value) final;
+
+    /// Serialize bytes. Size is not encoded and should be provided externally!
+    bool SerializeBytes(const char* name, void* bytes, unsigned size) final;
+    /// Serialize Variable Length Encoded unsigned integer, up to 29 significant bits.
+    bool SerializeVLE(const char* name, unsigned& value) final;
+
+private:
+    /// Block type.
+    using Block = XMLStreamInputArchiveBlock;
+    /// Start tag of an element.
+    struct ElementStart
+    {
+        /// Element name.
+        ea::string_view name_;
+        /// Attributes.
+        const char* attributes_{};
+        /// First character of the content, or null if the element is empty.
+        const char* content_{};
+    };
+
+    /// Get current block.
+    Block& GetCurrentBlock() { return stack_.back(); }
+    /// Check EOF.
+    bool CheckEOF(const char* elementName, const char* debugName);
+    /// Check EOF and root block.
+    bool CheckEOFAndRoot(const char* elementName, const char* debugName);
+    /// Read the next child element or the named child of an Unordered block. Return false if not found.
+    bool ReadChild(const char* name, ElementStart& element);
+    /// Read the value of the next element, or the named attribute of an Unordered block, into the temporary string. Return false if not found.
+    bool ReadValue(const char* name);
+    /// Find the named child of an Unordered block. Return false if not found.
+    bool FindChild(Block& block, const char* name, ElementStart& element);
+    /// Count the remaining children of a block without moving.
+    unsigned CountChildren();
+    /// Find attribute value in the attribute list of an element.
+    bool FindAttribute(const char* attributes, ea::string_view name, ea::string& value);
+    /// Parse element start tag at the current position.
+    bool ParseElementStart(ElementStart& element);
+    /// Skip the content and the end tag of an element whose start tag was parsed.
+    bool SkipElement(const ElementStart& element);
+    /// Skip the remaining children and the end tag of the current element.
+    bool SkipRemainingContent();
+    /// Move to the next child element, skipping text, comments and processing instructions. Return false at the end tag of the parent.
+    bool NextChild();
+    /// Skip end tag at the current position.
+    bool SkipEndTag();
+    /// Set syntax error at the current position.
+    void SetSyntaxError();
+
+    /// Context.
+    Context* context_{};
+    /// Archive name.
+    ea::string name_;
+    /// Whether to check the root element name.
+    bool serializeRootName_{};
+    /// Text storage when reading from a stream.
+    ea::vector<char> buffer_;
+    /// Beginning of text.
+    const char* text_{};
+    /// Current position.
+    const char* pos_{};
+    /// End of text.
+    const char* end_{};
+    /// Blocks stack.
+    ea::vector<Block> stack_;
+    /// Start tag of the Map block element whose key was read.
+    ElementStart keyElement_;
+    /// Temporary string.
+    ea::string tempString_;
+    /// Temporary buffer.
+    ea::vector<unsigned char> tempBuffer_;
+};
+
+}
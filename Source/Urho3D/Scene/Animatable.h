@@ -39,6 +39,8 @@ class ObjectAnimation;
 /// Attribute animation instance.
 class URHO3D_API AttributeAnimationInfo : public ValueAnimationInfo
 {
+    friend class AttributeAnimationSystem;
+
 public:
     /// Construct.
     AttributeAnimationInfo
@@ -66,6 +68,8 @@ class URHO3D_API Animatable : public Serializable
 {
     URHO3D_OBJECT(Animatable, Serializable);
 
+    friend class AttributeAnimationSystem;
+
 public:
     /// Construct.
     explicit Animatable(Context* context);
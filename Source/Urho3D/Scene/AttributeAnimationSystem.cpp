@@ -0,0 +1,254 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Animatable.h"
+#include "../Scene/AttributeAnimationSystem.h"
+#include "../Scene/Scene.h"
+#include "../Scene/ValueAnimation.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of animation instances per work item.
+static const unsigned MIN_INSTANCES_PER_WORK_ITEM = 256;
+
+void AttributeAnimationSystem::EvaluateInstancesWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* system = reinterpret_cast<AttributeAnimationSystem*>(item->aux_);
+    float* times = system->instanceTimes_.data();
+    const unsigned begin = reinterpret_cast<float*>(item->start_) - times;
+    const unsigned end = reinterpret_cast<float*>(item->end_) - times;
+    system->EvaluateInstances(begin, end);
+}
+
+AttributeAnimationSystem::AttributeAnimationSystem(Scene* scene) :
+    scene_(scene)
+{
+}
+
+void AttributeAnimationSystem::QueueUpdate(Animatable* animatable)
+{
+    queue_.emplace_back(animatable);
+}
+
+void AttributeAnimationSystem::Update(float timeStep)
+{
+    if (queue_.empty())
+        return;
+
+    URHO3D_PROFILE("UpdateAttributeAnimations");
+
+    Gather(timeStep);
+    EvaluateAllInstances();
+    Apply();
+
+    queue_.clear();
+    entries_.clear();
+}
+
+void AttributeAnimationSystem::EvaluateInstances(unsigned begin, unsigned end)
+{
+    // Find the group of the first instance
+    auto group = ea::upper_bound(groups_.begin(), groups_.end(), begin,
+        [](unsigned index, const Group& group) { return index < group.firstInstance_; }) - 1;
+
+    for (; begin < end; ++group)
+    {
+        const unsigned groupEnd = Min(group->firstInstance_ + group->numInstances_, end);
+        const unsigned resultOffset = group->resultOffset_ + (begin - group->firstInstance_) * group->keyFrames_->numComponents_;
+        group->keyFrames_->Evaluate(&instanceTimes_[begin], &results_[resultOffset], groupEnd - begin);
+        begin = groupEnd;
+    }
+}
+
+void AttributeAnimationSystem::Gather(float timeStep)
+{
+    entries_.clear();
+    groups_.clear();
+    groupIndices_.clear();
+
+    for (const WeakPtr<Animatable>& animatable : queue_)
+    {
+        if (!animatable || !animatable->animationEnabled_)
+            continue;
+
+        for (const auto& pair : animatable->attributeAnimationInfos_)
+        {
+            AttributeAnimationInfo* info = pair.second;
+            entries_.push_back({ SharedPtr<AttributeAnimationInfo>(info), 0.0f, M_MAX_UNSIGNED, false, false });
+            Entry& entry = entries_.back();
+
+            // Same as ValueAnimationInfo::Update()
+            ValueAnimation* animation = info->animation_;
+            if (!animation || !info->target_)
+            {
+                entry.finished_ = true;
+                continue;
+            }
+
+            info->currentTime_ += timeStep * info->speed_;
+            if (!animation->IsValid())
+            {
+                entry.finished_ = true;
+                continue;
+            }
+
+            entry.scaledTime_ = info->CalculateScaledTime(info->currentTime_, entry.finished_);
+            entry.apply_ = true;
+
+            const VAnimPackedKeyFrames* keyFrames = animation->GetPackedKeyFrames();
+            if (!keyFrames || keyFrames->valueType_ != info->GetAttributeInfo().type_)
+                continue;
+
+            auto i = groupIndices_.find(animation);
+            if (i == groupIndices_.end())
+            {
+                i = groupIndices_.emplace(animation, groups_.size()).first;
+                groups_.push_back({ keyFrames, 0, 0, 0 });
+            }
+
+            // Store the group index until the offsets are known
+            ++groups_[i->second].numInstances_;
+            entry.resultOffset_ = i->second;
+        }
+    }
+
+    // Lay out the instances and results of each group contiguously
+    unsigned numInstances = 0;
+    unsigned numResults = 0;
+    for (Group& group : groups_)
+    {
+        group.firstInstance_ = numInstances;
+        group.resultOffset_ = numResults;
+        numInstances += group.numInstances_;
+        numResults += group.numInstances_ * group.keyFrames_->numComponents_;
+        group.numInstances_ = 0;
+    }
+
+    instanceTimes_.resize(numInstances);
+    results_.resize(numResults);
+
+    for (Entry& entry : entries_)
+    {
+        if (entry.resultOffset_ == M_MAX_UNSIGNED)
+            continue;
+
+        Group& group = groups_[entry.resultOffset_];
+        const unsigned index = group.numInstances_++;
+        instanceTimes_[group.firstInstance_ + index] = entry.scaledTime_;
+        entry.resultOffset_ = group.resultOffset_ + index * group.keyFrames_->numComponents_;
+    }
+}
+
+void AttributeAnimationSystem::EvaluateAllInstances()
+{
+    const unsigned numInstances = instanceTimes_.size();
+    auto* queue = scene_->GetSubsystem<WorkQueue>();
+    const unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+    if (numThreads == 0 || numInstances < 2 * MIN_INSTANCES_PER_WORK_ITEM)
+    {
+        EvaluateInstances(0, numInstances);
+        return;
+    }
+
+    // Worker threads + main thread
+    const unsigned numWorkItems = Min(numThreads + 1, numInstances / MIN_INSTANCES_PER_WORK_ITEM);
+    const unsigned instancesPerItem = (numInstances + numWorkItems - 1) / numWorkItems;
+    for (unsigned itemBegin = 0; itemBegin < numInstances; itemBegin += instancesPerItem)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = EvaluateInstancesWork;
+        item->aux_ = this;
+        item->start_ = instanceTimes_.data() + itemBegin;
+        item->end_ = instanceTimes_.data() + Min(itemBegin + instancesPerItem, numInstances);
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+void AttributeAnimationSystem::Apply()
+{
+    // Apply all values before sending any event frames
+    for (const Entry& entry : entries_)
+    {
+        AttributeAnimationInfo* info = entry.info_;
+        auto* animatable = static_cast<Animatable*>(info->target_.Get());
+        if (!entry.apply_ || !animatable)
+            continue;
+
+        if (entry.resultOffset_ != M_MAX_UNSIGNED && animatable->SetAttributeRaw(info->GetAttributeInfo(), &results_[entry.resultOffset_]))
+        {
+            // Same as OnSetAttribute() followed by ApplyAttributes()
+            animatable->MarkSaveDirty();
+            animatable->ApplyAttributes();
+        }
+        else
+            info->ApplyValue(info->animation_->GetAnimationValue(entry.scaledTime_));
+    }
+
+    ea::vector<const VAnimEventFrame*> eventFrames;
+    for (const Entry& entry : entries_)
+    {
+        AttributeAnimationInfo* info = entry.info_;
+        if (!entry.apply_ || !info->target_)
+            continue;
+
+        if (info->animation_->HasEventFrames())
+        {
+            eventFrames.clear();
+            info->GetEventFrames(info->lastScaledTime_, entry.scaledTime_, eventFrames);
+
+            for (const VAnimEventFrame* eventFrame : eventFrames)
+            {
+                // Stop if the target expired due to an event
+                if (!info->target_)
+                    break;
+                info->target_->SendEvent(eventFrame->eventType_, const_cast<VariantMap&>(eventFrame->eventData_));
+            }
+        }
+
+        info->lastScaledTime_ = entry.scaledTime_;
+    }
+
+    for (const Entry& entry : entries_)
+    {
+        AttributeAnimationInfo* info = entry.info_;
+        auto* animatable = static_cast<Animatable*>(info->target_.Get());
+        if (!entry.finished_ || !animatable)
+            continue;
+
+        // The animation may have been replaced by an event handler
+        const ea::string& name = info->GetAttributeInfo().name_;
+        if (animatable->GetAttributeAnimationInfo(name) == info)
+            animatable->SetAttributeAnimation(name, nullptr);
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+
+#include "../Container/Ptr.h"
+
+namespace Urho3D
+{
+
+class Animatable;
+class AttributeAnimationInfo;
+class Scene;
+class ValueAnimation;
+struct VAnimPackedKeyFrames;
+struct WorkItem;
+
+/// Batched attribute animation update for the animatables of a scene. Animatables queue themselves on the attribute animation update event instead of updating, and the update evaluates all queued animations at once: animation instances are grouped by value animation, the key frames of each animation are packed as floats, and the interpolation runs over contiguous arrays of times and results, splitting large batches between worker threads. Results are written through the typed attribute setters when available. Animations of value types not made of floats are evaluated through Variant as before.
+class URHO3D_API AttributeAnimationSystem
+{
+public:
+    /// Construct for a scene.
+    explicit AttributeAnimationSystem(Scene* scene);
+
+    /// Queue an animatable for the next update.
+    void QueueUpdate(Animatable* animatable);
+    /// Advance, evaluate and apply the attribute animations of the queued animatables, then send event frames and remove finished animations. Must be called from the main thread.
+    void Update(float timeStep);
+    /// Evaluate a range of packed animation instances. Is thread-safe for disjoint ranges.
+    void EvaluateInstances(unsigned begin, unsigned end);
+
+    /// Return number of packed animation instances evaluated by the last update.
+    unsigned GetNumInstances() const { return instanceTimes_.size(); }
+    /// Return number of value animations evaluated in batch by the last update.
+    unsigned GetNumGroups() const { return groups_.size(); }
+
+private:
+    /// Animation instance being updated.
+    struct Entry
+    {
+        /// Animation instance.
+        SharedPtr<AttributeAnimationInfo> info_;
+        /// Scaled time.
+        float scaledTime_;
+        /// Offset of the packed result, or M_MAX_UNSIGNED if evaluated through Variant.
+        unsigned resultOffset_;
+        /// Whether a value is applied.
+        bool apply_;
+        /// Whether the animation is finished.
+        bool finished_;
+    };
+
+    /// Packed animation instances of one value animation.
+    struct Group
+    {
+        /// Packed key frames.
+        const VAnimPackedKeyFrames* keyFrames_;
+        /// Index of the first instance.
+        unsigned firstInstance_;
+        /// Number of instances.
+        unsigned numInstances_;
+        /// Offset of the first result.
+        unsigned resultOffset_;
+    };
+
+    /// Work function to evaluate a range of packed animation instances.
+    static void EvaluateInstancesWork(const WorkItem* item, unsigned threadIndex);
+    /// Advance the animations of the queued animatables and pack the instances by value animation.
+    void Gather(float timeStep);
+    /// Evaluate all packed animation instances.
+    void EvaluateAllInstances();
+    /// Apply values, send event frames and remove finished animations.
+    void Apply();
+
+    /// Scene.
+    Scene* scene_;
+    /// Animatables queued for the next update.
+    ea::vector<WeakPtr<Animatable> > queue_;
+    /// Animation instances being updated.
+    ea::vector<Entry> entries_;
+    /// Groups of packed animation instances.
+    ea::vector<Group> groups_;
+    /// Group index by value animation.
+    ea::unordered_map<const ValueAnimation*, unsigned> groupIndices_;
+    /// Scaled times of packed animation instances, grouped by value animation.
+    ea::vector<float> instanceTimes_;
+    /// Packed results.
+    ea::vector<float> results_;
+};
+
+}
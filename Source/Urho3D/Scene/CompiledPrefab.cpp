@@ -0,0 +1,406 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../Resource/JSONFile.h"
+#include "../Resource/XMLFile.h"
+#include "../Scene/CompiledPrefab.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Gather non-temporary nodes depth-first, parents before children.
+static void GatherNodes(Node* node, unsigned parentIndex, ea::vector<Node*>& nodes, ea::vector<unsigned>& parents)
+{
+    const unsigned index = nodes.size();
+    nodes.push_back(node);
+    parents.push_back(parentIndex);
+
+    for (const SharedPtr<Node>& child : node->GetChildren())
+    {
+        if (!child->IsTemporary())
+            GatherNodes(child, index, nodes, parents);
+    }
+}
+
+CompiledPrefab::CompiledPrefab(Context* context) :
+    Resource(context)
+{
+}
+
+CompiledPrefab::~CompiledPrefab() = default;
+
+void CompiledPrefab::RegisterObject(Context* context)
+{
+    context->RegisterFactory<CompiledPrefab>();
+}
+
+bool CompiledPrefab::BeginLoad(Deserializer& source)
+{
+    // Instantiating the source creates components, which is only safe in the main thread. Defer it to EndLoad()
+    loadData_.resize(source.GetSize());
+    if (!loadData_.empty() && source.Read(loadData_.data(), loadData_.size()) != loadData_.size())
+    {
+        loadData_.clear();
+        return false;
+    }
+
+    SetMemoryUse(loadData_.size());
+    return true;
+}
+
+bool CompiledPrefab::EndLoad()
+{
+    ea::vector<unsigned char> data = ea::move(loadData_);
+    if (data.empty())
+        return false;
+
+    // Detect the source format from the first non-whitespace character
+    char first = 0;
+    for (unsigned char c : data)
+    {
+        if (!isspace(c))
+        {
+            first = (char)c;
+            break;
+        }
+    }
+
+    // Instantiate into a temporary scene, then compile from the live nodes
+    SharedPtr<Scene> scene(MakeShared<Scene>(context_));
+    MemoryBuffer buffer(data);
+    Node* node = nullptr;
+    if (first == '<')
+    {
+        XMLFile xml(context_);
+        if (xml.Load(buffer))
+            node = scene->InstantiateXML(xml.GetRoot(), Vector3::ZERO, Quaternion::IDENTITY);
+    }
+    else if (first == '{')
+    {
+        JSONFile json(context_);
+        if (json.Load(buffer))
+            node = scene->InstantiateJSON(json.GetRoot(), Vector3::ZERO, Quaternion::IDENTITY);
+    }
+    else
+        node = scene->Instantiate(buffer, Vector3::ZERO, Quaternion::IDENTITY);
+
+    if (!node)
+    {
+        URHO3D_LOGERROR("Could not instantiate prefab " + GetName());
+        return false;
+    }
+
+    return Compile(node);
+}
+
+bool CompiledPrefab::Compile(Node* node)
+{
+    nodes_.clear();
+    components_.clear();
+    values_.clear();
+
+    if (!node)
+    {
+        URHO3D_LOGERROR("Null node for compiling prefab");
+        return false;
+    }
+
+    URHO3D_PROFILE("CompilePrefab");
+
+    // Assign prefab-local indices to nodes and components
+    ea::vector<Node*> sourceNodes;
+    ea::vector<unsigned> parents;
+    GatherNodes(node, M_MAX_UNSIGNED, sourceNodes, parents);
+
+    ea::unordered_map<unsigned, unsigned> nodeIndices;
+    ea::unordered_map<unsigned, unsigned> componentIndices;
+    ea::vector<Component*> sourceComponents;
+    ea::vector<ObjectFactory*> factories;
+    const auto& allFactories = context_->GetObjectFactories();
+    for (unsigned i = 0; i < sourceNodes.size(); ++i)
+    {
+        Node* sourceNode = sourceNodes[i];
+        nodeIndices[sourceNode->GetID()] = i;
+
+        NodeData nodeData;
+        nodeData.parent_ = parents[i];
+        nodeData.replicated_ = sourceNode->IsReplicated();
+        nodeData.enabled_ = sourceNode->IsEnabled();
+        nodeData.name_ = sourceNode->GetName();
+        nodeData.tags_ = sourceNode->GetTags();
+        nodeData.position_ = sourceNode->GetPosition();
+        nodeData.rotation_ = sourceNode->GetRotation();
+        nodeData.scale_ = sourceNode->GetScale();
+        nodeData.vars_ = sourceNode->GetVars();
+        nodeData.firstComponent_ = sourceComponents.size();
+
+        for (const SharedPtr<Component>& component : sourceNode->GetComponents())
+        {
+            if (component->IsTemporary())
+                continue;
+
+            // Components of unknown types keep their data in a custom format, so they can not be compiled
+            auto factory = allFactories.find(component->GetType());
+            if (factory == allFactories.end() || !factory->second->GetTypeInfo()->IsTypeOf<Component>())
+            {
+                URHO3D_LOGWARNING("Skipping component of unknown type " + component->GetTypeName() + " in prefab " + GetName());
+                continue;
+            }
+
+            componentIndices[component->GetID()] = sourceComponents.size();
+            sourceComponents.push_back(component);
+            factories.push_back(factory->second);
+        }
+
+        nodeData.numComponents_ = sourceComponents.size() - nodeData.firstComponent_;
+        nodes_.push_back(ea::move(nodeData));
+    }
+
+    // Store the attribute values that differ from what a new component has, translating references to local indices
+    Variant value;
+    for (unsigned i = 0; i < sourceComponents.size(); ++i)
+    {
+        Component* component = sourceComponents[i];
+        const ea::vector<AttributeInfo>* attributes = component->GetAttributes();
+
+        ComponentData componentData;
+        componentData.factory_ = factories[i];
+        componentData.attributes_ = attributes == context_->GetAttributes(component->GetType()) ? attributes : nullptr;
+        componentData.replicated_ = component->IsReplicated();
+        componentData.hasReferences_ = false;
+        componentData.firstValue_ = values_.size();
+
+        for (unsigned j = 0; attributes && j < attributes->size(); ++j)
+        {
+            const AttributeInfo& attr = attributes->at(j);
+            if (!(attr.mode_ & AM_FILE))
+                continue;
+
+            component->OnGetAttribute(attr, value);
+
+            if (attr.mode_ & (AM_NODEID | AM_COMPONENTID))
+            {
+                const unsigned id = value.GetUInt();
+                if (!id)
+                    continue;
+
+                // References outside the prefab are kept as they are
+                const auto& indices = (attr.mode_ & AM_NODEID) ? nodeIndices : componentIndices;
+                auto k = indices.find(id);
+                if (k != indices.end())
+                {
+                    values_.push_back({j, (attr.mode_ & AM_NODEID) ? VALUE_NODE : VALUE_COMPONENT, Variant(k->second)});
+                    componentData.hasReferences_ = true;
+                }
+                else
+                    values_.push_back({j, VALUE_PLAIN, value});
+            }
+            else if (attr.mode_ & AM_NODEIDVECTOR)
+            {
+                const VariantVector& ids = value.GetVariantVector();
+                if (ids.empty())
+                    continue;
+
+                // The first element is the number of IDs. Unresolvable IDs become zero, like in SceneResolver
+                VariantVector indices;
+                indices.push_back(ids[0]);
+                for (unsigned k = 1; k < ids.size(); ++k)
+                {
+                    auto l = nodeIndices.find(ids[k].GetUInt());
+                    indices.push_back(l != nodeIndices.end() ? l->second : M_MAX_UNSIGNED);
+                }
+                values_.push_back({j, VALUE_NODEVECTOR, Variant(indices)});
+                componentData.hasReferences_ = true;
+            }
+            else
+            {
+                if (value == component->GetAttributeDefault(j) && !component->SaveDefaultAttributes(attr))
+                    continue;
+                values_.push_back({j, VALUE_PLAIN, value});
+            }
+        }
+
+        componentData.numValues_ = values_.size() - componentData.firstValue_;
+        components_.push_back(ea::move(componentData));
+    }
+
+    SetMemoryUse(sizeof(CompiledPrefab) + nodes_.size() * sizeof(NodeData) + components_.size() * sizeof(ComponentData) +
+        values_.size() * sizeof(AttributeValue));
+    return true;
+}
+
+Node* CompiledPrefab::Instantiate(Node* parent, const Vector3& position, const Quaternion& rotation, CreateMode mode) const
+{
+    if (!parent || nodes_.empty())
+    {
+        URHO3D_LOGERROR("Null parent or empty prefab for instantiation");
+        return nullptr;
+    }
+
+    URHO3D_PROFILE("InstantiatePrefab");
+
+    ea::vector<Node*> nodes;
+    ea::vector<Component*> components;
+    return InstantiateCopy(parent, position, rotation, mode, nodes, components);
+}
+
+ea::vector<Node*> CompiledPrefab::Instantiate(Node* parent, const ea::vector<Vector3>& positions,
+    const ea::vector<Quaternion>& rotations, CreateMode mode) const
+{
+    ea::vector<Node*> roots;
+    if (!parent || nodes_.empty())
+    {
+        URHO3D_LOGERROR("Null parent or empty prefab for instantiation");
+        return roots;
+    }
+    if (!rotations.empty() && rotations.size() != positions.size())
+    {
+        URHO3D_LOGERROR("Rotation count does not match position count for prefab instantiation");
+        return roots;
+    }
+
+    URHO3D_PROFILE("InstantiatePrefabs");
+
+    // Share the scratch arrays between copies
+    ea::vector<Node*> nodes;
+    ea::vector<Component*> components;
+    roots.reserve(positions.size());
+    for (unsigned i = 0; i < positions.size(); ++i)
+    {
+        const Quaternion& rotation = rotations.empty() ? Quaternion::IDENTITY : rotations[i];
+        roots.push_back(InstantiateCopy(parent, positions[i], rotation, mode, nodes, components));
+    }
+
+    return roots;
+}
+
+Node* CompiledPrefab::InstantiateCopy(Node* parent, const Vector3& position, const Quaternion& rotation, CreateMode mode,
+    ea::vector<Node*>& nodes, ea::vector<Component*>& components) const
+{
+    nodes.resize(nodes_.size());
+    components.resize(components_.size());
+
+    for (unsigned i = 0; i < nodes_.size(); ++i)
+    {
+        const NodeData& nodeData = nodes_[i];
+        Node* nodeParent = nodeData.parent_ == M_MAX_UNSIGNED ? parent : nodes[nodeData.parent_];
+        Node* node = nodeParent->CreateChild(0, (mode == REPLICATED && nodeData.replicated_) ? REPLICATED : LOCAL);
+        nodes[i] = node;
+
+        if (!nodeData.enabled_)
+            node->SetEnabled(false);
+        if (!nodeData.name_.empty())
+            node->SetName(nodeData.name_);
+        if (!nodeData.tags_.empty())
+            node->SetTags(nodeData.tags_);
+        if (i == 0)
+            node->SetTransform(position, rotation, nodeData.scale_);
+        else
+            node->SetTransform(nodeData.position_, nodeData.rotation_, nodeData.scale_);
+        for (const auto& var : nodeData.vars_)
+            node->SetVar(var.first, var.second);
+
+        const CreateMode componentMode = node->IsReplicated() ? mode : LOCAL;
+        for (unsigned j = nodeData.firstComponent_; j < nodeData.firstComponent_ + nodeData.numComponents_; ++j)
+        {
+            const ComponentData& componentData = components_[j];
+            SharedPtr<Component> component(static_cast<Component*>(componentData.factory_->CreateObject().Get()));
+            node->AddComponent(component, 0, (componentMode == REPLICATED && componentData.replicated_) ? REPLICATED : LOCAL);
+            components[j] = component;
+
+            const ea::vector<AttributeInfo>* attributes = componentData.attributes_ ? componentData.attributes_ : component->GetAttributes();
+            component->BeginAttributeLoad();
+            for (unsigned k = componentData.firstValue_; k < componentData.firstValue_ + componentData.numValues_; ++k)
+            {
+                const AttributeValue& value = values_[k];
+                if (value.kind_ == VALUE_PLAIN && value.index_ < attributes->size())
+                    component->OnSetAttribute(attributes->at(value.index_), value.value_);
+            }
+            component->EndAttributeLoad();
+        }
+    }
+
+    // References can be set only after all nodes and components of the copy exist
+    for (unsigned i = 0; i < components_.size(); ++i)
+    {
+        const ComponentData& componentData = components_[i];
+        if (!componentData.hasReferences_)
+            continue;
+
+        Component* component = components[i];
+        const ea::vector<AttributeInfo>* attributes = componentData.attributes_ ? componentData.attributes_ : component->GetAttributes();
+        component->BeginAttributeLoad();
+        for (unsigned k = componentData.firstValue_; k < componentData.firstValue_ + componentData.numValues_; ++k)
+        {
+            const AttributeValue& value = values_[k];
+            if (value.kind_ != VALUE_PLAIN && value.index_ < attributes->size())
+                component->OnSetAttribute(attributes->at(value.index_), ResolveValue(value, nodes, components));
+        }
+        component->EndAttributeLoad();
+    }
+
+    Node* root = nodes[0];
+    root->ApplyAttributes();
+    return root;
+}
+
+Variant CompiledPrefab::ResolveValue(const AttributeValue& value, const ea::vector<Node*>& nodes,
+    const ea::vector<Component*>& components) const
+{
+    switch (value.kind_)
+    {
+    case VALUE_NODE:
+        return nodes[value.value_.GetUInt()]->GetID();
+
+    case VALUE_COMPONENT:
+        return components[value.value_.GetUInt()]->GetID();
+
+    case VALUE_NODEVECTOR:
+        {
+            const VariantVector& indices = value.value_.GetVariantVector();
+            VariantVector ids;
+            ids.reserve(indices.size());
+            ids.push_back(indices[0]);
+            for (unsigned i = 1; i < indices.size(); ++i)
+            {
+                const unsigned index = indices[i].GetUInt();
+                ids.push_back(index < nodes.size() ? nodes[index]->GetID() : 0);
+            }
+            return ids;
+        }
+
+    default:
+        return value.value_;
+    }
+}
+
+}
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Attribute.h"
+#include "../Math/Quaternion.h"
+#include "../Math/Vector3.h"
+#include "../Resource/Resource.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+
+class ObjectFactory;
+
+/// Object prefab preprocessed for fast instantiation. The node hierarchy is stored flat with pre-resolved component factories, non-default attribute values only, and node and component references as prefab-local indices.
+class URHO3D_API CompiledPrefab : public Resource
+{
+    URHO3D_OBJECT(CompiledPrefab, Resource);
+
+public:
+    /// Construct.
+    explicit CompiledPrefab(Context* context);
+    /// Destruct.
+    ~CompiledPrefab() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Load resource from stream. The source may be a binary, XML or JSON object prefab. May be called from a worker thread. Return true if successful.
+    bool BeginLoad(Deserializer& source) override;
+    /// Finish resource loading by compiling the prefab. Always called from the main thread. Return true if successful.
+    bool EndLoad() override;
+
+    /// Compile from a node hierarchy. Temporary nodes and components are skipped. Must be compiled again if attributes are registered for the contained component types afterwards. Return true if successful.
+    bool Compile(Node* node);
+    /// Instantiate a copy under a parent node. Return the root node if successful.
+    Node* Instantiate(Node* parent, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED) const;
+    /// Instantiate a copy for each position under a parent node. Rotations may be empty for identity or have one rotation per position. Return the root nodes.
+    ea::vector<Node*> Instantiate(Node* parent, const ea::vector<Vector3>& positions, const ea::vector<Quaternion>& rotations,
+        CreateMode mode = REPLICATED) const;
+
+    /// Return number of nodes in one copy.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+
+    /// Return number of components in one copy.
+    unsigned GetNumComponents() const { return components_.size(); }
+
+    /// Return whether the prefab is empty.
+    bool IsEmpty() const { return nodes_.empty(); }
+
+private:
+    /// Interpretation of a stored attribute value.
+    enum ValueKind
+    {
+        /// Plain value.
+        VALUE_PLAIN = 0,
+        /// Prefab-local node index.
+        VALUE_NODE,
+        /// Prefab-local component index.
+        VALUE_COMPONENT,
+        /// Node ID vector of prefab-local node indices.
+        VALUE_NODEVECTOR
+    };
+
+    /// Stored attribute value.
+    struct AttributeValue
+    {
+        /// Attribute index.
+        unsigned index_;
+        /// Value interpretation.
+        ValueKind kind_;
+        /// Value.
+        Variant value_;
+    };
+
+    /// Stored node.
+    struct NodeData
+    {
+        /// Parent node index, or M_MAX_UNSIGNED for the root.
+        unsigned parent_;
+        /// Replicated flag.
+        bool replicated_;
+        /// Enabled flag.
+        bool enabled_;
+        /// Name.
+        ea::string name_;
+        /// Tags.
+        StringVector tags_;
+        /// Position.
+        Vector3 position_;
+        /// Rotation.
+        Quaternion rotation_;
+        /// Scale.
+        Vector3 scale_;
+        /// User variables.
+        VariantMap vars_;
+        /// First component index.
+        unsigned firstComponent_;
+        /// Number of components.
+        unsigned numComponents_;
+    };
+
+    /// Stored component.
+    struct ComponentData
+    {
+        /// Factory.
+        SharedPtr<ObjectFactory> factory_;
+        /// Attribute descriptions of the type, or null if the attributes are instance-specific.
+        const ea::vector<AttributeInfo>* attributes_;
+        /// Replicated flag.
+        bool replicated_;
+        /// Whether any value refers to nodes or components of the prefab.
+        bool hasReferences_;
+        /// First value index.
+        unsigned firstValue_;
+        /// Number of values.
+        unsigned numValues_;
+    };
+
+    /// Instantiate one copy using preallocated scratch arrays.
+    Node* InstantiateCopy(Node* parent, const Vector3& position, const Quaternion& rotation, CreateMode mode,
+        ea::vector<Node*>& nodes, ea::vector<Component*>& components) const;
+    /// Translate a stored reference value to the IDs of an instantiated copy.
+    Variant ResolveValue(const AttributeValue& value, const ea::vector<Node*>& nodes, const ea::vector<Component*>& components) const;
+
+    /// Nodes in depth-first order, parents before children.
+    ea::vector<NodeData> nodes_;
+    /// Components in node order.
+    ea::vector<ComponentData> components_;
+    /// Attribute values of all components.
+    ea::vector<AttributeValue> values_;
+    /// Source data acquired during BeginLoad.
+    ea::vector<unsigned char> loadData_;
+};
+
+}
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Resource/JSONValue.h"
+#include "../Scene/AttributeAnimationSystem.h"
 #include "../Scene/Component.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
@@ -56,6 +57,7 @@ Component::Component(Context* context) :
     node_(nullptr),
     id_(0),
     networkUpdate_(false),
+    saveDirty_(false),
     enabled_(true)
 {
 }
@@ -107,6 +109,17 @@ void Component::MarkNetworkUpdate()
             networkUpdate_ = true;
         }
     }
+    MarkSaveDirty();
+}
+
+void Component::MarkSaveDirty()
+{
+    if (!saveDirty_)
+    {
+        Scene* scene = GetScene();
+        if (scene && scene->GetSaveTracking())
+            scene->MarkSaveDirty(this);
+    }
 }
 
 void Component::GetDependencyNodes(ea::vector<Node*>& dest)
@@ -284,7 +297,12 @@ void Component::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap&
 {
     using namespace AttributeAnimationUpdate;
 
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    // Batched scenes evaluate the queued animations after the event
+    auto* scene = static_cast<Scene*>(eventData[P_SCENE].GetPtr());
+    if (AttributeAnimationSystem* system = scene ? scene->GetAttributeAnimationSystem() : nullptr)
+        system->QueueUpdate(this);
+    else
+        UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
 }
 
 Component* Component::GetFixedUpdateSource()
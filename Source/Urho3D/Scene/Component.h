@@ -50,6 +50,7 @@ class URHO3D_API Component : public Animatable
 
     friend class Node;
     friend class Scene;
+    friend class SceneSaveTracker;
 
 public:
     /// Construct.
@@ -68,6 +69,8 @@ public:
     bool SaveJSON(JSONValue& dest) const override;
     /// Mark for attribute check on the next network update.
     void MarkNetworkUpdate() override;
+    /// Mark changed for the next incremental scene save.
+    void MarkSaveDirty() override;
     /// Return the depended on nodes to order network updates.
     virtual void GetDependencyNodes(ea::vector<Node*>& dest);
     /// Visualize the component as debug geometry.
@@ -140,6 +143,8 @@ protected:
     unsigned id_;
     /// Network update queued flag.
     bool networkUpdate_;
+    /// Save tracking change queued flag.
+    bool saveDirty_;
     /// Enabled flag.
     bool enabled_;
 };
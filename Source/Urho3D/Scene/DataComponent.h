@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include "../IO/ArchiveSerialization.h"
+
+#include <entt/entity/registry.hpp>
+
+#include <type_traits>
+
+namespace Urho3D
+{
+
+/// Type-erased operations of a data component type registered to a scene. Data components are plain structures stored directly in the scene registry, attached to node entities, without the Component object overhead.
+struct DataComponentType
+{
+    /// Type name.
+    ea::string name_;
+    /// Type name hash.
+    StringHash type_;
+    /// Return whether the entity has the component.
+    bool (*has_)(const entt::registry& registry, entt::entity entity){};
+    /// Remove the component from the entity, if present.
+    void (*remove_)(entt::registry& registry, entt::entity entity){};
+    /// Copy the component from one entity to another.
+    void (*copy_)(entt::registry& registry, entt::entity source, entt::entity dest){};
+    /// Serialize the component of the entity. Creates or replaces the component when loading.
+    bool (*serialize_)(Archive& archive, entt::registry& registry, entt::entity entity){};
+};
+
+/// Create the type-erased operations of a data component type. The type must be trivially copyable and serializable with SerializeValue().
+template <class T> DataComponentType MakeDataComponentType(const ea::string& name)
+{
+    static_assert(std::is_trivially_copyable_v<T> && !std::is_empty_v<T>, "Data component must be trivially copyable and not empty");
+
+    DataComponentType type;
+    type.name_ = name;
+    type.type_ = name;
+    type.has_ = [](const entt::registry& registry, entt::entity entity) { return registry.has<T>(entity); };
+    type.remove_ = [](entt::registry& registry, entt::entity entity) { registry.reset<T>(entity); };
+    type.copy_ = [](entt::registry& registry, entt::entity source, entt::entity dest)
+    {
+        const T value = registry.get<T>(source);
+        registry.assign_or_replace<T>(dest, value);
+    };
+    type.serialize_ = [](Archive& archive, entt::registry& registry, entt::entity entity)
+    {
+        T& value = archive.IsInput() ? registry.assign_or_replace<T>(entity) : registry.get<T>(entity);
+        return SerializeValue(archive, "value", value);
+    };
+    return type;
+}
+
+}
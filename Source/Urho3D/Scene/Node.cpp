@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include <EASTL/hash_set.h>
+
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../IO/Archive.h"
@@ -30,12 +32,14 @@
 #include "../IO/MemoryBuffer.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
+#include "../Scene/AttributeAnimationSystem.h"
 #include "../Scene/Component.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
+#include "../Scene/TransformSystem.h"
 #include "../Scene/UnknownComponent.h"
 
 #include "../DebugNew.h"
@@ -47,6 +51,22 @@
 namespace Urho3D
 {
 
+/// Append the nodes with a component depth-first, descending only into the branches that lead to such nodes.
+static void GetChildrenWithComponentInBranches(ea::vector<Node*>& dest, const Node* parent, StringHash type,
+    const ea::hash_set<const Node*>& branches)
+{
+    for (const SharedPtr<Node>& child : parent->GetChildren())
+    {
+        Node* node = child.Get();
+        if (!branches.count(node))
+            continue;
+        if (node->HasComponent(type))
+            dest.push_back(node);
+        if (!node->GetChildren().empty())
+            GetChildrenWithComponentInBranches(dest, node, type, branches);
+    }
+}
+
 Node::Node(Context* context) :
     Animatable(context),
     worldTransform_(Matrix3x4::IDENTITY),
@@ -54,6 +74,7 @@ Node::Node(Context* context) :
     enabled_(true),
     enabledPrev_(true),
     networkUpdate_(false),
+    saveDirty_(false),
     parent_(nullptr),
     scene_(nullptr),
     id_(0),
@@ -86,13 +107,15 @@ void Node::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Position", GetPosition, SetPosition, Vector3, Vector3::ZERO, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Rotation", GetRotation, SetRotation, Quaternion, Quaternion::IDENTITY, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Scale", GetScale, SetScale, Vector3, Vector3::ONE, AM_DEFAULT);
-    URHO3D_ATTRIBUTE("Variables", VariantMap, vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
+    URHO3D_ACCESSOR_ATTRIBUTE("Variables", GetVars, SetVars, VariantMap, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     URHO3D_ACCESSOR_ATTRIBUTE("Network Position", GetNetPositionAttr, SetNetPositionAttr, Vector3, Vector3::ZERO,
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
     URHO3D_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, ea::vector<unsigned char>, Variant::emptyBuffer,
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
     URHO3D_ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, ea::vector<unsigned char>, Variant::emptyBuffer,
         AM_NET | AM_NOEDIT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Network Data Components", GetNetDataComponentsAttr, SetNetDataComponentsAttr, ea::vector<unsigned char>,
+        Variant::emptyBuffer, AM_NET | AM_NOEDIT);
 }
 
 bool Node::Serialize(Archive& archive)
@@ -146,27 +169,30 @@ bool Node::Serialize(Archive& archive, ArchiveBlock& block, SceneResolver* resol
     if (!Animatable::Serialize(archive, block))
         return false;
 
-    // Serialize components
-    const unsigned numComponentsToWrite = loading ? 0 : GetNumPersistentComponents();
-    const bool componentsSerialized = SerializeCustomVector(archive, ArchiveBlockType::Array, "components", numComponentsToWrite, components_,
-        [&](unsigned /*index*/, SharedPtr<Component> component, bool loading)
+    // Serialize components. Data components follow the regular ones in the same array
+    Scene* scene = GetScene();
+    const unsigned numDataComponents = loading || !scene ? 0 : scene->GetNumDataComponents(this);
+    const unsigned numComponentsToWrite = loading ? 0 : GetNumPersistentComponents() + numDataComponents;
+    const auto serializeComponent = [&](Component* component, const DataComponentType* dataType)
     {
-        assert(loading || component);
-
-        // Skip temporary components
-        if (component && component->IsTemporary())
-            return true;
+        assert(loading || component || dataType);
 
         // Serialize component
         if (ArchiveBlock componentBlock = archive.OpenSafeUnorderedBlock("component"))
         {
             // Serialize component ID and type
             unsigned componentID = component ? component->GetID() : 0;
-            StringHash componentType = component ? component->GetType() : StringHash{};
-            const ea::string& componentTypeName = component ? component->GetTypeName() : EMPTY_STRING;
+            StringHash componentType = component ? component->GetType() : dataType ? dataType->type_ : StringHash{};
+            const ea::string& componentTypeName = component ? component->GetTypeName() : dataType ? dataType->name_ : EMPTY_STRING;
             SerializeValue(archive, "id", componentID);
             SerializeStringHash(archive, "type", componentType, componentTypeName);
 
+            // Data components are stored in the scene registry
+            if (loading && scene)
+                dataType = scene->GetDataComponentType(componentType);
+            if (dataType)
+                return dataType->serialize_(archive, scene->GetRegistry(), entity_);
+
             // Create component if loading
             if (loading)
             {
@@ -182,7 +208,36 @@ bool Node::Serialize(Archive& archive, ArchiveBlock& block, SceneResolver* resol
             return true;
         }
         return false;
-    });
+    };
+
+    bool componentsSerialized = false;
+    if (ArchiveBlock componentsBlock = archive.OpenArrayBlock("components", numComponentsToWrite))
+    {
+        componentsSerialized = true;
+        if (loading)
+        {
+            for (unsigned index = 0; index < componentsBlock.GetSizeHint() && componentsSerialized; ++index)
+                componentsSerialized = serializeComponent(nullptr, nullptr);
+        }
+        else
+        {
+            // Skip temporary components
+            for (Component* component : components_)
+            {
+                if (!component->IsTemporary())
+                    componentsSerialized = componentsSerialized && serializeComponent(component, nullptr);
+            }
+            for (unsigned index = 0; numDataComponents && index < scene->GetDataComponentTypes().size(); ++index)
+            {
+                const DataComponentType& dataType = scene->GetDataComponentTypes()[index];
+                if (dataType.has_(scene->GetRegistry(), entity_))
+                    componentsSerialized = componentsSerialized && serializeComponent(nullptr, &dataType);
+            }
+        }
+
+        if (!componentsSerialized)
+            archive.SetError("Failed to serialize components");
+    }
 
     if (!componentsSerialized)
         return false;
@@ -430,6 +485,13 @@ void Node::MarkNetworkUpdate()
         scene_->MarkNetworkUpdate(this);
         networkUpdate_ = true;
     }
+    MarkSaveDirty();
+}
+
+void Node::MarkSaveDirty()
+{
+    if (!saveDirty_ && scene_ && scene_->GetSaveTracking())
+        scene_->MarkSaveDirty(this);
 }
 
 void Node::AddReplicationState(NodeReplicationState* state)
@@ -884,6 +946,13 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
+    if (dirty_)
+        return;
+
+    // With the transform system enabled, listeners of the whole subtree are notified in batch on its next update
+    TransformSystem* transformSystem = scene_ ? scene_->GetTransformSystem() : nullptr;
+    const bool notifyListeners = !transformSystem || !transformSystem->MarkDirty(this);
+
     Node *cur = this;
     for (;;)
     {
@@ -899,22 +968,8 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (auto i = cur->listeners_.begin(); i !=
-            cur->listeners_.end();)
-        {
-            Component *c = i->Get();
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.back();
-                cur->listeners_.pop_back();
-            }
-        }
+        if (notifyListeners)
+            cur->NotifyListenersDirty();
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -985,6 +1040,9 @@ void Node::AddChild(Node* node, unsigned index)
     if (scene_ && node->GetScene() != scene_)
         scene_->NodeAdded(node);
 
+    if (TransformSystem* transformSystem = scene_ ? scene_->GetTransformSystem() : nullptr)
+        transformSystem->MarkHierarchyDirty();
+
     node->parent_ = this;
     node->MarkDirty();
     node->MarkNetworkUpdate();
@@ -1289,10 +1347,30 @@ void Node::SetParent(Node* parent)
 
 void Node::SetVar(StringHash key, const Variant& value)
 {
+    if (scene_)
+        scene_->NodeVarChanged(this, key, value);
+
     vars_[key] = value;
     MarkNetworkUpdate();
 }
 
+void Node::SetVars(const VariantMap& vars)
+{
+    if (scene_)
+    {
+        for (auto i = vars_.begin(); i != vars_.end(); ++i)
+        {
+            if (!vars.contains(i->first))
+                scene_->NodeVarChanged(this, i->first, Variant::EMPTY);
+        }
+        for (auto i = vars.begin(); i != vars.end(); ++i)
+            scene_->NodeVarChanged(this, i->first, i->second);
+    }
+
+    vars_ = vars;
+    MarkNetworkUpdate();
+}
+
 void Node::AddListener(Component* component)
 {
     if (!component)
@@ -1409,6 +1487,19 @@ void Node::GetChildrenWithComponent(ea::vector<Node*>& dest, StringHash type, bo
                 dest.push_back(i->Get());
         }
     }
+    else if (scene_ == this && scene_->HasComponentIndex(type))
+    {
+        // Collect the indexed nodes and their ancestors, then walk only those branches to keep the hierarchy order
+        ea::hash_set<const Node*> branches;
+        for (Component* component : scene_->GetComponentIndex(type))
+        {
+            for (const Node* node = component->GetNode(); node && node != this && branches.insert(node).second;
+                node = node->GetParent())
+            {
+            }
+        }
+        GetChildrenWithComponentInBranches(dest, this, type, branches);
+    }
     else
         GetChildrenWithComponentRecursive(dest, type);
 }
@@ -1697,6 +1788,21 @@ const ea::vector<unsigned char>& Node::GetNetParentAttr() const
     return impl_->attrBuffer_.GetBuffer();
 }
 
+void Node::SetNetDataComponentsAttr(const ea::vector<unsigned char>& value)
+{
+    if (Scene* scene = GetScene())
+        scene->LoadDataComponents(this, value);
+}
+
+const ea::vector<unsigned char>& Node::GetNetDataComponentsAttr() const
+{
+    impl_->attrBuffer_.Clear();
+    if (Scene* scene = GetScene())
+        scene->SaveDataComponents(this, impl_->attrBuffer_);
+
+    return impl_->attrBuffer_.GetBuffer();
+}
+
 bool Node::Load(Deserializer& source, SceneResolver& resolver, bool loadChildren, bool rewriteIDs, CreateMode mode)
 {
     // Remove all children and components first in case this is not a fresh load
@@ -2257,6 +2363,25 @@ void Node::UpdateWorldTransform() const
     dirty_ = false;
 }
 
+void Node::NotifyListenersDirty()
+{
+    for (auto i = listeners_.begin(); i != listeners_.end();)
+    {
+        Component *c = i->Get();
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.back();
+            listeners_.pop_back();
+        }
+    }
+}
+
 void Node::RemoveChild(ea::vector<SharedPtr<Node> >::iterator i)
 {
     // Keep a shared pointer to the child about to be removed, to make sure the erase from container completes first. Otherwise
@@ -2365,6 +2490,9 @@ Node* Node::CloneRecursive(Node* parent, SceneResolver& resolver, CreateMode mod
             resolver.AddComponent(component->GetID(), cloneComponent);
     }
 
+    if (scene_)
+        scene_->CopyDataComponents(this, cloneNode);
+
     // Clone child nodes recursively
     for (auto i = children_.begin(); i != children_.end(); ++i)
     {
@@ -2416,7 +2544,12 @@ void Node::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& even
 {
     using namespace AttributeAnimationUpdate;
 
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    // Batched scenes evaluate the queued animations after the event
+    auto* scene = static_cast<Scene*>(eventData[P_SCENE].GetPtr());
+    if (AttributeAnimationSystem* system = scene ? scene->GetAttributeAnimationSystem() : nullptr)
+        system->QueueUpdate(this);
+    else
+        UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
 }
 
 }
@@ -80,6 +80,9 @@ class URHO3D_API Node : public Animatable
     URHO3D_OBJECT(Node, Animatable);
 
     friend class Connection;
+    friend class ParallelSceneLoader;
+    friend class SceneSaveTracker;
+    friend class TransformSystem;
 
 public:
     /// Construct.
@@ -115,6 +118,8 @@ public:
 
     /// Mark for attribute check on the next network update.
     void MarkNetworkUpdate() override;
+    /// Mark changed for the next incremental scene save.
+    void MarkSaveDirty() override;
     /// Add a replication state that is tracking this node.
     virtual void AddReplicationState(NodeReplicationState* state);
 
@@ -334,6 +339,8 @@ public:
     void SetParent(Node* parent);
     /// Set a user variable.
     void SetVar(StringHash key, const Variant& value);
+    /// Set all user variables.
+    void SetVars(const VariantMap& vars);
     /// Add listener component that is notified of node being dirtied. Can either be in the same node or another.
     void AddListener(Component* component);
     /// Remove listener component.
@@ -526,7 +533,7 @@ public:
     void GetChildren(ea::vector<Node*>& dest, bool recursive = false) const;
     /// Return child scene nodes, optionally recursive.
     ea::vector<Node*> GetChildren(bool recursive) const;
-    /// Return child scene nodes with a specific component.
+    /// Return child scene nodes with a specific component. A recursive query on the scene visits only the branches that contain the component if the type is indexed. Recursive results are in depth-first hierarchy order.
     void GetChildrenWithComponent(ea::vector<Node*>& dest, StringHash type, bool recursive = false) const;
     /// Return child scene nodes with a specific component.
     ea::vector<Node*> GetChildrenWithComponent(StringHash type, bool recursive = false) const;
@@ -601,12 +608,16 @@ public:
     void SetNetRotationAttr(const ea::vector<unsigned char>& value);
     /// Set network parent attribute.
     void SetNetParentAttr(const ea::vector<unsigned char>& value);
+    /// Set network data components attribute.
+    void SetNetDataComponentsAttr(const ea::vector<unsigned char>& value);
     /// Return network position attribute.
     const Vector3& GetNetPositionAttr() const;
     /// Return network rotation attribute.
     const ea::vector<unsigned char>& GetNetRotationAttr() const;
     /// Return network parent attribute.
     const ea::vector<unsigned char>& GetNetParentAttr() const;
+    /// Return network data components attribute.
+    const ea::vector<unsigned char>& GetNetDataComponentsAttr() const;
     /// Load components and optionally load child nodes.
     bool Load(Deserializer& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false,
         CreateMode mode = REPLICATED);
@@ -664,6 +675,8 @@ private:
     Component* SafeCreateComponent(const ea::string& typeName, StringHash type, CreateMode mode, unsigned id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components that the world transform is dirty, and remove expired listeners.
+    void NotifyListenersDirty();
     /// Remove child node by iterator.
     void RemoveChild(ea::vector<SharedPtr<Node> >::iterator i);
     /// Return child nodes recursively.
@@ -693,6 +706,8 @@ private:
 protected:
     /// Network update queued flag.
     bool networkUpdate_;
+    /// Save tracking change queued flag.
+    bool saveDirty_;
 
 private:
     /// Parent scene node.
@@ -711,6 +726,8 @@ private:
     Vector3 scale_;
     /// World-space rotation.
     mutable Quaternion worldRotation_;
+    /// Index in the arrays of the scene transform system.
+    unsigned transformIndex_{ M_MAX_UNSIGNED };
     /// Components.
     ea::vector<SharedPtr<Component> > components_;
     /// Child scene nodes.
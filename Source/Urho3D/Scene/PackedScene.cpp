@@ -0,0 +1,561 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/Serializer.h"
+#include "../Scene/Component.h"
+#include "../Scene/Node.h"
+#include "../Scene/PackedScene.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneResolver.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Packed scene format version.
+static const unsigned PACKED_SCENE_VERSION = 1;
+/// Format flag: component values are grouped by type after the node hierarchy.
+static const unsigned PACKED_SCENE_GROUP_COMPONENTS = 0x1;
+
+/// Minimum encoded size of a schema: empty type name and field count.
+static const unsigned MIN_SCHEMA_SIZE = 2;
+/// Minimum encoded size of a schema field: empty name and type.
+static const unsigned MIN_FIELD_SIZE = 2;
+/// Minimum encoded size of a node: ID, parent index, schema index and component count.
+static const unsigned MIN_NODE_SIZE = 7;
+/// Minimum encoded size of a component: schema index and ID.
+static const unsigned MIN_COMPONENT_SIZE = 5;
+
+/// Return whether the rest of the source can hold the given number of elements. Used to reject corrupted counts before allocating.
+static bool CheckCount(Deserializer& source, unsigned count, unsigned minSize)
+{
+    return (unsigned long long)count * minSize <= source.GetSize() - source.GetPosition();
+}
+
+/// Storage for one raw attribute value.
+union RawAttributeValue
+{
+    /// Largest raw value.
+    Matrix4 matrix_;
+    /// Raw bytes.
+    unsigned char data_[sizeof(Matrix4)];
+
+    /// Construct uninitialized.
+    RawAttributeValue() { }
+};
+
+PackedSceneWriter::PackedSceneWriter(bool groupComponents) :
+    groupComponents_(groupComponents)
+{
+}
+
+PackedSceneWriter::~PackedSceneWriter() = default;
+
+bool PackedSceneWriter::Write(Serializer& dest, const Node* node)
+{
+    if (!node)
+        return false;
+
+    schemas_.clear();
+    typeSchemas_.clear();
+    instanceSchemas_.clear();
+    nodes_.clear();
+    componentSchemas_.clear();
+
+    // Collect first so that all schemas can be written before the values
+    CollectNode(node, 0);
+
+    dest.WriteVLE(PACKED_SCENE_VERSION);
+
+    dest.WriteVLE(schemas_.size());
+    for (const Schema& schema : schemas_)
+    {
+        dest.WriteString(schema.typeName_);
+        unsigned numFields = 0;
+        if (schema.attributes_)
+        {
+            for (const AttributeInfo& attr : *schema.attributes_)
+            {
+                if (attr.ShouldSave())
+                    ++numFields;
+            }
+        }
+        dest.WriteVLE(numFields);
+        if (schema.attributes_)
+        {
+            for (const AttributeInfo& attr : *schema.attributes_)
+            {
+                if (!attr.ShouldSave())
+                    continue;
+                dest.WriteString(attr.name_);
+                dest.WriteUByte(static_cast<unsigned char>(attr.type_));
+            }
+        }
+    }
+
+    // Layout flags come with the node hierarchy, so that the schemas can be read separately
+    dest.WriteVLE(groupComponents_ ? PACKED_SCENE_GROUP_COMPONENTS : 0);
+    dest.WriteVLE(nodes_.size());
+    unsigned componentIndex = 0;
+    for (const NodeEntry& entry : nodes_)
+    {
+        dest.WriteUInt(entry.node_->GetID());
+        dest.WriteVLE(entry.parent_);
+        dest.WriteVLE(entry.schema_);
+        if (!WriteValues(dest, entry.node_))
+            return false;
+
+        dest.WriteVLE(entry.node_->GetNumPersistentComponents());
+        for (Component* component : entry.node_->GetComponents())
+        {
+            if (component->IsTemporary())
+                continue;
+
+            dest.WriteVLE(componentSchemas_[componentIndex++]);
+            dest.WriteUInt(component->GetID());
+            if (!groupComponents_ && !WriteValues(dest, component))
+                return false;
+        }
+    }
+
+    if (groupComponents_)
+    {
+        unsigned numColumns = 0;
+        for (const Schema& schema : schemas_)
+        {
+            if (!schema.components_.empty())
+                ++numColumns;
+        }
+
+        dest.WriteVLE(numColumns);
+        for (unsigned i = 0; i < schemas_.size(); ++i)
+        {
+            const Schema& schema = schemas_[i];
+            if (schema.components_.empty())
+                continue;
+
+            dest.WriteVLE(i);
+            dest.WriteVLE(schema.components_.size());
+            for (const Component* component : schema.components_)
+            {
+                if (!WriteValues(dest, component))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void PackedSceneWriter::CollectNode(const Node* node, unsigned parentIndex)
+{
+    const unsigned nodeIndex = nodes_.size();
+    nodes_.push_back({ node, parentIndex, GetSchemaIndex(node) });
+
+    for (Component* component : node->GetComponents())
+    {
+        if (component->IsTemporary())
+            continue;
+
+        const unsigned schemaIndex = GetSchemaIndex(component);
+        componentSchemas_.push_back(schemaIndex);
+        if (groupComponents_)
+            schemas_[schemaIndex].components_.push_back(component);
+    }
+
+    for (Node* child : node->GetChildren())
+    {
+        if (!child->IsTemporary())
+            CollectNode(child, nodeIndex);
+    }
+}
+
+unsigned PackedSceneWriter::GetSchemaIndex(const Serializable* object)
+{
+    const StringHash type = object->GetType();
+    const ea::vector<AttributeInfo>* attributes = object->GetAttributes();
+
+    // Objects using the attributes registered for their type share one schema
+    if (attributes == object->GetContext()->GetAttributes(type))
+    {
+        auto it = typeSchemas_.find(type);
+        if (it != typeSchemas_.end())
+            return it->second;
+
+        const unsigned index = schemas_.size();
+        schemas_.push_back({ object->GetTypeName(), attributes, {} });
+        typeSchemas_[type] = index;
+        return index;
+    }
+
+    // Objects with instance-specific attributes share a schema only if the saved attributes are the same
+    ea::string signature = object->GetTypeName();
+    if (attributes)
+    {
+        for (const AttributeInfo& attr : *attributes)
+        {
+            if (!attr.ShouldSave())
+                continue;
+            signature += '\n';
+            signature += attr.name_;
+            signature += ':';
+            signature += ea::to_string(static_cast<unsigned>(attr.type_));
+        }
+    }
+
+    auto it = instanceSchemas_.find(signature);
+    if (it != instanceSchemas_.end())
+        return it->second;
+
+    const unsigned index = schemas_.size();
+    schemas_.push_back({ object->GetTypeName(), attributes, {} });
+    instanceSchemas_[signature] = index;
+    return index;
+}
+
+bool PackedSceneWriter::WriteValues(Serializer& dest, const Serializable* object) const
+{
+    const ea::vector<AttributeInfo>* attributes = object->GetAttributes();
+    if (!attributes)
+        return true;
+
+    RawAttributeValue rawValue;
+    Variant value;
+
+    for (const AttributeInfo& attr : *attributes)
+    {
+        if (!attr.ShouldSave())
+            continue;
+
+        const unsigned rawSize = GetRawAttributeSize(attr.type_);
+        if (rawSize && object->GetAttributeRaw(attr, rawValue.data_))
+        {
+            if (dest.Write(rawValue.data_, rawSize) != rawSize)
+            {
+                URHO3D_LOGERROR("Could not save " + object->GetTypeName() + ", writing to stream failed");
+                return false;
+            }
+            continue;
+        }
+
+        object->OnGetAttribute(attr, value);
+        if (value.GetType() != attr.type_)
+        {
+            URHO3D_LOGERROR("Could not save " + object->GetTypeName() + ", attribute " + attr.name_ + " has unexpected type " + value.GetTypeName());
+            return false;
+        }
+
+        if (!dest.WriteVariantData(value))
+        {
+            URHO3D_LOGERROR("Could not save " + object->GetTypeName() + ", writing to stream failed");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+PackedSceneReader::PackedSceneReader(Context* context) :
+    context_(context),
+    resources_(nullptr)
+{
+}
+
+PackedSceneReader::~PackedSceneReader() = default;
+
+bool PackedSceneReader::Read(Deserializer& source, Node* node, SceneResolver& resolver)
+{
+    if (!node)
+        return false;
+
+    resources_ = nullptr;
+    return ReadSchemas(source) && ReadNodes(source, node, &resolver);
+}
+
+bool PackedSceneReader::ReadResources(Deserializer& source, ea::vector<ResourceRef>& dest)
+{
+    resources_ = &dest;
+    const bool success = ReadSchemas(source) && ReadNodes(source, nullptr, nullptr);
+    resources_ = nullptr;
+    return success;
+}
+
+bool PackedSceneReader::ReadSchemas(Deserializer& source)
+{
+    schemas_.clear();
+
+    const unsigned version = source.ReadVLE();
+    if (version != PACKED_SCENE_VERSION)
+    {
+        URHO3D_LOGERROR("Unsupported packed scene version " + ea::to_string(version) + " in " + source.GetName());
+        return false;
+    }
+
+    const unsigned numSchemas = source.ReadVLE();
+    if (!CheckCount(source, numSchemas, MIN_SCHEMA_SIZE))
+    {
+        URHO3D_LOGERROR("Corrupted schema data in " + source.GetName());
+        return false;
+    }
+
+    schemas_.resize(numSchemas);
+    for (Schema& schema : schemas_)
+    {
+        schema.typeName_ = source.ReadString();
+        schema.type_ = StringHash(schema.typeName_);
+        schema.known_ = !context_->GetTypeName(schema.type_).empty();
+        schema.attributes_ = context_->GetAttributes(schema.type_);
+
+        const unsigned numFields = source.ReadVLE();
+        if (!CheckCount(source, numFields, MIN_FIELD_SIZE))
+        {
+            URHO3D_LOGERROR("Corrupted schema data of " + schema.typeName_ + " in " + source.GetName());
+            return false;
+        }
+
+        schema.fields_.resize(numFields);
+        for (Field& field : schema.fields_)
+        {
+            field.name_ = source.ReadString();
+            field.type_ = static_cast<VariantType>(source.ReadUByte());
+            field.rawSize_ = GetRawAttributeSize(field.type_);
+            field.attr_ = nullptr;
+
+            if (field.type_ == VAR_NONE || field.type_ >= MAX_VAR_TYPES)
+            {
+                URHO3D_LOGERROR("Invalid type of attribute " + field.name_ + " of " + schema.typeName_ + " in " + source.GetName());
+                return false;
+            }
+
+            if (schema.attributes_)
+            {
+                for (const AttributeInfo& attr : *schema.attributes_)
+                {
+                    if (attr.ShouldLoad() && attr.type_ == field.type_ && attr.name_ == field.name_)
+                    {
+                        field.attr_ = &attr;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return !source.IsEof();
+}
+
+bool PackedSceneReader::ReadNodes(Deserializer& source, Node* node, SceneResolver* resolver)
+{
+    const unsigned flags = source.ReadVLE();
+    const bool groupComponents = !!(flags & PACKED_SCENE_GROUP_COMPONENTS);
+
+    const unsigned numNodes = source.ReadVLE();
+    if (!CheckCount(source, numNodes, MIN_NODE_SIZE))
+    {
+        URHO3D_LOGERROR("Corrupted node data in " + source.GetName());
+        return false;
+    }
+
+    ea::vector<Node*> nodes(numNodes);
+    ea::vector<ea::vector<Component*> > columns(groupComponents ? schemas_.size() : 0);
+    ea::vector<bool> warned(schemas_.size());
+
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        const unsigned nodeID = source.ReadUInt();
+        const unsigned parentIndex = source.ReadVLE();
+        const unsigned schemaIndex = source.ReadVLE();
+        if ((i > 0 && parentIndex >= i) || schemaIndex >= schemas_.size() || source.IsEof())
+        {
+            URHO3D_LOGERROR("Corrupted node data in " + source.GetName());
+            return false;
+        }
+
+        Node* newNode = node;
+        if (node && i > 0)
+            newNode = nodes[parentIndex]->CreateChild(nodeID, Scene::IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
+        nodes[i] = newNode;
+        if (resolver)
+            resolver->AddNode(nodeID, newNode);
+
+        if (!ReadValues(source, schemas_[schemaIndex], newNode))
+            return false;
+
+        const unsigned numComponents = source.ReadVLE();
+        if (!CheckCount(source, numComponents, MIN_COMPONENT_SIZE))
+        {
+            URHO3D_LOGERROR("Corrupted component data in " + source.GetName());
+            return false;
+        }
+
+        for (unsigned j = 0; j < numComponents; ++j)
+        {
+            const unsigned compSchemaIndex = source.ReadVLE();
+            const unsigned compID = source.ReadUInt();
+            if (compSchemaIndex >= schemas_.size())
+            {
+                URHO3D_LOGERROR("Corrupted component data in " + source.GetName());
+                return false;
+            }
+
+            const Schema& schema = schemas_[compSchemaIndex];
+            Component* newComponent = nullptr;
+            if (newNode)
+            {
+                if (schema.known_)
+                {
+                    newComponent = newNode->CreateComponent(schema.type_, Scene::IsReplicatedID(compID) ? REPLICATED : LOCAL, compID);
+                    if (newComponent && resolver)
+                        resolver->AddComponent(compID, newComponent);
+                }
+                else if (!warned[compSchemaIndex])
+                {
+                    URHO3D_LOGWARNING("Component type " + schema.typeName_ + " not known, skipping its components");
+                    warned[compSchemaIndex] = true;
+                }
+            }
+
+            if (groupComponents)
+                columns[compSchemaIndex].push_back(newComponent);
+            else if (!ReadValues(source, schema, newComponent))
+                return false;
+        }
+    }
+
+    if (!groupComponents)
+        return true;
+
+    const unsigned numColumns = source.ReadVLE();
+    for (unsigned i = 0; i < numColumns; ++i)
+    {
+        const unsigned schemaIndex = source.ReadVLE();
+        const unsigned count = source.ReadVLE();
+        if (schemaIndex >= schemas_.size() || count != columns[schemaIndex].size())
+        {
+            URHO3D_LOGERROR("Corrupted component data in " + source.GetName());
+            return false;
+        }
+
+        const Schema& schema = schemas_[schemaIndex];
+        for (Component* component : columns[schemaIndex])
+        {
+            if (!ReadValues(source, schema, component))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool PackedSceneReader::ReadValues(Deserializer& source, const Schema& schema, Serializable* object)
+{
+    // Objects with instance-specific attributes are matched by name for each value
+    const ea::vector<AttributeInfo>* attributes = object ? object->GetAttributes() : nullptr;
+    const bool registered = attributes == schema.attributes_;
+
+    RawAttributeValue rawValue;
+    bool success = true;
+
+    if (object)
+        object->BeginAttributeLoad();
+
+    for (const Field& field : schema.fields_)
+    {
+        const AttributeInfo* attr = nullptr;
+        if (object)
+        {
+            if (registered)
+                attr = field.attr_;
+            else
+            {
+                attributes = object->GetAttributes();
+                if (attributes)
+                {
+                    for (const AttributeInfo& info : *attributes)
+                    {
+                        if (info.ShouldLoad() && info.type_ == field.type_ && info.name_ == field.name_)
+                        {
+                            attr = &info;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (field.rawSize_)
+        {
+            if (source.Read(rawValue.data_, field.rawSize_) != field.rawSize_)
+            {
+                URHO3D_LOGERROR("Could not load " + schema.typeName_ + ", stream not open or at end");
+                success = false;
+                break;
+            }
+
+            if (attr && !object->SetAttributeRaw(*attr, rawValue.data_))
+            {
+                MemoryBuffer valueBuffer(rawValue.data_, field.rawSize_);
+                object->OnSetAttribute(*attr, valueBuffer.ReadVariant(field.type_));
+            }
+        }
+        else
+        {
+            if (source.IsEof())
+            {
+                URHO3D_LOGERROR("Could not load " + schema.typeName_ + ", stream not open or at end");
+                success = false;
+                break;
+            }
+
+            const Variant value = source.ReadVariant(field.type_, context_);
+            if (attr)
+                object->OnSetAttribute(*attr, value);
+
+            if (resources_)
+            {
+                if (field.type_ == VAR_RESOURCEREF)
+                    resources_->push_back(value.GetResourceRef());
+                else if (field.type_ == VAR_RESOURCEREFLIST)
+                {
+                    const ResourceRefList& refList = value.GetResourceRefList();
+                    for (const ea::string& name : refList.names_)
+                        resources_->push_back(ResourceRef(refList.type_, name));
+                }
+            }
+        }
+    }
+
+    if (object)
+        object->EndAttributeLoad();
+
+    return success;
+}
+
+}
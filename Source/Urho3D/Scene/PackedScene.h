@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/unordered_map.h>
+
+#include "../Core/Attribute.h"
+
+namespace Urho3D
+{
+
+class Component;
+class Deserializer;
+class Node;
+class SceneResolver;
+class Serializable;
+class Serializer;
+
+/// Writes node hierarchies in the packed binary scene format. The attribute schema of each object type is written once, followed by attribute values without type tags.
+class URHO3D_API PackedSceneWriter
+{
+public:
+    /// Construct. Optionally write component attribute values grouped by component type after the node hierarchy.
+    explicit PackedSceneWriter(bool groupComponents = true);
+    /// Destruct.
+    ~PackedSceneWriter();
+
+    /// Write a node hierarchy without file identifier. Temporary nodes and components are skipped. Return true if successful.
+    bool Write(Serializer& dest, const Node* node);
+
+private:
+    /// Collected node.
+    struct NodeEntry
+    {
+        /// Node.
+        const Node* node_;
+        /// Parent node index.
+        unsigned parent_;
+        /// Schema index.
+        unsigned schema_;
+    };
+
+    /// Object type schema.
+    struct Schema
+    {
+        /// Type name.
+        ea::string typeName_;
+        /// Attribute descriptions.
+        const ea::vector<AttributeInfo>* attributes_;
+        /// Components of this schema in write order, when grouped by type.
+        ea::vector<const Component*> components_;
+    };
+
+    /// Collect a node, its components and children.
+    void CollectNode(const Node* node, unsigned parentIndex);
+    /// Return schema index for an object, adding a new schema as necessary.
+    unsigned GetSchemaIndex(const Serializable* object);
+    /// Write saved attribute values of an object.
+    bool WriteValues(Serializer& dest, const Serializable* object) const;
+
+    /// Whether to group component values by type.
+    bool groupComponents_;
+    /// Schemas.
+    ea::vector<Schema> schemas_;
+    /// Schema indices of types with registered attributes.
+    ea::unordered_map<StringHash, unsigned> typeSchemas_;
+    /// Schema indices of objects with instance-specific attributes, keyed by attribute signature.
+    ea::unordered_map<ea::string, unsigned> instanceSchemas_;
+    /// Nodes in depth-first order.
+    ea::vector<NodeEntry> nodes_;
+    /// Schema indices of the components of all nodes in write order.
+    ea::vector<unsigned> componentSchemas_;
+};
+
+/// Reads node hierarchies written by PackedSceneWriter. Attributes are matched by name, so types may gain or lose attributes between saving and loading. POD attribute values are set without constructing a Variant when the attribute accessor supports it.
+class URHO3D_API PackedSceneReader
+{
+public:
+    /// Construct.
+    explicit PackedSceneReader(Context* context);
+    /// Destruct.
+    ~PackedSceneReader();
+
+    /// Read a node hierarchy into an empty node, which receives the attributes of the root. Created objects are registered to the resolver. Return true if successful.
+    bool Read(Deserializer& source, Node* node, SceneResolver& resolver);
+    /// Read only the resource references of a node hierarchy without creating objects. Return true if successful.
+    bool ReadResources(Deserializer& source, ea::vector<ResourceRef>& dest);
+
+private:
+    /// Attribute of a schema.
+    struct Field
+    {
+        /// Name.
+        ea::string name_;
+        /// Type.
+        VariantType type_;
+        /// Raw data size, or 0 if stored as variant data.
+        unsigned rawSize_;
+        /// Matching registered attribute, or null if not found.
+        const AttributeInfo* attr_;
+    };
+
+    /// Object type schema.
+    struct Schema
+    {
+        /// Type.
+        StringHash type_;
+        /// Type name.
+        ea::string typeName_;
+        /// Whether the type can be created.
+        bool known_;
+        /// Registered attribute descriptions.
+        const ea::vector<AttributeInfo>* attributes_;
+        /// Fields in stored order.
+        ea::vector<Field> fields_;
+    };
+
+    /// Read schemas. Return true if successful.
+    bool ReadSchemas(Deserializer& source);
+    /// Read node hierarchy. Objects are created only if a root node is given. Return true if successful.
+    bool ReadNodes(Deserializer& source, Node* node, SceneResolver* resolver);
+    /// Read values of one object and apply them if the object exists. Return true if successful.
+    bool ReadValues(Deserializer& source, const Schema& schema, Serializable* object);
+
+    /// Context.
+    Context* context_;
+    /// Schemas.
+    ea::vector<Schema> schemas_;
+    /// Resource reference destination when reading only resources.
+    ea::vector<ResourceRef>* resources_;
+};
+
+}
@@ -0,0 +1,808 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../Resource/JSONValue.h"
+#include "../Resource/XMLFile.h"
+#include "../Scene/Component.h"
+#include "../Scene/Node.h"
+#include "../Scene/ParallelSceneLoader.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneResolver.h"
+
+#include <PugiXml/pugixml.hpp>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Number of consecutive nodes decoded by one work item.
+static const unsigned NODES_PER_BATCH = 256;
+
+/// Skip a null-terminated string in binary data.
+static void SkipString(MemoryBuffer& source)
+{
+    const unsigned char* data = source.GetData();
+    const unsigned size = source.GetSize();
+    unsigned position = source.GetPosition();
+    while (position < size && data[position])
+        ++position;
+    source.Seek(Min(position + 1, size));
+}
+
+/// Skip binary variant data of the given type without constructing the value when possible.
+static void SkipVariantData(MemoryBuffer& source, VariantType type, Context* context)
+{
+    if (const unsigned rawSize = GetRawAttributeSize(type))
+    {
+        source.Seek(source.GetPosition() + rawSize);
+        return;
+    }
+
+    switch (type)
+    {
+    case VAR_STRING:
+        SkipString(source);
+        break;
+
+    case VAR_BUFFER:
+    {
+        const unsigned size = source.ReadVLE();
+        source.Seek(source.GetPosition() + size);
+        break;
+    }
+
+    case VAR_VOIDPTR:
+    case VAR_PTR:
+        source.ReadUInt();
+        break;
+
+    case VAR_RESOURCEREF:
+        source.ReadStringHash();
+        SkipString(source);
+        break;
+
+    case VAR_RESOURCEREFLIST:
+    {
+        source.ReadStringHash();
+        const unsigned numNames = source.ReadVLE();
+        for (unsigned i = 0; i < numNames && !source.IsEof(); ++i)
+            SkipString(source);
+        break;
+    }
+
+    case VAR_STRINGVECTOR:
+    {
+        const unsigned numStrings = source.ReadVLE();
+        for (unsigned i = 0; i < numStrings && !source.IsEof(); ++i)
+            SkipString(source);
+        break;
+    }
+
+    case VAR_VARIANTVECTOR:
+    {
+        const unsigned numValues = source.ReadVLE();
+        for (unsigned i = 0; i < numValues && !source.IsEof(); ++i)
+            SkipVariantData(source, (VariantType)source.ReadUByte(), context);
+        break;
+    }
+
+    case VAR_VARIANTMAP:
+    {
+        const unsigned numValues = source.ReadVLE();
+        for (unsigned i = 0; i < numValues && !source.IsEof(); ++i)
+        {
+            source.ReadStringHash();
+            SkipVariantData(source, (VariantType)source.ReadUByte(), context);
+        }
+        break;
+    }
+
+    default:
+        source.ReadVariant(type, context);
+        break;
+    }
+}
+
+/// Return enum attribute value by name, or empty if not found.
+static Variant GetEnumValue(const AttributeInfo& attr, const ea::string& name)
+{
+    int enumValue = 0;
+    for (const char** enumPtr = attr.enumNames_; *enumPtr; ++enumPtr, ++enumValue)
+    {
+        if (!name.comparei(*enumPtr))
+            return enumValue;
+    }
+
+    URHO3D_LOGWARNING("Unknown enum value " + name + " in attribute " + attr.name_);
+    return Variant::EMPTY;
+}
+
+static Variant GetXMLVariantValue(const pugi::xml_node& element, VariantType type);
+
+/// Read a variant with its type name from an XML element.
+static Variant GetXMLVariant(const pugi::xml_node& element)
+{
+    return GetXMLVariantValue(element, Variant::GetTypeFromName(element.attribute("type").value()));
+}
+
+/// Read a variant from an XML element like XMLElement::GetVariantValue() does, without accessing the XML file object. Custom values are not supported.
+static Variant GetXMLVariantValue(const pugi::xml_node& element, VariantType type)
+{
+    switch (type)
+    {
+    case VAR_RESOURCEREF:
+    {
+        ResourceRef ret;
+        const ea::vector<ea::string> values = ea::string(element.attribute("value").value()).split(';');
+        if (values.size() == 2)
+        {
+            ret.type_ = values[0];
+            ret.name_ = values[1];
+        }
+        return ret;
+    }
+
+    case VAR_RESOURCEREFLIST:
+    {
+        ResourceRefList ret;
+        const ea::vector<ea::string> values = ea::string(element.attribute("value").value()).split(';', true);
+        if (values.size() >= 1)
+        {
+            ret.type_ = values[0];
+            ret.names_.resize(values.size() - 1);
+            for (unsigned i = 1; i < values.size(); ++i)
+                ret.names_[i - 1] = values[i];
+        }
+        return ret;
+    }
+
+    case VAR_VARIANTVECTOR:
+    {
+        VariantVector ret;
+        for (pugi::xml_node child = element.child("variant"); child; child = child.next_sibling("variant"))
+            ret.push_back(GetXMLVariant(child));
+        return ret;
+    }
+
+    case VAR_STRINGVECTOR:
+    {
+        StringVector ret;
+        for (pugi::xml_node child = element.child("string"); child; child = child.next_sibling("string"))
+            ret.push_back(child.attribute("value").value());
+        return ret;
+    }
+
+    case VAR_VARIANTMAP:
+    {
+        VariantMap ret;
+        for (pugi::xml_node child = element.child("variant"); child; child = child.next_sibling("variant"))
+        {
+            // Accept also names instead of hashes, as in manually edited maps
+            if (pugi::xml_attribute name = child.attribute("name"))
+                ret[StringHash(name.value())] = GetXMLVariant(child);
+            else if (pugi::xml_attribute hash = child.attribute("hash"))
+                ret[StringHash(ToUInt(hash.value()))] = GetXMLVariant(child);
+        }
+        return ret;
+    }
+
+    default:
+    {
+        Variant ret;
+        ret.FromString(type, element.attribute("value").value());
+        return ret;
+    }
+    }
+}
+
+ParallelSceneLoader::ParallelSceneLoader(Node* parent, unsigned priority) :
+    context_(parent->GetContext()),
+    parent_(parent),
+    workQueue_(parent->GetSubsystem<WorkQueue>()),
+    priority_(priority),
+    format_(SOURCE_NONE),
+    nextNode_(0)
+{
+    // Node type information is always first
+    GetTypeInfoIndex(Node::GetTypeStatic(), Node::GetTypeNameStatic());
+}
+
+ParallelSceneLoader::~ParallelSceneLoader()
+{
+    // Work items refer to the batches, so they must not run after this
+    for (auto& batch : batches_)
+    {
+        if (!batch->item_ || !workQueue_ || batch->decoded_.load(std::memory_order_acquire))
+            continue;
+        if (workQueue_->RemoveWorkItem(batch->item_))
+            continue;
+        WaitForDecoded(*batch);
+    }
+}
+
+bool ParallelSceneLoader::StartBinary(Deserializer& source)
+{
+    if (format_ != SOURCE_NONE)
+    {
+        URHO3D_LOGERROR("Parallel scene loader already started");
+        return false;
+    }
+
+    // Copy the rest of the data so that it can be decoded from multiple threads
+    const unsigned startPosition = source.GetPosition();
+    const unsigned size = source.GetSize() - startPosition;
+    buffer_.resize(size);
+    if (!size || source.Read(buffer_.data(), size) != size)
+    {
+        URHO3D_LOGERROR("Could not load child nodes from " + source.GetName() + ", stream not open or at end");
+        return false;
+    }
+
+    format_ = SOURCE_BINARY;
+
+    MemoryBuffer data(buffer_);
+    if (!SplitBinary(data, M_MAX_UNSIGNED))
+    {
+        URHO3D_LOGERROR("Corrupted node data in " + source.GetName());
+        nodes_.clear();
+        return false;
+    }
+
+    // Leave the source after the child nodes like a sequential load would
+    source.Seek(startPosition + data.GetPosition());
+
+    StartDecoding();
+    return true;
+}
+
+bool ParallelSceneLoader::StartXML(const XMLElement& source)
+{
+    if (format_ != SOURCE_NONE)
+    {
+        URHO3D_LOGERROR("Parallel scene loader already started");
+        return false;
+    }
+    if (source.IsNull())
+    {
+        URHO3D_LOGERROR("Could not load child nodes, null source element");
+        return false;
+    }
+
+    format_ = SOURCE_XML;
+    xmlFile_ = source.GetFile();
+
+    SplitXML(source.GetNode(), M_MAX_UNSIGNED);
+    StartDecoding();
+    return true;
+}
+
+bool ParallelSceneLoader::StartJSON(const JSONValue& source)
+{
+    if (format_ != SOURCE_NONE)
+    {
+        URHO3D_LOGERROR("Parallel scene loader already started");
+        return false;
+    }
+    if (!source.IsObject())
+    {
+        URHO3D_LOGERROR("Could not load child nodes, JSON source element is not an object");
+        return false;
+    }
+
+    format_ = SOURCE_JSON;
+
+    SplitJSON(source, M_MAX_UNSIGNED);
+    StartDecoding();
+    return true;
+}
+
+bool ParallelSceneLoader::CreateNextNode(SceneResolver& resolver)
+{
+    if (IsFinished())
+        return true;
+
+    NodeEntry& entry = nodes_[nextNode_];
+    Batch& batch = *batches_[entry.batch_];
+    WaitForBatch(batch);
+
+    Node* parent = entry.parent_ == M_MAX_UNSIGNED ? parent_.Get() : nodes_[entry.parent_].node_.Get();
+    const bool success = !parent || CreateNode(entry, batch, parent, resolver);
+
+    // Free the decoded values as soon as the batch has been created
+    ++nextNode_;
+    if (nextNode_ == batch.firstNode_ + batch.numNodes_)
+        ea::vector<DecodedValue>().swap(batch.values_);
+
+    return success;
+}
+
+bool ParallelSceneLoader::CreateNodes(SceneResolver& resolver)
+{
+    while (!IsFinished())
+    {
+        if (!CreateNextNode(resolver))
+            return false;
+    }
+
+    return true;
+}
+
+bool ParallelSceneLoader::IsNextNodePending() const
+{
+    if (IsFinished())
+        return false;
+
+    // Batches without a work item are decoded on the main thread when needed
+    const Batch& batch = *batches_[nodes_[nextNode_].batch_];
+    return batch.item_ && !batch.decoded_.load(std::memory_order_acquire);
+}
+
+bool ParallelSceneLoader::SplitBinary(MemoryBuffer& source, unsigned parentIndex)
+{
+    const ea::vector<AttributeInfo>* nodeAttributes = types_[0].attributes_;
+
+    const unsigned numChildren = source.ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (source.IsEof())
+            return false;
+
+        const unsigned index = nodes_.size();
+        nodes_.emplace_back();
+        NodeEntry& entry = nodes_.back();
+        entry.id_ = source.ReadUInt();
+        entry.parent_ = parentIndex;
+        entry.source_.offset_ = source.GetPosition();
+
+        if (nodeAttributes)
+        {
+            for (const AttributeInfo& attr : *nodeAttributes)
+            {
+                if (!attr.ShouldLoad())
+                    continue;
+                if (source.IsEof())
+                    return false;
+                SkipVariantData(source, attr.type_, context_);
+            }
+        }
+        entry.source_.size_ = source.GetPosition() - entry.source_.offset_;
+
+        // Components are stored in separate buffers, which makes them cheap to skip
+        entry.firstComponent_ = components_.size();
+        entry.numComponents_ = source.ReadVLE();
+        for (unsigned j = 0; j < entry.numComponents_; ++j)
+        {
+            ComponentEntry compEntry{};
+            compEntry.source_.size_ = source.ReadVLE();
+            compEntry.source_.offset_ = source.GetPosition();
+            if (compEntry.source_.size_ < sizeof(unsigned) * 2 || compEntry.source_.offset_ + compEntry.source_.size_ > source.GetSize())
+                return false;
+
+            const StringHash compType = source.ReadStringHash();
+            compEntry.id_ = source.ReadUInt();
+            compEntry.typeInfo_ = GetTypeInfoIndex(compType, EMPTY_STRING);
+            source.Seek(compEntry.source_.offset_ + compEntry.source_.size_);
+            components_.push_back(compEntry);
+        }
+
+        if (!SplitBinary(source, index))
+            return false;
+    }
+
+    return true;
+}
+
+void ParallelSceneLoader::SplitXML(pugi::xml_node_struct* source, unsigned parentIndex)
+{
+    for (pugi::xml_node child = pugi::xml_node(source).child("node"); child; child = child.next_sibling("node"))
+    {
+        const unsigned index = nodes_.size();
+        nodes_.emplace_back();
+        NodeEntry& entry = nodes_.back();
+        entry.id_ = ToUInt(child.attribute("id").value());
+        entry.parent_ = parentIndex;
+        entry.source_.xmlNode_ = child.internal_object();
+
+        entry.firstComponent_ = components_.size();
+        for (pugi::xml_node compElem = child.child("component"); compElem; compElem = compElem.next_sibling("component"))
+        {
+            const ea::string typeName = compElem.attribute("type").value();
+
+            ComponentEntry compEntry{};
+            compEntry.source_.xmlNode_ = compElem.internal_object();
+            compEntry.id_ = ToUInt(compElem.attribute("id").value());
+            compEntry.typeInfo_ = GetTypeInfoIndex(StringHash(typeName), typeName);
+            components_.push_back(compEntry);
+        }
+        entry.numComponents_ = components_.size() - entry.firstComponent_;
+
+        SplitXML(child.internal_object(), index);
+    }
+}
+
+void ParallelSceneLoader::SplitJSON(const JSONValue& source, unsigned parentIndex)
+{
+    const JSONArray& childrenArray = source.Get("children").GetArray();
+    for (const JSONValue& childValue : childrenArray)
+    {
+        const unsigned index = nodes_.size();
+        nodes_.emplace_back();
+        NodeEntry& entry = nodes_.back();
+        entry.id_ = childValue.Get("id").GetUInt();
+        entry.parent_ = parentIndex;
+        entry.source_.jsonValue_ = &childValue;
+
+        const JSONArray& componentsArray = childValue.Get("components").GetArray();
+        entry.firstComponent_ = components_.size();
+        entry.numComponents_ = componentsArray.size();
+        for (const JSONValue& compValue : componentsArray)
+        {
+            const ea::string& typeName = compValue.Get("type").GetString();
+
+            ComponentEntry compEntry{};
+            compEntry.source_.jsonValue_ = &compValue;
+            compEntry.id_ = compValue.Get("id").GetUInt();
+            compEntry.typeInfo_ = GetTypeInfoIndex(StringHash(typeName), typeName);
+            components_.push_back(compEntry);
+        }
+
+        SplitJSON(childValue, index);
+    }
+}
+
+unsigned ParallelSceneLoader::GetTypeInfoIndex(StringHash type, const ea::string& typeName)
+{
+    auto it = typeIndices_.find(type);
+    if (it != typeIndices_.end())
+        return it->second;
+
+    TypeInfo info;
+    info.type_ = type;
+    info.typeName_ = typeName;
+    info.attributes_ = context_->GetAttributes(type);
+
+    // Unknown types become UnknownComponents, and custom-typed values create objects while being decoded
+    info.decodable_ = !context_->GetTypeName(type).empty();
+    if (info.decodable_ && info.attributes_)
+    {
+        for (const AttributeInfo& attr : *info.attributes_)
+        {
+            if (attr.ShouldLoad() && attr.type_ == VAR_CUSTOM)
+            {
+                info.decodable_ = false;
+                break;
+            }
+        }
+    }
+
+    const unsigned index = types_.size();
+    types_.push_back(info);
+    typeIndices_[type] = index;
+    return index;
+}
+
+void ParallelSceneLoader::StartDecoding()
+{
+    const bool threaded = workQueue_ && workQueue_->GetNumThreads() > 0;
+
+    for (unsigned firstNode = 0; firstNode < nodes_.size(); firstNode += NODES_PER_BATCH)
+    {
+        const unsigned batchIndex = batches_.size();
+        batches_.emplace_back(new Batch());
+        Batch* batch = batches_.back().get();
+        batch->firstNode_ = firstNode;
+        batch->numNodes_ = Min(NODES_PER_BATCH, (unsigned)nodes_.size() - firstNode);
+        for (unsigned i = firstNode; i < firstNode + batch->numNodes_; ++i)
+            nodes_[i].batch_ = batchIndex;
+
+        if (threaded)
+            batch->item_ = workQueue_->AddWorkItem([this, batch]() { DecodeBatch(*batch); }, priority_);
+    }
+}
+
+void ParallelSceneLoader::DecodeBatch(Batch& batch)
+{
+    for (unsigned i = batch.firstNode_; i < batch.firstNode_ + batch.numNodes_; ++i)
+    {
+        NodeEntry& entry = nodes_[i];
+        entry.firstValue_ = batch.values_.size();
+        entry.fallback_ = !DecodeValues(entry.source_, types_[0], false, batch.values_);
+        if (entry.fallback_)
+            batch.values_.resize(entry.firstValue_);
+        entry.numValues_ = batch.values_.size() - entry.firstValue_;
+
+        for (unsigned j = entry.firstComponent_; j < entry.firstComponent_ + entry.numComponents_; ++j)
+        {
+            ComponentEntry& compEntry = components_[j];
+            compEntry.firstValue_ = batch.values_.size();
+            compEntry.fallback_ = !DecodeValues(compEntry.source_, types_[compEntry.typeInfo_], true, batch.values_);
+            if (compEntry.fallback_)
+                batch.values_.resize(compEntry.firstValue_);
+            compEntry.numValues_ = batch.values_.size() - compEntry.firstValue_;
+        }
+    }
+
+    // Notify under the lock, as a waiting destructor may destroy the condition as soon as it can acquire the lock
+    std::lock_guard<std::mutex> lock(decodeMutex_);
+    batch.decoded_.store(true, std::memory_order_release);
+    decodeCondition_.notify_all();
+}
+
+bool ParallelSceneLoader::DecodeValues(const SourceRef& source, const TypeInfo& typeInfo, bool isComponent,
+    ea::vector<DecodedValue>& values) const
+{
+    if (!typeInfo.decodable_)
+        return false;
+
+    const ea::vector<AttributeInfo>* attributes = typeInfo.attributes_;
+
+    switch (format_)
+    {
+    case SOURCE_BINARY:
+    {
+        if (!attributes)
+            return true;
+
+        MemoryBuffer data(buffer_.data() + source.offset_, source.size_);
+        // Component data begins with the type and ID
+        if (isComponent)
+            data.Seek(sizeof(unsigned) * 2);
+
+        for (const AttributeInfo& attr : *attributes)
+        {
+            if (!attr.ShouldLoad())
+                continue;
+            // Truncated data is reported by the regular load function
+            if (data.IsEof())
+                return false;
+            values.push_back({&attr, data.ReadVariant(attr.type_)});
+        }
+        return true;
+    }
+
+    case SOURCE_XML:
+    {
+        const pugi::xml_node element(source.xmlNode_);
+        // Animations create objects, so they are loaded by Animatable on the main thread
+        if (element.child("objectanimation") || element.child("attributeanimation"))
+            return false;
+        if (!attributes)
+            return true;
+
+        unsigned startIndex = 0;
+        for (pugi::xml_node attrElem = element.child("attribute"); attrElem; attrElem = attrElem.next_sibling("attribute"))
+        {
+            const char* name = attrElem.attribute("name").value();
+            unsigned i = startIndex;
+            unsigned attempts = attributes->size();
+
+            while (attempts)
+            {
+                const AttributeInfo& attr = attributes->at(i);
+                if (attr.ShouldLoad() && !attr.name_.compare(name))
+                {
+                    // If enums specified, do enum lookup and int assignment. Otherwise decode the variant directly
+                    Variant value;
+                    if (attr.enumNames_ && attr.type_ == VAR_INT)
+                        value = GetEnumValue(attr, attrElem.attribute("value").value());
+                    else
+                        value = GetXMLVariantValue(attrElem, attr.type_);
+
+                    if (!value.IsEmpty())
+                        values.push_back({&attr, value});
+
+                    startIndex = (i + 1) % attributes->size();
+                    break;
+                }
+                else
+                {
+                    i = (i + 1) % attributes->size();
+                    --attempts;
+                }
+            }
+
+            if (!attempts)
+                URHO3D_LOGWARNING("Unknown attribute " + ea::string(name) + " in XML data");
+        }
+        return true;
+    }
+
+    case SOURCE_JSON:
+    {
+        const JSONValue& value = *source.jsonValue_;
+        // Animations create objects, so they are loaded by Animatable on the main thread
+        if (!value.Get("objectanimation").IsNull() || !value.Get("attributeanimation").IsNull())
+            return false;
+        if (!attributes)
+            return true;
+
+        const JSONValue& attributesValue = value.Get("attributes");
+        if (attributesValue.IsNull())
+            return true;
+        if (!attributesValue.IsObject())
+        {
+            URHO3D_LOGWARNING("'attributes' object is present in " + typeInfo.typeName_ + " but is not a JSON object; skipping load");
+            return true;
+        }
+
+        for (const AttributeInfo& attr : *attributes)
+        {
+            if (!attr.ShouldLoad())
+                continue;
+
+            const JSONValue& attrValue = attributesValue.Get(attr.name_);
+            if (attrValue.GetValueType() == JSON_NULL)
+                continue;
+
+            // If enums specified, do enum lookup and int assignment. Otherwise decode the variant directly
+            Variant decoded;
+            if (attr.enumNames_ && attr.type_ == VAR_INT)
+                decoded = GetEnumValue(attr, attrValue.GetString());
+            else
+                decoded = attrValue.GetVariantValue(attr.type_);
+
+            if (!decoded.IsEmpty())
+                values.push_back({&attr, decoded});
+        }
+
+        // Report unknown attributes
+        for (const auto& pair : attributesValue.GetObject())
+        {
+            bool found = false;
+            for (unsigned i = 0; i < attributes->size() && !found; ++i)
+                found = attributes->at(i).name_ == pair.first;
+            if (!found)
+                URHO3D_LOGWARNING("Unknown attribute {} in JSON data", pair.first);
+        }
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+void ParallelSceneLoader::WaitForBatch(Batch& batch)
+{
+    if (batch.decoded_.load(std::memory_order_acquire))
+        return;
+
+    // Decode on the main thread rather than wait if no worker thread has taken the batch yet
+    if (!batch.item_ || !workQueue_ || workQueue_->RemoveWorkItem(batch.item_))
+    {
+        batch.item_.Reset();
+        DecodeBatch(batch);
+        return;
+    }
+
+    WaitForDecoded(batch);
+}
+
+void ParallelSceneLoader::WaitForDecoded(const Batch& batch)
+{
+    std::unique_lock<std::mutex> lock(decodeMutex_);
+    decodeCondition_.wait(lock, [&batch]() { return batch.decoded_.load(std::memory_order_acquire); });
+}
+
+bool ParallelSceneLoader::CreateNode(NodeEntry& entry, Batch& batch, Node* parent, SceneResolver& resolver)
+{
+    Node* node = parent->CreateChild(entry.id_, Scene::IsReplicatedID(entry.id_) ? REPLICATED : LOCAL);
+    entry.node_ = node;
+    resolver.AddNode(entry.id_, node);
+
+    if (entry.fallback_)
+    {
+        if (!LoadNode(node, entry.source_))
+            return false;
+    }
+    else
+        ApplyValues(node, batch, entry.firstValue_, entry.numValues_);
+
+    for (unsigned i = entry.firstComponent_; i < entry.firstComponent_ + entry.numComponents_; ++i)
+    {
+        const ComponentEntry& compEntry = components_[i];
+        const TypeInfo& typeInfo = types_[compEntry.typeInfo_];
+        Component* component = node->SafeCreateComponent(typeInfo.typeName_, typeInfo.type_,
+            Scene::IsReplicatedID(compEntry.id_) ? REPLICATED : LOCAL, compEntry.id_);
+        if (!component)
+            continue;
+
+        resolver.AddComponent(compEntry.id_, component);
+
+        // Objects with instance-specific attributes can not use values decoded against the registered attributes
+        if (compEntry.fallback_ || component->GetAttributes() != typeInfo.attributes_)
+        {
+            // Do not abort if a binary component fails to load, as the sequential loader skips it as well
+            if (!LoadComponent(component, compEntry.source_) && format_ != SOURCE_BINARY)
+                return false;
+        }
+        else
+            ApplyValues(component, batch, compEntry.firstValue_, compEntry.numValues_);
+    }
+
+    return true;
+}
+
+void ParallelSceneLoader::ApplyValues(Serializable* object, const Batch& batch, unsigned firstValue, unsigned numValues) const
+{
+    object->BeginAttributeLoad();
+    for (unsigned i = firstValue; i < firstValue + numValues; ++i)
+    {
+        const DecodedValue& value = batch.values_[i];
+        object->OnSetAttribute(*value.attr_, value.value_);
+    }
+    object->EndAttributeLoad();
+}
+
+bool ParallelSceneLoader::LoadNode(Node* node, const SourceRef& source) const
+{
+    switch (format_)
+    {
+    case SOURCE_BINARY:
+    {
+        MemoryBuffer data(buffer_.data() + source.offset_, source.size_);
+        return node->Animatable::Load(data);
+    }
+
+    case SOURCE_XML:
+        return node->Animatable::LoadXML(XMLElement(xmlFile_, source.xmlNode_));
+
+    case SOURCE_JSON:
+        return node->Animatable::LoadJSON(*source.jsonValue_);
+
+    default:
+        return false;
+    }
+}
+
+bool ParallelSceneLoader::LoadComponent(Serializable* component, const SourceRef& source) const
+{
+    switch (format_)
+    {
+    case SOURCE_BINARY:
+    {
+        MemoryBuffer data(buffer_.data() + source.offset_, source.size_);
+        data.Seek(sizeof(unsigned) * 2);
+        return component->Load(data);
+    }
+
+    case SOURCE_XML:
+        return component->LoadXML(XMLElement(xmlFile_, source.xmlNode_));
+
+    case SOURCE_JSON:
+        return component->LoadJSON(*source.jsonValue_);
+
+    default:
+        return false;
+    }
+}
+
+}
@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/unique_ptr.h>
+#include <EASTL/unordered_map.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "../Container/Ptr.h"
+#include "../Core/Attribute.h"
+
+namespace pugi
+{
+
+struct xml_node_struct;
+
+}
+
+namespace Urho3D
+{
+
+class Context;
+class Deserializer;
+class JSONValue;
+class MemoryBuffer;
+class Node;
+class SceneResolver;
+class Serializable;
+class WorkItem;
+class WorkQueue;
+class XMLElement;
+class XMLFile;
+
+/// Loads the child node hierarchies of a node in two phases. Attribute values are decoded into intermediate buffers on WorkQueue threads, while nodes and components are created and the decoded values assigned on the main thread in the original order. Objects that can not be decoded outside the main thread (unknown component types, custom-typed attributes, animations, instance-specific attributes) are loaded with their regular load functions when created.
+class URHO3D_API ParallelSceneLoader
+{
+public:
+    /// Construct for loading children into a node. Decoding work items are queued with the given priority.
+    explicit ParallelSceneLoader(Node* parent, unsigned priority = M_MAX_UNSIGNED);
+    /// Destruct. Cancel queued decoding and wait for decoding in progress.
+    ~ParallelSceneLoader();
+
+    /// Start loading child nodes from binary node data positioned at the child node count. The source is left positioned after the last child. Return true if successful.
+    bool StartBinary(Deserializer& source);
+    /// Start loading the child node elements of a node element. The XML file must not be modified during loading. Return true if successful.
+    bool StartXML(const XMLElement& source);
+    /// Start loading the children of a node JSON value. The value must outlive the loader and must not be modified during loading. Return true if successful.
+    bool StartJSON(const JSONValue& source);
+
+    /// Create the next node with its components, waiting for its decoding if necessary. Children of nodes that no longer exist are skipped. Return true if successful.
+    bool CreateNextNode(SceneResolver& resolver);
+    /// Create all remaining nodes. Return true if successful.
+    bool CreateNodes(SceneResolver& resolver);
+
+    /// Return whether creating the next node would have to wait for a worker thread.
+    bool IsNextNodePending() const;
+    /// Return whether all nodes have been created.
+    bool IsFinished() const { return nextNode_ >= nodes_.size(); }
+    /// Return number of nodes in all child hierarchies.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+    /// Return number of nodes created so far.
+    unsigned GetNumCreatedNodes() const { return nextNode_; }
+
+private:
+    /// Source data format.
+    enum SourceFormat
+    {
+        SOURCE_NONE = 0,
+        SOURCE_BINARY,
+        SOURCE_XML,
+        SOURCE_JSON
+    };
+
+    /// Object type information. Read-only while decoding.
+    struct TypeInfo
+    {
+        /// Type.
+        StringHash type_;
+        /// Type name as found in the source data, used for unknown types.
+        ea::string typeName_;
+        /// Registered attribute descriptions.
+        const ea::vector<AttributeInfo>* attributes_;
+        /// Whether the values can be decoded on worker threads.
+        bool decodable_;
+    };
+
+    /// Location of an object in the source data.
+    struct SourceRef
+    {
+        /// XML element.
+        pugi::xml_node_struct* xmlNode_;
+        /// JSON value.
+        const JSONValue* jsonValue_;
+        /// Offset of binary data.
+        unsigned offset_;
+        /// Size of binary data.
+        unsigned size_;
+    };
+
+    /// Decoded attribute value.
+    struct DecodedValue
+    {
+        /// Attribute description.
+        const AttributeInfo* attr_;
+        /// Value.
+        Variant value_;
+    };
+
+    /// Component to create.
+    struct ComponentEntry
+    {
+        /// Source data.
+        SourceRef source_;
+        /// Type information index.
+        unsigned typeInfo_;
+        /// Component ID.
+        unsigned id_;
+        /// First decoded value index within the batch.
+        unsigned firstValue_;
+        /// Number of decoded values.
+        unsigned numValues_;
+        /// Whether to load with the regular load function instead of the decoded values.
+        bool fallback_;
+    };
+
+    /// Node to create.
+    struct NodeEntry
+    {
+        /// Source data.
+        SourceRef source_;
+        /// Node ID.
+        unsigned id_;
+        /// Parent node index, or M_MAX_UNSIGNED for children of the root.
+        unsigned parent_;
+        /// Decoding batch index.
+        unsigned batch_;
+        /// First component index.
+        unsigned firstComponent_;
+        /// Number of components.
+        unsigned numComponents_;
+        /// First decoded value index within the batch.
+        unsigned firstValue_;
+        /// Number of decoded values.
+        unsigned numValues_;
+        /// Whether to load with the regular load function instead of the decoded values.
+        bool fallback_;
+        /// Created node.
+        WeakPtr<Node> node_;
+    };
+
+    /// Range of consecutive nodes decoded by one work item.
+    struct Batch
+    {
+        /// First node index.
+        unsigned firstNode_{};
+        /// Number of nodes.
+        unsigned numNodes_{};
+        /// Decoded values of the nodes and their components.
+        ea::vector<DecodedValue> values_;
+        /// Decoding finished flag.
+        std::atomic<bool> decoded_{};
+        /// Work item, null if decoded on the main thread.
+        SharedPtr<WorkItem> item_;
+    };
+
+    /// Split binary child node data into node and component entries. Return true if successful.
+    bool SplitBinary(MemoryBuffer& source, unsigned parentIndex);
+    /// Split XML child node elements into node and component entries.
+    void SplitXML(pugi::xml_node_struct* source, unsigned parentIndex);
+    /// Split JSON child node values into node and component entries.
+    void SplitJSON(const JSONValue& source, unsigned parentIndex);
+    /// Return type information index, adding new type information as necessary.
+    unsigned GetTypeInfoIndex(StringHash type, const ea::string& typeName);
+    /// Divide nodes into batches and queue them for decoding.
+    void StartDecoding();
+    /// Decode the values of all nodes and components in a batch.
+    void DecodeBatch(Batch& batch);
+    /// Decode the values of one object. Return false if the object must be loaded with its regular load function.
+    bool DecodeValues(const SourceRef& source, const TypeInfo& typeInfo, bool isComponent, ea::vector<DecodedValue>& values) const;
+    /// Make sure a batch is decoded, decoding it on the main thread if no worker thread has started it.
+    void WaitForBatch(Batch& batch);
+    /// Block until a worker thread has finished decoding a batch.
+    void WaitForDecoded(const Batch& batch);
+    /// Create a node and its components. Return true if successful.
+    bool CreateNode(NodeEntry& entry, Batch& batch, Node* parent, SceneResolver& resolver);
+    /// Assign decoded values to an object.
+    void ApplyValues(Serializable* object, const Batch& batch, unsigned firstValue, unsigned numValues) const;
+    /// Load node attributes with the regular load function. Return true if successful.
+    bool LoadNode(Node* node, const SourceRef& source) const;
+    /// Load component attributes with the regular load function. Return true if successful.
+    bool LoadComponent(Serializable* component, const SourceRef& source) const;
+
+    /// Context.
+    Context* context_;
+    /// Parent of the loaded hierarchies.
+    WeakPtr<Node> parent_;
+    /// Work queue, null if not available.
+    WeakPtr<WorkQueue> workQueue_;
+    /// Work item priority.
+    unsigned priority_;
+    /// Source data format.
+    SourceFormat format_;
+    /// Binary source data.
+    ea::vector<unsigned char> buffer_;
+    /// XML source file.
+    SharedPtr<XMLFile> xmlFile_;
+    /// Object type information. Node type is first.
+    ea::vector<TypeInfo> types_;
+    /// Type information indices by type.
+    ea::unordered_map<StringHash, unsigned> typeIndices_;
+    /// Nodes in depth-first order.
+    ea::vector<NodeEntry> nodes_;
+    /// Components of all nodes.
+    ea::vector<ComponentEntry> components_;
+    /// Decoding batches.
+    ea::vector<ea::unique_ptr<Batch> > batches_;
+    /// Index of the next node to create.
+    unsigned nextNode_;
+    /// Mutex for waiting on decoded batches.
+    std::mutex decodeMutex_;
+    /// Condition signaled when a batch has been decoded.
+    std::condition_variable decodeCondition_;
+};
+
+}
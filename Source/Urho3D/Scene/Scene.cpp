@@ -27,22 +27,34 @@
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
 #include "../IO/Archive.h"
+#include "../IO/BinaryArchive.h"
 #include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
+#include "../IO/VectorBuffer.h"
+#include "../Resource/PreloadManifest.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
+#include "../Scene/AttributeAnimationSystem.h"
 #include "../Scene/CameraViewport.h"
+#include "../Scene/CompiledPrefab.h"
 #include "../Scene/Component.h"
 #include "../Scene/ObjectAnimation.h"
+#include "../Scene/PackedScene.h"
+#include "../Scene/ParallelSceneLoader.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
+#include "../Scene/SceneDelta.h"
 #include "../Scene/SceneEvents.h"
+#include "../Scene/SceneSnapshot.h"
 #include "../Scene/SceneManager.h"
 #include "../Scene/SmoothedTransform.h"
 #include "../Scene/SplinePath.h"
+#include "../Scene/TransformSystem.h"
 #include "../Scene/UnknownComponent.h"
 #include "../Scene/ValueAnimation.h"
 
@@ -58,6 +70,23 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
 
+/// Write a save snapshot to a file. Called on a worker thread.
+static void SaveSnapshotWork(const WorkItem* item, unsigned threadIndex)
+{
+    const auto* saveItem = static_cast<const SceneSaveWorkItem*>(item);
+    File file(saveItem->context_);
+    if (!file.Open(saveItem->fileName_, FILE_WRITE))
+    {
+        URHO3D_LOGERROR("Could not open " + saveItem->fileName_ + " for writing scene snapshot");
+        return;
+    }
+
+    const bool success = saveItem->delta_ ? saveItem->snapshot_->SaveDelta(file) : saveItem->snapshot_->Save(file);
+    if (!success)
+        URHO3D_LOGERROR("Could not write scene snapshot to " + saveItem->fileName_);
+    saveItem->success_.store(success, std::memory_order_release);
+}
+
 Scene::Scene(Context* context) :
     Node(context),
     replicatedNodeID_(FIRST_REPLICATED_ID),
@@ -72,7 +101,10 @@ Scene::Scene(Context* context) :
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    recordPreloadManifest_(false),
+    preloadRecording_(false),
+    parallelLoading_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
@@ -84,6 +116,10 @@ Scene::Scene(Context* context) :
 
 Scene::~Scene()
 {
+    // Removing the nodes is not a change to save
+    saveTracker_.reset();
+    transformSystem_.reset();
+
     // Remove root-level components first, so that scene subsystems such as the octree destroy themselves. This will speed up
     // the removal of child nodes' components
     RemoveAllComponents();
@@ -118,7 +154,7 @@ void Scene::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Next Replicated Component ID", unsigned, replicatedComponentID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Next Local Node ID", unsigned, localNodeID_, FIRST_LOCAL_ID, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Next Local Component ID", unsigned, localComponentID_, FIRST_LOCAL_ID, AM_FILE | AM_NOEDIT);
-    URHO3D_ATTRIBUTE("Variables", VariantMap, vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
+    URHO3D_ACCESSOR_ATTRIBUTE("Variables", GetVars, SetVars, VariantMap, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Variable Names", GetVarNamesAttr, SetVarNamesAttr, ea::string, EMPTY_STRING, AM_FILE | AM_NOEDIT);
 }
 
@@ -126,19 +162,13 @@ bool Scene::EnableRegistry()
 {
     if (!registryEnabled_)
     {
-        const bool hasNodesExceptSelf = replicatedNodes_.size() != 1 || localNodes_.size() != 0;
-        const bool hasComponents = replicatedComponents_.size() != 0 || localComponents_.size() != 0;
-        if (hasNodesExceptSelf || hasComponents)
-        {
-            URHO3D_LOGERROR("Registry may be enabled only for empty Scene");
-            return false;
-        }
-
         registryEnabled_ = true;
 
-        // Add self to registry
-        const entt::entity entity = reg_.create();
-        SetEntity(entity);
+        // Add self and existing nodes to registry
+        for (auto i = replicatedNodes_.begin(); i != replicatedNodes_.end(); ++i)
+            i->second->SetEntity(reg_.create());
+        for (auto i = localNodes_.begin(); i != localNodes_.end(); ++i)
+            i->second->SetEntity(reg_.create());
     }
     return true;
 }
@@ -148,8 +178,23 @@ bool Scene::CreateComponentIndex(StringHash componentType)
     if (!EnableRegistry())
         return false;
 
+    if (GetComponentIndexStorage(componentType))
+        return true;
+
     indexedComponentTypes_.push_back(componentType);
-    componentIndexes_.emplace_back();
+    ComponentIndexStorage& storage = componentIndexes_.emplace_back();
+
+    // Index existing components
+    for (const auto* components : { &replicatedComponents_, &localComponents_ })
+    {
+        for (auto i = components->begin(); i != components->end(); ++i)
+        {
+            Component* component = i->second;
+            const entt::entity entity = component->GetNode()->GetEntity();
+            if (component->GetType() == componentType && !storage.has(entity))
+                storage.construct(entity, component);
+        }
+    }
     return true;
 }
 
@@ -160,6 +205,167 @@ ea::span<Component* const> Scene::GetComponentIndex(StringHash componentType)
     return {};
 }
 
+SceneComponentView Scene::GetComponentView(std::initializer_list<StringHash> include, std::initializer_list<StringHash> exclude)
+{
+    SceneComponentView::StorageVector includeStorages;
+    SceneComponentView::StorageVector excludeStorages;
+    for (const auto& [types, storages] : { ea::make_pair(include, &includeStorages), ea::make_pair(exclude, &excludeStorages) })
+    {
+        for (StringHash componentType : types)
+        {
+            const ComponentIndexStorage* storage = GetComponentIndexStorage(componentType);
+            if (!storage)
+            {
+                URHO3D_LOGERROR("Component type {} is not indexed, can not create component view", componentType.ToString());
+                return {};
+            }
+            storages->push_back(storage);
+        }
+    }
+    return { includeStorages, excludeStorages };
+}
+
+void Scene::CreateVarIndex(StringHash key)
+{
+    if (varIndexes_.contains(key))
+        return;
+
+    // Index existing nodes
+    auto& index = varIndexes_[key];
+    for (const auto* nodes : { &replicatedNodes_, &localNodes_ })
+    {
+        for (auto i = nodes->begin(); i != nodes->end(); ++i)
+        {
+            const Variant& value = i->second->GetVar(key);
+            if (!value.IsEmpty())
+                index[value].push_back(i->second);
+        }
+    }
+}
+
+ea::span<Node* const> Scene::GetNodesWithVar(StringHash key, const Variant& value) const
+{
+    auto index = varIndexes_.find(key);
+    if (index == varIndexes_.end())
+    {
+        URHO3D_LOGERROR("User variable {} is not indexed", key.ToString());
+        return {};
+    }
+
+    auto nodes = index->second.find(value);
+    if (nodes != index->second.end())
+        return nodes->second;
+    return {};
+}
+
+const DataComponentType* Scene::GetDataComponentType(StringHash type) const
+{
+    for (const DataComponentType& dataType : dataComponentTypes_)
+    {
+        if (dataType.type_ == type)
+            return &dataType;
+    }
+    return nullptr;
+}
+
+unsigned Scene::GetNumDataComponents(const Node* node) const
+{
+    const entt::entity entity = node->GetEntity();
+    if (dataComponentTypes_.empty() || entity == entt::null)
+        return 0;
+
+    unsigned num = 0;
+    for (const DataComponentType& dataType : dataComponentTypes_)
+    {
+        if (dataType.has_(reg_, entity))
+            ++num;
+    }
+    return num;
+}
+
+void Scene::SaveDataComponents(const Node* node, Serializer& dest)
+{
+    const unsigned numDataComponents = GetNumDataComponents(node);
+    if (!numDataComponents)
+        return;
+
+    const entt::entity entity = node->GetEntity();
+    BinaryOutputArchive archive(context_, dest);
+    if (ArchiveBlock block = archive.OpenArrayBlock("dataComponents", numDataComponents))
+    {
+        for (const DataComponentType& dataType : dataComponentTypes_)
+        {
+            if (!dataType.has_(reg_, entity))
+                continue;
+
+            if (ArchiveBlock componentBlock = archive.OpenUnorderedBlock("component"))
+            {
+                StringHash type = dataType.type_;
+                SerializeStringHash(archive, "type", type, dataType.name_);
+                dataType.serialize_(archive, reg_, entity);
+            }
+        }
+    }
+}
+
+bool Scene::LoadDataComponents(Node* node, const ea::vector<unsigned char>& data)
+{
+    const entt::entity entity = node->GetEntity();
+    if (dataComponentTypes_.empty() || entity == entt::null)
+        return data.empty();
+
+    // Data components not present in the buffer are removed
+    ea::fixed_vector<bool, 16> loaded(dataComponentTypes_.size(), false);
+    bool success = true;
+    if (!data.empty())
+    {
+        MemoryBuffer buffer(data);
+        BinaryInputArchive archive(context_, buffer);
+        if (ArchiveBlock block = archive.OpenArrayBlock("dataComponents"))
+        {
+            for (unsigned i = 0; i < block.GetSizeHint() && success; ++i)
+            {
+                ArchiveBlock componentBlock = archive.OpenUnorderedBlock("component");
+                StringHash type;
+                success = componentBlock && SerializeStringHash(archive, "type", type, EMPTY_STRING);
+                const DataComponentType* dataType = success ? GetDataComponentType(type) : nullptr;
+                if (!dataType)
+                {
+                    URHO3D_LOGERROR("Unknown data component type {}", type.ToString());
+                    success = false;
+                    break;
+                }
+
+                loaded[dataType - dataComponentTypes_.data()] = true;
+                success = dataType->serialize_(archive, reg_, entity);
+            }
+        }
+        else
+            success = false;
+    }
+
+    for (unsigned i = 0; i < dataComponentTypes_.size(); ++i)
+    {
+        if (!loaded[i])
+            dataComponentTypes_[i].remove_(reg_, entity);
+    }
+    return success;
+}
+
+void Scene::CopyDataComponents(const Node* source, Node* dest)
+{
+    const entt::entity sourceEntity = source->GetEntity();
+    const entt::entity destEntity = dest->GetEntity();
+    if (dataComponentTypes_.empty() || sourceEntity == entt::null || destEntity == entt::null)
+        return;
+
+    for (const DataComponentType& dataType : dataComponentTypes_)
+    {
+        if (dataType.has_(reg_, sourceEntity))
+            dataType.copy_(reg_, sourceEntity, destEntity);
+    }
+}
+
 bool Scene::Serialize(Archive& archive)
 {
     if (!Node::Serialize(archive))
@@ -177,7 +383,9 @@ bool Scene::Load(Deserializer& source)
     StopAsyncLoading();
 
     // Check ID
-    if (source.ReadFileID() != "USCN")
+    const ea::string fileID = source.ReadFileID();
+    const bool isPackedFile = fileID == "USCP";
+    if (fileID != "USCN" && !isPackedFile)
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid scene file");
         return false;
@@ -186,15 +394,34 @@ bool Scene::Load(Deserializer& source)
     URHO3D_LOGINFO("Loading scene from " + source.GetName());
 
     Clear();
+    BeginPreloadRecording();
+
+    bool success;
+    if (isPackedFile)
+    {
+        SceneResolver resolver;
+        PackedSceneReader reader(context_);
+        success = reader.Read(source, this, resolver);
+        if (success)
+        {
+            resolver.Resolve();
+            ApplyAttributes();
+        }
+    }
+    else
+        success = parallelLoading_ ? LoadParallel(source) : Node::Load(source);
 
     // Load the whole scene, then perform post-load if successfully loaded
-    if (Node::Load(source))
+    if (success)
     {
         FinishLoading(&source);
         return true;
     }
     else
+    {
+        EndPreloadRecording(nullptr);
         return false;
+    }
 }
 
 bool Scene::Save(Serializer& dest) const
@@ -229,7 +456,7 @@ bool Scene::LoadXML(const XMLElement& source)
 
     // Load the whole scene, then perform post-load if successfully loaded
     // Note: the scene filename and checksum can not be set, as we only used an XML element
-    if (Node::LoadXML(source))
+    if (parallelLoading_ ? LoadXMLParallel(source) : Node::LoadXML(source))
     {
         FinishLoading(nullptr);
         return true;
@@ -246,7 +473,7 @@ bool Scene::LoadJSON(const JSONValue& source)
 
     // Load the whole scene, then perform post-load if successfully loaded
     // Note: the scene filename and checksum can not be set, as we only used an XML element
-    if (Node::LoadJSON(source))
+    if (parallelLoading_ ? LoadJSONParallel(source) : Node::LoadJSON(source))
     {
         FinishLoading(nullptr);
         return true;
@@ -287,14 +514,18 @@ bool Scene::LoadXML(Deserializer& source)
     URHO3D_LOGINFO("Loading scene from " + source.GetName());
 
     Clear();
+    BeginPreloadRecording();
 
-    if (Node::LoadXML(xml->GetRoot()))
+    if (parallelLoading_ ? LoadXMLParallel(xml->GetRoot()) : Node::LoadXML(xml->GetRoot()))
     {
         FinishLoading(&source);
         return true;
     }
     else
+    {
+        EndPreloadRecording(nullptr);
         return false;
+    }
 }
 
 bool Scene::LoadJSON(Deserializer& source)
@@ -310,14 +541,18 @@ bool Scene::LoadJSON(Deserializer& source)
     URHO3D_LOGINFO("Loading scene from " + source.GetName());
 
     Clear();
+    BeginPreloadRecording();
 
-    if (Node::LoadJSON(json->GetRoot()))
+    if (parallelLoading_ ? LoadJSONParallel(json->GetRoot()) : Node::LoadJSON(json->GetRoot()))
     {
         FinishLoading(&source);
         return true;
     }
     else
+    {
+        EndPreloadRecording(nullptr);
         return false;
+    }
 }
 
 bool Scene::SaveXML(Serializer& dest, const ea::string& indentation) const
@@ -366,6 +601,31 @@ bool Scene::SaveJSON(Serializer& dest, const ea::string& indentation) const
         return false;
 }
 
+bool Scene::SavePacked(Serializer& dest, bool groupComponents) const
+{
+    URHO3D_PROFILE("SaveScenePacked");
+
+    // Write ID first
+    if (!dest.WriteFileID("USCP"))
+    {
+        URHO3D_LOGERROR("Could not save scene, writing to stream failed");
+        return false;
+    }
+
+    auto* ptr = dynamic_cast<Deserializer*>(&dest);
+    if (ptr)
+        URHO3D_LOGINFO("Saving scene to " + ptr->GetName());
+
+    PackedSceneWriter writer(groupComponents);
+    if (writer.Write(dest, this))
+    {
+        FinishSaving(&dest);
+        return true;
+    }
+    else
+        return false;
+}
+
 bool Scene::LoadAsync(File* file, LoadMode mode)
 {
     if (!file)
@@ -377,8 +637,10 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
     StopAsyncLoading();
 
     // Check ID
-    bool isSceneFile = file->ReadFileID() == "USCN";
-    if (!isSceneFile)
+    const ea::string fileID = file->ReadFileID();
+    bool isSceneFile = fileID == "USCN";
+    const bool isPackedFile = fileID == "USCP";
+    if (!isSceneFile && !isPackedFile)
     {
         // In resource load mode can load also object prefabs, which have no identifier
         if (mode > LOAD_RESOURCES_ONLY)
@@ -398,9 +660,11 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
 
     asyncLoading_ = true;
     asyncProgress_.file_ = file;
+    asyncProgress_.packed_ = isPackedFile;
     asyncProgress_.mode_ = mode;
     asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
     asyncProgress_.resources_.clear();
+    BeginPreloadRecording();
 
     if (mode > LOAD_RESOURCES_ONLY)
     {
@@ -409,9 +673,22 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
         {
             URHO3D_PROFILE("FindResourcesToPreload");
 
-            unsigned currentPos = file->GetPosition();
-            PreloadResources(file, isSceneFile);
-            file->Seek(currentPos);
+            if (!PreloadResourcesFromManifest(file))
+            {
+                unsigned currentPos = file->GetPosition();
+                if (isPackedFile)
+                    PreloadResourcesPacked(file);
+                else
+                    PreloadResources(file, isSceneFile);
+                file->Seek(currentPos);
+            }
+        }
+
+        // Packed files store the hierarchy flat, so the whole scene is loaded at once in the async update
+        if (isPackedFile)
+        {
+            asyncProgress_.totalNodes_ = 1;
+            return true;
         }
 
         // Store own old ID for resolving possible root node references
@@ -425,15 +702,32 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
             return false;
         }
 
-        // Then prepare to load child nodes in the async updates
-        asyncProgress_.totalNodes_ = file->ReadVLE();
+        // Then prepare to load child nodes in the async updates. The parallel loader counts nodes of all levels
+        if (parallelLoading_)
+        {
+            asyncLoader_ = ea::make_unique<ParallelSceneLoader>(this, 0);
+            if (!asyncLoader_->StartBinary(*file))
+            {
+                StopAsyncLoading();
+                return false;
+            }
+            asyncProgress_.totalNodes_ = asyncLoader_->GetNumNodes();
+        }
+        else
+            asyncProgress_.totalNodes_ = file->ReadVLE();
     }
     else
     {
         URHO3D_PROFILE("FindResourcesToPreload");
 
         URHO3D_LOGINFO("Preloading resources from " + file->GetName());
-        PreloadResources(file, isSceneFile);
+        if (!PreloadResourcesFromManifest(file))
+        {
+            if (isPackedFile)
+                PreloadResourcesPacked(file);
+            else
+                PreloadResources(file, isSceneFile);
+        }
     }
 
     return true;
@@ -465,6 +759,7 @@ bool Scene::LoadAsyncXML(File* file, LoadMode mode)
     asyncProgress_.mode_ = mode;
     asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
     asyncProgress_.resources_.clear();
+    BeginPreloadRecording();
 
     if (mode > LOAD_RESOURCES_ONLY)
     {
@@ -475,7 +770,8 @@ bool Scene::LoadAsyncXML(File* file, LoadMode mode)
         {
             URHO3D_PROFILE("FindResourcesToPreload");
 
-            PreloadResourcesXML(rootElement);
+            if (!PreloadResourcesFromManifest(file))
+                PreloadResourcesXML(rootElement);
         }
 
         // Store own old ID for resolving possible root node references
@@ -484,9 +780,24 @@ bool Scene::LoadAsyncXML(File* file, LoadMode mode)
 
         // Load the root level components first
         if (!Node::LoadXML(rootElement, resolver_, false))
+        {
+            StopAsyncLoading();
             return false;
+        }
+
+        // Then prepare for loading all root level child nodes in the async update. The parallel loader counts nodes of all levels
+        if (parallelLoading_)
+        {
+            asyncLoader_ = ea::make_unique<ParallelSceneLoader>(this, 0);
+            if (!asyncLoader_->StartXML(rootElement))
+            {
+                StopAsyncLoading();
+                return false;
+            }
+            asyncProgress_.totalNodes_ = asyncLoader_->GetNumNodes();
+            return true;
+        }
 
-        // Then prepare for loading all root level child nodes in the async update
         XMLElement childNodeElement = rootElement.GetChild("node");
         asyncProgress_.xmlElement_ = childNodeElement;
 
@@ -502,7 +813,8 @@ bool Scene::LoadAsyncXML(File* file, LoadMode mode)
         URHO3D_PROFILE("FindResourcesToPreload");
 
         URHO3D_LOGINFO("Preloading resources from " + file->GetName());
-        PreloadResourcesXML(xml->GetRoot());
+        if (!PreloadResourcesFromManifest(file))
+            PreloadResourcesXML(xml->GetRoot());
     }
 
     return true;
@@ -534,6 +846,7 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
     asyncProgress_.mode_ = mode;
     asyncProgress_.loadedNodes_ = asyncProgress_.totalNodes_ = asyncProgress_.loadedResources_ = asyncProgress_.totalResources_ = 0;
     asyncProgress_.resources_.clear();
+    BeginPreloadRecording();
 
     if (mode > LOAD_RESOURCES_ONLY)
     {
@@ -544,7 +857,8 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
         {
             URHO3D_PROFILE("FindResourcesToPreload");
 
-            PreloadResourcesJSON(rootVal);
+            if (!PreloadResourcesFromManifest(file))
+                PreloadResourcesJSON(rootVal);
         }
 
         // Store own old ID for resolving possible root node references
@@ -553,9 +867,24 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
 
         // Load the root level components first
         if (!Node::LoadJSON(rootVal, resolver_, false))
+        {
+            StopAsyncLoading();
             return false;
+        }
+
+        // Then prepare for loading all root level child nodes in the async update. The parallel loader counts nodes of all levels
+        if (parallelLoading_)
+        {
+            asyncLoader_ = ea::make_unique<ParallelSceneLoader>(this, 0);
+            if (!asyncLoader_->StartJSON(json->GetRoot()))
+            {
+                StopAsyncLoading();
+                return false;
+            }
+            asyncProgress_.totalNodes_ = asyncLoader_->GetNumNodes();
+            return true;
+        }
 
-        // Then prepare for loading all root level child nodes in the async update
         JSONArray childrenArray = rootVal.Get("children").GetArray();
         asyncProgress_.jsonIndex_ = 0;
 
@@ -567,7 +896,8 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
         URHO3D_PROFILE("FindResourcesToPreload");
 
         URHO3D_LOGINFO("Preloading resources from " + file->GetName());
-        PreloadResourcesJSON(json->GetRoot());
+        if (!PreloadResourcesFromManifest(file))
+            PreloadResourcesJSON(json->GetRoot());
     }
 
     return true;
@@ -576,13 +906,16 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
 void Scene::StopAsyncLoading()
 {
     asyncLoading_ = false;
+    asyncLoader_.reset();
     asyncProgress_.file_.Reset();
     asyncProgress_.xmlFile_.Reset();
     asyncProgress_.jsonFile_.Reset();
     asyncProgress_.xmlElement_ = XMLElement::EMPTY;
     asyncProgress_.jsonIndex_ = 0;
+    asyncProgress_.packed_ = false;
     asyncProgress_.resources_.clear();
     resolver_.Reset();
+    EndPreloadRecording(nullptr);
 }
 
 Node* Scene::Instantiate(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode)
@@ -672,6 +1005,17 @@ Node* Scene::InstantiateJSON(Deserializer& source, const Vector3& position, cons
     return InstantiateJSON(json->GetRoot(), position, rotation, mode);
 }
 
+Node* Scene::Instantiate(CompiledPrefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    if (!prefab)
+    {
+        URHO3D_LOGERROR("Null prefab for instantiation");
+        return nullptr;
+    }
+
+    return prefab->Instantiate(this, position, rotation, mode);
+}
+
 void Scene::Clear(bool clearReplicated, bool clearLocal)
 {
     StopAsyncLoading();
@@ -734,6 +1078,189 @@ void Scene::SetElapsedTime(float time)
     elapsedTime_ = time;
 }
 
+void Scene::SetSaveTracking(bool enable)
+{
+    if (enable == GetSaveTracking())
+        return;
+
+    if (enable)
+    {
+        saveTracker_ = ea::make_unique<SceneSaveTracker>(this);
+        SubscribeToEvent(E_TEMPORARYCHANGED, URHO3D_HANDLER(Scene, HandleTemporaryChanged));
+    }
+    else
+    {
+        saveTracker_.reset();
+        UnsubscribeFromEvent(E_TEMPORARYCHANGED);
+    }
+}
+
+void Scene::SetBatchedTransformUpdate(bool enable)
+{
+    if (enable == GetBatchedTransformUpdate())
+        return;
+
+    if (enable)
+        transformSystem_ = ea::make_unique<TransformSystem>(this);
+    else
+    {
+        // Notify the listeners of nodes moved since the last update
+        transformSystem_->Update();
+        transformSystem_.reset();
+    }
+}
+
+void Scene::UpdateTransforms()
+{
+    if (transformSystem_)
+        transformSystem_->Update();
+}
+
+void Scene::SetBatchedAttributeAnimation(bool enable)
+{
+    if (enable == GetBatchedAttributeAnimation())
+        return;
+
+    if (enable)
+        attributeAnimationSystem_ = ea::make_unique<AttributeAnimationSystem>(this);
+    else
+        attributeAnimationSystem_.reset();
+}
+
+bool Scene::AddSnapshotAttribute(StringHash objectType, const ea::string& name)
+{
+    if (!snapshotTracker_)
+        snapshotTracker_ = ea::make_unique<SceneSnapshotTracker>(this);
+    return snapshotTracker_->AddAttribute(objectType, name);
+}
+
+SharedPtr<SceneSnapshot> Scene::CaptureSnapshot()
+{
+    if (!snapshotTracker_)
+        snapshotTracker_ = ea::make_unique<SceneSnapshotTracker>(this);
+    return snapshotTracker_->Capture();
+}
+
+SharedPtr<SceneSaveSnapshot> Scene::CaptureSaveSnapshot()
+{
+    if (!saveTracker_)
+    {
+        URHO3D_LOGERROR("Save tracking is not enabled, can not capture save snapshot");
+        return nullptr;
+    }
+
+    return saveTracker_->Capture();
+}
+
+SharedPtr<SceneSaveWorkItem> Scene::SaveSnapshotAsync(const ea::string& fileName, bool delta)
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (!queue)
+    {
+        URHO3D_LOGERROR("Can not save scene snapshot without WorkQueue");
+        return nullptr;
+    }
+
+    SharedPtr<SceneSaveSnapshot> snapshot = CaptureSaveSnapshot();
+    if (!snapshot)
+        return nullptr;
+
+    SharedPtr<SceneSaveWorkItem> item(new SceneSaveWorkItem());
+    item->workFunction_ = SaveSnapshotWork;
+    item->context_ = context_;
+    item->snapshot_ = snapshot;
+    item->fileName_ = fileName;
+    item->delta_ = delta;
+    queue->AddWorkItem(item);
+
+    return item;
+}
+
+bool Scene::ApplyDelta(Deserializer& source)
+{
+    URHO3D_PROFILE("ApplySceneDelta");
+
+    if (source.ReadFileID() != "USCD")
+    {
+        URHO3D_LOGERROR(source.GetName() + " is not a valid scene delta file");
+        return false;
+    }
+
+    // Apply the tombstones first, as removed IDs may have been reused by changed objects
+    unsigned numRemoved = source.ReadVLE();
+    for (unsigned i = 0; i < numRemoved; ++i)
+    {
+        Node* node = GetNode(source.ReadUInt());
+        if (node && node != this)
+            node->Remove();
+    }
+    numRemoved = source.ReadVLE();
+    for (unsigned i = 0; i < numRemoved; ++i)
+    {
+        Component* component = GetComponent(source.ReadUInt());
+        if (component)
+            component->Remove();
+    }
+
+    // Changed nodes are listed parents first, so that new parents exist when their children are created
+    ea::vector<Component*> loadedComponents;
+    const unsigned numNodes = source.ReadVLE();
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        const unsigned nodeID = source.ReadUInt();
+        const unsigned parentID = source.ReadUInt();
+        const unsigned attributesSize = source.ReadVLE();
+
+        Node* node = GetNode(nodeID);
+        Node* parent = parentID ? GetNode(parentID) : nullptr;
+        if (!node && parent)
+            node = parent->CreateChild(EMPTY_STRING, IsReplicatedID(nodeID) ? REPLICATED : LOCAL, nodeID);
+        else if (node && parent && node->GetParent() != parent)
+            parent->AddChild(node);
+
+        if (node)
+        {
+            VectorBuffer attributes(source, attributesSize);
+            node->Animatable::Load(attributes);
+        }
+        else
+        {
+            URHO3D_LOGWARNING("Parent node " + ea::to_string(parentID) + " of node " + ea::to_string(nodeID) +
+                " not found, skipping node in scene delta");
+            source.Seek(source.GetPosition() + attributesSize);
+        }
+
+        const unsigned numComponents = source.ReadVLE();
+        for (unsigned j = 0; j < numComponents; ++j)
+        {
+            const unsigned componentID = source.ReadUInt();
+            if (!source.ReadBool())
+                continue;
+
+            VectorBuffer componentBuffer(source, source.ReadVLE());
+            if (!node)
+                continue;
+
+            const StringHash componentType = componentBuffer.ReadStringHash();
+            componentBuffer.ReadUInt();
+
+            Component* component = GetComponent(componentID);
+            if (!component)
+                component = node->CreateComponent(componentType, IsReplicatedID(componentID) ? REPLICATED : LOCAL, componentID);
+            if (component)
+            {
+                component->Load(componentBuffer);
+                loadedComponents.push_back(component);
+            }
+        }
+    }
+
+    for (Component* component : loadedComponents)
+        component->ApplyAttributes();
+
+    return true;
+}
+
 void Scene::AddRequiredPackageFile(PackageFile* package)
 {
     // Do not add packages that failed to load
@@ -790,6 +1317,14 @@ bool Scene::GetNodesWithTag(ea::vector<Node*>& dest, const ea::string& tag) cons
         return false;
 }
 
+ea::span<Node* const> Scene::GetNodesWithTag(StringHash tag) const
+{
+    auto it = taggedNodes_.find(tag);
+    if (it != taggedNodes_.end())
+        return it->second;
+    return {};
+}
+
 Component* Scene::GetComponent(unsigned id) const
 {
     if (IsReplicatedID(id))
@@ -842,8 +1377,11 @@ void Scene::Update(float timeStep)
 
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
+    if (attributeAnimationSystem_)
+        attributeAnimationSystem_->Update(timeStep);
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
+    UpdateTransforms();
     SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
 
     // Update transform smoothing
@@ -862,6 +1400,7 @@ void Scene::Update(float timeStep)
 
     // Post-update variable timestep logic
     SendEvent(E_SCENEPOSTUPDATE, eventData);
+    UpdateTransforms();
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -1017,6 +1556,13 @@ void Scene::NodeAdded(Node* node)
         localNodes_[id] = node;
     }
 
+    if (saveTracker_)
+        saveTracker_->MarkDirty(node);
+    if (transformSystem_)
+        transformSystem_->MarkHierarchyDirty();
+    if (!varIndexes_.empty())
+        UpdateVarIndexes(node, true);
+
     // Cache tag if already tagged.
     if (!node->GetTags().empty())
     {
@@ -1044,11 +1590,43 @@ void Scene::NodeTagRemoved(Node* node, const ea::string& tag)
     taggedNodes_[tag].erase_first(node);
 }
 
+void Scene::NodeVarChanged(Node* node, StringHash key, const Variant& value)
+{
+    if (varIndexes_.empty() || node->GetScene() != this)
+        return;
+
+    auto index = varIndexes_.find(key);
+    if (index == varIndexes_.end())
+        return;
+
+    const Variant& oldValue = node->GetVar(key);
+    if (oldValue == value)
+        return;
+
+    if (!oldValue.IsEmpty())
+    {
+        auto nodes = index->second.find(oldValue);
+        if (nodes != index->second.end())
+        {
+            nodes->second.erase_first(node);
+            if (nodes->second.empty())
+                index->second.erase(nodes);
+        }
+    }
+    if (!value.IsEmpty())
+        index->second[value].push_back(node);
+}
+
 void Scene::NodeRemoved(Node* node)
 {
     if (!node || node->GetScene() != this)
         return;
 
+    if (saveTracker_)
+        saveTracker_->NodeRemoved(node);
+    if (transformSystem_)
+        transformSystem_->NodeRemoved(node);
+
     unsigned id = node->GetID();
     if (Scene::IsReplicatedID(id))
     {
@@ -1067,6 +1645,8 @@ void Scene::NodeRemoved(Node* node)
         for (unsigned i = 0; i < tags.size(); ++i)
             taggedNodes_[tags[i]].erase_first(node);
     }
+    if (!varIndexes_.empty())
+        UpdateVarIndexes(node, false);
 
     // Remove components and child nodes as well
     const ea::vector<SharedPtr<Component> >& components = node->GetComponents();
@@ -1121,6 +1701,9 @@ void Scene::ComponentAdded(Component* component)
         localComponents_[id] = component;
     }
 
+    if (saveTracker_)
+        saveTracker_->MarkDirty(component);
+
     component->OnSceneSet(this);
 
     if (registryEnabled_)
@@ -1151,6 +1734,9 @@ void Scene::ComponentRemoved(Component* component)
         }
     }
 
+    if (saveTracker_)
+        saveTracker_->ComponentRemoved(component);
+
     unsigned id = component->GetID();
     if (Scene::IsReplicatedID(id))
         replicatedComponents_.erase(id);
@@ -1245,6 +1831,34 @@ void Scene::MarkNetworkUpdate(Component* component)
     }
 }
 
+void Scene::MarkSaveDirty(Node* node)
+{
+    if (saveTracker_ && node)
+    {
+        if (!threadedUpdate_)
+            saveTracker_->MarkDirty(node);
+        else
+        {
+            MutexLock lock(sceneMutex_);
+            saveTracker_->MarkDirty(node);
+        }
+    }
+}
+
+void Scene::MarkSaveDirty(Component* component)
+{
+    if (saveTracker_ && component)
+    {
+        if (!threadedUpdate_)
+            saveTracker_->MarkDirty(component);
+        else
+        {
+            MutexLock lock(sceneMutex_);
+            saveTracker_->MarkDirty(component);
+        }
+    }
+}
+
 void Scene::MarkReplicationDirty(Node* node)
 {
     if (networkState_ && node->IsReplicated())
@@ -1282,6 +1896,27 @@ void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eve
     }
 }
 
+void Scene::HandleTemporaryChanged(StringHash eventType, VariantMap& eventData)
+{
+    using namespace TemporaryChanged;
+
+    if (!saveTracker_)
+        return;
+
+    // Objects changing to temporary are removed from the save, and objects changing to persistent are added with their children
+    Serializable* serializable = static_cast<Serializable*>(eventData[P_SERIALIZABLE].GetPtr());
+    if (auto* node = dynamic_cast<Node*>(serializable))
+    {
+        if (node->GetScene() == this)
+            saveTracker_->MarkHierarchyDirty(node);
+    }
+    else if (auto* component = dynamic_cast<Component*>(serializable))
+    {
+        if (component->GetScene() == this)
+            saveTracker_->MarkDirty(component);
+    }
+}
+
 void Scene::UpdateAsyncLoading()
 {
     URHO3D_PROFILE("UpdateAsyncLoading");
@@ -1301,9 +1936,16 @@ void Scene::UpdateAsyncLoading()
         }
 
 
+        // Create one decoded node of any level, but do not stall the frame waiting for the worker threads
+        if (asyncLoader_)
+        {
+            if (asyncLoader_->IsNextNodePending())
+                break;
+            asyncLoader_->CreateNextNode(resolver_);
+        }
         // Read one child node with its full sub-hierarchy either from binary, JSON, or XML
         /// \todo Works poorly in scenes where one root-level child node contains all content
-        if (asyncProgress_.xmlFile_)
+        else if (asyncProgress_.xmlFile_)
         {
             unsigned nodeID = asyncProgress_.xmlElement_.GetUInt("id");
             Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
@@ -1322,6 +1964,12 @@ void Scene::UpdateAsyncLoading()
             newNode->LoadJSON(childValue, resolver_);
             ++asyncProgress_.jsonIndex_;
         }
+        else if (asyncProgress_.packed_) // Load the whole packed file
+        {
+            PackedSceneReader reader(context_);
+            if (!reader.Read(*asyncProgress_.file_, this, resolver_))
+                URHO3D_LOGERROR("Could not load scene from " + asyncProgress_.file_->GetName());
+        }
         else // Load from binary
         {
             unsigned nodeID = asyncProgress_.file_->ReadUInt();
@@ -1357,6 +2005,8 @@ void Scene::FinishAsyncLoading()
         ApplyAttributes();
         FinishLoading(asyncProgress_.file_);
     }
+    else
+        EndPreloadRecording(asyncProgress_.file_);
 
     StopAsyncLoading();
 
@@ -1374,6 +2024,8 @@ void Scene::FinishLoading(Deserializer* source)
         fileName_ = source->GetName();
         checksum_ = source->GetChecksum();
     }
+
+    EndPreloadRecording(source);
 }
 
 void Scene::FinishSaving(Serializer* dest) const
@@ -1386,6 +2038,60 @@ void Scene::FinishSaving(Serializer* dest) const
     }
 }
 
+bool Scene::LoadParallel(Deserializer& source)
+{
+    SceneResolver resolver;
+
+    // Read own ID. Will not be applied, only stored for resolving possible references
+    unsigned nodeID = source.ReadUInt();
+    resolver.AddNode(nodeID, this);
+
+    // Load root level attributes and components, then the child nodes while they are decoded on the worker threads
+    ParallelSceneLoader loader(this);
+    if (!Node::Load(source, resolver, false) || !loader.StartBinary(source) || !loader.CreateNodes(resolver))
+        return false;
+
+    resolver.Resolve();
+    ApplyAttributes();
+    return true;
+}
+
+bool Scene::LoadXMLParallel(const XMLElement& source)
+{
+    SceneResolver resolver;
+
+    // Read own ID. Will not be applied, only stored for resolving possible references
+    unsigned nodeID = source.GetUInt("id");
+    resolver.AddNode(nodeID, this);
+
+    // Load root level attributes and components, then the child nodes while they are decoded on the worker threads
+    ParallelSceneLoader loader(this);
+    if (!Node::LoadXML(source, resolver, false) || !loader.StartXML(source) || !loader.CreateNodes(resolver))
+        return false;
+
+    resolver.Resolve();
+    ApplyAttributes();
+    return true;
+}
+
+bool Scene::LoadJSONParallel(const JSONValue& source)
+{
+    SceneResolver resolver;
+
+    // Read own ID. Will not be applied, only stored for resolving possible references
+    unsigned nodeID = source.Get("id").GetUInt();
+    resolver.AddNode(nodeID, this);
+
+    // Load root level attributes and components, then the child nodes while they are decoded on the worker threads
+    ParallelSceneLoader loader(this);
+    if (!Node::LoadJSON(source, resolver, false) || !loader.StartJSON(source) || !loader.CreateNodes(resolver))
+        return false;
+
+    resolver.Resolve();
+    ApplyAttributes();
+    return true;
+}
+
 void Scene::PreloadResources(File* file, bool isSceneFile)
 {
     // If not threaded, can not background load resources, so rather load synchronously later when needed
@@ -1462,6 +2168,93 @@ void Scene::PreloadResources(File* file, bool isSceneFile)
 #endif
 }
 
+void Scene::PreloadResourcesPacked(File* file)
+{
+    // If not threaded, can not background load resources, so rather load synchronously later when needed
+#ifdef URHO3D_THREADING
+    auto* cache = GetSubsystem<ResourceCache>();
+
+    ea::vector<ResourceRef> resources;
+    PackedSceneReader reader(context_);
+    reader.ReadResources(*file, resources);
+
+    for (const ResourceRef& ref : resources)
+    {
+        // Sanitate resource name beforehand so that when we get the background load event, the name matches exactly
+        ea::string name = cache->SanitateResourceName(ref.name_);
+        if (cache->BackgroundLoadResource(ref.type_, name))
+        {
+            ++asyncProgress_.totalResources_;
+            asyncProgress_.resources_.insert(StringHash(name));
+        }
+    }
+#endif
+}
+
+bool Scene::PreloadResourcesFromManifest(File* file)
+{
+    // If not threaded, can not background load resources, so rather load synchronously later when needed
+#ifdef URHO3D_THREADING
+    auto* cache = GetSubsystem<ResourceCache>();
+
+    const ea::string manifestName = PreloadManifest::GetManifestName(file->GetName());
+    if (!cache->Exists(manifestName))
+        return false;
+
+    SharedPtr<PreloadManifest> manifest = cache->GetTempResource<PreloadManifest>(manifestName);
+    if (!manifest || manifest->GetSourceChecksum() != file->GetChecksum())
+    {
+        URHO3D_LOGDEBUG("Preload manifest " + manifestName + " is out of date, scanning " + file->GetName() + " instead");
+        return false;
+    }
+
+    // Dependencies come first, so all resources start loading at once instead of being discovered by the resources using them
+    for (const PreloadManifestEntry& entry : manifest->GetEntries())
+    {
+        if (cache->BackgroundLoadResource(entry.type_, entry.name_))
+        {
+            ++asyncProgress_.totalResources_;
+            asyncProgress_.resources_.insert(StringHash(entry.name_));
+        }
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Scene::BeginPreloadRecording()
+{
+    if (recordPreloadManifest_ && !preloadRecording_)
+        preloadRecording_ = GetSubsystem<ResourceCache>()->BeginResourceRecording();
+}
+
+void Scene::EndPreloadRecording(Deserializer* source)
+{
+    if (!preloadRecording_)
+        return;
+
+    preloadRecording_ = false;
+    auto* cache = GetSubsystem<ResourceCache>();
+    SharedPtr<PreloadManifest> manifest = cache->EndResourceRecording();
+    if (!manifest || !source)
+        return;
+
+    // The manifest can only be written next to a file in a resource directory or with an absolute path, not into a package
+    const ea::string sourceFileName = cache->GetResourceFileName(source->GetName());
+    if (sourceFileName.empty())
+    {
+        URHO3D_LOGWARNING("Can not write preload manifest for " + source->GetName() + ", not found in resource directories");
+        return;
+    }
+
+    manifest->SetSourceChecksum(source->GetChecksum());
+    const ea::string manifestFileName = PreloadManifest::GetManifestName(sourceFileName);
+    if (manifest->SaveFile(manifestFileName))
+        URHO3D_LOGINFO("Wrote preload manifest of " + ea::to_string(manifest->GetNumEntries()) + " resources to " + manifestFileName);
+}
+
 void Scene::PreloadResourcesXML(const XMLElement& element)
 {
     // If not threaded, can not background load resources, so rather load synchronously later when needed
@@ -1625,7 +2418,7 @@ void Scene::PreloadResourcesJSON(const JSONValue& value)
 #endif
 }
 
-entt::storage<entt::entity, Component*>* Scene::GetComponentIndexStorage(StringHash componentType)
+ComponentIndexStorage* Scene::GetComponentIndexStorage(StringHash componentType)
 {
     const unsigned idx = indexedComponentTypes_.index_of(componentType);
     if (idx < componentIndexes_.size())
@@ -1633,6 +2426,30 @@ entt::storage<entt::entity, Component*>* Scene::GetComponentIndexStorage(StringH
     return nullptr;
 }
 
+void Scene::UpdateVarIndexes(Node* node, bool add)
+{
+    const VariantMap& vars = node->GetVars();
+    for (auto i = vars.begin(); i != vars.end(); ++i)
+    {
+        auto index = varIndexes_.find(i->first);
+        if (index == varIndexes_.end() || i->second.IsEmpty())
+            continue;
+
+        if (add)
+            index->second[i->second].push_back(node);
+        else
+        {
+            auto nodes = index->second.find(i->second);
+            if (nodes != index->second.end())
+            {
+                nodes->second.erase_first(node);
+                if (nodes->second.empty())
+                    index->second.erase(nodes);
+            }
+        }
+    }
+}
+
 void RegisterSceneLibrary(Context* context)
 {
     ValueAnimation::RegisterObject(context);
@@ -1644,6 +2461,7 @@ void RegisterSceneLibrary(Context* context)
     SplinePath::RegisterObject(context);
     SceneManager::RegisterObject(context);
     CameraViewport::RegisterObject(context);
+    CompiledPrefab::RegisterObject(context);
 }
 
 }
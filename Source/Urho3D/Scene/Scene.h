@@ -30,7 +30,9 @@
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONFile.h"
+#include "../Scene/DataComponent.h"
 #include "../Scene/Node.h"
+#include "../Scene/SceneQuery.h"
 #include "../Scene/SceneResolver.h"
 
 #include <entt/entity/registry.hpp>
@@ -38,8 +40,17 @@
 namespace Urho3D
 {
 
+class AttributeAnimationSystem;
+class CompiledPrefab;
 class File;
 class PackageFile;
+class ParallelSceneLoader;
+class SceneSaveSnapshot;
+class SceneSaveTracker;
+struct SceneSaveWorkItem;
+class SceneSnapshot;
+class SceneSnapshotTracker;
+class TransformSystem;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -72,6 +83,8 @@ struct AsyncProgress
 
     /// Current JSON child array and for JSON mode
     unsigned jsonIndex_;
+    /// Packed file flag. The whole file is loaded at once.
+    bool packed_;
 
     /// Current load mode.
     LoadMode mode_;
@@ -104,23 +117,54 @@ public:
     /// Register object factory. Node must be registered first.
     static void RegisterObject(Context* context);
 
-    /// Enable registry. Scene must be empty.
+    /// Enable registry. Existing nodes are added to the registry.
     bool EnableRegistry();
-    /// Create component index. Scene must be empty.
+    /// Create component index. Existing components of the type are indexed.
     bool CreateComponentIndex(StringHash componentType);
-    /// Create component index for template type. Scene must be empty.
+    /// Create component index for template type. Existing components of the type are indexed.
     template <class T> void CreateComponentIndex() { CreateComponentIndex(T::GetTypeStatic()); }
     /// Return registry.
     entt::registry& GetRegistry() { return reg_; }
+    /// Return whether component type is indexed.
+    bool HasComponentIndex(StringHash componentType) const { return indexedComponentTypes_.contains(componentType); }
     /// Return component index. Iterable. Invalidated when indexed component is added or removed!
     ea::span<Component* const> GetComponentIndex(StringHash componentType);
     /// Return component index for template type. Invalidated when indexed component is added or removed!
     template <class T> ea::span<Component* const> GetComponentIndex() { return GetComponentIndex(T::GetTypeStatic()); }
+    /// Return view of the nodes that have all the included component types and none of the excluded ones. All the types must be indexed. Invalidated when indexed component is added or removed!
+    SceneComponentView GetComponentView(std::initializer_list<StringHash> include, std::initializer_list<StringHash> exclude = {});
+    /// Create index of the nodes by the value of a user variable. Existing nodes are indexed.
+    void CreateVarIndex(StringHash key);
+    /// Return nodes with a user variable value. The variable must be indexed. Invalidated when the variable of any node is set!
+    ea::span<Node* const> GetNodesWithVar(StringHash key, const Variant& value) const;
+
+    /// Register data component type for serialization and network replication. Enables the registry. Data components are plain trivially copyable structures stored in dense registry arrays and attached to node entities.
+    template <class T> void RegisterDataComponent(const ea::string& name);
+    /// Create or replace data component of a node. Registry must be enabled. Call MarkNetworkUpdate() on the node after changing a data component that should be replicated.
+    template <class T, class... Args> T& CreateDataComponent(Node* node, Args&&... args) { return reg_.assign_or_replace<T>(node->GetEntity(), std::forward<Args>(args)...); }
+    /// Return data component of a node, or null if the node has none.
+    template <class T> T* GetDataComponent(const Node* node) { return reg_.try_get<T>(node->GetEntity()); }
+    /// Remove data component from a node, if present.
+    template <class T> void RemoveDataComponent(const Node* node) { reg_.reset<T>(node->GetEntity()); }
+    /// Return view of the entities having all the data component types, iterated in dense arrays.
+    template <class... T> auto GetDataComponentView() { return reg_.view<T...>(); }
+    /// Return registered data component types.
+    const ea::vector<DataComponentType>& GetDataComponentTypes() const { return dataComponentTypes_; }
+    /// Return registered data component type, or null if not registered.
+    const DataComponentType* GetDataComponentType(StringHash type) const;
+    /// Return number of data components of registered types attached to a node.
+    unsigned GetNumDataComponents(const Node* node) const;
+    /// Write the data components of registered types attached to a node in binary archive format. Nothing is written if the node has none.
+    void SaveDataComponents(const Node* node, Serializer& dest);
+    /// Replace the data components of registered types attached to a node with the ones written by SaveDataComponents(). Return true if successful.
+    bool LoadDataComponents(Node* node, const ea::vector<unsigned char>& data);
+    /// Copy the data components of registered types from one node to another.
+    void CopyDataComponents(const Node* source, Node* dest);
 
     /// Serialize from/to archive. Return true if successful.
     bool Serialize(Archive& archive) override;
 
-    /// Load from binary data. Removes all existing child nodes and components first. Return true if successful.
+    /// Load from binary data. Packed scene files are also accepted. Removes all existing child nodes and components first. Return true if successful.
     bool Load(Deserializer& source) override;
     /// Save to binary data. Return true if successful.
     bool Save(Serializer& dest) const override;
@@ -141,6 +185,8 @@ public:
     bool SaveXML(Serializer& dest, const ea::string& indentation = "\t") const;
     /// Save to a JSON file. Return true if successful.
     bool SaveJSON(Serializer& dest, const ea::string& indentation = "\t") const;
+    /// Save to a packed binary file, which stores the attribute schema of each type once and attribute values without type tags. Component values are optionally grouped by type. Loaded by Load() and LoadAsync(). Return true if successful.
+    bool SavePacked(Serializer& dest, bool groupComponents = true) const;
     /// Load from a binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsync(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
     /// Load from an XML file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
@@ -161,6 +207,8 @@ public:
         (const JSONValue& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Instantiate scene content from JSON data. Return root node if successful.
     Node* InstantiateJSON(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a compiled prefab. Faster than instantiating from binary, XML or JSON data. Return root node if successful.
+    Node* Instantiate(CompiledPrefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
 
     /// Clear scene completely of either replicated, local or all nodes and components.
     void Clear(bool clearReplicated = true, bool clearLocal = true);
@@ -176,6 +224,28 @@ public:
     void SetSnapThreshold(float threshold);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     void SetAsyncLoadingMs(int ms);
+    /// Set whether to record the resources used when loading a scene or preloading an object prefab from a file, and write them as a preload manifest next to the file. Asynchronous loading queues all resources listed in an up to date manifest at once instead of scanning the file for them.
+    void SetRecordPreloadManifest(bool enable) { recordPreloadManifest_ = enable; }
+    /// Set whether loading decodes the attributes of child nodes and their components on worker threads, while objects are still created on the main thread. Applies to both synchronous and asynchronous loading of binary, XML and JSON scenes.
+    void SetParallelLoading(bool enable) { parallelLoading_ = enable; }
+    /// Set whether node and component changes are tracked for incremental saving. Changes are reported by attribute writes and by the MarkNetworkUpdate() calls of setter functions. Enabling marks the whole scene changed.
+    void SetSaveTracking(bool enable);
+    /// Set whether world transforms are updated in batch. Moved nodes are only flagged, and their world transforms are recalculated and their listener components notified once per update, before the scene subsystem update, after the post-update and before octree update.
+    void SetBatchedTransformUpdate(bool enable);
+    /// Recalculate the world transforms of moved nodes and notify their listener components, if batched transform update is enabled. Must be called from the main thread.
+    void UpdateTransforms();
+    /// Set whether the attribute animations of nodes and components are evaluated in batch after the attribute animation update event, instead of by each object on the event. Event frames are sent after all animated values are applied.
+    void SetBatchedAttributeAnimation(bool enable);
+    /// Add a node or component attribute to capture in scene snapshots, in addition to the node transforms. Component attributes are read from the first component of the type in each node. Return true if successful.
+    bool AddSnapshotAttribute(StringHash objectType, const ea::string& name);
+    /// Capture a read-only versioned snapshot of the node transforms and the selected attributes, which worker threads can read while the scene changes. Pages of unchanged nodes are shared with the previous snapshot. Must be called from the main thread.
+    SharedPtr<SceneSnapshot> CaptureSnapshot();
+    /// Capture a copy-on-write save snapshot of the persistent scene state. Only the nodes and components changed since the previous capture are serialized; the snapshot can then be written on any thread. Return null if save tracking is disabled.
+    SharedPtr<SceneSaveSnapshot> CaptureSaveSnapshot();
+    /// Capture a save snapshot and write it to a binary file on a worker thread, either as the delta since the previous capture or as the full scene. Return the work item, which tells whether the file was written once completed, or null if saving could not be started.
+    SharedPtr<SceneSaveWorkItem> SaveSnapshotAsync(const ea::string& fileName, bool delta);
+    /// Apply a binary delta written by SceneSaveSnapshot::SaveDelta() to a scene loaded from the previous snapshot. Return true if successful.
+    bool ApplyDelta(Deserializer& source);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -193,6 +263,8 @@ public:
     Component* GetComponent(unsigned id) const;
     /// Get nodes with specific tag from the whole scene, return false if empty.
     bool GetNodesWithTag(ea::vector<Node*>& dest, const ea::string& tag)  const;
+    /// Return nodes with specific tag from the whole scene without copying. Invalidated when the tag is added or removed!
+    ea::span<Node* const> GetNodesWithTag(StringHash tag) const;
 
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
@@ -227,6 +299,25 @@ public:
     /// Return maximum milliseconds per frame to spend on async loading.
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
 
+    /// Return whether preload manifests are recorded when loading.
+    bool GetRecordPreloadManifest() const { return recordPreloadManifest_; }
+
+    /// Return whether child node attributes are decoded on worker threads when loading.
+    bool GetParallelLoading() const { return parallelLoading_; }
+
+    /// Return whether node and component changes are tracked for incremental saving.
+    bool GetSaveTracking() const { return saveTracker_ != nullptr; }
+
+    /// Return whether world transforms are updated in batch.
+    bool GetBatchedTransformUpdate() const { return transformSystem_ != nullptr; }
+    /// Return batched transform system, or null if disabled.
+    TransformSystem* GetTransformSystem() const { return transformSystem_.get(); }
+
+    /// Return whether attribute animations are evaluated in batch.
+    bool GetBatchedAttributeAnimation() const { return attributeAnimationSystem_ != nullptr; }
+    /// Return batched attribute animation system, or null if disabled.
+    AttributeAnimationSystem* GetAttributeAnimationSystem() const { return attributeAnimationSystem_.get(); }
+
     /// Return required package files.
     const ea::vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
 
@@ -256,6 +347,8 @@ public:
     void NodeTagAdded(Node* node, const ea::string& tag);
     /// Cache node by tag if tag not zero.
     void NodeTagRemoved(Node* node, const ea::string& tag);
+    /// Update the index of a node user variable before it changes. An empty value removes the variable. Called by Node.
+    void NodeVarChanged(Node* node, StringHash key, const Variant& value);
 
     /// Node added. Assign scene pointer and add to ID map.
     void NodeAdded(Node* node);
@@ -277,6 +370,10 @@ public:
     void MarkNetworkUpdate(Node* node);
     /// Mark a component for attribute check on the next network update.
     void MarkNetworkUpdate(Component* component);
+    /// Mark a node changed for incremental saving. Is thread-safe during threaded update.
+    void MarkSaveDirty(Node* node);
+    /// Mark a component changed for incremental saving. Is thread-safe during threaded update.
+    void MarkSaveDirty(Component* component);
     /// Mark a node dirty in scene replication states. The node does not need to have own replication state yet.
     void MarkReplicationDirty(Node* node);
 
@@ -285,6 +382,8 @@ private:
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Handle a node or component temporary flag change during save tracking.
+    void HandleTemporaryChanged(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
     void UpdateAsyncLoading();
     /// Finish asynchronous loading.
@@ -295,12 +394,28 @@ private:
     void FinishSaving(Serializer* dest) const;
     /// Preload resources from a binary scene or object prefab file.
     void PreloadResources(File* file, bool isSceneFile);
+    /// Preload resources from a packed scene file.
+    void PreloadResourcesPacked(File* file);
     /// Preload resources from an XML scene or object prefab file.
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    /// Preload resources listed in the preload manifest of a scene or object prefab file. Return false if there is no up to date manifest.
+    bool PreloadResourcesFromManifest(File* file);
+    /// Load own attributes and components from binary data, then child nodes with the parallel loader. Return true if successful.
+    bool LoadParallel(Deserializer& source);
+    /// Load own attributes and components from XML data, then child nodes with the parallel loader. Return true if successful.
+    bool LoadXMLParallel(const XMLElement& source);
+    /// Load own attributes and components from JSON data, then child nodes with the parallel loader. Return true if successful.
+    bool LoadJSONParallel(const JSONValue& source);
+    /// Begin recording the resources used for a preload manifest, if enabled.
+    void BeginPreloadRecording();
+    /// End recording the resources used and write the preload manifest next to the source file. Discard the recording if source is null.
+    void EndPreloadRecording(Deserializer* source);
     /// Return component index storage for given type.
-    entt::storage<entt::entity, Component*>* GetComponentIndexStorage(StringHash componentType);
+    ComponentIndexStorage* GetComponentIndexStorage(StringHash componentType);
+    /// Add node to or remove node from the user variable indexes.
+    void UpdateVarIndexes(Node* node, bool add);
 
     /// Whether the registry is active.
     bool registryEnabled_{ false };
@@ -309,7 +424,11 @@ private:
     /// Types of components that should be indexed.
     ea::vector<StringHash> indexedComponentTypes_;
     /// Indexes of components.
-    ea::vector<entt::storage<entt::entity, Component*>> componentIndexes_;
+    ea::vector<ComponentIndexStorage> componentIndexes_;
+    /// Registered data component types.
+    ea::vector<DataComponentType> dataComponentTypes_;
+    /// Nodes by user variable value for indexed variables.
+    ea::unordered_map<StringHash, ea::unordered_map<Variant, ea::vector<Node*> > > varIndexes_;
 
     /// Replicated scene nodes by ID.
     ea::unordered_map<unsigned, Node*> replicatedNodes_;
@@ -325,6 +444,16 @@ private:
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
     SceneResolver resolver_;
+    /// Parallel loader of child nodes for asynchronous loading.
+    ea::unique_ptr<ParallelSceneLoader> asyncLoader_;
+    /// Node and component change tracker for incremental saving.
+    ea::unique_ptr<SceneSaveTracker> saveTracker_;
+    /// Read-only scene snapshot capture.
+    ea::unique_ptr<SceneSnapshotTracker> snapshotTracker_;
+    /// Batched world transform update.
+    ea::unique_ptr<TransformSystem> transformSystem_;
+    /// Batched attribute animation update.
+    ea::unique_ptr<AttributeAnimationSystem> attributeAnimationSystem_;
     /// Source file name.
     mutable ea::string fileName_;
     /// Required package files for networking.
@@ -367,8 +496,21 @@ private:
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Preload manifest recording enabled flag.
+    bool recordPreloadManifest_;
+    /// Preload manifest recording in progress flag.
+    bool preloadRecording_;
+    /// Parallel loading flag.
+    bool parallelLoading_;
 };
 
+template <class T> void Scene::RegisterDataComponent(const ea::string& name)
+{
+    EnableRegistry();
+    if (!GetDataComponentType(name))
+        dataComponentTypes_.push_back(MakeDataComponentType<T>(name));
+}
+
 /// Register Scene library objects.
 void URHO3D_API RegisterSceneLibrary(Context* context);
 
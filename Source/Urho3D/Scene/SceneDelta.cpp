@@ -0,0 +1,305 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/Serializer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneDelta.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+bool SceneSaveSnapshot::Save(Serializer& dest) const
+{
+    if (!dest.WriteFileID("USCN"))
+    {
+        URHO3D_LOGERROR("Could not save scene snapshot, writing to stream failed");
+        return false;
+    }
+
+    return !nodes_.empty() && SaveNode(dest, 0) != M_MAX_UNSIGNED;
+}
+
+bool SceneSaveSnapshot::SaveDelta(Serializer& dest) const
+{
+    if (!dest.WriteFileID("USCD"))
+    {
+        URHO3D_LOGERROR("Could not save scene delta, writing to stream failed");
+        return false;
+    }
+
+    dest.WriteVLE(removedNodes_.size());
+    for (unsigned id : removedNodes_)
+        dest.WriteUInt(id);
+    dest.WriteVLE(removedComponents_.size());
+    for (unsigned id : removedComponents_)
+        dest.WriteUInt(id);
+
+    dest.WriteVLE(changedNodes_.size());
+    for (unsigned index : changedNodes_)
+    {
+        const SceneSaveNodeRecord& record = *nodes_[index].record_;
+        if (!dest.WriteUInt(record.id_))
+        {
+            URHO3D_LOGERROR("Could not save scene delta, writing to stream failed");
+            return false;
+        }
+        dest.WriteUInt(record.parentID_);
+        dest.WriteVLE(record.attributes_.size());
+        dest.Write(record.attributes_.data(), record.attributes_.size());
+
+        // Unchanged components are listed by ID only
+        dest.WriteVLE(record.components_.size());
+        for (const SceneSaveComponentRecord* component : record.components_)
+        {
+            const bool changed = component->serial_ == serial_;
+            dest.WriteUInt(component->id_);
+            dest.WriteBool(changed);
+            if (changed)
+            {
+                dest.WriteVLE(component->data_.size());
+                dest.Write(component->data_.data(), component->data_.size());
+            }
+        }
+    }
+
+    return true;
+}
+
+unsigned SceneSaveSnapshot::SaveNode(Serializer& dest, unsigned index) const
+{
+    // Same layout as Node::Save()
+    const NodeEntry& entry = nodes_[index];
+    const SceneSaveNodeRecord& record = *entry.record_;
+    if (!dest.WriteUInt(record.id_))
+        return M_MAX_UNSIGNED;
+    dest.Write(record.attributes_.data(), record.attributes_.size());
+
+    dest.WriteVLE(record.components_.size());
+    for (const SceneSaveComponentRecord* component : record.components_)
+    {
+        dest.WriteVLE(component->data_.size());
+        dest.Write(component->data_.data(), component->data_.size());
+    }
+
+    dest.WriteVLE(entry.numChildren_);
+    ++index;
+    for (unsigned i = 0; i < entry.numChildren_ && index != M_MAX_UNSIGNED; ++i)
+        index = SaveNode(dest, index);
+
+    return index;
+}
+
+SceneSaveTracker::SceneSaveTracker(Scene* scene) :
+    scene_(scene)
+{
+    MarkHierarchyDirty(scene_);
+}
+
+void SceneSaveTracker::MarkDirty(Node* node)
+{
+    node->saveDirty_ = true;
+    dirtyNodes_.insert(node->GetID());
+}
+
+void SceneSaveTracker::MarkDirty(Component* component)
+{
+    component->saveDirty_ = true;
+    dirtyComponents_.insert(component->GetID());
+    if (Node* node = component->GetNode())
+        dirtyNodes_.insert(node->GetID());
+}
+
+void SceneSaveTracker::MarkHierarchyDirty(Node* node)
+{
+    ea::vector<Node*> nodes;
+    node->GetChildren(nodes, true);
+    nodes.push_back(node);
+    for (Node* child : nodes)
+    {
+        MarkDirty(child);
+        for (Component* component : child->GetComponents())
+            MarkDirty(component);
+    }
+}
+
+void SceneSaveTracker::NodeRemoved(Node* node)
+{
+    const unsigned id = node->GetID();
+    dirtyNodes_.erase(id);
+    if (nodeRecords_.erase(id))
+        removedNodes_.push_back(id);
+}
+
+void SceneSaveTracker::ComponentRemoved(Component* component)
+{
+    const unsigned id = component->GetID();
+    dirtyComponents_.erase(id);
+    if (componentRecords_.erase(id))
+        removedComponents_.push_back(id);
+
+    // The node record lists its components, unless the node itself is being removed
+    Node* node = component->GetNode();
+    if (node && node->GetScene() == scene_)
+        dirtyNodes_.insert(node->GetID());
+}
+
+SharedPtr<SceneSaveSnapshot> SceneSaveTracker::Capture()
+{
+    URHO3D_PROFILE("CaptureSaveSnapshot");
+
+    SharedPtr<SceneSaveSnapshot> snapshot(new SceneSaveSnapshot());
+    snapshot->serial_ = serial_;
+
+    // Serialize changed components first, so that the records of their nodes pick them up
+    for (unsigned id : dirtyComponents_)
+    {
+        Component* component = scene_->GetComponent(id);
+        if (!component)
+            continue;
+        component->saveDirty_ = false;
+        if (!component->IsTemporary())
+            componentRecords_[id] = CaptureComponent(component);
+        else if (componentRecords_.erase(id))
+            removedComponents_.push_back(id);
+    }
+    dirtyComponents_.clear();
+
+    for (unsigned id : dirtyNodes_)
+    {
+        Node* node = scene_->GetNode(id);
+        if (!node)
+            continue;
+        node->saveDirty_ = false;
+        if (!node->IsTemporary())
+            nodeRecords_[id] = CaptureNode(node);
+        else if (nodeRecords_.erase(id))
+            removedNodes_.push_back(id);
+    }
+    dirtyNodes_.clear();
+
+    // Scene attributes such as elapsed time and the next free IDs change without notification, so compare them with
+    // the previous record and keep it if nothing changed
+    SharedPtr<SceneSaveNodeRecord> sceneRecord = CaptureNode(scene_);
+    SharedPtr<SceneSaveNodeRecord>& lastSceneRecord = nodeRecords_[scene_->GetID()];
+    if (!lastSceneRecord || lastSceneRecord->attributes_ != sceneRecord->attributes_ ||
+        lastSceneRecord->components_ != sceneRecord->components_)
+        lastSceneRecord = sceneRecord;
+
+    // Collect the records of the persistent hierarchy in depth-first order. Only pointers are copied here
+    ea::vector<Node*> stack;
+    stack.push_back(scene_);
+    while (!stack.empty())
+    {
+        Node* node = stack.back();
+        stack.pop_back();
+
+        // A node may lack a record if it was temporary when last changed
+        SharedPtr<SceneSaveNodeRecord>& record = nodeRecords_[node->GetID()];
+        if (!record)
+            record = CaptureNode(node);
+
+        const ea::vector<SharedPtr<Node> >& children = node->GetChildren();
+        unsigned numChildren = 0;
+        for (auto i = children.rbegin(); i != children.rend(); ++i)
+        {
+            if (!(*i)->IsTemporary())
+            {
+                stack.push_back(*i);
+                ++numChildren;
+            }
+        }
+
+        if (record->serial_ == serial_)
+            snapshot->changedNodes_.push_back(snapshot->nodes_.size());
+        snapshot->nodes_.push_back({ record, numChildren });
+    }
+
+    snapshot->removedNodes_.swap(removedNodes_);
+    snapshot->removedComponents_.swap(removedComponents_);
+    ++serial_;
+
+    return snapshot;
+}
+
+SharedPtr<SceneSaveNodeRecord> SceneSaveTracker::CaptureNode(Node* node)
+{
+    SharedPtr<SceneSaveNodeRecord> record(new SceneSaveNodeRecord());
+    record->id_ = node->GetID();
+    record->parentID_ = node->GetParent() ? node->GetParent()->GetID() : 0;
+    record->serial_ = serial_;
+
+    VectorBuffer buffer;
+    node->Animatable::Save(buffer);
+    record->attributes_ = buffer.GetBuffer();
+
+    for (Component* component : node->GetComponents())
+    {
+        if (component->IsTemporary())
+            continue;
+
+        SharedPtr<SceneSaveComponentRecord>& componentRecord = componentRecords_[component->GetID()];
+        if (!componentRecord)
+            componentRecord = CaptureComponent(component);
+        record->components_.push_back(componentRecord);
+    }
+
+    return record;
+}
+
+SharedPtr<SceneSaveComponentRecord> SceneSaveTracker::CaptureComponent(Component* component)
+{
+    SharedPtr<SceneSaveComponentRecord> record(new SceneSaveComponentRecord());
+    record->id_ = component->GetID();
+    record->serial_ = serial_;
+
+    VectorBuffer buffer;
+    component->Save(buffer);
+    record->data_ = buffer.GetBuffer();
+
+    return record;
+}
+
+bool CompactSceneDeltas(Context* context, Deserializer& base, const ea::vector<Deserializer*>& deltas, Serializer& dest)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    if (!scene->Load(base))
+        return false;
+
+    for (Deserializer* delta : deltas)
+    {
+        if (!scene->ApplyDelta(*delta))
+            return false;
+    }
+
+    return scene->Save(dest);
+}
+
+}
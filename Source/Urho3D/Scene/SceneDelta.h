@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include <EASTL/hash_set.h>
+#include <EASTL/unordered_map.h>
+
+#include "../Container/Ptr.h"
+#include "../Container/RefCounted.h"
+#include "../Core/WorkQueue.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class Component;
+class Context;
+class Deserializer;
+class Node;
+class Scene;
+class Serializer;
+
+/// Serialized state of a component, shared between snapshots until the component changes.
+struct SceneSaveComponentRecord : public RefCounted
+{
+    /// Component ID.
+    unsigned id_{};
+    /// Snapshot serial at which the record was captured.
+    unsigned serial_{};
+    /// Binary component data as written by Component::Save().
+    ea::vector<unsigned char> data_;
+};
+
+/// Serialized state of a node without its children, shared between snapshots until the node or one of its components changes.
+struct SceneSaveNodeRecord : public RefCounted
+{
+    /// Node ID.
+    unsigned id_{};
+    /// Parent node ID.
+    unsigned parentID_{};
+    /// Snapshot serial at which the record was captured.
+    unsigned serial_{};
+    /// Binary node attribute data.
+    ea::vector<unsigned char> attributes_;
+    /// Persistent components.
+    ea::vector<SharedPtr<SceneSaveComponentRecord> > components_;
+};
+
+/// Immutable copy-on-write snapshot of the persistent scene state, captured on the main thread and written on any thread. Unchanged objects share their serialized records with the previous snapshot, so a capture only serializes the nodes and components changed since the previous one. Holds both the full node hierarchy and the delta since the previous snapshot.
+class URHO3D_API SceneSaveSnapshot : public RefCounted
+{
+    friend class SceneSaveTracker;
+
+public:
+    /// Write the full scene in the binary scene format. The result is loadable with Scene::Load(). Is thread-safe.
+    bool Save(Serializer& dest) const;
+    /// Write the changes since the previous snapshot in the binary delta format. The result is applicable with Scene::ApplyDelta() to a scene loaded from the previous snapshot. Is thread-safe.
+    bool SaveDelta(Serializer& dest) const;
+
+    /// Return snapshot serial. Serials increase by one with each capture.
+    unsigned GetSerial() const { return serial_; }
+    /// Return number of persistent nodes including the scene.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+    /// Return number of nodes written to the delta.
+    unsigned GetNumChangedNodes() const { return changedNodes_.size(); }
+    /// Return number of node and component tombstones written to the delta.
+    unsigned GetNumRemoved() const { return removedNodes_.size() + removedComponents_.size(); }
+    /// Return whether the delta contains any changes.
+    bool HasChanges() const { return !changedNodes_.empty() || GetNumRemoved() != 0; }
+
+private:
+    /// Node in depth-first order.
+    struct NodeEntry
+    {
+        /// Node record.
+        SharedPtr<SceneSaveNodeRecord> record_;
+        /// Number of persistent children, which follow the node recursively.
+        unsigned numChildren_;
+    };
+
+    /// Write a node with its descendants starting from the given index. Return the index after the last descendant, or M_MAX_UNSIGNED on failure.
+    unsigned SaveNode(Serializer& dest, unsigned index) const;
+
+    /// Snapshot serial.
+    unsigned serial_{};
+    /// Persistent nodes in depth-first order, starting from the scene.
+    ea::vector<NodeEntry> nodes_;
+    /// Indices of nodes recaptured since the previous snapshot, parents before children.
+    ea::vector<unsigned> changedNodes_;
+    /// IDs of nodes removed since the previous snapshot.
+    ea::vector<unsigned> removedNodes_;
+    /// IDs of components removed since the previous snapshot.
+    ea::vector<unsigned> removedComponents_;
+};
+
+/// Work item writing a save snapshot to a binary file on a worker thread. The result is valid once the item has completed.
+struct SceneSaveWorkItem : public WorkItem
+{
+    /// Context.
+    Context* context_{};
+    /// Snapshot to write.
+    SharedPtr<SceneSaveSnapshot> snapshot_;
+    /// Destination file name.
+    ea::string fileName_;
+    /// Whether to write the delta instead of the full scene.
+    bool delta_{};
+    /// Whether the file was written successfully. Set by the work function.
+    mutable std::atomic<bool> success_{};
+};
+
+/// Tracks the nodes and components of a scene changed since the last captured save snapshot, and caches the serialized state of unchanged objects. Changes are reported by attribute writes, by the replication change notifications (MarkNetworkUpdate) and by scene membership changes.
+class URHO3D_API SceneSaveTracker
+{
+public:
+    /// Construct for a scene and mark all its current nodes and components changed.
+    explicit SceneSaveTracker(Scene* scene);
+
+    /// Mark a node changed.
+    void MarkDirty(Node* node);
+    /// Mark a component and its node changed.
+    void MarkDirty(Component* component);
+    /// Mark a node with its components and all descendants changed.
+    void MarkHierarchyDirty(Node* node);
+    /// Handle node removal from the scene.
+    void NodeRemoved(Node* node);
+    /// Handle component removal from the scene.
+    void ComponentRemoved(Component* component);
+
+    /// Capture a snapshot, serializing the objects changed since the previous capture. Must be called from the main thread.
+    SharedPtr<SceneSaveSnapshot> Capture();
+
+private:
+    /// Serialize a node without its children.
+    SharedPtr<SceneSaveNodeRecord> CaptureNode(Node* node);
+    /// Serialize a component.
+    SharedPtr<SceneSaveComponentRecord> CaptureComponent(Component* component);
+
+    /// Scene.
+    Scene* scene_;
+    /// Serial of the next snapshot.
+    unsigned serial_{1};
+    /// Nodes changed since the previous capture.
+    ea::hash_set<unsigned> dirtyNodes_;
+    /// Components changed since the previous capture.
+    ea::hash_set<unsigned> dirtyComponents_;
+    /// Nodes removed since the previous capture.
+    ea::vector<unsigned> removedNodes_;
+    /// Components removed since the previous capture.
+    ea::vector<unsigned> removedComponents_;
+    /// Latest node records by ID.
+    ea::unordered_map<unsigned, SharedPtr<SceneSaveNodeRecord> > nodeRecords_;
+    /// Latest component records by ID.
+    ea::unordered_map<unsigned, SharedPtr<SceneSaveComponentRecord> > componentRecords_;
+};
+
+/// Compact a full binary scene and the deltas saved after it, in order, into a single full binary scene. Return true if successful.
+URHO3D_API bool CompactSceneDeltas(Context* context, Deserializer& base, const ea::vector<Deserializer*>& deltas, Serializer& dest);
+
+}
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include <EASTL/fixed_vector.h>
+
+#include "../Scene/Component.h"
+#include "../Scene/Node.h"
+
+#include <entt/entity/storage.hpp>
+
+namespace Urho3D
+{
+
+/// Component index storage of the scene registry.
+using ComponentIndexStorage = entt::storage<entt::entity, Component*>;
+
+/// View of the scene nodes that have all the included component types and none of the excluded ones. All the types must be indexed with Scene::CreateComponentIndex(). Iterates the smallest included index and checks the other indexes for each node, so neither creating the view for up to MAX_STATIC_TYPES types nor iterating it allocates. Invalidated when an indexed component is added or removed.
+class SceneComponentView
+{
+public:
+    /// Maximum number of component types without heap allocation.
+    static const unsigned MAX_STATIC_TYPES = 4;
+    /// Storage container.
+    using StorageVector = ea::fixed_vector<const ComponentIndexStorage*, MAX_STATIC_TYPES>;
+
+    /// Node iterator.
+    class Iterator
+    {
+    public:
+        /// Construct.
+        Iterator(const SceneComponentView* view, unsigned index) : view_(view), index_(index) { SkipMismatches(); }
+
+        /// Return current node.
+        Node* operator *() const { return view_->smallest_->raw()[index_]->GetNode(); }
+        /// Advance to the next matching node.
+        Iterator& operator ++()
+        {
+            ++index_;
+            SkipMismatches();
+            return *this;
+        }
+        /// Test for equality with another iterator.
+        bool operator ==(const Iterator& rhs) const { return index_ == rhs.index_; }
+        /// Test for inequality with another iterator.
+        bool operator !=(const Iterator& rhs) const { return index_ != rhs.index_; }
+
+    private:
+        /// Advance to the first matching node at or after the current index.
+        void SkipMismatches()
+        {
+            const unsigned size = view_->GetMaxSize();
+            while (index_ < size && !view_->Contains(view_->smallest_->data()[index_]))
+                ++index_;
+        }
+
+        /// View.
+        const SceneComponentView* view_;
+        /// Index in the smallest included storage.
+        unsigned index_;
+    };
+
+    /// Construct empty view.
+    SceneComponentView() = default;
+    /// Construct from included and excluded storages.
+    SceneComponentView(const StorageVector& include, const StorageVector& exclude)
+        : include_(include)
+        , exclude_(exclude)
+    {
+        for (const ComponentIndexStorage* storage : include_)
+        {
+            if (!smallest_ || storage->size() < smallest_->size())
+                smallest_ = storage;
+        }
+    }
+
+    /// Return iterator to the first matching node.
+    Iterator begin() const { return { this, 0 }; }
+    /// Return iterator past the last matching node.
+    Iterator end() const { return { this, GetMaxSize() }; }
+
+    /// Return whether a node matches the view.
+    bool Contains(const Node* node) const { return node && smallest_ && Contains(node->GetEntity()); }
+    /// Return included component of a matching node by the index of its type in the view.
+    Component* GetComponent(const Node* node, unsigned index) const { return include_[index]->get(node->GetEntity()); }
+    /// Return upper bound of the number of matching nodes.
+    unsigned GetMaxSize() const { return smallest_ ? smallest_->size() : 0; }
+    /// Return whether the view has no included types.
+    bool IsEmpty() const { return !smallest_; }
+
+private:
+    /// Return whether an entity matches the view.
+    bool Contains(entt::entity entity) const
+    {
+        for (const ComponentIndexStorage* storage : include_)
+        {
+            if (!storage->has(entity))
+                return false;
+        }
+        for (const ComponentIndexStorage* storage : exclude_)
+        {
+            if (storage->has(entity))
+                return false;
+        }
+        return true;
+    }
+
+    /// Included storages.
+    StorageVector include_;
+    /// Excluded storages.
+    StorageVector exclude_;
+    /// Smallest included storage.
+    const ComponentIndexStorage* smallest_{};
+};
+
+}
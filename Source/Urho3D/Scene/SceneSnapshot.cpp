@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../IO/Log.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneSnapshot.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+unsigned SceneSnapshot::FindNode(unsigned nodeID) const
+{
+    auto i = index_->entries_.find(nodeID);
+    return i != index_->entries_.end() ? i->second : M_MAX_UNSIGNED;
+}
+
+SceneSnapshotTracker::SceneSnapshotTracker(Scene* scene) :
+    scene_(scene)
+{
+}
+
+bool SceneSnapshotTracker::AddAttribute(StringHash objectType, const ea::string& name)
+{
+    const ea::vector<AttributeInfo>* attributes = scene_->GetContext()->GetAttributes(objectType);
+    const unsigned numAttributes = attributes ? attributes->size() : 0;
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (attributes->at(i).name_ == name)
+        {
+            attributes_.push_back({ objectType, i });
+
+            // The page layout changes, so start over
+            previous_ = nullptr;
+            entryVersions_.clear();
+            freeEntries_.clear();
+            return true;
+        }
+    }
+
+    URHO3D_LOGERROR("Could not find attribute {} to capture in scene snapshots", name);
+    return false;
+}
+
+SharedPtr<SceneSnapshot> SceneSnapshotTracker::Capture()
+{
+    URHO3D_PROFILE("CaptureSceneSnapshot");
+
+    SharedPtr<SceneSnapshot> snapshot(new SceneSnapshot());
+    snapshot->version_ = version_;
+    snapshot->numAttributes_ = attributes_.size();
+    if (previous_)
+    {
+        snapshot->pages_ = previous_->pages_;
+        snapshot->index_ = previous_->index_;
+    }
+    else
+        snapshot->index_ = new SceneSnapshotIndex();
+
+    // Release the previous snapshot, so that pages no longer read through it are written in place
+    previous_ = nullptr;
+
+    scene_->GetChildren(nodes_, true);
+    for (Node* node : nodes_)
+    {
+        const auto i = snapshot->index_->entries_.find(node->GetID());
+        unsigned index;
+        if (i != snapshot->index_->entries_.end())
+            index = i->second;
+        else
+        {
+            if (!freeEntries_.empty())
+            {
+                index = freeEntries_.back();
+                freeEntries_.pop_back();
+            }
+            else
+            {
+                index = entryVersions_.size();
+                entryVersions_.push_back(0);
+                if (index >= snapshot->GetNumEntries())
+                    snapshot->pages_.push_back(MakeShared<SceneSnapshotPage>(attributes_.size()));
+            }
+            GetWritableIndex(*snapshot).entries_[node->GetID()] = index;
+        }
+
+        entryVersions_[index] = version_;
+        CaptureNode(*snapshot, node, index);
+    }
+
+    // Free the entries of removed nodes
+    for (unsigned index = 0; index < entryVersions_.size(); ++index)
+    {
+        if (entryVersions_[index] == version_ || !snapshot->IsValid(index))
+            continue;
+
+        GetWritableIndex(*snapshot).entries_.erase(snapshot->GetNodeID(index));
+        SceneSnapshotPage& page = GetWritablePage(*snapshot, index);
+        const unsigned i = index % SceneSnapshotPage::SIZE;
+        page.nodeIDs_[i] = 0;
+        for (unsigned j = 0; j < attributes_.size(); ++j)
+            page.attributes_[j * SceneSnapshotPage::SIZE + i].Clear();
+        freeEntries_.push_back(index);
+    }
+
+    previous_ = snapshot;
+    ++version_;
+    return snapshot;
+}
+
+void SceneSnapshotTracker::CaptureNode(SceneSnapshot& snapshot, Node* node, unsigned index)
+{
+    const unsigned i = index % SceneSnapshotPage::SIZE;
+    const unsigned nodeID = node->GetID();
+    const unsigned parentID = node->GetParent() ? node->GetParent()->GetID() : 0;
+    const bool enabled = node->IsEnabled();
+    const Matrix3x4& worldTransform = node->GetWorldTransform();
+
+    // Leave the page shared if nothing changed
+    const SceneSnapshotPage* page = &snapshot.GetPage(index);
+    if (page->nodeIDs_[i] != nodeID || page->parentIDs_[i] != parentID || page->enabled_[i] != enabled
+        || page->worldTransforms_[i] != worldTransform)
+    {
+        SceneSnapshotPage& writablePage = GetWritablePage(snapshot, index);
+        writablePage.nodeIDs_[i] = nodeID;
+        writablePage.parentIDs_[i] = parentID;
+        writablePage.enabled_[i] = enabled;
+        writablePage.worldTransforms_[i] = worldTransform;
+        page = &writablePage;
+    }
+
+    for (unsigned j = 0; j < attributes_.size(); ++j)
+    {
+        const Attribute& attribute = attributes_[j];
+        Variant value;
+        if (attribute.objectType_ == Node::GetTypeStatic())
+            value = node->GetAttribute(attribute.index_);
+        else if (Component* component = node->GetComponent(attribute.objectType_))
+            value = component->GetAttribute(attribute.index_);
+
+        const unsigned attributeIndex = j * SceneSnapshotPage::SIZE + i;
+        if (page->attributes_[attributeIndex] != value)
+        {
+            SceneSnapshotPage& writablePage = GetWritablePage(snapshot, index);
+            writablePage.attributes_[attributeIndex] = value;
+            page = &writablePage;
+        }
+    }
+}
+
+SceneSnapshotPage& SceneSnapshotTracker::GetWritablePage(SceneSnapshot& snapshot, unsigned index)
+{
+    SharedPtr<SceneSnapshotPage>& page = snapshot.pages_[index / SceneSnapshotPage::SIZE];
+    if (page->Refs() > 1)
+    {
+        // An older snapshot still references the page, copy it
+        SharedPtr<SceneSnapshotPage> copy = MakeShared<SceneSnapshotPage>(attributes_.size());
+        ea::copy_n(page->nodeIDs_, SceneSnapshotPage::SIZE, copy->nodeIDs_);
+        ea::copy_n(page->parentIDs_, SceneSnapshotPage::SIZE, copy->parentIDs_);
+        ea::copy_n(page->enabled_, SceneSnapshotPage::SIZE, copy->enabled_);
+        ea::copy_n(page->worldTransforms_, SceneSnapshotPage::SIZE, copy->worldTransforms_);
+        copy->attributes_ = page->attributes_;
+        page = copy;
+    }
+    return *page;
+}
+
+SceneSnapshotIndex& SceneSnapshotTracker::GetWritableIndex(SceneSnapshot& snapshot)
+{
+    if (snapshot.index_->Refs() > 1)
+    {
+        SharedPtr<SceneSnapshotIndex> copy = MakeShared<SceneSnapshotIndex>();
+        copy->entries_ = snapshot.index_->entries_;
+        snapshot.index_ = copy;
+    }
+    return *snapshot.index_;
+}
+
+}
@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include <EASTL/unordered_map.h>
+
+#include "../Container/Ptr.h"
+#include "../Container/RefCounted.h"
+#include "../Core/Variant.h"
+#include "../Math/Matrix3x4.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Fixed-size page of scene snapshot node entries, shared between snapshots until one of its nodes changes. Internal.
+struct SceneSnapshotPage : public RefCounted
+{
+    /// Number of node entries per page.
+    static const unsigned SIZE = 256;
+
+    /// Construct with attribute storage.
+    explicit SceneSnapshotPage(unsigned numAttributes) : attributes_(SIZE * numAttributes) {}
+
+    /// Node IDs. Zero for free entries.
+    unsigned nodeIDs_[SIZE]{};
+    /// Parent node IDs.
+    unsigned parentIDs_[SIZE]{};
+    /// Enabled flags.
+    bool enabled_[SIZE]{};
+    /// World transforms.
+    Matrix3x4 worldTransforms_[SIZE];
+    /// Selected attribute values, SIZE per attribute.
+    ea::vector<Variant> attributes_;
+};
+
+/// Node ID to entry index mapping of a scene snapshot, shared between snapshots until nodes are added or removed. Internal.
+struct SceneSnapshotIndex : public RefCounted
+{
+    /// Entry indices by node ID.
+    ea::unordered_map<unsigned, unsigned> entries_;
+};
+
+/// Immutable versioned snapshot of the node transforms and selected attributes of a scene, readable from any thread without locking the scene. Nodes are stored in fixed-size copy-on-write pages: a capture shares the pages of unchanged nodes with the previous snapshot and copies a changed page only while an older snapshot still references it.
+class URHO3D_API SceneSnapshot : public RefCounted
+{
+    friend class SceneSnapshotTracker;
+
+public:
+    /// Return snapshot version. Versions increase by one with each capture.
+    unsigned GetVersion() const { return version_; }
+    /// Return number of node entries, including free ones.
+    unsigned GetNumEntries() const { return pages_.size() * SceneSnapshotPage::SIZE; }
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return index_->entries_.size(); }
+    /// Return number of selected attributes.
+    unsigned GetNumAttributes() const { return numAttributes_; }
+
+    /// Return entry index of a node, or M_MAX_UNSIGNED if not in the snapshot.
+    unsigned FindNode(unsigned nodeID) const;
+    /// Return whether an entry holds a node.
+    bool IsValid(unsigned index) const { return GetNodeID(index) != 0; }
+    /// Return node ID of an entry, or zero for a free entry.
+    unsigned GetNodeID(unsigned index) const { return GetPage(index).nodeIDs_[index % SceneSnapshotPage::SIZE]; }
+    /// Return parent node ID of an entry.
+    unsigned GetParentID(unsigned index) const { return GetPage(index).parentIDs_[index % SceneSnapshotPage::SIZE]; }
+    /// Return whether the node of an entry is enabled.
+    bool IsEnabled(unsigned index) const { return GetPage(index).enabled_[index % SceneSnapshotPage::SIZE]; }
+    /// Return world transform of an entry.
+    const Matrix3x4& GetWorldTransform(unsigned index) const { return GetPage(index).worldTransforms_[index % SceneSnapshotPage::SIZE]; }
+    /// Return selected attribute value of an entry. Empty if the node has no such component.
+    const Variant& GetAttribute(unsigned index, unsigned attributeIndex) const
+    {
+        return GetPage(index).attributes_[attributeIndex * SceneSnapshotPage::SIZE + index % SceneSnapshotPage::SIZE];
+    }
+
+private:
+    /// Return page of an entry.
+    const SceneSnapshotPage& GetPage(unsigned index) const { return *pages_[index / SceneSnapshotPage::SIZE]; }
+
+    /// Version.
+    unsigned version_{};
+    /// Number of selected attributes.
+    unsigned numAttributes_{};
+    /// Node entry pages.
+    ea::vector<SharedPtr<SceneSnapshotPage> > pages_;
+    /// Node ID to entry index mapping.
+    SharedPtr<SceneSnapshotIndex> index_;
+};
+
+/// Captures scene snapshots and keeps the entry assignment of nodes stable between captures, so that unchanged pages can be shared.
+class URHO3D_API SceneSnapshotTracker
+{
+public:
+    /// Construct for a scene.
+    explicit SceneSnapshotTracker(Scene* scene);
+
+    /// Add a node or component attribute to capture. Component attributes are read from the first component of the type in each node. The next capture does not share pages with older snapshots. Return true if successful.
+    bool AddAttribute(StringHash objectType, const ea::string& name);
+    /// Capture a snapshot. Must be called from the main thread.
+    SharedPtr<SceneSnapshot> Capture();
+
+private:
+    /// Selected attribute.
+    struct Attribute
+    {
+        /// Node or component type.
+        StringHash objectType_;
+        /// Attribute index within the type.
+        unsigned index_;
+    };
+
+    /// Write the state of a node to its entry, copying the page first if it is shared.
+    void CaptureNode(SceneSnapshot& snapshot, Node* node, unsigned index);
+    /// Return page of an entry for writing, copying it first if it is shared.
+    SceneSnapshotPage& GetWritablePage(SceneSnapshot& snapshot, unsigned index);
+    /// Return node ID to entry index mapping for writing, copying it first if it is shared.
+    SceneSnapshotIndex& GetWritableIndex(SceneSnapshot& snapshot);
+
+    /// Scene.
+    Scene* scene_;
+    /// Selected attributes.
+    ea::vector<Attribute> attributes_;
+    /// Version of the next snapshot.
+    unsigned version_{1};
+    /// Previous snapshot.
+    SharedPtr<SceneSnapshot> previous_;
+    /// Version at which each entry was last visited.
+    ea::vector<unsigned> entryVersions_;
+    /// Free entry indices.
+    ea::vector<unsigned> freeEntries_;
+    /// Nodes of the scene being captured.
+    ea::vector<Node*> nodes_;
+};
+
+}
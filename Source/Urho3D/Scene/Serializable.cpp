@@ -126,6 +126,7 @@ void Serializable::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
     if (attr.accessor_)
     {
         attr.accessor_->Set(this, src);
+        MarkSaveDirty();
         return;
     }
 
@@ -227,6 +228,7 @@ void Serializable::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
     // If it is a network attribute then mark it for next network update
     if (attr.mode_ & AM_NET)
         MarkNetworkUpdate();
+    MarkSaveDirty();
 }
 
 void Serializable::OnGetAttribute(const AttributeInfo& attr, Variant& dest) const
@@ -914,6 +916,53 @@ bool Serializable::SetAttribute(const ea::string& name, const Variant& value)
     return false;
 }
 
+bool Serializable::SetAttributeRaw(const AttributeInfo& attr, const void* src)
+{
+    // Instance defaults are stored as Variants
+    if (setInstanceDefault_)
+        return false;
+
+    if (attr.accessor_)
+    {
+        if (attr.accessor_->GetRawType() != attr.type_)
+            return false;
+        attr.accessor_->SetRaw(this, src);
+        return true;
+    }
+
+    const unsigned size = GetRawAttributeSize(attr.type_);
+    if (!size || !attr.ptr_)
+        return false;
+
+    // If enum type, use the low 8 bits only
+    if (attr.type_ == VAR_INT && attr.enumNames_)
+        *(reinterpret_cast<unsigned char*>(attr.ptr_)) = *(reinterpret_cast<const int*>(src));
+    else
+        memcpy(attr.ptr_, src, size);
+    return true;
+}
+
+bool Serializable::GetAttributeRaw(const AttributeInfo& attr, void* dest) const
+{
+    if (attr.accessor_)
+    {
+        if (attr.accessor_->GetRawType() != attr.type_)
+            return false;
+        attr.accessor_->GetRaw(this, dest);
+        return true;
+    }
+
+    const unsigned size = GetRawAttributeSize(attr.type_);
+    if (!size || !attr.ptr_)
+        return false;
+
+    if (attr.type_ == VAR_INT && attr.enumNames_)
+        *(reinterpret_cast<int*>(dest)) = *(reinterpret_cast<const unsigned char*>(attr.ptr_));
+    else
+        memcpy(dest, attr.ptr_, size);
+    return true;
+}
+
 void Serializable::ResetToDefault()
 {
     const ea::vector<AttributeInfo>* attributes = GetAttributes();
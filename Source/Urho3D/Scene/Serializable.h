@@ -90,17 +90,27 @@ public:
 
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     virtual void ApplyAttributes() { }
+    /// Called before attributes are assigned from serialized data that bypasses Load(), LoadXML() and LoadJSON().
+    virtual void BeginAttributeLoad() { }
+    /// Called after attributes are assigned from serialized data that bypasses Load(), LoadXML() and LoadJSON().
+    virtual void EndAttributeLoad() { }
 
     /// Return whether should save default-valued attributes into XML. Default false.
     virtual bool SaveDefaultAttributes(const AttributeInfo& attr) const { return false; }
 
     /// Mark for attribute check on the next network update.
     virtual void MarkNetworkUpdate() { }
+    /// Mark changed for the next incremental scene save.
+    virtual void MarkSaveDirty() { }
 
     /// Set attribute by index. Return true if successfully set.
     bool SetAttribute(unsigned index, const Variant& value);
     /// Set attribute by name. Return true if successfully set.
     bool SetAttribute(const ea::string& name, const Variant& value);
+    /// Set attribute from raw data of the attribute type, bypassing Variant. Return false if the attribute can only be set through Variant, in which case nothing is set.
+    bool SetAttributeRaw(const AttributeInfo& attr, const void* src);
+    /// Copy attribute value as raw data of the attribute type, bypassing Variant. Return false if the attribute can only be read through Variant.
+    bool GetAttributeRaw(const AttributeInfo& attr, void* dest) const;
     /// (Internal use) Set instance-level default flag.
     void SetInstanceDefault(bool enable) { setInstanceDefault_ = enable; }
     /// (Internal use) Set instance-level default value. Allocate the internal data structure as necessary.
@@ -203,15 +213,77 @@ SharedPtr<AttributeAccessor> MakeVariantAttributeAccessor(TGetFunction getFuncti
     return SharedPtr<AttributeAccessor>(new VariantAttributeAccessorImpl<TClassType, TGetFunction, TSetFunction>(getFunction, setFunction));
 }
 
+/// Template implementation of the attribute accessor for values of a known type. Values of POD types can also be accessed as raw data, bypassing Variant.
+template <class TClassType, class TValueType, class TGetFunction, class TSetFunction>
+class TypedAttributeAccessorImpl : public AttributeAccessor
+{
+public:
+    /// Construct.
+    TypedAttributeAccessorImpl(TGetFunction getFunction, TSetFunction setFunction) : getFunction_(getFunction), setFunction_(setFunction) { }
+
+    /// Invoke getter function.
+    void Get(const Serializable* ptr, Variant& value) const override
+    {
+        assert(ptr);
+        const auto classPtr = static_cast<const TClassType*>(ptr);
+        // The getter may return a reference or a value of another type, convert to the attribute type for the variant
+        value = static_cast<const TValueType&>(getFunction_(*classPtr));
+    }
+
+    /// Invoke setter function.
+    void Set(Serializable* ptr, const Variant& value) override
+    {
+        assert(ptr);
+        auto classPtr = static_cast<TClassType*>(ptr);
+        setFunction_(*classPtr, value.Get<TValueType>());
+    }
+
+    /// Return variant type of the raw data.
+    VariantType GetRawType() const override { return GetRawAttributeType<TValueType>(); }
+
+    /// Invoke getter function with raw data.
+    void GetRaw(const Serializable* ptr, void* dest) const override
+    {
+        assert(ptr && dest);
+        const auto classPtr = static_cast<const TClassType*>(ptr);
+        *static_cast<TValueType*>(dest) = getFunction_(*classPtr);
+    }
+
+    /// Invoke setter function with raw data.
+    void SetRaw(Serializable* ptr, const void* src) override
+    {
+        assert(ptr && src);
+        auto classPtr = static_cast<TClassType*>(ptr);
+        setFunction_(*classPtr, *static_cast<const TValueType*>(src));
+    }
+
+private:
+    /// Get functor.
+    TGetFunction getFunction_;
+    /// Set functor.
+    TSetFunction setFunction_;
+};
+
+/// Make typed attribute accessor implementation.
+/// \tparam TClassType Serializable class type.
+/// \tparam TValueType Attribute value type.
+/// \tparam TGetFunction Functional object with call signature `TValueType getFunction(const TClassType& self)`. May return a reference, or a value convertible to TValueType
+/// \tparam TSetFunction Functional object with call signature `void setFunction(TClassType& self, const TValueType& value)`
+template <class TClassType, class TValueType, class TGetFunction, class TSetFunction>
+SharedPtr<AttributeAccessor> MakeTypedAttributeAccessor(TGetFunction getFunction, TSetFunction setFunction)
+{
+    return SharedPtr<AttributeAccessor>(new TypedAttributeAccessorImpl<TClassType, TValueType, TGetFunction, TSetFunction>(getFunction, setFunction));
+}
+
 /// Make member attribute accessor.
-#define URHO3D_MAKE_MEMBER_ATTRIBUTE_ACCESSOR(typeName, variable) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
-    [](const ClassName& self, Urho3D::Variant& value) { value = self.variable; }, \
-    [](ClassName& self, const Urho3D::Variant& value) { self.variable = value.Get<typeName>(); })
+#define URHO3D_MAKE_MEMBER_ATTRIBUTE_ACCESSOR(typeName, variable) Urho3D::MakeTypedAttributeAccessor<ClassName, typeName >( \
+    [](const ClassName& self) -> decltype(auto) { return (self.variable); }, \
+    [](ClassName& self, const typeName& value) { self.variable = value; })
 
 /// Make member attribute accessor with custom post-set callback.
-#define URHO3D_MAKE_MEMBER_ATTRIBUTE_ACCESSOR_EX(typeName, variable, postSetCallback) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
-    [](const ClassName& self, Urho3D::Variant& value) { value = self.variable; }, \
-    [](ClassName& self, const Urho3D::Variant& value) { self.variable = value.Get<typeName>(); self.postSetCallback(); })
+#define URHO3D_MAKE_MEMBER_ATTRIBUTE_ACCESSOR_EX(typeName, variable, postSetCallback) Urho3D::MakeTypedAttributeAccessor<ClassName, typeName >( \
+    [](const ClassName& self) -> decltype(auto) { return (self.variable); }, \
+    [](ClassName& self, const typeName& value) { self.variable = value; self.postSetCallback(); })
 
 /// Make custom member attribute accessor.
 #define URHO3D_MAKE_CUSTOM_MEMBER_ATTRIBUTE_ACCESSOR(typeName, variable) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
@@ -219,24 +291,24 @@ SharedPtr<AttributeAccessor> MakeVariantAttributeAccessor(TGetFunction getFuncti
     [](ClassName& self, const Urho3D::Variant& value) { self.variable = value.GetCustom<typeName>(); })
 
 /// Make get/set attribute accessor.
-#define URHO3D_MAKE_GET_SET_ATTRIBUTE_ACCESSOR(getFunction, setFunction, typeName) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
-    [](const ClassName& self, Urho3D::Variant& value) { value = self.getFunction(); }, \
-    [](ClassName& self, const Urho3D::Variant& value) { self.setFunction(value.Get<typeName>()); })
+#define URHO3D_MAKE_GET_SET_ATTRIBUTE_ACCESSOR(getFunction, setFunction, typeName) Urho3D::MakeTypedAttributeAccessor<ClassName, typeName >( \
+    [](const ClassName& self) -> decltype(auto) { return self.getFunction(); }, \
+    [](ClassName& self, const typeName& value) { self.setFunction(value); })
 
 /// Make member enum attribute accessor
-#define URHO3D_MAKE_MEMBER_ENUM_ATTRIBUTE_ACCESSOR(variable) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
-    [](const ClassName& self, Urho3D::Variant& value) { value = static_cast<int>(self.variable); }, \
-    [](ClassName& self, const Urho3D::Variant& value) { self.variable = static_cast<decltype(self.variable)>(value.Get<int>()); })
+#define URHO3D_MAKE_MEMBER_ENUM_ATTRIBUTE_ACCESSOR(variable) Urho3D::MakeTypedAttributeAccessor<ClassName, int>( \
+    [](const ClassName& self) { return static_cast<int>(self.variable); }, \
+    [](ClassName& self, const int& value) { self.variable = static_cast<decltype(self.variable)>(value); })
 
 /// Make member enum attribute accessor with custom post-set callback.
-#define URHO3D_MAKE_MEMBER_ENUM_ATTRIBUTE_ACCESSOR_EX(variable, postSetCallback) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
-    [](const ClassName& self, Urho3D::Variant& value) { value = static_cast<int>(self.variable); }, \
-    [](ClassName& self, const Urho3D::Variant& value) { self.variable = static_cast<decltype(self.variable)>(value.Get<int>()); self.postSetCallback(); })
+#define URHO3D_MAKE_MEMBER_ENUM_ATTRIBUTE_ACCESSOR_EX(variable, postSetCallback) Urho3D::MakeTypedAttributeAccessor<ClassName, int>( \
+    [](const ClassName& self) { return static_cast<int>(self.variable); }, \
+    [](ClassName& self, const int& value) { self.variable = static_cast<decltype(self.variable)>(value); self.postSetCallback(); })
 
 /// Make get/set enum attribute accessor.
-#define URHO3D_MAKE_GET_SET_ENUM_ATTRIBUTE_ACCESSOR(getFunction, setFunction, typeName) Urho3D::MakeVariantAttributeAccessor<ClassName>( \
-    [](const ClassName& self, Urho3D::Variant& value) { value = static_cast<int>(self.getFunction()); }, \
-    [](ClassName& self, const Urho3D::Variant& value) { self.setFunction(static_cast<typeName>(value.Get<int>())); })
+#define URHO3D_MAKE_GET_SET_ENUM_ATTRIBUTE_ACCESSOR(getFunction, setFunction, typeName) Urho3D::MakeTypedAttributeAccessor<ClassName, int>( \
+    [](const ClassName& self) { return static_cast<int>(self.getFunction()); }, \
+    [](ClassName& self, const int& value) { self.setFunction(static_cast<typeName>(value)); })
 
 /// Attribute metadata.
 namespace AttributeMetadata
@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+#include "../Scene/TransformSystem.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of nodes of one hierarchy level per work item.
+static const unsigned MIN_NODES_PER_WORK_ITEM = 1024;
+/// Maximum number of update passes. Listeners may move nodes when notified, which requires another pass.
+static const unsigned MAX_UPDATE_PASSES = 4;
+/// Dirty flag of a node whose listeners are notified on the next update.
+static const unsigned char DIRTY_NOTIFY = 1;
+/// Dirty flag of a node whose listeners were already notified when it was marked dirty.
+static const unsigned char DIRTY_NOTIFIED = 2;
+
+void TransformSystem::UpdateWorldTransformsWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* system = reinterpret_cast<TransformSystem*>(item->aux_);
+    Node** nodes = system->nodes_.data();
+    const unsigned begin = reinterpret_cast<Node**>(item->start_) - nodes;
+    const unsigned end = reinterpret_cast<Node**>(item->end_) - nodes;
+    system->UpdateWorldTransforms(begin, end);
+}
+
+TransformSystem::TransformSystem(Scene* scene) :
+    scene_(scene)
+{
+}
+
+bool TransformSystem::MarkDirty(Node* node)
+{
+    const unsigned index = node->transformIndex_;
+    if (hierarchyDirty_ || index >= nodes_.size() || nodes_[index] != node)
+        return false;
+
+    // Listeners are notified immediately during threaded update, as they expect the notification before the update ends.
+    // The world transform is still updated in batch, but a deferred notification from before is kept
+    const bool deferNotification = !scene_->IsThreadedUpdate();
+    if (deferNotification || dirtyFlags_[index] != DIRTY_NOTIFY)
+        dirtyFlags_[index] = deferNotification ? DIRTY_NOTIFY : DIRTY_NOTIFIED;
+    hasDirty_ = true;
+
+    return deferNotification;
+}
+
+void TransformSystem::NodeRemoved(Node* node)
+{
+    hierarchyDirty_ = true;
+    if (notifying_)
+        ea::replace(notifyNodes_.begin(), notifyNodes_.end(), node, static_cast<Node*>(nullptr));
+}
+
+void TransformSystem::Update()
+{
+    if (!hierarchyDirty_ && !hasDirty_)
+        return;
+
+    URHO3D_PROFILE("UpdateTransforms");
+
+    if (hierarchyDirty_)
+        Rebuild();
+
+    for (unsigned pass = 0; pass < MAX_UPDATE_PASSES && hasDirty_; ++pass)
+    {
+        hasDirty_ = false;
+        UpdateAllWorldTransforms();
+
+        // Collect changed nodes first, as listeners may flag more nodes for the next pass
+        notifyNodes_.clear();
+        for (unsigned i = 0; i < nodes_.size(); ++i)
+        {
+            if (dirtyFlags_[i] == DIRTY_NOTIFY)
+                notifyNodes_.push_back(nodes_[i]);
+            dirtyFlags_[i] = 0;
+        }
+
+        notifying_ = true;
+        for (unsigned i = 0; i < notifyNodes_.size(); ++i)
+        {
+            if (Node* node = notifyNodes_[i])
+                node->NotifyListenersDirty();
+        }
+        notifying_ = false;
+
+        if (hierarchyDirty_)
+            Rebuild();
+    }
+}
+
+void TransformSystem::UpdateWorldTransforms(unsigned begin, unsigned end)
+{
+    Node* const* nodes = nodes_.data();
+    const unsigned* parents = parents_.data();
+    Matrix3x4* worldTransforms = worldTransforms_.data();
+    Quaternion* worldRotations = worldRotations_.data();
+    unsigned char* dirtyFlags = dirtyFlags_.data();
+
+    for (unsigned i = begin; i < end; ++i)
+    {
+        // Parents precede children, so the parent flag is final here. A pending notification of the parent applies to
+        // the children as well
+        const unsigned parent = parents[i];
+        const unsigned char parentFlag = parent != M_MAX_UNSIGNED ? dirtyFlags[parent] : 0;
+        if (parentFlag && (!dirtyFlags[i] || parentFlag < dirtyFlags[i]))
+            dirtyFlags[i] = parentFlag;
+        if (!dirtyFlags[i])
+            continue;
+
+        Node* node = nodes[i];
+        const Matrix3x4 transform(node->position_, node->rotation_, node->scale_);
+
+        // Assume the root node (scene) has identity transform
+        if (parent == M_MAX_UNSIGNED)
+        {
+            worldTransforms[i] = transform;
+            worldRotations[i] = node->rotation_;
+        }
+        else
+        {
+            worldTransforms[i] = worldTransforms[parent] * transform;
+            worldRotations[i] = worldRotations[parent] * node->rotation_;
+        }
+
+        node->worldTransform_ = worldTransforms[i];
+        node->worldRotation_ = worldRotations[i];
+        node->dirty_ = false;
+    }
+}
+
+void TransformSystem::UpdateAllWorldTransforms()
+{
+    auto* queue = scene_->GetSubsystem<WorkQueue>();
+    const unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+
+    for (unsigned level = 0; level + 1 < levels_.size(); ++level)
+    {
+        const unsigned begin = levels_[level];
+        const unsigned end = levels_[level + 1];
+        const unsigned numNodes = end - begin;
+        if (numThreads == 0 || numNodes < 2 * MIN_NODES_PER_WORK_ITEM)
+        {
+            UpdateWorldTransforms(begin, end);
+            continue;
+        }
+
+        // Worker threads + main thread
+        const unsigned numWorkItems = Min(numThreads + 1, numNodes / MIN_NODES_PER_WORK_ITEM);
+        const unsigned nodesPerItem = (numNodes + numWorkItems - 1) / numWorkItems;
+        for (unsigned itemBegin = begin; itemBegin < end; itemBegin += nodesPerItem)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = UpdateWorldTransformsWork;
+            item->aux_ = this;
+            item->start_ = nodes_.data() + itemBegin;
+            item->end_ = nodes_.data() + Min(itemBegin + nodesPerItem, end);
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+}
+
+void TransformSystem::Rebuild()
+{
+    // A dirty flag may outlive the node dirty flag when the world transform was queried before the update, so carry
+    // the deferred notifications over. Removed nodes may be destroyed already and are only compared, not accessed
+    pendingNodes_.clear();
+    if (hasDirty_)
+    {
+        for (unsigned i = 0; i < nodes_.size(); ++i)
+        {
+            if (dirtyFlags_[i] == DIRTY_NOTIFY)
+                pendingNodes_.insert(nodes_[i]);
+        }
+    }
+
+    nodes_.clear();
+    parents_.clear();
+    levels_.clear();
+
+    // Breadth-first traversal sorts the nodes by hierarchy depth
+    for (Node* child : scene_->GetChildren())
+    {
+        nodes_.push_back(child);
+        parents_.push_back(M_MAX_UNSIGNED);
+    }
+
+    levels_.push_back(0);
+    unsigned levelBegin = 0;
+    while (levelBegin < nodes_.size())
+    {
+        const unsigned levelEnd = nodes_.size();
+        levels_.push_back(levelEnd);
+        for (unsigned i = levelBegin; i < levelEnd; ++i)
+        {
+            for (Node* child : nodes_[i]->children_)
+            {
+                nodes_.push_back(child);
+                parents_.push_back(i);
+            }
+        }
+        levelBegin = levelEnd;
+    }
+
+    // Clean world transforms are up to date in the nodes
+    const unsigned numNodes = nodes_.size();
+    worldTransforms_.resize(numNodes);
+    worldRotations_.resize(numNodes);
+    dirtyFlags_.resize(numNodes);
+
+    bool hasDirty = false;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = nodes_[i];
+        node->transformIndex_ = i;
+        worldTransforms_[i] = node->worldTransform_;
+        worldRotations_[i] = node->worldRotation_;
+        // Listeners of nodes that became dirty without a deferred notification were notified already
+        dirtyFlags_[i] = pendingNodes_.count(node) ? DIRTY_NOTIFY : node->dirty_ ? DIRTY_NOTIFIED : 0;
+        hasDirty |= dirtyFlags_[i] != 0;
+    }
+    pendingNodes_.clear();
+
+    hasDirty_ = hasDirty;
+    hierarchyDirty_ = false;
+}
+
+}
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include <EASTL/hash_set.h>
+#include <EASTL/vector.h>
+
+#include "../Math/Matrix3x4.h"
+#include "../Math/Quaternion.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+struct WorkItem;
+
+/// Batched world transform update for the nodes of a scene. Nodes are kept in contiguous arrays sorted by hierarchy depth, together with their parent indices, world transforms and dirty flags. Marking a node dirty only sets flags, and the update recalculates the world transforms of all changed nodes in one linear pass per hierarchy level, splitting large levels between worker threads. The listener components of changed nodes are notified in batch after the pass instead of on every change. World transforms queried before the update are still calculated on demand. After a hierarchy change listeners are notified immediately until the next update.
+class URHO3D_API TransformSystem
+{
+public:
+    /// Construct for a scene.
+    explicit TransformSystem(Scene* scene);
+
+    /// Flag a node whose world transform became dirty. Return true if the notification of listeners is deferred to the next update. Is thread-safe.
+    bool MarkDirty(Node* node);
+    /// Mark the node hierarchy changed. The arrays are rebuilt on the next update.
+    void MarkHierarchyDirty() { hierarchyDirty_ = true; }
+    /// Handle node removal from the scene.
+    void NodeRemoved(Node* node);
+
+    /// Recalculate dirty world transforms and notify the listeners of changed nodes. Must be called from the main thread.
+    void Update();
+    /// Recalculate dirty world transforms in a range of nodes of one hierarchy level. Is thread-safe for disjoint ranges of the same level.
+    void UpdateWorldTransforms(unsigned begin, unsigned end);
+
+    /// Return number of nodes in the arrays.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+    /// Return number of hierarchy levels.
+    unsigned GetNumLevels() const { return levels_.empty() ? 0 : levels_.size() - 1; }
+
+private:
+    /// Work function to recalculate dirty world transforms in a range of nodes.
+    static void UpdateWorldTransformsWork(const WorkItem* item, unsigned threadIndex);
+    /// Rebuild the arrays from the scene hierarchy.
+    void Rebuild();
+    /// Recalculate dirty world transforms of all levels.
+    void UpdateAllWorldTransforms();
+
+    /// Scene.
+    Scene* scene_;
+    /// Nodes sorted by hierarchy depth, excluding the scene.
+    ea::vector<Node*> nodes_;
+    /// Parent node indices. M_MAX_UNSIGNED for children of the scene.
+    ea::vector<unsigned> parents_;
+    /// World transforms.
+    ea::vector<Matrix3x4> worldTransforms_;
+    /// World rotations.
+    ea::vector<Quaternion> worldRotations_;
+    /// Dirty flags. Nonzero if the world transform needs update, with a different value depending on whether listeners still need notification.
+    ea::vector<unsigned char> dirtyFlags_;
+    /// Index of the first node of each hierarchy level, followed by the number of nodes.
+    ea::vector<unsigned> levels_;
+    /// Nodes whose listeners are being notified.
+    ea::vector<Node*> notifyNodes_;
+    /// Nodes with a deferred notification while the arrays are rebuilt. Their world transform may already be clean.
+    ea::hash_set<Node*> pendingNodes_;
+    /// Whether the node hierarchy changed since the arrays were built.
+    bool hierarchyDirty_{ true };
+    /// Whether any node is flagged dirty.
+    std::atomic<bool> hasDirty_{};
+    /// Whether listeners are being notified.
+    bool notifying_{};
+};
+
+}
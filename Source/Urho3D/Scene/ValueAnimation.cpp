@@ -40,6 +40,39 @@
 namespace Urho3D
 {
 
+/// Return number of floats in a value of the given type when packed for batched evaluation, or 0 if the type is not made of floats.
+static unsigned GetPackedValueSize(VariantType type)
+{
+    switch (type)
+    {
+    case VAR_FLOAT: return 1;
+    case VAR_VECTOR2: return 2;
+    case VAR_VECTOR3: return 3;
+    case VAR_VECTOR4: return 4;
+    case VAR_QUATERNION: return 4;
+    case VAR_COLOR: return 4;
+    default: return 0;
+    }
+}
+
+/// Append the floats of a value of a type supported by GetPackedValueSize().
+static void AppendPackedValue(const Variant& value, ea::vector<float>& dest)
+{
+    const float* data = nullptr;
+    unsigned size = 0;
+    switch (value.GetType())
+    {
+    case VAR_FLOAT: dest.push_back(value.GetFloat()); return;
+    case VAR_VECTOR2: data = value.GetVector2().Data(); size = 2; break;
+    case VAR_VECTOR3: data = value.GetVector3().Data(); size = 3; break;
+    case VAR_VECTOR4: data = value.GetVector4().Data(); size = 4; break;
+    case VAR_QUATERNION: data = value.GetQuaternion().Data(); size = 4; break;
+    case VAR_COLOR: data = value.GetColor().Data(); size = 4; break;
+    default: return;
+    }
+    dest.insert(dest.end(), data, data + size);
+}
+
 const char* interpMethodNames[] =
 {
     "None",
@@ -80,7 +113,8 @@ ValueAnimation::ValueAnimation(Context* context) :
     interpolatable_(false),
     beginTime_(M_INFINITY),
     endTime_(-M_INFINITY),
-    splineTangentsDirty_(false)
+    splineTangentsDirty_(false),
+    packedKeyFramesDirty_(true)
 {
 }
 
@@ -310,6 +344,7 @@ void ValueAnimation::SetValueType(VariantType valueType)
     eventFrames_.clear();
     beginTime_ = M_INFINITY;
     endTime_ = -M_INFINITY;
+    packedKeyFramesDirty_ = true;
 }
 
 void ValueAnimation::SetOwner(void* owner)
@@ -328,12 +363,14 @@ void ValueAnimation::SetInterpolationMethod(InterpMethod method)
 
     interpolationMethod_ = method;
     splineTangentsDirty_ = true;
+    packedKeyFramesDirty_ = true;
 }
 
 void ValueAnimation::SetSplineTension(float tension)
 {
     splineTension_ = tension;
     splineTangentsDirty_ = true;
+    packedKeyFramesDirty_ = true;
 }
 
 bool ValueAnimation::SetKeyFrame(float time, const Variant& value)
@@ -367,6 +404,7 @@ bool ValueAnimation::SetKeyFrame(float time, const Variant& value)
     beginTime_ = Min(time, beginTime_);
     endTime_ = Max(time, endTime_);
     splineTangentsDirty_ = true;
+    packedKeyFramesDirty_ = true;
 
     return true;
 }
@@ -423,6 +461,42 @@ Variant ValueAnimation::GetAnimationValue(float scaledTime) const
     }
 }
 
+const VAnimPackedKeyFrames* ValueAnimation::GetPackedKeyFrames() const
+{
+    if (packedKeyFramesDirty_)
+    {
+        VAnimPackedKeyFrames& packed = packedKeyFrames_;
+        packed.valueType_ = valueType_;
+        packed.interpolationMethod_ = interpolationMethod_;
+        packed.numComponents_ = IsValid() ? GetPackedValueSize(valueType_) : 0;
+        packed.times_.clear();
+        packed.values_.clear();
+        packed.tangents_.clear();
+
+        if (packed.numComponents_)
+        {
+            for (const VAnimKeyFrame& keyFrame : keyFrames_)
+            {
+                packed.times_.push_back(keyFrame.time_);
+                AppendPackedValue(keyFrame.value_, packed.values_);
+            }
+
+            // Use the same tangents as SplineInterpolation()
+            if (interpolationMethod_ == IM_SPLINE)
+            {
+                if (splineTangentsDirty_)
+                    UpdateSplineTangents();
+                for (const Variant& tangent : splineTangents_)
+                    AppendPackedValue(tangent, packed.tangents_);
+            }
+        }
+
+        packedKeyFramesDirty_ = false;
+    }
+
+    return packedKeyFrames_.numComponents_ ? &packedKeyFrames_ : nullptr;
+}
+
 void ValueAnimation::GetEventFrames(float beginTime, float endTime, ea::vector<const VAnimEventFrame*>& eventFrames) const
 {
     for (unsigned i = 0; i < eventFrames_.size(); ++i)
@@ -436,6 +510,63 @@ void ValueAnimation::GetEventFrames(float beginTime, float endTime, ea::vector<c
     }
 }
 
+void VAnimPackedKeyFrames::Evaluate(const float* times, float* dest, unsigned count) const
+{
+    const unsigned numKeyFrames = times_.size();
+    const unsigned numComponents = numComponents_;
+
+    for (unsigned i = 0; i < count; ++i, dest += numComponents)
+    {
+        // Same key frame search as GetAnimationValue(): the first key frame after the time
+        const float time = times[i];
+        const unsigned index = ea::upper_bound(times_.begin() + 1, times_.end(), time) - times_.begin();
+        const float* value1 = &values_[(index - 1) * numComponents];
+
+        if (index >= numKeyFrames || interpolationMethod_ == IM_NONE)
+        {
+            for (unsigned j = 0; j < numComponents; ++j)
+                dest[j] = value1[j];
+            continue;
+        }
+
+        const float* value2 = value1 + numComponents;
+        const float t = (time - times_[index - 1]) / (times_[index] - times_[index - 1]);
+
+        if (interpolationMethod_ == IM_LINEAR)
+        {
+            if (valueType_ == VAR_QUATERNION)
+            {
+                const Quaternion result = Quaternion(value1).Slerp(Quaternion(value2), t);
+                for (unsigned j = 0; j < numComponents; ++j)
+                    dest[j] = result.Data()[j];
+            }
+            else if (valueType_ == VAR_FLOAT)
+                dest[0] = Lerp(value1[0], value2[0], t);
+            else
+            {
+                const float s = 1.0f - t;
+                for (unsigned j = 0; j < numComponents; ++j)
+                    dest[j] = value1[j] * s + value2[j] * t;
+            }
+        }
+        else
+        {
+            const float tt = t * t;
+            const float ttt = t * tt;
+
+            const float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+            const float h2 = -2.0f * ttt + 3.0f * tt;
+            const float h3 = ttt - 2.0f * tt + t;
+            const float h4 = ttt - tt;
+
+            const float* tangent1 = &tangents_[(index - 1) * numComponents];
+            const float* tangent2 = tangent1 + numComponents;
+            for (unsigned j = 0; j < numComponents; ++j)
+                dest[j] = value1[j] * h1 + value2[j] * h2 + tangent1[j] * h3 + tangent2[j] * h4;
+        }
+    }
+}
+
 Variant ValueAnimation::LinearInterpolation(unsigned index1, unsigned index2, float scaledTime) const
 {
     const VAnimKeyFrame& keyFrame1 = keyFrames_[index1];
@@ -66,6 +66,26 @@ struct VAnimEventFrame
     VariantMap eventData_{};
 };
 
+/// Value animation key frames packed as floats for batched evaluation.
+struct URHO3D_API VAnimPackedKeyFrames
+{
+    /// Evaluate values at scaled times. Writes numComponents_ floats per time to dest. Is thread-safe.
+    void Evaluate(const float* times, float* dest, unsigned count) const;
+
+    /// Value type.
+    VariantType valueType_{};
+    /// Interpolation method.
+    InterpMethod interpolationMethod_{};
+    /// Number of floats per value.
+    unsigned numComponents_{};
+    /// Key frame times.
+    ea::vector<float> times_;
+    /// Key frame values, numComponents_ floats per key frame.
+    ea::vector<float> values_;
+    /// Spline tangents, numComponents_ floats per key frame. Empty unless spline interpolation is used.
+    ea::vector<float> tangents_;
+};
+
 /// Value animation class.
 class URHO3D_API ValueAnimation : public Resource
 {
@@ -134,6 +154,8 @@ public:
 
     /// Return animation value.
     Variant GetAnimationValue(float scaledTime) const;
+    /// Return key frames packed as floats for batched evaluation, or null if the animation is not valid or its value type is not made of floats. The key frames are packed on the first call after a change, which must be made from the main thread.
+    const VAnimPackedKeyFrames* GetPackedKeyFrames() const;
 
     /// Return all key frames.
     const ea::vector<VAnimKeyFrame>& GetKeyFrames() const { return keyFrames_; }
@@ -174,6 +196,10 @@ protected:
     mutable VariantVector splineTangents_;
     /// Spline tangents dirty.
     mutable bool splineTangentsDirty_;
+    /// Packed key frames.
+    mutable VAnimPackedKeyFrames packedKeyFrames_;
+    /// Packed key frames dirty.
+    mutable bool packedKeyFramesDirty_;
     /// Event frames.
     ea::vector<VAnimEventFrame> eventFrames_;
 };